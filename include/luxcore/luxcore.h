@@ -255,8 +255,14 @@ public:
 	 * \brief Serializes a Film in a file.
 	 * 
 	 * \param fileName is the name of the file where to serialize the film.
+	 * \param async if true and the Film belongs to a RenderSession, the
+	 * method returns as soon as the Film has been copied and the file is
+	 * written by a background thread while the rendering goes on (i.e. for
+	 * periodic checkpoints). Only one file is written at time: the next
+	 * SaveFilm() waits for the end of the previous one. A stand alone Film
+	 * is always saved synchronously.
 	 */
-	virtual void SaveFilm(const std::string &fileName) const = 0;
+	virtual void SaveFilm(const std::string &fileName, const bool async = false) const = 0;
 
 	/*!
 	 * \brief Returns the total sample count.
@@ -307,6 +313,15 @@ public:
 	 * \return the number of channels. Returns 0 if the channel is not available.
 	 */
 	virtual unsigned int GetChannelCount(const FilmChannelType type) const = 0;
+	/*!
+	 * \brief Returns the size (in float or unsigned int) of a Film channel.
+	 *
+	 * \param type is the Film channel to use.
+	 *
+	 * \return the size (in float or unsigned int) of a Film channel. Returns 0
+	 * if the channel is not available.
+	 */
+	virtual size_t GetChannelSize(const FilmChannelType type) const = 0;
 	/*!
 	 * \brief Returns a pointer to the type of channel requested. The channel is
 	 * not normalized (if it has a weight channel).
@@ -530,6 +545,18 @@ public:
 	 * \return true if the image map has been defined, false otherwise.
 	 */
 	virtual bool IsImageMapDefined(const std::string &imgMapName) const = 0;
+	/*!
+	 * \brief Enables the reading on demand, one tile at time, of the image
+	 * textures from tiled MIP-mapped files. An image file not tiled and
+	 * MIP-mapped is converted once to a .tx file. It affects only the image
+	 * textures defined after the call and it can be called only once (it is
+	 * the same as the images.cache.* RenderConfig properties).
+	 *
+	 * \param maxMemorySize is the max. memory used by the loaded tiles (in bytes).
+	 * \param cacheDir is the directory where the .tx files are written. The
+	 * .tx files are written next to the image files if it is empty.
+	 */
+	virtual void EnableImageCache(const size_t maxMemorySize, const std::string &cacheDir = "") = 0;
 	/*!
 	 * \brief Sets if the Scene class destructor will delete the arrays
 	 * pointed to by the defined meshes.
@@ -537,6 +564,13 @@ public:
 	 * \param v defines if the Scene class destructor will delete the mesh data.
 	 */
 	virtual void SetDeleteMeshData(const bool v) = 0;
+	/*!
+	 * \brief Returns if the Scene class destructor will delete the arrays
+	 * pointed to by the defined meshes.
+	 *
+	 * \return true if the Scene class destructor will delete the mesh data.
+	 */
+	virtual bool GetDeleteMeshData() const = 0;
 	/*!
 	 * \brief Defines a mesh (to be later used in one or more scene objects). The
 	 * memory allocated for the ExtTriangleMesh is always freed by the Scene class,
@@ -562,7 +596,9 @@ public:
 		float *p, unsigned int *vi, float *n, float *uv,
 		float *cols, float *alphas) = 0;
 	/*!
-	 * \brief Save a previously defined mesh to file system in PLY format.
+	 * \brief Save a previously defined mesh to file system in PLY format or,
+	 * if the file name has the .lxm extension, in the LuxRays binary format.
+	 * Binary meshes are memory mapped when loaded, without any parsing.
 	 *
 	 * \param meshName is the name of the defined mesh to be saved.
 	 * \param fileName is the name of the file where to save the mesh.
@@ -664,6 +700,75 @@ public:
 	 */
 	virtual void DeleteLight(const std::string &lightName) = 0;
 
+	/*!
+	 * \brief Returns the handle of an object. Handles are stable: they don't
+	 * change when other objects are defined or deleted and they survive the
+	 * redefinition of the object with the same name. They can be used to
+	 * edit the scene without the overhead of looking up names. The handle
+	 * of a deleted object is never valid again: it is rejected, instead of
+	 * referencing an object defined later.
+	 *
+	 * \param objName is the name of the object.
+	 *
+	 * \return the handle of the object.
+	 */
+	virtual unsigned long long GetObjectHandle(const std::string &objName) const = 0;
+	/*!
+	 * \brief Returns the handle of a material. See GetObjectHandle().
+	 *
+	 * \param matName is the name of the material.
+	 *
+	 * \return the handle of the material.
+	 */
+	virtual unsigned long long GetMaterialHandle(const std::string &matName) const = 0;
+	/*!
+	 * \brief Returns the handle of a light. See GetObjectHandle().
+	 *
+	 * \param lightName is the name of the light.
+	 *
+	 * \return the handle of the light.
+	 */
+	virtual unsigned long long GetLightHandle(const std::string &lightName) const = 0;
+
+	/*!
+	 * \brief Apply a transformation to multiple objects.
+	 *
+	 * \param count is the number of objects to transform.
+	 * \param objHandles is an array of count object handles.
+	 * \param transMats is an array of count transformation 4x4 matrices to apply
+	 * (16 floats for each object, with the same layout of
+	 * UpdateObjectTransformation()).
+	 */
+	virtual void UpdateObjectTransformations(const unsigned int count,
+		const unsigned long long *objHandles, const float *transMats) = 0;
+	/*!
+	 * \brief Apply a new material to multiple objects.
+	 *
+	 * \param count is the number of objects to edit.
+	 * \param objHandles is an array of count object handles.
+	 * \param matHandles is an array of count material handles.
+	 */
+	virtual void UpdateObjectMaterials(const unsigned int count,
+		const unsigned long long *objHandles, const unsigned long long *matHandles) = 0;
+	/*!
+	 * \brief Deletes multiple objects from the scene. It is much faster than
+	 * calling DeleteObject() for each object.
+	 *
+	 * \param count is the number of objects to delete.
+	 * \param objHandles is an array of count object handles. The scene is
+	 * not modified if any of the handles is invalid.
+	 */
+	virtual void DeleteObjects(const unsigned int count, const unsigned long long *objHandles) = 0;
+	/*!
+	 * \brief Deletes multiple lights from the scene.
+	 *
+	 * \param count is the number of lights to delete.
+	 * \param lightHandles is an array of count light handles. The scene is
+	 * not modified if any of the handles is invalid. Note: to delete area
+	 * lights, use DeleteObjects().
+	 */
+	virtual void DeleteLights(const unsigned int count, const unsigned long long *lightHandles) = 0;
+
 	/*!
 	 * \brief Removes all unused image maps.
 	 */
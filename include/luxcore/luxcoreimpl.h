@@ -46,7 +46,7 @@ public:
 
 	void SaveOutputs() const;
 	void SaveOutput(const std::string &fileName, const FilmOutputType type, const luxrays::Properties &props) const;
-	void SaveFilm(const std::string &fileName) const;
+	void SaveFilm(const std::string &fileName, const bool async = false) const;
 
 	double GetTotalSampleCount() const;
 
@@ -55,6 +55,7 @@ public:
 	
 	unsigned int GetRadianceGroupCount() const;
 	unsigned int GetChannelCount(const FilmChannelType type) const;
+	size_t GetChannelSize(const FilmChannelType type) const;
 
 	void GetOutputFloat(const FilmOutputType type, float *buffer, const unsigned int index);
 	void GetOutputUInt(const FilmOutputType type, unsigned int *buffer, const unsigned int index);
@@ -62,6 +63,18 @@ public:
 	const float *GetChannelFloat(const FilmChannelType type, const unsigned int index);
 	const unsigned int *GetChannelUInt(const FilmChannelType type, const unsigned int index);
 
+	// Copy a channel in a buffer of GetChannelSize() elements while holding
+	// the film lock
+	void CopyChannelFloat(const FilmChannelType type, float *buffer, const unsigned int index);
+	void CopyChannelUInt(const FilmChannelType type, unsigned int *buffer, const unsigned int index);
+
+	// Used by pyluxcore (always with the Python GIL held) to count the Python
+	// views on the channel memory: the film can not be resized while there
+	// are views alive
+	void AddChannelView() { ++channelViewCount; }
+	void RemoveChannelView() { --channelViewCount; }
+	bool HasChannelViews() const { return (channelViewCount > 0); }
+
 	void Parse(const luxrays::Properties &props);
 
 	friend class RenderSessionImpl;
@@ -71,6 +84,8 @@ private:
 
 	const RenderSessionImpl *renderSession;
 	slg::Film *standAloneFilm;
+
+	u_int channelViewCount;
 };
 
 //------------------------------------------------------------------------------
@@ -119,8 +134,10 @@ public:
 	const Camera &GetCamera() const;
 
 	bool IsImageMapDefined(const std::string &imgMapName) const;
+	void EnableImageCache(const size_t maxMemorySize, const std::string &cacheDir = "");
 
 	void SetDeleteMeshData(const bool v);
+	bool GetDeleteMeshData() const;
 
 	void DefineMesh(const std::string &meshName,
 		const long plyNbVerts, const long plyNbTris,
@@ -149,6 +166,17 @@ public:
 	void DeleteObject(const std::string &objName);
 	void DeleteLight(const std::string &lightName);
 
+	unsigned long long GetObjectHandle(const std::string &objName) const;
+	unsigned long long GetMaterialHandle(const std::string &matName) const;
+	unsigned long long GetLightHandle(const std::string &lightName) const;
+
+	void UpdateObjectTransformations(const unsigned int count,
+		const unsigned long long *objHandles, const float *transMats);
+	void UpdateObjectMaterials(const unsigned int count,
+		const unsigned long long *objHandles, const unsigned long long *matHandles);
+	void DeleteObjects(const unsigned int count, const unsigned long long *objHandles);
+	void DeleteLights(const unsigned int count, const unsigned long long *lightHandles);
+
 	void RemoveUnusedImageMaps();
 	void RemoveUnusedTextures();
 	void RemoveUnusedMaterials();
@@ -169,8 +197,9 @@ public:
 			const unsigned int width, const unsigned int height,
 			ChannelSelectionType selectionType);
 
-	// Note: this method is not part of LuxCore API and it is used only internally
+	// Note: these methods are not part of LuxCore API and they are used only internally
 	void DefineMesh(const std::string &meshName, luxrays::ExtTriangleMesh *mesh);
+	void SetMeshDataOwner(const std::string &meshName, slg::ExtMeshDataOwner *owner);
 
 	static luxrays::Point *AllocVerticesBuffer(const unsigned int meshVertCount);
 	static luxrays::Triangle *AllocTrianglesBuffer(const unsigned int meshTriCount);
@@ -36,6 +36,14 @@ extern boost::python::list ConvertFilmChannelOutput_3xFloat_To_4xFloatList(const
 		const u_int height, boost::python::object &objSrc, const bool normalize);
 extern boost::python::list ConvertFilmChannelOutput_4xFloat_To_4xFloatList(const u_int width, 
 		const u_int height, boost::python::object &objSrc, const bool normalize);
+extern void ConvertFilmChannelOutput_1xFloat_To_4xFloatBuffer(const u_int width,
+		const u_int height, boost::python::object &objSrc, boost::python::object &objDst, const bool normalize);
+extern void ConvertFilmChannelOutput_2xFloat_To_4xFloatBuffer(const u_int width,
+		const u_int height, boost::python::object &objSrc, boost::python::object &objDst, const bool normalize);
+extern void ConvertFilmChannelOutput_3xFloat_To_4xFloatBuffer(const u_int width,
+		const u_int height, boost::python::object &objSrc, boost::python::object &objDst, const bool normalize);
+extern void ConvertFilmChannelOutput_4xFloat_To_4xFloatBuffer(const u_int width,
+		const u_int height, boost::python::object &objSrc, boost::python::object &objDst, const bool normalize);
 
 extern boost::python::list Scene_DefineBlenderMesh1(luxcore::detail::SceneImpl *scene, const std::string &name,
 		const size_t blenderFaceCount, const size_t blenderFacesPtr,
@@ -21,13 +21,59 @@
 
 #include <vector>
 #include <boost/foreach.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include "luxrays/luxrays.h"
 #include "luxrays/core/accelerator.h"
 #include "luxrays/core/bvh/bvhbuild.h"
+#include "luxrays/core/bvh/bvhwidetree.h"
 
 namespace luxrays {
 
+// Max. number of rays traversing the tree together in BVHAccel::IntersectBatch()
+// and MBVHAccel::IntersectBatch()
+#define BVHACCEL_PACKET_SIZE 8
+
+// A coherent packet of rays sharing the same traversal. A node is visited
+// if at least one ray of the packet intersects its bounding box.
+class BVHRayPacket {
+public:
+	void Init(const Ray *rs, const u_int count) {
+		rayCount = count;
+		for (u_int i = 0; i < rayCount; ++i)
+			SetRay(i, rs[i]);
+	}
+
+	void SetRay(const u_int index, const Ray &ray) {
+		rays[index] = ray;
+		invDir[index] = Vector(1.f / ray.d.x, 1.f / ray.d.y, 1.f / ray.d.z);
+	}
+
+	bool IntersectP(const float *bboxMin, const float *bboxMax) const {
+		for (u_int i = 0; i < rayCount; ++i) {
+			const Ray &ray = rays[i];
+
+			float t0 = ray.mint, t1 = ray.maxt;
+			for (u_int j = 0; j < 3; ++j) {
+				float tNear = (bboxMin[j] - ray.o[j]) * invDir[i][j];
+				float tFar = (bboxMax[j] - ray.o[j]) * invDir[i][j];
+				if (tNear > tFar) Swap(tNear, tFar);
+				t0 = tNear > t0 ? tNear : t0;
+				t1 = tFar < t1 ? tFar : t1;
+			}
+
+			if (t0 <= t1)
+				return true;
+		}
+
+		return false;
+	}
+
+	Ray rays[BVHACCEL_PACKET_SIZE];
+	Vector invDir[BVHACCEL_PACKET_SIZE];
+	u_int rayCount;
+};
+
 // BVHAccel Declarations
 class BVHAccel : public Accelerator {
 public:
@@ -41,8 +87,20 @@ public:
 	virtual void Init(const std::deque<const Mesh *> &meshes,
 		const u_longlong totalVertexCount,
 		const u_longlong totalTriangleCount);
+	virtual bool DoesSupportMeshesUpdate() const { return true; }
+	virtual void UpdateMeshes(const std::deque<const Mesh *> &meshes,
+		const u_longlong totalVertexCount, const u_longlong totalTriangleCount,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes);
+
+	// Recompute the bounding boxes of the tree after the vertices of the
+	// meshes have been moved (the triangles must be the same). It falls back
+	// to a full rebuild if the quality of the tree degrades too much.
+	void Refit();
 
 	virtual bool Intersect(const Ray *ray, RayHit *hit) const;
+	virtual void IntersectBatch(const Ray *rays, RayHit *hits, const size_t rayCount) const;
+	virtual bool Occluded(const Ray *ray) const;
 
 	static BVHParams ToBVHParams(const Properties &props);
 
@@ -53,10 +111,25 @@ public:
 #endif
 
 private:
+	void IntersectPacket(const Ray *rays, RayHit *hits, const u_int rayCount) const;
+	void Rebuild();
+	void BuildTree(const std::string &builderType);
+	void BuildWideTree();
+	void FreeTree();
+	void RefitBBoxes();
+	float EvaluateSAHCost() const;
+
 	BVHParams params;
+	// The tree is rebuilt when a refit increases the SAH cost over
+	// refitSAHThreshold times the cost of the initial build
+	float refitSAHThreshold, buildSAHCost;
 
 	u_int nNodes;
 	luxrays::ocl::BVHArrayNode *bvhTree;
+	// The file mapped when bvhTree has been loaded from the BVH cache
+	boost::iostreams::mapped_file bvhTreeFile;
+	// The CPU only 4/8-ary version of bvhTree, it can be NULL
+	BVHWideTree *wideTree;
 
 	const Context *ctx;
 	std::deque<const Mesh *> meshes;
@@ -29,6 +29,8 @@
 
 namespace luxrays {
 
+class ExtCurveMesh;
+
 class EmbreeAccel : public Accelerator {
 public:
 	EmbreeAccel(const Context *context);
@@ -48,14 +50,36 @@ public:
 
 	virtual bool DoesSupportUpdate() const { return true; }
 	virtual void Update();
+	virtual bool DoesSupportMeshesUpdate() const { return true; }
+	virtual void UpdateMeshes(const std::deque<const Mesh *> &meshes,
+		const u_longlong totalVertexCount, const u_longlong totalTriangleCount,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes);
 
 	virtual bool Intersect(const Ray *ray, RayHit *hit) const;
+	virtual void IntersectBatch(const Ray *rays, RayHit *hits, const size_t rayCount) const;
+	virtual bool Occluded(const Ray *ray) const;
 
 private:
+	template<class T> struct MeshMap {
+		typedef std::map<const Mesh *, T, bool (*)(const Mesh *, const Mesh *)> type;
+	};
+
 	static bool MeshPtrCompare(const Mesh *p0, const Mesh *p1);
+
+	void ExportMeshes(const std::deque<const Mesh *> &meshes,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes);
+
+	template<class RTCRayN, u_int N> void IntersectPacket(
+		void (*rtcIntersectN)(const void *, RTCScene, RTCRayN &),
+		const Ray *rays, RayHit *hits, const u_int rayCount) const;
 	
-	u_int ExportTriangleMesh(const RTCScene embreeScene, const Mesh *mesh) const;
+	u_int ExportTriangleMesh(const RTCScene embreeScene, const Mesh *mesh,
+		const RTCGeometryFlags geomFlags) const;
 	u_int ExportMotionTriangleMesh(const RTCScene embreeScene, const MotionTriangleMesh *mtm) const;
+	// Exports a not tessellated curve mesh as Embree hair geometry
+	u_int ExportCurveMesh(const RTCScene embreeScene, const ExtCurveMesh *mesh) const;
 
 	// Used for Embree initialization
 	static boost::mutex initMutex;
@@ -66,9 +90,20 @@ private:
 
 	RTCDevice embreeDevice;
 	RTCScene embreeScene;
-	std::map<const Mesh *, RTCScene, bool (*)(const Mesh *, const Mesh *)> uniqueRTCSceneByMesh;
-	std::map<const Mesh *, u_int, bool (*)(const Mesh *, const Mesh *)> uniqueInstIDByMesh;
-	std::map<const Mesh *, Matrix4x4, bool (*)(const Mesh *, const Mesh *)> uniqueInstMatrixByMesh;
+	// The widest ray packet supported by the Embree device (1, 4, 8 or 16)
+	u_int packetSize;
+	int sceneAlgorithmFlags;
+	// The geometry ID of each not instanced mesh
+	MeshMap<u_int>::type uniqueGeomIDByMesh;
+	// The not instanced meshes exported as deformable geometries: Embree
+	// refits them instead of rebuilding when their vertices move
+	boost::unordered_set<const Mesh *> deformableMeshes;
+	MeshMap<RTCScene>::type uniqueRTCSceneByMesh;
+	MeshMap<u_int>::type uniqueInstIDByMesh;
+	MeshMap<Matrix4x4>::type uniqueInstMatrixByMesh;
+	// Geometry IDs are not in the same order of the meshes after an
+	// UpdateMeshes()
+	std::vector<u_int> meshIndexByGeomID;
 	// Used to normalize between 0.f and 1.f
 	float minTime, maxTime, timeScale;
 };
@@ -20,6 +20,7 @@
 #define	_LUXRAYS_MBVHACCEL_H
 
 #include <vector>
+#include <map>
 
 #include "luxrays/luxrays.h"
 #include "luxrays/accelerators/bvhaccel.h"
@@ -44,17 +45,33 @@ public:
 
 	virtual bool DoesSupportUpdate() const { return true; }
 	virtual void Update();
+	virtual bool DoesSupportMeshesUpdate() const { return true; }
+	virtual void UpdateMeshes(const std::deque<const Mesh *> &meshes,
+		const u_longlong totalVertexCount, const u_longlong totalTriangleCount,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes);
 
 	virtual bool Intersect(const Ray *ray, RayHit *hit) const;
+	virtual void IntersectBatch(const Ray *rays, RayHit *hits, const size_t rayCount) const;
+	virtual bool Occluded(const Ray *ray) const;
 
 #if !defined(LUXRAYS_DISABLE_OPENCL)
 	friend class OpenCLMBVHKernels;
 #endif
 
 private:
+	typedef std::map<const Mesh *, u_int, bool (*)(const Mesh *, const Mesh *)> LeafIndexByMeshMap;
+
 	static bool MeshPtrCompare(const Mesh *, const Mesh *);
 
+	void BuildLeafs(const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes);
+	void LogMemoryUsage() const;
 	void UpdateRootBVH();
+	bool OccludedLeaf(const luxrays::ocl::BVHArrayNode &leafNode, const Ray &ray) const;
+	void IntersectPacket(const Ray *rays, RayHit *hits, const u_int rayCount) const;
+	void IntersectLeafPacket(const luxrays::ocl::BVHArrayNode &leafNode,
+		const Ray *rays, RayHit *hits, const u_int rayCount) const;
 
 	BVHParams params;
 
@@ -65,7 +82,9 @@ private:
 	unsigned int nRootNodes;
 	luxrays::ocl::BVHArrayNode *bvhRootTree;
 
-	std::vector<const BVHAccel *> uniqueLeafs;
+	std::vector<BVHAccel *> uniqueLeafs;
+	// The index in uniqueLeafs of the BVH built for each mesh
+	LeafIndexByMeshMap uniqueLeafIndexByMesh;
 	std::vector<const Transform *> uniqueLeafsTransform;
 	std::vector<const MotionSystem *> uniqueLeafsMotionSystem;
 	
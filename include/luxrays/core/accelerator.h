@@ -22,6 +22,8 @@
 #include <string>
 #include <deque>
 
+#include <boost/unordered_set.hpp>
+
 #include "luxrays/luxrays.h"
 #include "luxrays/core/geometry/ray.h"
 #include "luxrays/core/trianglemesh.h"
@@ -49,8 +51,27 @@ public:
 	virtual void Init(const std::deque<const Mesh *> &meshes, const u_longlong totalVertexCount, const u_longlong totalTriangleCount) = 0;
 	virtual bool DoesSupportUpdate() const { return false; }
 	virtual void Update() { throw new std::runtime_error("Internal error in Accelerator::Update()"); }
+	// Replace the list of meshes. Only the meshes included in editedMeshes or
+	// not included in the previous list have to be rebuilt, the acceleration
+	// structures of all the others can be reused. The meshes included in
+	// deformedMeshes have only moved their vertices (the triangles are the
+	// same) so their acceleration structures can be refitted.
+	virtual bool DoesSupportMeshesUpdate() const { return false; }
+	virtual void UpdateMeshes(const std::deque<const Mesh *> &meshes,
+		const u_longlong totalVertexCount, const u_longlong totalTriangleCount,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes) {
+		throw std::runtime_error("Internal error in Accelerator::UpdateMeshes()");
+	}
 
 	virtual bool Intersect(const Ray *ray, RayHit *hit) const = 0;
+	// Intersect a batch of rays. The default implementation just calls
+	// Intersect() for each ray, accelerators able to trace packets or
+	// streams of rays override this method.
+	virtual void IntersectBatch(const Ray *rays, RayHit *hits, const size_t rayCount) const;
+	// Return true if the ray hits anything between mint and maxt. It can stop
+	// at the first hit found so it is cheaper than Intersect() for shadow rays.
+	virtual bool Occluded(const Ray *ray) const;
 
 	static std::string AcceleratorType2String(const AcceleratorType type);
 	static AcceleratorType String2AcceleratorType(const std::string &type);
@@ -0,0 +1,66 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#ifndef _LUXRAYS_BVHCACHE_H
+#define	_LUXRAYS_BVHCACHE_H
+
+#include <string>
+#include <deque>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "luxrays/luxrays.h"
+#include "luxrays/core/bvh/bvhbuild.h"
+
+namespace luxrays {
+
+/*
+ * A persistent cache of BVH trees stored in a directory. A tree is stored in
+ * a file named after a hash of the meshes vertices and triangles, of the
+ * build parameters and of the builder used so it can be reused by any later
+ * run working on the same data. Cached trees are memory mapped
+ * copy-on-write, so the pages are shared between all the processes using
+ * the same tree until they are modified (i.e. by a refit).
+ */
+
+class BVHCache {
+public:
+	BVHCache(const std::string &cacheDir);
+
+	// Returns the key identifying the tree built with the given arguments
+	static std::string GetKey(const BVHParams &params, const std::string &builderType,
+		const std::deque<const Mesh *> &meshes);
+
+	// Returns NULL if the tree is not in the cache. The returned tree points
+	// to the memory of the mapped file.
+	luxrays::ocl::BVHArrayNode *Load(const std::string &key, u_int *nNodes,
+		boost::iostreams::mapped_file *mappedFile) const;
+	// The tree is written to a temporary file and renamed so concurrent
+	// processes never read a partially written tree
+	void Save(const std::string &key, const luxrays::ocl::BVHArrayNode *bvhTree,
+		const u_int nNodes) const;
+
+private:
+	std::string GetFileName(const std::string &key) const;
+
+	const std::string cacheDir;
+};
+
+}
+
+#endif	/* _LUXRAYS_BVHCACHE_H */
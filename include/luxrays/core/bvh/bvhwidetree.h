@@ -0,0 +1,67 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#ifndef _LUXRAYS_BVHWIDETREE_H
+#define	_LUXRAYS_BVHWIDETREE_H
+
+#include <deque>
+
+#include "luxrays/luxrays.h"
+#include "luxrays/core/geometry/ray.h"
+#include "luxrays/core/bvh/bvhbuild.h"
+
+namespace luxrays {
+
+// Max. number of triangles stored in a single leaf of the wide tree
+#define BVHWIDETREE_MAX_LEAF_SIZE 4
+// Size of the traversal stack
+#define BVHWIDETREE_STACK_SIZE 1024
+
+//------------------------------------------------------------------------------
+// BVHWideTree
+//
+// A CPU only 4 or 8-ary version of a BVHArrayNode tree. Each node stores the
+// bounding boxes of all its children in SoA form so they can be tested with a
+// single set of SSE/AVX instructions. Leaves store up to
+// BVHWIDETREE_MAX_LEAF_SIZE triangles with their vertices already gathered.
+// The binary BVHArrayNode tree is still required by the OpenCL kernels.
+//------------------------------------------------------------------------------
+
+class BVHWideTree {
+public:
+	virtual ~BVHWideTree() { }
+
+	virtual u_int GetWidth() const = 0;
+	virtual size_t GetMemoryUsage() const = 0;
+
+	// Return true and fill rayHit if there is a hit between ray.mint and
+	// ray.maxt. The mesh index is relative to the list of meshes used to
+	// build the tree.
+	virtual bool Intersect(const Ray &ray, RayHit *rayHit) const = 0;
+	// Return true if there is any hit between ray.mint and ray.maxt
+	virtual bool Occluded(const Ray &ray) const = 0;
+
+	// Return NULL if the tree can not be converted (i.e. too many triangles,
+	// a too deep tree or nodes with more than width children)
+	static BVHWideTree *Build(const u_int width, const std::deque<const Mesh *> &meshes,
+		const luxrays::ocl::BVHArrayNode *bvhTree, const u_int nNodes);
+};
+
+}
+
+#endif	/* _LUXRAYS_BVHWIDETREE_H */
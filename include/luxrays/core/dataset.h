@@ -23,6 +23,7 @@
 #include <vector>
 
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
 #include "luxrays/luxrays.h"
 #include "luxrays/core/accelerator.h"
@@ -56,13 +57,23 @@ public:
 	const Accelerator *GetAccelerator(const AcceleratorType accelType);
 	bool DoesAllAcceleratorsSupportUpdate() const;
 	void UpdateAccelerators();
+	// Replace the list of meshes of a preprocessed DataSet and rebuild only
+	// the parts of the accelerators related to new or edited meshes (and
+	// refit the parts related to deformed meshes)
+	bool DoesAllAcceleratorsSupportMeshesUpdate() const;
+	void UpdateMeshes(const std::deque<const Mesh *> &meshes,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes);
 
 	const BBox &GetBBox() const { return bbox; }
 	const BSphere &GetBSphere() const { return bsphere; }
 
 	u_longlong GetTotalVertexCount() const { return totalVertexCount; }
 	u_longlong GetTotalTriangleCount() const { return totalTriangleCount; }
+	// The curve segments intersected as native curves (see ExtCurveMesh)
+	u_longlong GetTotalCurveSegmentCount() const { return totalCurveSegmentCount; }
 
+	const Context *GetContext() const { return context; }
 	u_int GetDataSetID() const { return dataSetID; }
 	bool IsEqual(const DataSet *dataSet) const;
 
@@ -70,12 +81,15 @@ public:
 	friend class OpenCLIntersectionDevice;
 
 private:
+	void AddMeshInfo(const Mesh *mesh);
+
 	u_int dataSetID;
 
 	const Context *context;
 
 	u_longlong totalVertexCount;
 	u_longlong totalTriangleCount;
+	u_longlong totalCurveSegmentCount;
 	std::deque<const Mesh *> meshes;
 
 	BBox bbox;
@@ -0,0 +1,103 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#ifndef _LUXRAYS_EXTCURVEMESH_H
+#define	_LUXRAYS_EXTCURVEMESH_H
+
+#include "luxrays/core/exttrianglemesh.h"
+
+namespace luxrays {
+
+/*
+ * A mesh of cubic Bezier curves (i.e. hair strands) intersected as native
+ * curves by the accelerators supporting them (i.e. Embree). The triangle
+ * part of the mesh is empty until Tessellate() is called to replace the
+ * curves with triangles, as required by all the other accelerators.
+ *
+ * The hit points on curves have the segment index as triangle index and
+ * the curve parameter of the segment as first barycentric coordinate.
+ */
+
+class ExtCurveMesh : public ExtTriangleMesh {
+public:
+	// curveVertices has 4 floats (x, y, z, radius) for each Bezier control
+	// point and curveSegments the index of the first of the 4 control points
+	// of each segment (this is the layout used by Embree). segmentPoints
+	// has, for each segment, the index of the strand point where the segment
+	// starts (the segment ends at the next point): the optional point UVs,
+	// colors and alphas are interpolated along the segment.
+	ExtCurveMesh(const u_int curveVertCount, const u_int curveSegmentCount,
+			float *curveVertices, u_int *curveSegments, u_int *segmentPoints,
+			UV *pointUVs = NULL, Spectrum *pointCols = NULL, float *pointAlphas = NULL);
+	virtual ~ExtCurveMesh() { }
+	virtual void Delete();
+
+	virtual BBox GetBBox() const;
+	virtual void ApplyTransform(const Transform &trans);
+
+	virtual ExtCurveMesh *GetCurveMesh() const {
+		return tessellated ? NULL : const_cast<ExtCurveMesh *>(this);
+	}
+
+	virtual void WritePly(const std::string &fileName) const;
+	virtual void WriteBinary(const std::string &fileName) const;
+
+	bool IsTessellated() const { return tessellated; }
+	// Replaces the curves with the triangles returned by TessellateCurves()
+	void Tessellate();
+
+	u_int GetCurveVertexCount() const { return curveVertCount; }
+	u_int GetCurveSegmentCount() const { return curveSegmentCount; }
+	const float *GetCurveVertices() const { return curveVertices; }
+	const u_int *GetCurveSegments() const { return curveSegments; }
+
+	// All the following methods work in the mesh local space. The curves are
+	// intersected as ribbons facing the ray direction but they are shaded
+	// as tubes. The normals point outside the tube, so they face the ray only
+	// if rayStart (the point where the ray segment starts) is outside.
+	void GetCurveHitGeometry(const u_int segmentIndex, const float u,
+		const Point &hitPoint, const Point &rayStart, const Vector &rayDir,
+		Normal *geometryN, Normal *shadeN, Vector *dpdu, Vector *dpdv) const;
+	UV InterpolateCurveUV(const u_int segmentIndex, const float u) const;
+	Spectrum InterpolateCurveColor(const u_int segmentIndex, const float u) const;
+	float InterpolateCurveAlpha(const u_int segmentIndex, const float u) const;
+
+protected:
+	// Returns the buffers of the triangle mesh replacing the curves
+	virtual void TessellateCurves(u_int *meshVertCount, u_int *meshTriCount,
+		Point **meshVertices, Triangle **meshTris, Normal **meshNormals, UV **meshUVs,
+		Spectrum **meshCols, float **meshAlphas) const = 0;
+
+	// Returns a new mesh with a temporary tessellation of the curves
+	ExtTriangleMesh *AllocTessellatedMesh() const;
+	void DeleteCurves();
+
+	u_int curveVertCount, curveSegmentCount;
+	float *curveVertices;
+	u_int *curveSegments;
+	u_int *segmentPoints;
+	UV *pointUVs;
+	Spectrum *pointCols;
+	float *pointAlphas;
+
+	bool tessellated;
+};
+
+}
+
+#endif	/* _LUXRAYS_EXTCURVEMESH_H */
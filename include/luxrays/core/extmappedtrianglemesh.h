@@ -0,0 +1,80 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#ifndef _LUXRAYS_EXTMAPPEDTRIANGLEMESH_H
+#define	_LUXRAYS_EXTMAPPEDTRIANGLEMESH_H
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "luxrays/core/exttrianglemesh.h"
+
+namespace luxrays {
+
+/*
+ * The LuxRays binary mesh file format (.lxm): a header followed by the raw
+ * mesh arrays, in native byte order and aligned to LXM_ALIGNMENT bytes, so
+ * a file can be memory mapped and used without any parsing. The vertices
+ * array includes the float padding required by Embree (see
+ * TriangleMesh::AllocVerticesBuffer()).
+ */
+
+#define LXM_MAGIC "LXMESH\0\0"
+#define LXM_VERSION 1u
+#define LXM_BYTE_ORDER_MARK 0x01020304u
+#define LXM_ALIGNMENT 64u
+#define LXM_FILE_EXTENSION ".lxm"
+
+typedef struct {
+	char magic[8];
+	u_int version;
+	u_int byteOrderMark;
+	u_int vertCount, triCount;
+	// The offset from the begin of the file of each array, 0 if the
+	// array is not available
+	u_longlong verticesOffset, trisOffset, normalsOffset, uvsOffset,
+		colsOffset, alphasOffset;
+} LxmHeader;
+
+/*
+ * An ExtTriangleMesh using the arrays of a memory mapped .lxm file. The file
+ * is mapped copy-on-write: the pages are shared with all the other processes
+ * mapping the same file until they are modified (i.e. by ApplyTransform()).
+ */
+
+class ExtMappedTriangleMesh : public ExtTriangleMesh {
+public:
+	virtual ~ExtMappedTriangleMesh() { }
+	// Frees only the arrays not stored in the mapped file (i.e. the triangle
+	// normals) and unmaps the file
+	virtual void Delete();
+
+	static bool IsLxmFile(const std::string &fileName);
+	static ExtMappedTriangleMesh *Load(const std::string &fileName);
+	static void Write(const std::string &fileName, const ExtTriangleMesh &mesh);
+
+protected:
+	ExtMappedTriangleMesh(const boost::iostreams::mapped_file &file, const LxmHeader &header);
+
+	bool IsMapped(const void *p) const;
+
+	boost::iostreams::mapped_file mappedFile;
+};
+
+}
+
+#endif	/* _LUXRAYS_EXTMAPPEDTRIANGLEMESH_H */
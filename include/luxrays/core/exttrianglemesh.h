@@ -36,6 +36,8 @@
 
 namespace luxrays {
 
+class ExtCurveMesh;
+
 /*
  * The inheritance scheme used here:
  * 
@@ -89,8 +91,17 @@ public:
 	virtual void Sample(const float time, const u_int triIndex, const float u0, const float u1,
 		Point *p, float *b0, float *b1, float *b2) const = 0;
 
+	// Returns the curve mesh (see ExtCurveMesh) used by this mesh if its
+	// curves have not been tessellated, NULL otherwise
+	virtual ExtCurveMesh *GetCurveMesh() const { return NULL; }
+
 	virtual void Delete() = 0;
 	virtual void WritePly(const std::string &fileName) const = 0;
+	// Writes the mesh in the LuxRays binary format (see ExtMappedTriangleMesh)
+	virtual void WriteBinary(const std::string &fileName) const = 0;
+	// Uses WriteBinary() for file names with the .lxm extension, WritePly()
+	// otherwise
+	void Save(const std::string &fileName) const;
 };
 
 class ExtTriangleMesh : public TriangleMesh, public ExtMesh {
@@ -113,6 +124,11 @@ public:
 
 	virtual MeshType GetType() const { return TYPE_EXT_TRIANGLE; }
 
+	Normal *GetNormals() const { return normals; }
+	UV *GetUVs() const { return uvs; }
+	Spectrum *GetCols() const { return cols; }
+	float *GetAlphas() const { return alphas; }
+
 	virtual bool HasNormals() const { return normals != NULL; }
 	virtual bool HasUVs() const { return uvs != NULL; }
 	virtual bool HasColors() const { return cols != NULL; }
@@ -185,6 +201,7 @@ public:
 	}
 
 	virtual void WritePly(const std::string &fileName) const;
+	virtual void WriteBinary(const std::string &fileName) const;
 
 	ExtTriangleMesh *Copy(Point *meshVertices, Triangle *meshTris, Normal *meshNormals, UV *meshUV,
 			Spectrum *meshCols, float *meshAlpha) const;
@@ -192,9 +209,16 @@ public:
 		return Copy(NULL, NULL, NULL, NULL, NULL, NULL);
 	}
 
+	// Returns true if the mesh has the same triangles and the same vertex
+	// attributes of this one (i.e. it is a deformed version of this mesh)
+	bool HasSameTopology(const ExtTriangleMesh &mesh) const;
+	// Swaps the vertex and triangle arrays with the ones of mesh, it is used
+	// to update a mesh in place with the data of a mesh with the same topology
+	void SwapData(ExtTriangleMesh &mesh);
+
 	static ExtTriangleMesh *LoadExtTriangleMesh(const std::string &fileName);
 
-private:
+protected:
 	void Preprocess();
 
 	Normal *normals; // Vertices normals
@@ -284,7 +308,10 @@ public:
 		*p *= trans;
 	}
 
+	virtual ExtCurveMesh *GetCurveMesh() const { return ((ExtTriangleMesh *)mesh)->GetCurveMesh(); }
+
 	virtual void WritePly(const std::string &fileName) const { ((ExtTriangleMesh *)mesh)->WritePly(fileName); }
+	virtual void WriteBinary(const std::string &fileName) const { ((ExtTriangleMesh *)mesh)->WriteBinary(fileName); }
 
 	virtual void ApplyTransform(const Transform &t) {
 		InstanceTriangleMesh::ApplyTransform(t);
@@ -390,7 +417,10 @@ public:
 		*p *= motionSystem.Sample(time);
 	}
 
+	virtual ExtCurveMesh *GetCurveMesh() const { return ((ExtTriangleMesh *)mesh)->GetCurveMesh(); }
+
 	virtual void WritePly(const std::string &fileName) const { ((ExtTriangleMesh *)mesh)->WritePly(fileName); }
+	virtual void WriteBinary(const std::string &fileName) const { ((ExtTriangleMesh *)mesh)->WriteBinary(fileName); }
 
 	virtual void ApplyTransform(const Transform &t) {
 		MotionTriangleMesh::ApplyTransform(t);
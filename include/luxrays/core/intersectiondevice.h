@@ -102,6 +102,11 @@ public:
 		return accel->Intersect(ray, rayHit);
 	}
 
+	virtual bool TraceOccludedRay(const Ray *ray) {
+		statsTotalSerialRayCount += 1.0;
+		return accel->Occluded(ray);
+	}
+
 	friend class Context;
 	friend class VirtualIntersectionDevice;
 
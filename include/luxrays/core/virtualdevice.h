@@ -65,6 +65,13 @@ public:
 		return realDevices[traceRayRealDeviceIndex]->TraceRay(ray, rayHit);
 	}
 
+	virtual bool TraceOccludedRay(const Ray *ray) {
+		statsTotalSerialRayCount += 1.0;
+
+		traceRayRealDeviceIndex = (traceRayRealDeviceIndex + 1) % realDevices.size();
+		return realDevices[traceRayRealDeviceIndex]->TraceOccludedRay(ray);
+	}
+
 	//--------------------------------------------------------------------------
 	// Statistics
 	//--------------------------------------------------------------------------
@@ -329,6 +329,11 @@ public:
 	 * \brief Initialize the property from a string (ex. "a.b.c = 1 2")
 	 */
 	void FromString(std::string &s);
+	/*!
+	 * \brief Initialize the property from a range of characters (ex.
+	 * "a.b.c = 1 2") without any intermediate copy of the text.
+	 */
+	void FromString(const char *begin, const char *end);
 	/*!
 	 * \brief Returns a string with the name of the property followed by " = "
 	 * and by all values associated to the property.
@@ -497,11 +502,12 @@ inline std::ostream &operator<<(std::ostream &os, const Property &p) {
  * \brief A container for multiple Property.
  *
  * Properties is a container for instances of Property class. It keeps also
- * track of the insertion order.
+ * track of the insertion order. The queries by prefix are O(log n) plus the
+ * size of the result (which is always returned in insertion order).
  */
 CPP_EXPORT class CPP_API Properties {
 public:
-	Properties() { }
+	Properties() : nextInsertionIndex(0) { }
 	/*!
 	 * \brief Sets the list of Property from a text file .
 	 * 
@@ -709,9 +715,22 @@ public:
 	std::string ToString() const;
 
 private:
+	typedef std::map<std::string, std::pair<unsigned long long, Property> > PropertiesMap;
+
+	void GetRange(const std::string &prefix, PropertiesMap::const_iterator &begin,
+		PropertiesMap::const_iterator &end) const;
+	std::vector<std::string> GetSortedNames(const PropertiesMap::const_iterator &begin,
+		const PropertiesMap::const_iterator &end) const;
+
 	// This vector is used, among other things, to keep track of the insertion order
 	std::vector<std::string> names;
-	std::map<std::string, Property> props;
+	// The insertion index of each name (sorted, used to find a name in the
+	// vector above with a binary search)
+	std::vector<unsigned long long> nameIndices;
+	// The map is sorted by name so all Property with the same prefix are a
+	// contiguous range. It stores the insertion index of each Property too.
+	PropertiesMap props;
+	unsigned long long nextInsertionIndex;
 };
 
 CPP_EXPORT CPP_API Properties operator<<(const Property &prop0, const Property &prop1);
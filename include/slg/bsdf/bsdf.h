@@ -48,14 +48,15 @@ public:
 	// A BSDF initialized from a ray hit
 	BSDF(const bool fixedFromLight, const Scene &scene, const luxrays::Ray &ray,
 		const luxrays::RayHit &rayHit, const float passThroughEvent,
-		const PathVolumeInfo *volInfo) {
+		const PathVolumeInfo *volInfo, const float footprint = 0.f) {
 		assert (!rayHit.Miss());
-		Init(fixedFromLight, scene, ray, rayHit, passThroughEvent, volInfo);
+		Init(fixedFromLight, scene, ray, rayHit, passThroughEvent, volInfo, footprint);
 	}
-	// Used when hitting a surface
+	// Used when hitting a surface. footprint is the value of
+	// HitPoint::footprint (see PathFootprint).
 	void Init(const bool fixedFromLight, const Scene &scene, const luxrays::Ray &ray,
 		const luxrays::RayHit &rayHit, const float passThroughEvent,
-		const PathVolumeInfo *volInfo);
+		const PathVolumeInfo *volInfo, const float footprint = 0.f);
 	// Used when hitting a volume scatter point
 	void Init(const bool fixedFromLight, const Scene &scene, const luxrays::Ray &ray,
 		const Volume &volume, const float t, const float passThroughEvent);
@@ -95,6 +96,10 @@ public:
 	luxrays::Spectrum GetEmittedRadiance(float *directPdfA = NULL, float *emissionPdfW = NULL) const ;
 
 	const LightSource *GetLightSource() const { return triangleLightSource; }
+	// The normal of the side of the surface receiving the light or a null
+	// normal if the light can arrive from any direction. It is used by the
+	// light strategies to skip the light sources behind the surface.
+	luxrays::Normal GetLightSamplingNormal() const;
 
 	HitPoint hitPoint;
 
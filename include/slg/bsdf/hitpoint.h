@@ -53,6 +53,9 @@ typedef struct {
 	// computation and scene default world volume)
 	const Volume *interiorVolume, *exteriorVolume;
 	bool fromLight, intoObject;
+	// An estimation of the size of the area seen by a pixel at this point, in
+	// world units (0 if unknown). It is used to filter MIP-mapped textures.
+	float footprint;
 
 	luxrays::Frame GetFrame() const { return luxrays::Frame(dpdu, dpdv, shadeN); }
 } HitPoint;
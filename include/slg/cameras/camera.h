@@ -85,6 +85,12 @@ public:
 	virtual bool SampleLens(const float time, const float u1, const float u2,
 		luxrays::Point *lensPoint) const = 0;
 	virtual float GetPDF(const luxrays::Vector &eyeDir, const float filmX, const float filmY) const = 0;
+	// An estimation of the size (in world units) of the area seen by a pixel
+	// at the distance t along a camera ray: width + spread * t (0 if unknown)
+	virtual void GetPixelFootprint(float *width, float *spread) const {
+		*width = 0.f;
+		*spread = 0.f;
+	}
 
 	virtual luxrays::Properties ToProperties() const;
 
@@ -102,6 +102,7 @@ public:
 	virtual bool SampleLens(const float time, const float u1, const float u2,
 		luxrays::Point *lensPoint) const;
 	virtual float GetPDF(const luxrays::Vector &eyeDir, const float filmX, const float filmY) const;
+	virtual void GetPixelFootprint(float *width, float *spread) const;
 
 	virtual luxrays::Properties ToProperties() const;
 
@@ -80,11 +80,15 @@ protected:
 		const float u0, const float u1, const float u2,
 		const float u3, const float u4,
 		const PathVertexVM &eyeVertex, SampleResult &eyeSampleResult) const;
+	// lastHitPoint and lastLightSamplingN are the ones of the eye path vertex
+	// where the last direct light sampling was done
 	void DirectHitLight(const bool finiteLightSource,
-		const PathVertexVM &eyeVertex, SampleResult &eyeSampleResult) const;
+		const PathVertexVM &eyeVertex, const luxrays::Point &lastHitPoint,
+		const luxrays::Normal &lastLightSamplingN, SampleResult &eyeSampleResult) const;
 	void DirectHitLight(const LightSource *light, const luxrays::Spectrum &lightRadiance,
 		const float directPdfA, const float emissionPdfW,
-		const PathVertexVM &eyeVertex, luxrays::Spectrum *radiance) const;
+		const PathVertexVM &eyeVertex, const luxrays::Point &lastHitPoint,
+		const luxrays::Normal &lastLightSamplingN, luxrays::Spectrum *radiance) const;
 
 	void ConnectVertices(const float time,
 		const PathVertexVM &eyeVertex, const PathVertexVM &BiDirVertex,
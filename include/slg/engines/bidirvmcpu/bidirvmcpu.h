@@ -31,6 +31,9 @@ namespace slg {
 class BiDirVMCPURenderEngine;
 class BiDirVMCPURenderThread;
 
+// The light path vertices are sorted by cell with a counting sort. Their
+// positions are stored in separate (SoA) arrays, so the merge radius test can
+// check 4 vertices at time before touching the full PathVertexVM.
 class HashGrid {
 public:
 	HashGrid() { }
@@ -47,22 +50,12 @@ public:
 
 private:
 	void Process(const BiDirVMCPURenderThread *thread,
-		const PathVertexVM &eyeVertex, const int i0, const int i1,
+		const PathVertexVM &eyeVertex, const u_int cellIndex,
 		luxrays::Spectrum *radiance) const;
 	void Process(const BiDirVMCPURenderThread *thread,
 		const PathVertexVM &eyeVertex, const PathVertexVM *lightVertex,
 		luxrays::Spectrum *radiance) const;
 
-	void HashRange(const u_int i, int *i0, int *i1) const {
-		if (i == 0) {
-			*i0 = 0;
-			*i1 = cellEnds[0];
-		} else {
-			*i0 = cellEnds[i - 1];
-			*i1 = cellEnds[i];
-		}
-	}
-
 	u_int Hash(const int ix, const int iy, const int iz) const {
 		return (u_int)((ix * 73856093) ^ (iy * 19349663) ^ (iz * 83492791)) % gridSize;
 	}
@@ -82,8 +75,13 @@ private:
 	luxrays::BBox vertexBBox;
 	u_int vertexCount;
 
+	// The cell of each vertex, in the order of Build() input
+	vector<u_int> vertexCells;
+	// All the following arrays are sorted by cell
 	vector<const PathVertexVM *> lightVertices;
-    vector<int> cellEnds;
+	vector<float> vertexX, vertexY, vertexZ;
+	// The vertices of cell i are in the range [cellStarts[i], cellStarts[i + 1])
+	vector<u_int> cellStarts;
 
 	// Statistics
 	//mutable u_int mergeHitsV2V; // merge Volume with Volume path vertex
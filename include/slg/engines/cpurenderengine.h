@@ -113,7 +113,10 @@ public:
 protected:
 	virtual void StartRenderThread();
 
+	// The film where the thread accumulates samples: its own film or the
+	// engine film if it is shared among all threads
 	Film *threadFilm;
+	bool useSharedFilm;
 };
 
 class CPUNoTileRenderEngine : public CPURenderEngine {
@@ -131,11 +134,20 @@ public:
 protected:
 	static const luxrays::Properties &GetDefaultProps();
 
+	virtual void EndSceneEditLockLess(const EditActionList &editActions);
 	virtual void UpdateFilmLockLess();
 	virtual void UpdateCounters();
 
+	// Engines with render threads writing directly to the engine film
+	// without synchronization have to return false
+	virtual bool IsSharedFilmSupported() const { return true; }
+
 	SamplerSharedData *samplerSharedData;
 
+	// If true, all render threads accumulate samples directly in the engine
+	// film (in thread safe mode) instead of having a film each. The memory
+	// usage is O(film) instead of O(threads x film).
+	bool useSharedFilm;
 	bool hasStartFilm;
 };
 
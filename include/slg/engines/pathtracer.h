@@ -26,6 +26,7 @@
 #include "slg/film/filmsamplesplatter.h"
 #include "slg/bsdf/bsdf.h"
 #include "slg/utils/pathdepthinfo.h"
+#include "slg/utils/pathfootprint.h"
 
 namespace slg {
 
@@ -83,6 +84,7 @@ private:
 	void DirectHitFiniteLight(const Scene *scene, 
 			const BSDFEvent lastBSDFEvent, const luxrays::Spectrum &pathThrouput,
 			const float distance, const BSDF &bsdf, const float lastPdfW,
+			const luxrays::Point &lastHitPoint, const luxrays::Normal &lastLightSamplingN,
 			SampleResult *sampleResult) const;
 	void DirectHitInfiniteLight(const Scene *scene,
 			const BSDFEvent lastBSDFEvent, const luxrays::Spectrum &pathThrouput,
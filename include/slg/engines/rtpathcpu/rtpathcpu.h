@@ -93,6 +93,8 @@ protected:
 	virtual void EndFilmEdit(Film *flm);
 
 	virtual void UpdateFilmLockLess();
+	// Render threads already use directly the engine Film
+	virtual bool IsSharedFilmSupported() const { return false; }
 
 	void PauseThreads();
 	void ResumeThreads();
@@ -53,6 +53,7 @@ protected:
 	void UpdateOCLBuffers(const EditActionList &updateActions);
 
 	TileRepository::Tile *tile;
+	u_int tileRound;
 };
 
 //------------------------------------------------------------------------------
@@ -20,6 +20,8 @@
 #define	_SLG_TILEREPOSITORY_H
 
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/atomic.hpp>
 #include <boost/serialization/version.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/deque.hpp>
@@ -56,6 +58,7 @@ public:
 		u_int xStart, yStart, tileWidth, tileHeight;
 		u_int pass;
 		float error;
+		// Written and read only with tileMutex locked
 		bool done;
 
 		friend class boost::serialization::access;
@@ -76,6 +79,17 @@ public:
 
 		float allPassFilmTotalYValue;
 		bool hasEnoughWarmUpSample;
+
+		// Used by TileRepository to serialize the passes added by the
+		// threads rendering the same tile
+		boost::mutex tileMutex;
+		// The number of threads currently rendering this tile
+		boost::atomic<u_int> renderingCount;
+		// The last round including the tile and the last round where a pass
+		// of the tile has been completed
+		u_int scheduledRound, completedRound;
+
+		friend class TileRepository;
 	};
 
 	TileRepository(const u_int tileWidth, const u_int tileHeight);
@@ -88,8 +102,16 @@ public:
 	void GetConvergedTiles(std::deque<const Tile *> &tiles);
 
 	void InitTiles(const Film &film);
+	// Adds the pass rendered in tileFilm (if *tile is not NULL) and returns
+	// the next tile to render with the round it has been taken from.
+	// threadIndex selects the work queue used before stealing tiles from
+	// the other queues.
 	bool NextTile(Film *film, boost::mutex *filmMutex,
-		Tile **tile, Film *tileFilm);
+		Tile **tile, u_int *tileRound, Film *tileFilm, const u_int threadIndex = 0);
+	// Adds the pass rendered in tileFilm to the tile and to the film. The
+	// pass is counted for the round only if tileRound is the current round.
+	void MergeTile(Film *film, boost::mutex *filmMutex,
+		Tile *tile, const u_int tileRound, Film *tileFilm);
 
 	static luxrays::Properties ToProperties(const luxrays::Properties &cfg);
 	static TileRepository *FromProperties(const luxrays::Properties &cfg);
@@ -117,11 +139,37 @@ private:
 	template<class Archive>	void load(Archive &ar, const unsigned int version);
 	BOOST_SERIALIZATION_SPLIT_MEMBER()
 
-	class CompareTilesPtr {
+	// A range of the round tiles: the owner thread takes the tiles from the
+	// front while the other threads steal them from the back. Both ends and
+	// the round the range belongs to are packed in a single word updated
+	// with a CAS so no lock is required.
+	class TileWorkQueue {
 	public:
-		bool operator()(const TileRepository::Tile *lt, const TileRepository::Tile *rt) const {
-			return lt->pass > rt->pass;
+		TileWorkQueue() : range(0) { }
+
+		void Reset(const u_int round, const u_int first, const u_int last) { range = Pack(round, first, last); }
+		// Return the popped index and the low bits of its round
+		bool PopFront(u_int *roundTag, u_int *index);
+		bool PopBack(u_int *roundTag, u_int *index);
+
+		static u_int RoundTag(const u_int round) { return round & 0xffffu; }
+		static const u_int MAX_TILE_COUNT = 0xffffffu;
+
+	private:
+		// 16 bits for the round and 24 bits for each end of the range
+		static unsigned long long Pack(const u_int round, const u_int first, const u_int last) {
+			return (static_cast<unsigned long long>(RoundTag(round)) << 48) |
+					(static_cast<unsigned long long>(first) << 24) | last;
+		}
+		static void Unpack(const unsigned long long r, u_int *roundTag, u_int *first, u_int *last) {
+			*roundTag = static_cast<u_int>(r >> 48);
+			*first = static_cast<u_int>(r >> 24) & MAX_TILE_COUNT;
+			*last = static_cast<u_int>(r) & MAX_TILE_COUNT;
 		}
+
+		boost::atomic<unsigned long long> range;
+		// Avoid false sharing between the queues
+		char padding[64 - sizeof(boost::atomic<unsigned long long>)];
 	};
 
 	void HilberCurveTiles(
@@ -131,22 +179,35 @@ private:
 		const int xEnd, const int yEnd);
 
 	void SetDone();
-	bool GetToDoTile(Tile **tile);
-
+	void InitWorkQueues();
+	void RestartTiles(const u_int pass);
+	void StartRound(const std::vector<Tile *> &tiles);
+	bool StartNextRound();
+	bool PopTile(const u_int threadIndex, Tile **tile, u_int *tileRound);
+	bool GetPendingNotDoneTile(const u_int round, Tile **tile, u_int *tileRound);
+
+	// Used only to start a new round and for the other infrequent operations
 	mutable boost::mutex tileMutex;
+	// Signaled, with tileMutex, at the end and at the start of a round
+	boost::condition_variable roundCondition;
 	double startTime;
 
 	u_int filmRegionWidth, filmRegionHeight;
 	float filmTotalYValue; // Updated only if convergence test is enabled
 
+	// All tiles in Hilbert curve order
 	std::vector<Tile *> tileList;
 
-	boost::heap::priority_queue<Tile *,
-			boost::heap::compare<CompareTilesPtr>,
-			boost::heap::stable<true>
-		> todoTiles;
-	std::deque<Tile *> pendingTiles;
-	std::deque<Tile *> convergedTiles;
+	// A round is a pass over all the not yet converged tiles: they are
+	// split, in Hilbert curve order, between the work queues. The array is
+	// allocated only when the tile list changes, so a thread holding an
+	// index of a past round can still read it and discard the tile.
+	boost::atomic<Tile *> *roundTiles;
+	u_int roundTilesCapacity;
+	std::vector<TileWorkQueue *> workQueues;
+	boost::atomic<u_int> roundIndex;
+	// The number of round tiles without a completed pass
+	boost::atomic<u_int> roundPendingCount;
 };
 
 }
@@ -28,6 +28,7 @@
 #include <vector>
 #include <set>
 
+#include <boost/atomic.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/serialization/version.hpp>
 #include <boost/serialization/vector.hpp>
@@ -42,6 +43,7 @@
 #include "luxrays/core/oclintersectiondevice.h"
 #include "luxrays/utils/oclcache.h"
 #include "luxrays/utils/properties.h"
+#include "luxrays/utils/atomic.h"
 #include "slg/slg.h"
 #include "slg/bsdf/bsdf.h"
 #include "slg/film/imagepipeline/imagepipeline.h"
@@ -57,6 +59,7 @@ namespace slg {
 //------------------------------------------------------------------------------
 
 class SampleResult;
+class ChunkFileWriter;
 
 class Film {
 public:
@@ -188,8 +191,16 @@ public:
 	void AddFilm(const Film &film) {
 		AddFilm(film, 0, 0, width, height, 0, 0);
 	}
+	// Set this film to the sum of all the given films (all with the same
+	// size of this one). Only the rows modified in the source films since the
+	// last call are merged again and the work is done in parallel across rows.
+	// It assumes to be the only consumer of the source films dirty rows.
+	void MergeFilms(const std::vector<Film *> &films);
 
 	u_int GetChannelCount(const FilmChannelType type) const;
+	// Returns the size (in float or u_int) of a channel buffer, 0 if the
+	// channel is not available
+	size_t GetChannelSize(const FilmChannelType type) const;
 	size_t GetOutputSize(const FilmOutputs::FilmOutputType type) const;
 	bool HasOutput(const FilmOutputs::FilmOutputType type) const;
 	void Output();
@@ -214,7 +225,7 @@ public:
 	u_int GetHeight() const { return height; }
 	const u_int *GetSubRegion() const { return subRegion; }
 	double GetTotalSampleCount() const {
-		return statsTotalSampleCount;
+		return statsTotalSampleCount + statsPendingSampleCount;
 	}
 	double GetTotalTime() const {
 		return luxrays::WallClockTime() - statsStartSampleTime;
@@ -232,14 +243,44 @@ public:
 	void ResetConvergenceTest();
 	u_int RunConvergenceTest(const float threshold);
 
+	// The noise map is updated by the convergence test and it is used by
+	// adaptive samplers to distribute the samples where the error is higher.
+	// When the update flag is set, the render engine runs the convergence
+	// test even if no halt threshold has been defined.
+	void SetNoiseMapUpdate(const bool update) { noiseMapUpdate = update; }
+	bool IsNoiseMapUpdate() const { return noiseMapUpdate; }
+	u_int GetNoiseMapVersion() const;
+	// Return the noise map of the film sub-region reduced to blocks of
+	// blockSize x blockSize pixels
+	void GetNoiseMap(const u_int blockSize, std::vector<float> &map,
+		u_int *mapWidth, u_int *mapHeight) const;
+
 	//--------------------------------------------------------------------------
 
 	void SetSampleCount(const double count) {
 		statsTotalSampleCount = count;
+		statsPendingSampleCount = 0;
 	}
 	void AddSampleCount(const double count) {
-		statsTotalSampleCount += count;
+		if (rowLocks) {
+			// Only whole samples are counted in thread safe mode
+			statsPendingSampleCount += (u_longlong)count;
+		} else
+			statsTotalSampleCount += count;
 	}
+	// Move the samples counted in thread safe mode to the total count. It
+	// must not be called by multiple threads at the same time.
+	void FlushSampleCount();
+
+	// In thread safe mode, multiple threads can call AddSample*() and
+	// AddSampleCount() on the same film at the same time: each film row is
+	// protected by its own lock. It is used by render engines sharing a
+	// single film among all render threads.
+	void SetThreadSafeAddSample(const bool enable);
+	bool IsThreadSafeAddSample() const { return threadSafeAddSample; }
+	// The lock of the film row in thread safe mode, NULL otherwise. It has
+	// to be held to read the pixels while the other threads add samples.
+	boost::mutex *GetRowLock(const u_int y) const { return rowLocks ? &rowLocks[y] : NULL; }
 
 	void AddSample(const u_int x, const u_int y,
 		const SampleResult &sampleResult, const float weight = 1.f);
@@ -308,8 +349,15 @@ public:
 	cl::Kernel *notOverlappedScreenBufferUpdateKernel;
 #endif
 
+	// Films are saved in the chunk file format. The old gzip compressed
+	// archive format can still be loaded.
 	static Film *LoadSerialized(const std::string &fileName);
 	static void SaveSerialized(const std::string &fileName, const Film *film);
+	// Returns a copy of the film ready to be written. The film is only read:
+	// samples added by other threads while the snapshot is taken may be
+	// partially included.
+	static ChunkFileWriter *AllocSerializedSnapshot(const Film *film,
+		const bool compress = true);
 
 	static luxrays::Properties ToProperties(const luxrays::Properties &cfg);
 
@@ -327,6 +375,22 @@ private:
 	BOOST_SERIALIZATION_SPLIT_MEMBER()
 
 	void FreeChannels();
+	void AllocRowLocks();
+	void FreeRowLocks();
+	void AllocDirtyRows();
+	void FreeDirtyRows();
+	void SetRowDirty(const u_int y) {
+		dirtyRows[y].store(1, boost::memory_order_release);
+	}
+	void ResetRows(const u_int rowStart, const u_int rowCount);
+	void AddFilmChannels(const Film &film,
+		const u_int srcOffsetX, const u_int srcOffsetY,
+		const u_int srcWidth, const u_int srcHeight,
+		const u_int dstOffsetX, const u_int dstOffsetY);
+	void AddSampleResultColorLockLess(const u_int x, const u_int y,
+		const SampleResult &sampleResult, const float weight);
+	void AddSampleResultDataLockLess(const u_int x, const u_int y,
+		const SampleResult &sampleResult);
 	void MergeSampleBuffers(const u_int index);
 	void GetPixelFromMergedSampleBuffers(const u_int index, float *c) const;
 	void GetPixelFromMergedSampleBuffers(const u_int x, const u_int y, float *c) const {
@@ -359,9 +423,24 @@ private:
 	bool hasDataChannel, hasComposingChannel;
 
 	double statsTotalSampleCount, statsStartSampleTime, statsAvgSampleSec;
+	// The samples counted in thread safe mode and not yet flushed
+	boost::atomic<u_longlong> statsPendingSampleCount;
+
+	// One lock for each film row, NULL if thread safe mode is disabled
+	boost::mutex *rowLocks;
+	bool threadSafeAddSample;
+
+	// One flag for each film row, set (with release semantic) after the row
+	// has been modified and cleared (with acquire semantic) by MergeFilms()
+	// before reading the row. A row is the smallest tracked unit: samplers
+	// scattering samples over the whole image (i.e. SOBOL and RANDOM) mark
+	// every row at each pass, so MergeFilms() can only save work with
+	// samplers writing a part of the image at a time.
+	boost::atomic<u_char> *dirtyRows;
 
 	std::vector<ImagePipeline *> imagePipelines;
 	FilmConvTest *convTest;
+	bool noiseMapUpdate;
 
 	std::vector<RadianceChannelScale> radianceChannelScales;
 	FilmOutputs filmOutputs;
@@ -19,6 +19,10 @@
 #ifndef _SLG_FILMCONVTEST_H
 #define	_SLG_FILMCONVTEST_H
 
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/serialization/version.hpp>
 
 #include "eos/portable_oarchive.hpp"
@@ -42,7 +46,15 @@ public:
 
 	void Reset();
 	u_int Test(const float threshold);
-	
+
+	// The noise map holds, for each pixel, the error measured by the last
+	// test. The version is incremented each time the map changes.
+	u_int GetNoiseMapVersion() const { return noiseMapVersion; }
+	// Copy the noise map of the given region reduced to blocks of
+	// blockSize x blockSize pixels (the max. error of each block is used)
+	void GetNoiseMap(const u_int *region, const u_int blockSize,
+		std::vector<float> &map, u_int *mapWidth, u_int *mapHeight) const;
+
 	u_int todoPixelsCount;
 	float maxError;
 	
@@ -62,6 +74,11 @@ private:
 
 	GenericFrameBuffer<3, 0, float> *referenceImage;
 	bool firstTest;
+
+	// Not serialized, it is rebuilt by the next tests
+	GenericFrameBuffer<1, 0, float> *noiseMap;
+	mutable boost::mutex noiseMapMutex;
+	boost::atomic<u_int> noiseMapVersion;
 };
 
 }
@@ -20,11 +20,28 @@
 #define	_SLG_FRAMEBUFFER_H
 
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/thread/tss.hpp>
 
 #include "luxrays/utils/utils.h"
 
 namespace slg {
 
+// While an instance of this class exists, the frame buffers serialized by the
+// current thread are saved without pixels (i.e. the film serialization stores
+// them outside of the archive). The frame buffers are not modified so other
+// threads can keep writing to them in the meantime.
+class FrameBufferSkipPixelsSerialization {
+public:
+	FrameBufferSkipPixelsSerialization() { skipPixels.reset(new bool(true)); }
+	~FrameBufferSkipPixelsSerialization() { skipPixels.reset(); }
+
+	static bool IsSkippingPixels() { return skipPixels.get() && *skipPixels; }
+
+private:
+	static boost::thread_specific_ptr<bool> skipPixels;
+};
+
 template<u_int CHANNELS, u_int WEIGHT_CHANNELS, class T> class GenericFrameBuffer {
 public:
 	GenericFrameBuffer(const u_int w, const u_int h)
@@ -35,6 +52,11 @@ public:
 	void Clear(const T value = 0) {
 		std::fill(pixels.begin(), pixels.begin() + width * height * CHANNELS, value);
 	};
+
+	void ClearRows(const u_int rowStart, const u_int rowCount, const T value = 0) {
+		std::fill(pixels.begin() + rowStart * width * CHANNELS,
+				pixels.begin() + (rowStart + rowCount) * width * CHANNELS, value);
+	};
 	
 	void Copy(const GenericFrameBuffer<CHANNELS, WEIGHT_CHANNELS, T> *src) {
 		// Copy the current image
@@ -209,17 +231,33 @@ public:
 	u_int GetHeight() const { return height; }
 	size_t GetSize() const { return width * height * CHANNELS * sizeof(T); }
 
+	// Used by the film serialization to load the pixels stored outside of
+	// the archive
+	void SwapPixels(std::vector<T> &p) { pixels.swap(p); }
+
 	friend class boost::serialization::access;
 
 private:
 	// Used by serialization
 	GenericFrameBuffer() { }
 
-	template<class Archive> void serialize(Archive &ar, const u_int version) {
+	template<class Archive> void save(Archive &ar, const u_int version) const {
+		ar & width;
+		ar & height;
+
+		if (FrameBufferSkipPixelsSerialization::IsSkippingPixels()) {
+			const std::vector<T> noPixels;
+			ar & noPixels;
+		} else
+			ar & pixels;
+	}
+
+	template<class Archive>	void load(Archive &ar, const u_int version) {
 		ar & width;
 		ar & height;
 		ar & pixels;
 	}
+	BOOST_SERIALIZATION_SPLIT_MEMBER()
 
 	u_int width, height;
 
@@ -23,6 +23,67 @@
 
 namespace slg {
 
+//------------------------------------------------------------------------------
+// SampleResultRadiance
+//------------------------------------------------------------------------------
+
+// SampleResults are created, copied and destroyed in the inner loop of all
+// render engines so the radiance of the first SAMPLERESULT_INLINE_RADIANCE_GROUPS
+// radiance groups is stored inline, without touching the heap. It supports
+// the subset of the std::vector interface used to access the radiance groups.
+#define SAMPLERESULT_INLINE_RADIANCE_GROUPS 8
+
+class SampleResultRadiance {
+public:
+	SampleResultRadiance() : count(0), heapCapacity(0), heapData(NULL) { }
+	SampleResultRadiance(const SampleResultRadiance &r) : count(0), heapCapacity(0), heapData(NULL) {
+		*this = r;
+	}
+	~SampleResultRadiance() { delete[] heapData; }
+
+	SampleResultRadiance &operator=(const SampleResultRadiance &r) {
+		if (this != &r) {
+			Alloc(r.count);
+			std::copy(r.GetData(), r.GetData() + count, GetData());
+		}
+
+		return *this;
+	}
+
+	size_t size() const { return count; }
+	// Note: all radiance groups are set to black, not only the new ones
+	void resize(const u_int groupCount) {
+		Alloc(groupCount);
+		std::fill(GetData(), GetData() + count, luxrays::Spectrum());
+	}
+
+	luxrays::Spectrum &operator[](const u_int index) { return GetData()[index]; }
+	const luxrays::Spectrum &operator[](const u_int index) const { return GetData()[index]; }
+
+private:
+	void Alloc(const u_int groupCount) {
+		// The heap storage is kept and reused by the following allocations
+		if ((groupCount > SAMPLERESULT_INLINE_RADIANCE_GROUPS) && (groupCount > heapCapacity)) {
+			delete[] heapData;
+			heapData = new luxrays::Spectrum[groupCount];
+			heapCapacity = groupCount;
+		}
+
+		count = groupCount;
+	}
+
+	luxrays::Spectrum *GetData() {
+		return (count > SAMPLERESULT_INLINE_RADIANCE_GROUPS) ? heapData : inlineData;
+	}
+	const luxrays::Spectrum *GetData() const {
+		return (count > SAMPLERESULT_INLINE_RADIANCE_GROUPS) ? heapData : inlineData;
+	}
+
+	u_int count, heapCapacity;
+	luxrays::Spectrum inlineData[SAMPLERESULT_INLINE_RADIANCE_GROUPS];
+	luxrays::Spectrum *heapData;
+};
+
 //------------------------------------------------------------------------------
 // SampleResult
 //------------------------------------------------------------------------------
@@ -63,7 +124,7 @@ public:
 	// pixelX and pixelY have to be initialized only if !useFilmSplat
 	u_int pixelX, pixelY;
 	float filmX, filmY;
-	std::vector<luxrays::Spectrum> radiance;
+	SampleResultRadiance radiance;
 
 	float alpha, depth;
 	luxrays::Point position;
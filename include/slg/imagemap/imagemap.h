@@ -519,6 +519,18 @@ public:
 	virtual luxrays::UV GetDuv(const luxrays::UV &uv) const = 0;
 	virtual luxrays::UV GetDuv(const u_int index) const = 0;
 
+	// Lookups filtered over a footprint (in UV space). Only MIP-mapped
+	// storages use the footprint.
+	virtual float GetFloat(const luxrays::UV &uv, const float footprint) const {
+		return GetFloat(uv);
+	}
+	virtual luxrays::Spectrum GetSpectrum(const luxrays::UV &uv, const float footprint) const {
+		return GetSpectrum(uv);
+	}
+	virtual float GetAlpha(const luxrays::UV &uv, const float footprint) const {
+		return GetAlpha(uv);
+	}
+
 	virtual void ReverseGammaCorrection(const float gamma) = 0;
 
 	virtual ImageMapStorage *Copy() const = 0;
@@ -526,6 +538,7 @@ public:
 	static StorageType String2StorageType(const std::string &type);
 	static std::string StorageType2String(const StorageType type);
 	static ChannelSelectionType String2ChannelSelectionType(const std::string &type);
+	static std::string ChannelSelectionType2String(const ChannelSelectionType type);
 
 	u_int width, height;	
 };
@@ -633,6 +646,7 @@ template <class T> ImageMapStorage *AllocImageMapStorage(const u_int channels,
 //------------------------------------------------------------------------------
 
 class ImageMapCache;
+class ImageMapTileCache;
 
 class ImageMap {
 public:
@@ -657,6 +671,14 @@ public:
 	float GetAlpha(const luxrays::UV &uv) const { return pixelStorage->GetAlpha(uv); }
 	luxrays::UV GetDuv(const luxrays::UV &uv) const { return pixelStorage->GetDuv(uv); }
 
+	float GetFloat(const luxrays::UV &uv, const float footprint) const { return pixelStorage->GetFloat(uv, footprint); }
+	luxrays::Spectrum GetSpectrum(const luxrays::UV &uv, const float footprint) const { return pixelStorage->GetSpectrum(uv, footprint); }
+	float GetAlpha(const luxrays::UV &uv, const float footprint) const { return pixelStorage->GetAlpha(uv, footprint); }
+
+	// True if the pixels are read on demand from a tiled MIP-mapped file
+	// (see ImageMapTiledStorage)
+	bool IsTiled() const;
+
 	void Resize(const u_int newWidth, const u_int newHeight);
 
 	std::string GetFileExtension() const;
@@ -676,6 +698,10 @@ public:
 		const u_int width, const u_int height);
 	static ImageMap *FromProperties(const luxrays::Properties &props, const std::string &prefix);
 
+	// Return NULL if the image file can not be read as tiled MIP-mapped texture
+	static ImageMap *AllocTiledImageMap(ImageMapTileCache *tileCache,
+		const std::string &fileName, const float gamma,
+		const ImageMapStorage::StorageType storageType);
 	template <class T> static ImageMap *AllocImageMap(const float gamma, const u_int channels,
 		const u_int width, const u_int height) {
 		ImageMapStorage *imageMapStorage = AllocImageMapStorage<T>(channels, width, height);
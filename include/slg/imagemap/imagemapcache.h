@@ -38,12 +38,18 @@ public:
 	~ImageMapCache();
 
 	void SetImageResize(const float s) { allImageScale = s; }
+	// Enable the reading on demand of the image maps requested with
+	// enableTileCache, using at most maxMemorySize bytes for the tiles. The
+	// tiled MIP-mapped version of the image files is written in cacheDir (or
+	// next to the image files if it is empty).
+	void EnableTileCache(const size_t maxMemorySize, const std::string &cacheDir = "");
 
 	void DefineImageMap(const std::string &name, ImageMap *im);
 
 	ImageMap *GetImageMap(const std::string &fileName, const float gamma,
 		const ImageMapStorage::ChannelSelectionType selectionType,
-		const ImageMapStorage::StorageType storageType);
+		const ImageMapStorage::StorageType storageType,
+		const bool enableTileCache = false);
 
 	// Get a path/name from imageMap object
 	const std::string &GetPath(const ImageMap *im)const {
@@ -75,7 +81,7 @@ public:
 private:
 	std::string GetCacheKey(const std::string &fileName, const float gamma,
 		const ImageMapStorage::ChannelSelectionType selectionType,
-		const ImageMapStorage::StorageType storageType) const;
+		const ImageMapStorage::StorageType storageType, const bool tiled) const;
 	std::string GetCacheKey(const std::string &fileName) const;
 
 	boost::unordered_map<std::string, ImageMap *> mapByName;
@@ -83,6 +89,8 @@ private:
 	std::vector<ImageMap *> maps;
 
 	float allImageScale;
+	// NULL if the tiled image maps are disabled
+	ImageMapTileCache *tileCache;
 };
 
 }
@@ -0,0 +1,243 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+
+#ifndef _SLG_IMAGEMAPTILECACHE_H
+#define	_SLG_IMAGEMAPTILECACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <OpenImageIO/imageio.h>
+
+#include "slg/imagemap/imagemap.h"
+
+namespace slg {
+
+class ImageMapTiledStorage;
+
+//------------------------------------------------------------------------------
+// ImageMapTileCache
+//
+// It holds the tiles of all the ImageMapTiledStorage of an ImageMapCache. The
+// tiles are loaded on demand and the least recently used ones are evicted
+// when the memory budget is exceeded. The cache is split in shards, each one
+// with its own lock and a fraction of the budget, to reduce the contention
+// among the rendering threads.
+//
+// Each thread has also a small private cache of the last fetched tiles so the
+// lookups of the tiles in use (i.e. most of them) don't touch the shards at
+// all. The tiles in the thread caches are not accounted in the memory budget.
+//------------------------------------------------------------------------------
+
+#define IMAGEMAPTILECACHE_SHARD_COUNT 16
+#define IMAGEMAPTILECACHE_THREAD_TILE_COUNT 8
+
+class ImageMapTileCache {
+public:
+	// The tiled MIP-mapped version of the image files is written in cacheDir
+	// or next to the image file if cacheDir is empty
+	ImageMapTileCache(const size_t maxMemorySize, const std::string &cacheDir);
+	~ImageMapTileCache();
+
+	// The returned tile can be evicted from the cache at any time but it
+	// stays valid until the calling thread has fetched at least other
+	// IMAGEMAPTILECACHE_THREAD_TILE_COUNT - 1 tiles
+	const ImageMapStorage *GetTile(const ImageMapTiledStorage *storage,
+			const u_int level, const u_int tileX, const u_int tileY);
+	// Remove all the tiles of an image map
+	void Flush(const ImageMapTiledStorage *storage);
+
+	size_t GetMaxMemorySize() const { return maxMemorySize; }
+	size_t GetMemorySize();
+	const std::string &GetCacheDir() const { return cacheDir; }
+
+private:
+	class TileKey {
+	public:
+		TileKey() : storage(NULL), level(0), tileX(0), tileY(0) { }
+		TileKey(const ImageMapTiledStorage *s, const u_int l, const u_int x, const u_int y) :
+			storage(s), level(l), tileX(x), tileY(y) { }
+
+		bool operator==(const TileKey &k) const {
+			return (storage == k.storage) && (level == k.level) &&
+					(tileX == k.tileX) && (tileY == k.tileY);
+		}
+
+		friend size_t hash_value(const TileKey &k) {
+			size_t seed = 0;
+			boost::hash_combine(seed, k.storage);
+			boost::hash_combine(seed, k.level);
+			boost::hash_combine(seed, k.tileX);
+			boost::hash_combine(seed, k.tileY);
+
+			return seed;
+		}
+
+		const ImageMapTiledStorage *storage;
+		u_int level, tileX, tileY;
+	};
+
+	typedef std::list<std::pair<TileKey, boost::shared_ptr<const ImageMapStorage> > > TileList;
+
+	class Shard {
+	public:
+		Shard() : memorySize(0) { }
+
+		boost::mutex shardMutex;
+		// The most recently used tiles are at the beginning of the list
+		TileList tiles;
+		boost::unordered_map<TileKey, TileList::iterator> tilesByKey;
+		size_t memorySize;
+	};
+
+	// The tiles last fetched by a thread, replaced in FIFO order
+	class ThreadTileCache {
+	public:
+		ThreadTileCache() : nextTile(0) { }
+
+		TileKey keys[IMAGEMAPTILECACHE_THREAD_TILE_COUNT];
+		u_int generations[IMAGEMAPTILECACHE_THREAD_TILE_COUNT];
+		boost::shared_ptr<const ImageMapStorage> tiles[IMAGEMAPTILECACHE_THREAD_TILE_COUNT];
+		u_int nextTile;
+	};
+
+	boost::shared_ptr<const ImageMapStorage> GetSharedTile(const TileKey &key);
+
+	Shard shards[IMAGEMAPTILECACHE_SHARD_COUNT];
+	size_t maxMemorySize, maxShardMemorySize;
+	std::string cacheDir;
+
+	boost::thread_specific_ptr<ThreadTileCache> threadTileCaches;
+	// Incremented by Flush() and by the constructor to invalidate the tiles
+	// in the thread caches. It is shared by all the tile caches because a
+	// thread cache of a deleted tile cache can be found again by a new tile
+	// cache allocated at the same address.
+	static boost::atomic<u_int> generation;
+};
+
+//------------------------------------------------------------------------------
+// ImageMapTiledStorage
+//
+// An ImageMapStorage reading the pixels, one tile at time, from a tiled and
+// MIP-mapped image file. If the original image file isn't tiled and
+// MIP-mapped, a .tx version is written with OpenImageIO and used instead.
+//------------------------------------------------------------------------------
+
+class ImageMapTiledStorage : public ImageMapStorage {
+public:
+	virtual ~ImageMapTiledStorage();
+
+	virtual ImageMapStorage *SelectChannel(const ChannelSelectionType selectionType) const;
+
+	virtual StorageType GetStorageType() const { return storageType; }
+	virtual u_int GetChannelCount() const { return channelCount; }
+	// The memory size of the first MIP level (not the one of the loaded tiles)
+	virtual size_t GetMemorySize() const;
+	// Pixels are not stored in memory
+	virtual void *GetPixelsData() const { return NULL; }
+
+	virtual float GetFloat(const luxrays::UV &uv) const;
+	virtual float GetFloat(const u_int index) const;
+	virtual luxrays::Spectrum GetSpectrum(const luxrays::UV &uv) const;
+	virtual luxrays::Spectrum GetSpectrum(const u_int index) const;
+	virtual float GetAlpha(const luxrays::UV &uv) const;
+	virtual float GetAlpha(const u_int index) const;
+	virtual luxrays::UV GetDuv(const luxrays::UV &uv) const;
+	virtual luxrays::UV GetDuv(const u_int index) const;
+
+	virtual float GetFloat(const luxrays::UV &uv, const float footprint) const;
+	virtual luxrays::Spectrum GetSpectrum(const luxrays::UV &uv, const float footprint) const;
+	virtual float GetAlpha(const luxrays::UV &uv, const float footprint) const;
+
+	virtual void ReverseGammaCorrection(const float gamma);
+
+	virtual ImageMapStorage *Copy() const;
+
+	// Used by ImageMapTileCache
+	ImageMapStorage *LoadTile(const u_int level, const u_int tileX, const u_int tileY) const;
+
+	// The average of all pixels, read from the last MIP level
+	luxrays::Spectrum GetSpectrumMean() const;
+	// Write the first MIP level, one row of tiles at time, without loading
+	// the whole image in memory
+	void WriteImage(const std::string &fileName) const;
+
+	// The tiled MIP-mapped image file
+	const std::string &GetFileName() const { return txFileName; }
+	float GetGamma() const { return gamma; }
+	const std::vector<ChannelSelectionType> &GetChannelSelections() const { return channelSelections; }
+
+	// Return NULL if the image file can not be converted in the required format
+	static ImageMapTiledStorage *Create(ImageMapTileCache *tileCache,
+			const std::string &fileName, const StorageType storageType);
+
+private:
+	typedef struct {
+		u_int width, height, tileCountX, tileCountY;
+	} MipLevel;
+
+	ImageMapTiledStorage(ImageMapTileCache *tileCache, const std::string &txFileName,
+			const StorageType storageType, const u_int fileChannelCount,
+			const u_int tileWidth, const u_int tileHeight,
+			const std::vector<MipLevel> &levels);
+
+	// Return the tile including the texel (s, t) and the index of the texel
+	// inside the tile
+	const ImageMapStorage *GetTexelTile(const u_int level,
+			const int s, const int t, u_int *index) const;
+	// Return the 4 texels (and the weights) used by bilinear filtering
+	void GetBilinearTexels(const u_int level, const luxrays::UV &uv,
+			const ImageMapStorage *tiles[4],
+			u_int indices[4], float weights[4]) const;
+	float GetTexelFloat(const u_int level, const int s, const int t) const;
+
+	float GetFloat(const u_int level, const luxrays::UV &uv) const;
+	luxrays::Spectrum GetSpectrum(const u_int level, const luxrays::UV &uv) const;
+	float GetAlpha(const u_int level, const luxrays::UV &uv) const;
+	// Return the MIP levels to use for the footprint and the interpolation factor
+	u_int GetMipLevels(const float footprint, u_int *level1, float *t) const;
+
+	ImageMapTileCache *tileCache;
+	std::string txFileName;
+	StorageType storageType;
+	u_int fileChannelCount, channelCount;
+	u_int tileWidth, tileHeight;
+	std::vector<MipLevel> levels;
+
+	// Applied to each tile after the loading
+	float gamma;
+	std::vector<ChannelSelectionType> channelSelections;
+
+	// OpenImageIO ImageInput is not thread safe
+	mutable boost::mutex imageInputMutex;
+	mutable std::auto_ptr<OIIO::ImageInput> imageInput;
+};
+
+}
+
+#endif	/* _SLG_IMAGEMAPTILECACHE_H */
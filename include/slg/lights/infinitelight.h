@@ -19,6 +19,8 @@
 #ifndef _SLG_INFINITELIGHT_H
 #define	_SLG_INFINITELIGHT_H
 
+#include <vector>
+
 #include "slg/lights/light.h"
 
 namespace slg {
@@ -51,6 +53,10 @@ public:
 	virtual luxrays::Spectrum GetRadiance(const Scene &scene, const luxrays::Vector &dir,
 			float *directPdfA = NULL, float *emissionPdfW = NULL) const;
 
+	virtual bool HasVisibilityMap() const { return useVisibilityMap; }
+	virtual void UpdateVisibilityMap(const Scene *scene,
+			const u_int filmWidth, const u_int filmHeight);
+
 	virtual void AddReferencedImageMaps(boost::unordered_set<const ImageMap *> &referencedImgMaps) const {
 		referencedImgMaps.insert(imageMap);
 	}
@@ -60,9 +66,22 @@ public:
 	const ImageMap *imageMap;
 	UVMapping2D mapping;
 	bool sampleUpperHemisphereOnly;
+	// If enabled, the importance sampling is weighted by how much each
+	// direction is visible from the points seen by the camera. It avoids
+	// to waste most shadow rays on walls in interiors lit through windows.
+	// The map rays pass through the surfaces transparent to shadow rays
+	// (null and archglass materials, alpha maps, etc.) but not through the
+	// other glass materials and volumes: they block the light like walls.
+	bool useVisibilityMap;
+	u_int visibilityMapWidth, visibilityMapHeight, visibilityMapSamples;
 
 private:	
+	void BuildImageMapDistribution();
+
 	luxrays::Distribution2D *imageMapDistribution;
+	// The fraction of the camera points seeing each lat-long cell (in light
+	// local space) of the map, empty if not available
+	std::vector<float> visibilityMap;
 };
 
 }
@@ -208,6 +208,13 @@ public:
 
 	virtual luxrays::Spectrum GetRadiance(const Scene &scene, const luxrays::Vector &dir,
 			float *directPdfA = NULL, float *emissionPdfW = NULL) const = 0;
+
+	// Called by Scene::UpdateEnvLightVisibilityMaps(), once the render engine
+	// accelerator is available, to update any data depending on the scene
+	// geometry and on the camera
+	virtual bool HasVisibilityMap() const { return false; }
+	virtual void UpdateVisibilityMap(const Scene *scene,
+			const u_int filmWidth, const u_int filmHeight) { }
 };
 
 }
@@ -22,6 +22,7 @@
 #include "luxrays/utils/properties.h"
 #include "slg/lights/light.h"
 #include "slg/lights/lightstrategy.h"
+#include "slg/scene/scenehandle.h"
 
 namespace slg {
 
@@ -48,6 +49,20 @@ public:
 	const LightSource *GetLightSource(const std::string &name) const;
 	LightSource *GetLightSource(const std::string &name);
 
+	// Handles are stable identifiers of the light sources: they survive the
+	// redefinition of the light source with the same name. The slot of a
+	// deleted light source is recycled for the next new light source but with
+	// a new generation, so the handle of the deleted light source stays invalid.
+	SceneHandle GetLightSourceHandle(const std::string &name) const;
+	bool IsLightSourceHandleValid(const SceneHandle handle) const {
+		const u_int slot = GetSceneHandleSlot(handle);
+
+		return (slot < lightsBySlot.size()) && lightsBySlot[slot] &&
+				(generationsBySlot[slot] == GetSceneHandleGeneration(handle));
+	}
+	LightSource *GetLightSourceByHandle(const SceneHandle handle);
+	const std::string &GetLightSourceName(const SceneHandle handle) const;
+
 	u_int GetSize() const { return static_cast<u_int>(lightsByName.size()); }
 	std::vector<std::string> GetLightSourceNames() const;
 
@@ -82,6 +97,15 @@ public:
 private:
 	boost::unordered_map<std::string, LightSource *> lightsByName;
 
+	// Indexed by handle slot: the light source (NULL if it has been deleted),
+	// its name and the current generation of the slot
+	std::vector<LightSource *> lightsBySlot;
+	std::vector<std::string> namesBySlot;
+	std::vector<u_int> generationsBySlot;
+	boost::unordered_map<std::string, SceneHandle> handlesByName;
+	// The slots of the deleted light sources, available to be reused
+	std::vector<u_int> freeSlots;
+
 	//--------------------------------------------------------------------------
 	// Following fields are updated with Preprocess() method
 	//--------------------------------------------------------------------------
@@ -22,6 +22,7 @@
 #include <boost/unordered_map.hpp>
 
 #include "slg/lights/light.h"
+#include "slg/lights/lighttree.h"
 
 namespace slg {
 
@@ -35,7 +36,7 @@ typedef enum {
 } LightStrategyTask;
 
 typedef enum {
-	TYPE_UNIFORM, TYPE_POWER, TYPE_LOG_POWER,
+	TYPE_UNIFORM, TYPE_POWER, TYPE_LOG_POWER, TYPE_LIGHT_TREE,
 	LIGHT_STRATEGY_TYPE_COUNT
 } LightStrategyType;
 
@@ -50,6 +51,16 @@ public:
 
 	LightSource *SampleLights(const float u, float *pdf) const;
 	float SampleLightPdf(const LightSource *light) const;
+	// Used to sample the light sources illuminating the point p (with the
+	// normal n, it can be null). The default implementation ignores the point.
+	virtual LightSource *SampleLights(const float u, const luxrays::Point &p,
+			const luxrays::Normal &n, float *pdf) const {
+		return SampleLights(u, pdf);
+	}
+	virtual float SampleLightPdf(const LightSource *light, const luxrays::Point &p,
+			const luxrays::Normal &n) const {
+		return SampleLightPdf(light);
+	}
 	
 	const luxrays::Distribution1D *GetLightsDistribution() const { return lightsDistribution; }
 
@@ -133,6 +144,8 @@ public:
 	static LightStrategy *FromProperties(const luxrays::Properties &cfg);
 
 protected:
+	LightStrategyPower(const LightStrategyType t) : LightStrategy(t) { }
+
 	static const luxrays::Properties &GetDefaultProps();
 };
 
@@ -162,6 +175,52 @@ protected:
 	static const luxrays::Properties &GetDefaultProps();
 };
 
+//------------------------------------------------------------------------------
+// LightStrategyLightTree
+//
+// The triangle and point light sources are organized in a LightTree and
+// sampled according their estimated contribution to the illuminated point.
+// All the other light sources are sampled by power. The light power
+// distribution is still available for the tasks without a point to
+// illuminate.
+//------------------------------------------------------------------------------
+
+class LightStrategyLightTree : public LightStrategyPower {
+public:
+	LightStrategyLightTree() : LightStrategyPower(TYPE_LIGHT_TREE),
+			lightTree(NULL), otherLightsDistribution(NULL), lightTreePickProb(0.f) { }
+	virtual ~LightStrategyLightTree();
+
+	virtual void Preprocess(const Scene *scene, const LightStrategyTask taskType);
+
+	using LightStrategy::SampleLights;
+	using LightStrategy::SampleLightPdf;
+	virtual LightSource *SampleLights(const float u, const luxrays::Point &p,
+			const luxrays::Normal &n, float *pdf) const;
+	virtual float SampleLightPdf(const LightSource *light, const luxrays::Point &p,
+			const luxrays::Normal &n) const;
+
+	virtual LightStrategyType GetType() const { return GetObjectType(); }
+	virtual std::string GetTag() const { return GetObjectTag(); }
+
+	//--------------------------------------------------------------------------
+	// Static methods used by LightStrategyRegistry
+	//--------------------------------------------------------------------------
+
+	static LightStrategyType GetObjectType() { return TYPE_LIGHT_TREE; }
+	static std::string GetObjectTag() { return "LIGHT_TREE"; }
+	static luxrays::Properties ToProperties(const luxrays::Properties &cfg);
+	static LightStrategy *FromProperties(const luxrays::Properties &cfg);
+
+protected:
+	static const luxrays::Properties &GetDefaultProps();
+
+	LightTree *lightTree;
+	// The light sources not included in the tree
+	luxrays::Distribution1D *otherLightsDistribution;
+	float lightTreePickProb;
+};
+
 }
 
 #endif	/* _SLG_LIGHTSTRATEGY_H */
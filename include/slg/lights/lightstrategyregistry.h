@@ -56,6 +56,7 @@ protected:
 	OBJECTSTATICREGISTRY_DECLARE_REGISTRATION(LightStrategyRegistry, LightStrategyUniform);
 	OBJECTSTATICREGISTRY_DECLARE_REGISTRATION(LightStrategyRegistry, LightStrategyPower);
 	OBJECTSTATICREGISTRY_DECLARE_REGISTRATION(LightStrategyRegistry, LightStrategyLogPower);
+	OBJECTSTATICREGISTRY_DECLARE_REGISTRATION(LightStrategyRegistry, LightStrategyLightTree);
 	// Just add here any new LightStrategy (don't forget in the .cpp too)
 
 	friend class LightStrategy;
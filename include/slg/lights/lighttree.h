@@ -0,0 +1,112 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#ifndef _SLG_LIGHTTREE_H
+#define	_SLG_LIGHTTREE_H
+
+#include <vector>
+
+#include "luxrays/luxrays.h"
+#include "luxrays/core/epsilon.h"
+#include "luxrays/core/geometry/bbox.h"
+#include "luxrays/core/geometry/vector.h"
+#include "luxrays/core/geometry/normal.h"
+#include "slg/slg.h"
+
+namespace slg {
+
+//------------------------------------------------------------------------------
+// LightTree
+//
+// A bounding volume hierarchy over the light sources with a position in the
+// scene (i.e. triangle and point lights). Each node bounds the position, the
+// emission directions and the power of all the light sources below it, so
+// the tree can be traversed to pick a light source proportionally to an
+// estimation of its contribution to a shading point. It is based on
+// "Importance Sampling of Many Lights with Adaptive Tree Splitting" by
+// Alejandro Conty Estevez and Christopher Kulla.
+//------------------------------------------------------------------------------
+
+// The bounds of a light source (or of a group of light sources): all normals
+// are within thetaO of the axis and the light is emitted within thetaE of
+// the normals
+class LightTreeBounds {
+public:
+	LightTreeBounds() : axis(0.f, 0.f, 1.f), thetaO(0.f), thetaE(0.f), power(0.f) { }
+
+	void Union(const LightTreeBounds &b);
+
+	// The measure used by the surface area orientation heuristic
+	float GetOrientationMeasure() const;
+
+	luxrays::BBox bbox;
+	luxrays::Vector axis;
+	float thetaO, thetaE;
+	float power;
+};
+
+class LightTreeEmitter {
+public:
+	LightTreeBounds bounds;
+	u_int lightIndex;
+};
+
+#define LIGHTTREE_NULL_INDEX 0xffffffffu
+
+#define LightTreeNodeData_IsLeaf(nodeData) ((nodeData) & 0x80000000u)
+#define LightTreeNodeData_GetLightIndex(nodeData) ((nodeData) & 0x7fffffffu)
+
+typedef struct {
+	LightTreeBounds bounds;
+	// For leafs the light index with the 0x80000000 bit set, for the other
+	// nodes the index of the second child (the first one always follows its
+	// parent in the array)
+	u_int nodeData;
+	u_int parentIndex;
+} LightTreeNode;
+
+class LightTree {
+public:
+	LightTree(std::vector<LightTreeEmitter> &emitters, const u_int lightCount);
+	~LightTree() { }
+
+	bool HasLight(const u_int lightIndex) const {
+		return leafIndexByLightIndex[lightIndex] != LIGHTTREE_NULL_INDEX;
+	}
+	float GetPower() const { return nodes[0].bounds.power; }
+
+	// The normal n can be null if the point is not on a surface (or it is
+	// on a surface receiving light from both sides). Return LIGHTTREE_NULL_INDEX
+	// if no light source can illuminate the point.
+	u_int SampleLight(const float u, const luxrays::Point &p, const luxrays::Normal &n,
+			float *pdf) const;
+	float LightPdf(const u_int lightIndex, const luxrays::Point &p, const luxrays::Normal &n) const;
+
+private:
+	u_int BuildNode(std::vector<LightTreeEmitter> &emitters,
+			const u_int begin, const u_int end, const u_int parentIndex);
+	float Importance(const LightTreeBounds &bounds, const luxrays::Point &p,
+			const luxrays::Normal &n) const;
+
+	std::vector<LightTreeNode> nodes;
+	std::vector<u_int> leafIndexByLightIndex;
+};
+
+}
+
+#endif	/* _SLG_LIGHTTREE_H */
@@ -19,6 +19,8 @@
 #ifndef _SLG_SKY2LIGHT_H
 #define	_SLG_SKY2LIGHT_H
 
+#include <vector>
+
 #include "slg/lights/light.h"
 
 namespace slg {
@@ -62,12 +64,25 @@ public:
 	luxrays::Spectrum groundAlbedo;
 	luxrays::Spectrum groundColor;
 	bool hasGround, hasGroundAutoScale;
+	// If enabled, the sky radiance is baked at Preprocess() time in a
+	// lat-long RGB table (in light local space) used for the radiance look up,
+	// with bilinear filtering, and, with a Distribution2D, for importance
+	// sampling. Around the sun, where the model changes too fast for the
+	// table resolution, the radiance is still evaluated with the analytic model.
+	bool useSkyDistribution;
+	u_int skyDistributionWidth, skyDistributionHeight;
 
 private:
 	luxrays::Vector SampleSkyDome(const float u0, const float u1) const;
 	void SampleSkyDomePdf(const Scene &scene, float *directPdf, float *emissionPdf) const;
 	luxrays::Spectrum ComputeRadiance(const luxrays::Vector &w) const;
 
+	void PreprocessSkyTable();
+	luxrays::Vector SampleSkyTable(const float u0, const float u1, float *directPdf) const;
+	float GetSkyTablePdf(const luxrays::Vector &localDir) const;
+	const luxrays::Spectrum &GetSkyTableTexel(const int x, const int y) const;
+	luxrays::Spectrum GetSkyTableRadiance(const luxrays::Vector &localDir) const;
+
 	luxrays::Vector absoluteSunDir, absoluteUpDir;
 	luxrays::Spectrum scaledGroundColor;
 
@@ -76,6 +91,13 @@ private:
 		gTerm, hTerm, iTerm, radianceTerm;
 
 	bool isGroundBlack;
+
+	// The sky only radiance, the ground is not baked so it doesn't bleed
+	// over the horizon with the bilinear filtering
+	std::vector<luxrays::Spectrum> skyTable;
+	luxrays::Distribution2D *skyDistribution;
+	// The cosine of the angle around the sun evaluated with the analytic model
+	float sunRegionCosAngle;
 };
 
 }
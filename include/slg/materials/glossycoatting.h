@@ -51,6 +51,9 @@ public:
 	virtual bool IsPassThrough() const {
 		return (matBase->IsPassThrough());
 	}
+	virtual bool IsShadowTransparent() const {
+		return (matBase->IsShadowTransparent());
+	}
 	virtual luxrays::Spectrum GetPassThroughTransparency(const HitPoint &hitPoint,
 		const luxrays::Vector &localFixedDir, const float passThroughEvent) const;
 
@@ -114,6 +114,11 @@ public:
 
 	virtual bool IsDelta() const { return false; }
 	virtual bool IsPassThrough() const { return false; }
+	// Return true if GetPassThroughTransparency() can return a non black value
+	// i.e. if shadow rays may pass through the material
+	virtual bool IsShadowTransparent() const {
+		return (transparencyTex != NULL) || IsPassThrough();
+	}
 	virtual luxrays::Spectrum GetPassThroughTransparency(const HitPoint &hitPoint,
 		const luxrays::Vector &localFixedDir, const float passThroughEvent) const;
 
@@ -24,6 +24,7 @@
 #include <boost/unordered_map.hpp>
 
 #include "slg/materials/material.h"
+#include "slg/scene/scenehandle.h"
 
 namespace slg {
 
@@ -37,7 +38,7 @@ public:
 	~MaterialDefinitions();
 
 	bool IsMaterialDefined(const std::string &name) const {
-		return (matsByName.count(name) > 0);
+		return (handlesByName.count(name) > 0);
 	}
 	void DefineMaterial(const std::string &name, Material *m);
 
@@ -53,14 +54,39 @@ public:
 		return mats;
 	}
 
+	// Handles are stable identifiers of the materials: they don't change
+	// when other materials are deleted and they survive the redefinition of
+	// the material with the same name. The slot of a deleted material is
+	// recycled for the next new material but with a new generation, so the
+	// handle of the deleted material stays invalid.
+	SceneHandle GetMaterialHandle(const std::string &name) const;
+	bool IsMaterialHandleValid(const SceneHandle handle) const {
+		const u_int slot = GetSceneHandleSlot(handle);
+
+		return (slot < indicesBySlot.size()) && (indicesBySlot[slot] != NULL_INDEX) &&
+				(generationsBySlot[slot] == GetSceneHandleGeneration(handle));
+	}
+	Material *GetMaterialByHandle(const SceneHandle handle);
+
 	u_int GetSize() const { return static_cast<u_int>(mats.size()); }
 	std::vector<std::string> GetMaterialNames() const;
 
 	void DeleteMaterial(const std::string &name);
   
 private:
+	// The materials in index order and their handles
 	std::vector<Material *> mats;
-	boost::unordered_map<std::string, Material *> matsByName;
+	std::vector<SceneHandle> matHandles;
+
+	// Indexed by handle slot: the material index (NULL_INDEX if the material
+	// has been deleted) and the current generation of the slot
+	std::vector<u_int> indicesBySlot;
+	std::vector<u_int> generationsBySlot;
+	// The slots of the deleted materials, available to be reused
+	std::vector<u_int> freeSlots;
+
+	boost::unordered_map<std::string, SceneHandle> handlesByName;
+	boost::unordered_map<const Material *, u_int> indicesByMat;
 };
 
 }
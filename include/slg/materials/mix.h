@@ -39,6 +39,7 @@ public:
 	virtual bool HasBumpTex() const { return hasBumpTex; }
 	virtual bool IsDelta() const { return isDelta; }
 	virtual bool IsPassThrough() const { return isPassThrough; }
+	virtual bool IsShadowTransparent() const { return isShadowTransparent; }
 
 	virtual luxrays::Spectrum GetPassThroughTransparency(const HitPoint &hitPoint,
 		const luxrays::Vector &localFixedDir, const float passThroughEvent) const;
@@ -83,6 +84,7 @@ private:
 	bool HasBumpTexImpl() const;
 	bool IsDeltaImpl() const;
 	bool IsPassThroughImpl() const;
+	bool IsShadowTransparentImpl() const;
 
 	void Preprocess();
 
@@ -92,7 +94,7 @@ private:
 
 	// Cached values for performance with very large material node trees
 	BSDFEvent eventTypes;
-	bool isLightSource, hasBumpTex, isDelta, isPassThrough;
+	bool isLightSource, hasBumpTex, isDelta, isPassThrough, isShadowTransparent;
 	
 };
 
@@ -26,6 +26,7 @@
 #include "slg/renderstate.h"
 #include "slg/engines/renderengine.h"
 #include "slg/film/film.h"
+#include "slg/utils/chunkfile.h"
 
 namespace slg {
 
@@ -47,7 +48,12 @@ public:
 	void Resume();
 
 	bool NeedPeriodicFilmSave();
-	void SaveFilm(const std::string &fileName);
+	// The film is copied while holding the film lock. If async is true,
+	// the copy is written by a background thread and the method returns
+	// immediately (i.e. for periodic film saves).
+	void SaveFilm(const std::string &fileName, const bool async = false);
+	// Waits for the end of the last asynchronous film save
+	void WaitFilmSave();
 	void SaveFilmOutputs();
 	
 	RenderState *GetRenderState();
@@ -61,9 +67,13 @@ public:
 	Film *film;
 
 protected:
+	static void FilmSaveThreadImpl(ChunkFileWriter *filmSnapshot, const std::string fileName);
+
 	double lastPeriodicSave, periodiceSaveTime;
 
 	bool periodicSaveEnabled;
+
+	boost::thread *filmSaveThread;
 };
 
 }
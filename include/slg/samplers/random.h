@@ -37,13 +37,14 @@ namespace slg {
 
 class RandomSamplerSharedData : public SamplerSharedData {
 public:
-	RandomSamplerSharedData() { }
-	virtual ~RandomSamplerSharedData() { }
+	RandomSamplerSharedData(Film *engineFilm, const float adaptiveStrength);
+	virtual ~RandomSamplerSharedData();
 
 	static SamplerSharedData *FromProperties(const luxrays::Properties &cfg,
 			luxrays::RandomGenerator *rndGen, Film *film);
 
-	// Nothing to share
+	// NULL if adaptive sampling is disabled
+	AdaptiveImageDistribution *adaptiveImageDistribution;
 };
 
 //------------------------------------------------------------------------------
@@ -53,16 +54,19 @@ public:
 class RandomSampler : public Sampler {
 public:
 	RandomSampler(luxrays::RandomGenerator *rnd, Film *flm,
-			const FilmSampleSplatter *flmSplatter) : Sampler(rnd, flm, flmSplatter) { }
-	virtual ~RandomSampler() { }
+			const FilmSampleSplatter *flmSplatter,
+			RandomSamplerSharedData *samplerSharedData);
+	virtual ~RandomSampler();
 
 	virtual SamplerType GetType() const { return GetObjectType(); }
 	virtual std::string GetTag() const { return GetObjectTag(); }
 	virtual void RequestSamples(const u_int size) { }
 
-	virtual float GetSample(const u_int index) { return rndGen->floatValue(); }
+	virtual float GetSample(const u_int index);
 	virtual void NextSample(const std::vector<SampleResult> &sampleResults);
 
+	virtual luxrays::Properties ToProperties() const;
+
 	//--------------------------------------------------------------------------
 	// Static methods used by SamplerRegistry
 	//--------------------------------------------------------------------------
@@ -74,8 +78,17 @@ public:
 		Film *film, const FilmSampleSplatter *flmSplatter, SamplerSharedData *sharedData);
 	static slg::ocl::Sampler *FromPropertiesOCL(const luxrays::Properties &cfg);
 
+	friend class RandomSamplerSharedData;
+
 private:
 	static const luxrays::Properties &GetDefaultProps();
+
+	RandomSamplerSharedData *sharedData;
+
+	// Used only if adaptive sampling is enabled
+	AdaptiveImageSampling *adaptiveImageSampling;
+	float imageSamples[2];
+	bool imageSamplesReady;
 };
 
 }
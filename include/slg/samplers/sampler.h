@@ -22,7 +22,11 @@
 #include <string>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "luxrays/core/randomgen.h"
+#include "luxrays/utils/mcdistribution.h"
 #include "slg/slg.h"
 #include "slg/core/namedobject.h"
 #include "slg/film/film.h"
@@ -56,6 +60,64 @@ public:
 			luxrays::RandomGenerator *rndGen, Film *film);
 };
 
+//------------------------------------------------------------------------------
+// AdaptiveImageDistribution
+//
+// Used by the samplers supporting adaptive sampling to distribute the image
+// samples according the noise map of the film convergence test. The noise map
+// is reduced to blocks of ADAPTIVE_SAMPLING_BLOCK_SIZE x ADAPTIVE_SAMPLING_BLOCK_SIZE
+// pixels and mixed with a uniform distribution (according the strength in
+// the [0, 1) range), so converged blocks keep receiving a few samples and
+// their noise estimate can be still updated.
+//
+// It is shared by all the samplers of a render engine.
+//------------------------------------------------------------------------------
+
+#define ADAPTIVE_SAMPLING_BLOCK_SIZE 8
+
+class AdaptiveImageDistribution {
+public:
+	AdaptiveImageDistribution(Film *engineFilm, const float strength);
+	~AdaptiveImageDistribution();
+
+	float GetStrength() const { return strength; }
+	u_int GetNoiseMapVersion() const { return film->GetNoiseMapVersion(); }
+	// Return the distribution of the current noise map (rebuilt if required)
+	// and its version. It is NULL if no noise map is available yet.
+	boost::shared_ptr<const luxrays::Distribution2D> GetDistribution(u_int *version);
+
+private:
+	Film *film;
+	const float strength;
+
+	boost::mutex distributionMutex;
+	std::vector<float> noiseMap;
+	u_int noiseMapVersion;
+	boost::shared_ptr<const luxrays::Distribution2D> distribution;
+};
+
+//------------------------------------------------------------------------------
+// AdaptiveImageSampling
+//
+// The AdaptiveImageDistribution front end used by each sampler, it caches the
+// current distribution so no lock is required until the noise map changes.
+//------------------------------------------------------------------------------
+
+class AdaptiveImageSampling {
+public:
+	AdaptiveImageSampling(AdaptiveImageDistribution *imageDistribution);
+	~AdaptiveImageSampling() { }
+
+	// Map the uniform image sample (u0, u1) to the noise map distribution
+	void Sample(float *u0, float *u1);
+
+private:
+	AdaptiveImageDistribution *imageDistribution;
+
+	u_int noiseMapVersion;
+	boost::shared_ptr<const luxrays::Distribution2D> distribution;
+};
+
 //------------------------------------------------------------------------------
 // Sampler
 //------------------------------------------------------------------------------
@@ -39,14 +39,18 @@ namespace slg {
 
 class SobolSamplerSharedData : public SamplerSharedData {
 public:
-	SobolSamplerSharedData(luxrays::RandomGenerator *rndGen);
-	virtual ~SobolSamplerSharedData() { }
+	SobolSamplerSharedData(luxrays::RandomGenerator *rndGen, Film *engineFilm,
+			const float adaptiveStrength);
+	virtual ~SobolSamplerSharedData();
 
 	static SamplerSharedData *FromProperties(const luxrays::Properties &cfg,
 			luxrays::RandomGenerator *rndGen, Film *film);
 
 	float rng0, rng1;
 	boost::atomic<u_int> pass;
+
+	// NULL if adaptive sampling is disabled
+	AdaptiveImageDistribution *adaptiveImageDistribution;
 };
 
 //------------------------------------------------------------------------------
@@ -74,6 +78,8 @@ public:
 	virtual float GetSample(const u_int index);
 	virtual void NextSample(const std::vector<SampleResult> &sampleResults);
 
+	virtual luxrays::Properties ToProperties() const;
+
 	//--------------------------------------------------------------------------
 	// Static methods used by SamplerRegistry
 	//--------------------------------------------------------------------------
@@ -85,15 +91,23 @@ public:
 		Film *film, const FilmSampleSplatter *flmSplatter, SamplerSharedData *sharedData);
 	static slg::ocl::Sampler *FromPropertiesOCL(const luxrays::Properties &cfg);
 
+	friend class SobolSamplerSharedData;
+
 private:
 	static const luxrays::Properties &GetDefaultProps();
 
 	u_int SobolDimension(const u_int index, const u_int dimension) const;
+	float GetSobolSample(const u_int index) const;
 
 	SobolSamplerSharedData *sharedData;
 
 	u_int *directions;
 	u_int passBase, passOffset;
+
+	// Used only if adaptive sampling is enabled
+	AdaptiveImageSampling *adaptiveImageSampling;
+	float imageSamples[2];
+	bool imageSamplesReady;
 };
 
 }
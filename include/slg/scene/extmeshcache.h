@@ -33,18 +33,39 @@
 
 namespace slg {
 
+// Keeps alive the data of a mesh when the cache doesn't own it (i.e. the
+// buffers passed to the Python binding). It is deleted when the mesh is
+// redefined or deleted, or when the cache is destroyed.
+class ExtMeshDataOwner {
+public:
+	virtual ~ExtMeshDataOwner() { }
+};
+
 class ExtMeshCache {
 public:
 	ExtMeshCache();
 	~ExtMeshCache();
 
 	void SetDeleteMeshData(const bool v) { deleteMeshData = v; }
+	bool GetDeleteMeshData() const { return deleteMeshData; }
+
+	// The cache takes the ownership of owner. The previous owner of the data
+	// of the mesh, if there is one, is deleted.
+	void SetExtMeshDataOwner(const std::string &meshName, ExtMeshDataOwner *owner);
 
-	void DefineExtMesh(const std::string &meshName,
+	// If a mesh with the same name and the same topology is already defined
+	// (see IsExtMeshUpdateInPlace()), the old mesh takes the data of the new
+	// one and the new one is deleted. The defined mesh is returned.
+	luxrays::ExtMesh *DefineExtMesh(const std::string &meshName,
 		const u_int plyNbVerts, const u_int plyNbTris,
 		luxrays::Point *p, luxrays::Triangle *vi, luxrays::Normal *n, luxrays::UV *uv,
 		luxrays::Spectrum *cols, float *alphas);
-	void DefineExtMesh(const std::string &meshName, luxrays::ExtMesh *mesh);
+	luxrays::ExtMesh *DefineExtMesh(const std::string &meshName, luxrays::ExtMesh *mesh);
+	// Returns true if mesh is a deformed version of the mesh with the same
+	// name: same triangles and vertex attributes, only the vertex data
+	// changes (i.e. cloth or character animations). Such a mesh is updated
+	// in place so the accelerators can be just refitted.
+	bool IsExtMeshUpdateInPlace(const std::string &meshName, const luxrays::ExtMesh *mesh) const;
 
 	bool IsExtMeshDefined(const std::string &meshName) const { return meshByName.find(meshName) != meshByName.end(); }
 
@@ -59,12 +80,29 @@ public:
 	u_int GetExtMeshIndex(const std::string &meshName) const;
 	u_int GetExtMeshIndex(const luxrays::ExtMesh *m) const;
 
+	// Handles are stable identifiers of the named meshes: they don't change
+	// when other meshes are deleted and they survive the redefinition of
+	// the mesh with the same name
+	u_int GetExtMeshHandle(const std::string &meshName) const;
+	luxrays::ExtMesh *GetExtMeshByHandle(const u_int handle);
+
 	const std::vector<luxrays::ExtMesh *> &GetMeshes() const { return meshes; }
 
+private:
+	void AddExtMesh(luxrays::ExtMesh *mesh);
+	void DeleteExtMeshDataOwner(const std::string &meshName);
+
 public:
 	boost::unordered_map<std::string, luxrays::ExtMesh *> meshByName;
 	// Used to preserve insertion order and to retrieve insertion index
 	std::vector<luxrays::ExtMesh *> meshes;
+	boost::unordered_map<const luxrays::ExtMesh *, u_int> meshIndices;
+
+	// The named meshes indexed by handle (NULL if the mesh has been deleted)
+	std::vector<luxrays::ExtMesh *> meshesByHandle;
+	boost::unordered_map<std::string, u_int> handlesByName;
+
+	boost::unordered_map<std::string, ExtMeshDataOwner *> dataOwnersByName;
 
 	bool deleteMeshData;
 };
@@ -23,6 +23,8 @@
 #include <iostream>
 #include <fstream>
 
+#include <boost/unordered_set.hpp>
+
 #include "luxrays/core/intersectiondevice.h"
 #include "luxrays/core/accelerator.h"
 #include "luxrays/utils/mc.h"
@@ -42,6 +44,7 @@
 #include "slg/volumes/volume.h"
 #include "slg/scene/sceneobject.h"
 #include "slg/scene/extmeshcache.h"
+#include "slg/utils/pathfootprint.h"
 
 namespace slg {
 
@@ -51,19 +54,37 @@ class Scene {
 public:
 	// Constructor used to create a scene by calling methods
 	Scene(const float imageScale = 1.f);
-	// Constructor used to load a scene from file
-	Scene(const std::string &fileName, const float imageScale = 1.f);
+	// Constructor used to load a scene from file. Image textures are read on
+	// demand from tiled MIP-mapped files if imageCacheSize (the max. memory
+	// used by the tiles, in bytes) is not 0 (see ImageMapCache::EnableTileCache()).
+	Scene(const std::string &fileName, const float imageScale = 1.f,
+		const size_t imageCacheSize = 0, const std::string &imageCacheDir = "");
 	~Scene();
 
 	bool Intersect(luxrays::IntersectionDevice *device,
 		const bool fromLight, PathVolumeInfo *volInfo,
 		const float passThrough, luxrays::Ray *ray, luxrays::RayHit *rayHit, BSDF *bsdf,
 		luxrays::Spectrum *connectionThroughput, const luxrays::Spectrum *pathThroughput = NULL,
-		SampleResult *sampleResult = NULL) const;
+		SampleResult *sampleResult = NULL, const PathFootprint *pathFootprint = NULL) const;
+	// Used for shadow rays and the other visibility only tests: return true
+	// if the ray is blocked. It uses the faster occlusion query of the
+	// accelerator when volumes and pass-through/transparent materials can
+	// not affect the result.
+	bool Occluded(luxrays::IntersectionDevice *device,
+		const bool fromLight, PathVolumeInfo *volInfo,
+		const float passThrough, luxrays::Ray *ray,
+		luxrays::Spectrum *connectionThroughput) const;
 
 	void PreprocessCamera(const u_int filmWidth, const u_int filmHeight, const u_int *filmSubRegion);
 	void Preprocess(luxrays::Context *ctx,
 		const u_int filmWidth, const u_int filmHeight, const u_int *filmSubRegion);
+	// Rebuilds the env. light source visibility maps invalidated by the last
+	// Preprocess(). It is called by the render engine once its accelerator
+	// has been built or updated.
+	void UpdateEnvLightVisibilityMaps(const u_int filmWidth, const u_int filmHeight);
+	// True if an env. light source has a visibility map: camera and geometry
+	// edits change the light source too
+	bool HasEnvLightVisibilityMaps() const;
 
 	luxrays::Properties ToProperties();
 
@@ -111,6 +132,15 @@ public:
 	void UpdateObjectMaterial(const std::string &objName, const std::string &matName);
 	void UpdateObjectTransformation(const std::string &objName, const luxrays::Transform &trans);
 
+	// The same edits using the handles returned by objDefs.GetSceneObjectHandle(),
+	// matDefs.GetMaterialHandle() and lightDefs.GetLightSourceHandle(): they
+	// avoid the name look up and the deletion of multiple objects is done in
+	// a single pass.
+	void DeleteObjects(const std::vector<SceneHandle> &objHandles);
+	void DeleteLights(const std::vector<SceneHandle> &lightHandles);
+	void UpdateObjectMaterial(const SceneHandle objHandle, const SceneHandle matHandle);
+	void UpdateObjectTransformation(const SceneHandle objHandle, const luxrays::Transform &trans);
+
 	void RemoveUnusedImageMaps();
 	void RemoveUnusedTextures();
 	void RemoveUnusedMaterials();
@@ -134,10 +164,36 @@ public:
 	luxrays::DataSet *dataSet;
 
 	EditActionList editActions;
+	// The meshes defined or modified since the last Preprocess(), used to
+	// update the DataSet incrementally
+	boost::unordered_set<const luxrays::Mesh *> editedMeshes;
+	// The meshes with vertices moved in place (the triangles are the same)
+	// since the last Preprocess(), the accelerators can be just refitted
+	boost::unordered_set<const luxrays::Mesh *> deformedMeshes;
 
 	bool enableParsePrint;
 protected:
+	// True if there is at least one material able to let shadow rays pass
+	bool hasShadowTransparentMaterials;
+	// True if the env. light source visibility maps have to be rebuilt
+	bool envLightVisibilityMapsDirty;
+
 	void Init(const float imageScale);
+	void TessellateCurves(const bool enableCurves);
+
+	// Used by Intersect() and Occluded(): if firstHitTraced is true, rayHit
+	// already has the result of tracing the ray
+	bool Intersect(luxrays::IntersectionDevice *device,
+		const bool fromLight, PathVolumeInfo *volInfo,
+		const float passThrough, luxrays::Ray *ray, luxrays::RayHit *rayHit, BSDF *bsdf,
+		luxrays::Spectrum *connectionThroughput, const luxrays::Spectrum *pathThroughput,
+		SampleResult *sampleResult, const PathFootprint *pathFootprint,
+		const bool firstHitTraced) const;
+
+	// Defines or replaces a mesh, updating editedMeshes or deformedMeshes
+	void DefineExtMesh(const std::string &meshName, luxrays::ExtMesh *mesh);
+	// Updates the triangle lights of all the objects using the mesh
+	void UpdateMeshTriangleLights(const luxrays::ExtMesh *mesh);
 
 	luxrays::ExtMesh *CreateInlinedMesh(const std::string &shapeName,
 			const std::string &propName, const luxrays::Properties &props);
@@ -0,0 +1,51 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#ifndef _SLG_SCENEHANDLE_H
+#define	_SLG_SCENEHANDLE_H
+
+#include "luxrays/utils/utils.h"
+
+namespace slg {
+
+//------------------------------------------------------------------------------
+// SceneHandle
+//------------------------------------------------------------------------------
+
+// The handle of a scene object, material or light source. The low 32 bits are
+// the slot of the entity in the tables of its definitions class and the high
+// 32 bits are the generation of the slot. The generation is increased each
+// time the slot is freed, so a stale handle is rejected instead of referencing
+// the entity reusing the slot.
+typedef u_longlong SceneHandle;
+
+inline SceneHandle MakeSceneHandle(const u_int slot, const u_int generation) {
+	return (static_cast<SceneHandle>(generation) << 32) | slot;
+}
+
+inline u_int GetSceneHandleSlot(const SceneHandle handle) {
+	return static_cast<u_int>(handle & 0xffffffffu);
+}
+
+inline u_int GetSceneHandleGeneration(const SceneHandle handle) {
+	return static_cast<u_int>(handle >> 32);
+}
+
+}
+
+#endif	/* _SLG_SCENEHANDLE_H */
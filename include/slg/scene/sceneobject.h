@@ -33,6 +33,7 @@
 #include "slg/bsdf/bsdfevents.h"
 #include "slg/bsdf/hitpoint.h"
 #include "slg/scene/extmeshcache.h"
+#include "slg/scene/scenehandle.h"
 #include "slg/lights/lightsourcedefinition.h"
 
 namespace slg {
@@ -90,7 +91,7 @@ public:
 	~SceneObjectDefinitions();
 
 	bool IsSceneObjectDefined(const std::string &name) const {
-		return (objsByName.count(name) > 0);
+		return (handlesByName.count(name) > 0);
 	}
 	void DefineSceneObject(const std::string &name, SceneObject *m);
 	void DefineIntersectableLights(LightSourceDefinitions &lightDefs, const Material *newMat) const;
@@ -108,6 +109,22 @@ public:
 	u_int GetSceneObjectIndex(const SceneObject *m) const;
 	u_int GetSceneObjectIndex(const luxrays::ExtMesh *mesh) const;
 
+	// Handles are stable identifiers of the objects: unlike indices, they
+	// don't change when other objects are deleted and they survive the
+	// redefinition of the object with the same name. The slot of a deleted
+	// object is recycled for the next new object but with a new generation,
+	// so the handle of the deleted object stays invalid.
+	SceneHandle GetSceneObjectHandle(const std::string &name) const;
+	bool IsSceneObjectHandleValid(const SceneHandle handle) const {
+		const u_int slot = GetSceneHandleSlot(handle);
+
+		return (slot < indicesBySlot.size()) && (indicesBySlot[slot] != NULL_INDEX) &&
+				(generationsBySlot[slot] == GetSceneHandleGeneration(handle));
+	}
+	const SceneObject *GetSceneObjectByHandle(const SceneHandle handle) const;
+	SceneObject *GetSceneObjectByHandle(const SceneHandle handle);
+	const std::string &GetSceneObjectName(const SceneHandle handle) const;
+
 	u_int GetSize() const { return static_cast<u_int>(objs.size()); }
 	std::vector<std::string> GetSceneObjectNames() const;
 
@@ -119,10 +136,37 @@ public:
 		boost::unordered_set<SceneObject *> &modifiedObjsList);
 
 	void DeleteSceneObject(const std::string &name);
+	// Deletes all the objects at once, it is much faster than deleting
+	// one object at time. Duplicated handles are ignored and nothing is
+	// deleted if any handle is invalid.
+	void DeleteSceneObjects(const std::vector<SceneHandle> &handles);
+
+	// Returns the list of handles without duplicates, it throws an
+	// exception if any handle is invalid
+	std::vector<SceneHandle> GetUniqueSceneObjectHandles(const std::vector<SceneHandle> &handles) const;
   
 private:
+	void CheckHandle(const SceneHandle handle) const;
+	void UpdateIndicesByMesh() const;
+
+	// The objects in index order and their handles
 	std::vector<SceneObject *> objs;
-	boost::unordered_map<std::string, SceneObject *> objsByName;
+	std::vector<SceneHandle> objHandles;
+
+	// Indexed by handle slot: the object index (NULL_INDEX if the object has
+	// been deleted), name and the current generation of the slot
+	std::vector<u_int> indicesBySlot;
+	std::vector<std::string> namesBySlot;
+	std::vector<u_int> generationsBySlot;
+	// The slots of the deleted objects, available to be reused
+	std::vector<u_int> freeSlots;
+
+	boost::unordered_map<std::string, SceneHandle> handlesByName;
+	boost::unordered_map<const SceneObject *, u_int> indicesByObj;
+	// The index of the first object using each mesh, it is rebuilt only
+	// when required
+	mutable boost::unordered_map<const luxrays::ExtMesh *, u_int> indicesByMesh;
+	mutable bool indicesByMeshValid;
 };
 
 }
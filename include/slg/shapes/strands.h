@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 
+#include "luxrays/core/extcurvemesh.h"
 #include "luxrays/utils/cyhair/cyHairFile.h"
 
 #include "slg/shapes/shape.h"
@@ -46,37 +47,63 @@ public:
 
 protected:
 	virtual luxrays::ExtMesh *RefineImpl(const Scene *scene);
-	
-	void TessellateRibbon(const Scene *scene,
-		const vector<luxrays::Point> &hairPoints,
+
+	luxrays::ExtMesh *mesh;
+};
+
+//------------------------------------------------------------------------------
+// StrandsMesh
+//
+// The strands are rendered as native curves by the accelerators supporting
+// them, otherwise they are tessellated with the options of the shape.
+//------------------------------------------------------------------------------
+
+class StrandsMesh : public luxrays::ExtCurveMesh {
+public:
+	StrandsMesh(const Scene *scene, const StrendsShape::TessellationType tesselType,
+			const u_int adaptiveMaxDepth, const float adaptiveError,
+			const u_int solidSideCount, const bool solidCapBottom, const bool solidCapTop,
+			const bool useCameraPosition,
+			const u_int curveVertCount, const u_int curveSegmentCount,
+			float *curveVertices, u_int *curveSegments, u_int *segmentPoints,
+			luxrays::UV *pointUVs, luxrays::Spectrum *pointCols, float *pointAlphas);
+	virtual ~StrandsMesh() { }
+
+protected:
+	virtual void TessellateCurves(u_int *meshVertCount, u_int *meshTriCount,
+		luxrays::Point **meshVertices, luxrays::Triangle **meshTris,
+		luxrays::Normal **meshNormals, luxrays::UV **meshUVs,
+		luxrays::Spectrum **meshCols, float **meshAlphas) const;
+
+	void TessellateRibbon(const vector<luxrays::Point> &hairPoints,
 		const vector<float> &hairSizes, const vector<luxrays::Spectrum> &hairCols,
 		const vector<luxrays::UV> &hairUVs, const vector<float> &hairTransps,
 		vector<luxrays::Point> &meshVerts, vector<luxrays::Normal> &meshNorms,
 		vector<luxrays::Triangle> &meshTris, vector<luxrays::UV> &meshUVs, vector<luxrays::Spectrum> &meshCols,
 		vector<float> &meshTransps) const;
-	void TessellateAdaptive(const Scene *scene,
-		const bool solid, const vector<luxrays::Point> &hairPoints,
+	void TessellateAdaptive(const bool solid, const vector<luxrays::Point> &hairPoints,
 		const vector<float> &hairSizes, const vector<luxrays::Spectrum> &hairCols,
 		const vector<luxrays::UV> &hairUVs, const vector<float> &hairTransps,
 		vector<luxrays::Point> &meshVerts, vector<luxrays::Normal> &meshNorms,
 		vector<luxrays::Triangle> &meshTris, vector<luxrays::UV> &meshUVs, vector<luxrays::Spectrum> &meshCols,
 		vector<float> &meshTransps) const;
-	void TessellateSolid(const Scene *scene,
-		const vector<luxrays::Point> &hairPoints,
+	void TessellateSolid(const vector<luxrays::Point> &hairPoints,
 		const vector<float> &hairSizes, const vector<luxrays::Spectrum> &hairCols,
 		const vector<luxrays::UV> &hairUVs, const vector<float> &hairTransps,
 		vector<luxrays::Point> &meshVerts, vector<luxrays::Normal> &meshNorms,
 		vector<luxrays::Triangle> &meshTris, vector<luxrays::UV> &meshUVs, vector<luxrays::Spectrum> &meshCols,
 		vector<float> &meshTransps) const;
 
+	// The scene camera is used by the ribbon tessellation
+	const Scene *scene;
+
 	// Tessellation options
+	StrendsShape::TessellationType tesselType;
 	u_int adaptiveMaxDepth;
 	float adaptiveError;
 	u_int solidSideCount;
 	bool solidCapBottom, solidCapTop;
 	bool useCameraPosition;
-
-	luxrays::ExtMesh *mesh;
 };
 
 }
@@ -41,6 +41,10 @@ public:
 	virtual float Filter() const { return .5f; }
 
 	const vector<float> &GetData() const { return data; }
+	int GetNx() const { return nx; }
+	int GetNy() const { return ny; }
+	int GetNz() const { return nz; }
+	WrapMode GetWrapMode() const { return wrapMode; }
 
 	virtual luxrays::Properties ToProperties(const ImageMapCache &imgMapCache) const;
 	const TextureMapping3D *GetTextureMapping() const { return mapping; }
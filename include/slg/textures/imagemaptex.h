@@ -50,9 +50,15 @@ public:
 	virtual luxrays::Properties ToProperties(const ImageMapCache &imgMapCache) const;
 
 private:
+	// Return the mapped UV and the footprint of the hit point in the image
+	// UV space
+	luxrays::UV GetUV(const HitPoint &hitPoint, float *footprint) const;
+
 	const ImageMap *imageMap;
 	const TextureMapping2D *mapping;
 	float gain;
+	// True if the image map can be filtered over the footprint of the hit point
+	bool filtered;
 };
 
 }
@@ -0,0 +1,111 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#ifndef _SLG_CHUNKFILE_H
+#define	_SLG_CHUNKFILE_H
+
+#include <string>
+#include <vector>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "luxrays/luxrays.h"
+
+namespace slg {
+
+/*
+ * A binary container used to save films and render states. The content is
+ * a list of blocks of raw bytes (i.e. one for each film channel) split in
+ * chunks. Each chunk is compressed on its own, so the chunks can be
+ * compressed and decompressed in parallel, and has a CRC-32 checksum.
+ *
+ * The file layout (all integers are little endian) is:
+ *
+ *  - the "SLGCHUNK" magic string, the format version and the block count
+ *  - the size of each block
+ *  - for each chunk: block index, compression type, offset inside the
+ *    block, raw size, stored size, checksum and the stored data
+ */
+
+class ChunkFileWriter {
+public:
+	ChunkFileWriter(const bool compress = true);
+	~ChunkFileWriter();
+
+	// The data is copied so it can be modified as soon as the method returns
+	void AddBlock(const void *data, const size_t size);
+
+	// Compresses the chunks in parallel and writes the file. The file is
+	// replaced only once it has been completely written.
+	void Write(const std::string &fileName);
+
+	static const size_t CHUNK_SIZE;
+
+private:
+	class Chunk {
+	public:
+		u_int blockIndex, compression, checksum;
+		size_t offset, rawSize;
+		std::vector<char> data;
+	};
+
+	void ProcessChunk(Chunk *chunk) const;
+	void WriteFile(const std::string &fileName) const;
+
+	const bool compress;
+	std::vector<size_t> blockSizes;
+	std::vector<Chunk *> chunks;
+};
+
+class ChunkFileReader {
+public:
+	// The file is memory mapped
+	ChunkFileReader(const std::string &fileName);
+	~ChunkFileReader();
+
+	u_int GetBlockCount() const { return blockSizes.size(); }
+	size_t GetBlockSize(const u_int index) const { return blockSizes[index]; }
+
+	// Decompresses (in parallel) and checks a block. data must be
+	// GetBlockSize(index) bytes long.
+	void ReadBlock(const u_int index, void *data);
+
+	// Returns true if the file starts with the chunk file magic string
+	static bool IsChunkFile(const std::string &fileName);
+
+private:
+	class Chunk {
+	public:
+		u_int blockIndex, compression, checksum;
+		size_t offset, rawSize, storedSize;
+		const char *data;
+	};
+
+	static bool ChunkLess(const Chunk *a, const Chunk *b);
+
+	void ProcessChunk(const Chunk &chunk, char *blockData) const;
+
+	const std::string fileName;
+	boost::iostreams::mapped_file_source file;
+	std::vector<size_t> blockSizes;
+	std::vector<Chunk> chunks;
+};
+
+}
+
+#endif	/* _SLG_CHUNKFILE_H */
@@ -0,0 +1,58 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#ifndef _SLG_PATHFOOTPRINT_H
+#define	_SLG_PATHFOOTPRINT_H
+
+#include "slg/slg.h"
+#include "slg/bsdf/bsdfevents.h"
+
+namespace slg {
+
+class Camera;
+
+//------------------------------------------------------------------------------
+// PathFootprint
+//
+// An estimation of the size of the area seen by a pixel along an eye path,
+// used to filter MIP-mapped textures. It is a cone starting at the camera and
+// growing with the length of the path. The footprint is unknown (i.e. 0 and
+// textures are not filtered) along light paths and after a specular bounce,
+// where the cone would require ray differentials.
+//------------------------------------------------------------------------------
+
+class PathFootprint {
+public:
+	// An unknown footprint
+	PathFootprint() : width(0.f), spread(0.f) { }
+	// The footprint of a camera ray
+	PathFootprint(const Camera &camera);
+	~PathFootprint() { }
+
+	// The footprint at the distance t along the current path ray
+	float GetFootprint(const float t) const { return width + spread * t; }
+	// Move the origin of the cone to the distance t along the current path
+	// ray, after a bounce of the type event
+	void Bounce(const float t, const BSDFEvent event);
+
+	float width, spread;
+};
+
+}
+
+#endif	/* _SLG_PATHFOOTPRINT_H */
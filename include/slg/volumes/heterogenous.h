@@ -23,16 +23,34 @@
 
 namespace slg {
 
+class DensityGridTexture;
+
 //------------------------------------------------------------------------------
 // HeterogeneousVolume
 //------------------------------------------------------------------------------
 
+// Max. number of tentative collisions of delta/ratio tracking along a ray
+#define HETEROGENEOUS_VOL_MAX_TRACKING_STEPS 65536u
+// Size, in voxels, of the cells of the majorant grid
+#define HETEROGENEOUS_VOL_MAJORANT_CELL_SIZE 8
+
 class HeterogeneousVolume : public Volume {
 public:
+	typedef enum {
+		// Fixed step ray marching (biased)
+		RAY_MARCHING,
+		// Delta tracking to sample the scattering distance and ratio tracking
+		// to estimate the transmittance (unbiased)
+		DELTA_TRACKING
+	} TrackingType;
+
+	// majorant is an upper bound of SigmaT used by DELTA_TRACKING when it
+	// can not be computed from the textures (0 to compute it)
 	HeterogeneousVolume(const Texture *iorTex, const Texture *emiTex,
 			const Texture *a, const Texture *s,
 			const Texture *g, const float stepSize, const u_int maxStepsCount,
-			const bool multiScattering);
+			const bool multiScattering, const TrackingType tracking = RAY_MARCHING,
+			const float majorant = 0.f);
 
 	virtual float Scatter(const luxrays::Ray &ray, const float u, const bool scatteredStart,
 		luxrays::Spectrum *connectionThroughput, luxrays::Spectrum *connectionEmission) const;
@@ -65,17 +83,49 @@ public:
 	float GetStepSize() const { return stepSize; }
 	u_int GetMaxStepsCount() const { return maxStepsCount; }
 	bool IsMultiScattering() const { return multiScattering; }
+	TrackingType GetTrackingType() const { return tracking; }
+
+	static TrackingType String2TrackingType(const std::string &type);
+	static std::string TrackingType2String(const TrackingType type);
+
+	friend class HeterogeneousVolumeMajorantIterator;
 
 protected:
 	virtual luxrays::Spectrum SigmaA(const HitPoint &hitPoint) const;
 	virtual luxrays::Spectrum SigmaS(const HitPoint &hitPoint) const;
 
 private:
+	float ScatterRayMarching(const luxrays::Ray &ray, const float u, const bool scatteredStart,
+		luxrays::Spectrum *connectionThroughput, luxrays::Spectrum *connectionEmission) const;
+	float ScatterDeltaTracking(const luxrays::Ray &ray, const float u, const bool scatteredStart,
+		luxrays::Spectrum *connectionThroughput, luxrays::Spectrum *connectionEmission) const;
+
+	void PreprocessMajorant();
+
 	const Texture *sigmaA, *sigmaS;
 	SchlickScatter schlickScatter;
 	float stepSize;
 	u_int maxStepsCount;
 	const bool multiScattering;
+	const TrackingType tracking;
+	const float userMajorant;
+
+	// The majorant of SigmaT used by DELTA_TRACKING. If the textures use a
+	// DensityGridTexture with a world space mapping, the majorant inside the
+	// grid is gridMajorantScale * majorantGrid[cell] + gridMajorantOffset
+	// where majorantGrid is a coarse grid of the max. absolute values of
+	// the density grid. Otherwise it is the constant majorant.
+	float majorant;
+	// False if tracking is RAY_MARCHING or if the majorant is not available
+	// anymore after a texture edit (see UpdateTextureReferences()): ray
+	// marching is used in both cases
+	bool deltaTrackingEnabled;
+	const DensityGridTexture *majorantGridTex;
+	float gridMajorantScale, gridMajorantOffset;
+	// The majorant outside the [0, 1]^3 box of the density grid
+	float outsideMajorant;
+	int majorantGridSize[3];
+	std::vector<float> majorantGrid;
 };
 
 }
@@ -0,0 +1,123 @@
+# -*- coding: utf-8 -*-
+################################################################################
+# Copyright 1998-2015 by authors (see AUTHORS.txt)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+
+import gc
+import unittest
+import pyluxcore
+
+from pyluxcoreunittests.tests.utils import *
+
+################################################################################
+# Scene.DefineMesh() with buffer protocol objects tests
+################################################################################
+
+# A quad made of 2 triangles
+quadVertices = [-1.0, -1.0, 0.0,  1.0, -1.0, 0.0,  1.0, 1.0, 0.0,  -1.0, 1.0, 0.0]
+quadTriangles = [0, 1, 2,  0, 2, 3]
+
+def CreateConfig():
+	props = pyluxcore.Properties(LuxCoreTest.customConfigProps)
+	props.SetFromFile("resources/scenes/simple/simple.cfg")
+	props.Set(GetEngineProperties("PATHCPU"))
+
+	return pyluxcore.RenderConfig(props)
+
+def AddQuadObject(scene):
+	scene.Parse(pyluxcore.Properties().SetFromString("""
+		scene.objects.quad.shape = quad
+		scene.objects.quad.material = greenmatte
+		"""))
+
+class SceneDefineMesh(LuxCoreTest):
+	def test_SceneDefineMesh_Buffers(self):
+		config = CreateConfig()
+		scene = config.GetScene()
+
+		scene.DefineMesh("quad", array('f', quadVertices), array('I', quadTriangles), None, None, None, None)
+		AddQuadObject(scene)
+
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
+
+	def test_SceneDefineMesh_WrongBuffers(self):
+		config = CreateConfig()
+		scene = config.GetScene()
+
+		# Out of range triangle index
+		with self.assertRaises(RuntimeError):
+			scene.DefineMesh("quad", array('f', quadVertices), array('I', [0, 1, 2,  0, 2, 4]), None, None, None, None)
+		with self.assertRaises(RuntimeError):
+			scene.DefineMesh("quad", [(-1.0, -1.0, 0.0), (1.0, -1.0, 0.0), (1.0, 1.0, 0.0)],
+					[(0, 1, 3)], None, None, None, None)
+
+		# Buffer sizes not multiple of the element size
+		with self.assertRaises(RuntimeError):
+			scene.DefineMesh("quad", array('f', quadVertices + [0.0, 0.0]), array('I', quadTriangles), None, None, None, None)
+		with self.assertRaises(RuntimeError):
+			scene.DefineMesh("quad", array('f', quadVertices), array('I', quadTriangles + [0]), None, None, None, None)
+
+		# Wrong item type
+		with self.assertRaises(RuntimeError):
+			scene.DefineMesh("quad", array('d', quadVertices), array('I', quadTriangles), None, None, None, None)
+
+		self.assertFalse(scene.IsMeshDefined("quad"))
+
+	def test_SceneDefineMesh_NoDeleteMeshData(self):
+		config = CreateConfig()
+		scene = config.GetScene()
+		scene.SetDeleteMeshData(False)
+
+		# A padded vertex buffer is used in place, the other buffers (a list
+		# and a read-only buffer) are copied. All of them must stay valid
+		# without any reference held by the caller.
+		scene.DefineMesh("quad", array('f', quadVertices + [0.0]), memoryview(array('I', quadTriangles).tobytes()).cast('I'),
+				[(0.0, 0.0, 1.0)] * 4, None, None, None)
+		AddQuadObject(scene)
+		gc.collect()
+
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
+
+		# Redefine the mesh with buffers without padding
+		scene.DefineMesh("quad", array('f', quadVertices), array('I', quadTriangles), None, None, None, None)
+		gc.collect()
+
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
+
+	def test_SceneDefineMesh_NoDeleteMeshDataTemporaryScene(self):
+		config = CreateConfig()
+		config.GetScene().SetDeleteMeshData(False)
+
+		# Each GetScene() returns a new Python object: the buffers must be
+		# kept alive by the Scene and not by the temporary Python object
+		config.GetScene().DefineMesh("quad", array('f', quadVertices + [0.0]), array('I', quadTriangles),
+				None, None, None, None)
+		gc.collect()
+		AddQuadObject(config.GetScene())
+		gc.collect()
+
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
+
+		# The buffers of the old mesh are released when it is redefined
+		config.GetScene().DefineMesh("quad", [(-1.0, -1.0, 0.0), (1.0, -1.0, 0.0), (1.0, 1.0, 0.0), (-1.0, 1.0, 0.0)],
+				[(0, 1, 2), (0, 2, 3)], None, None, None, None)
+		gc.collect()
+
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
@@ -0,0 +1,109 @@
+# -*- coding: utf-8 -*-
+################################################################################
+# Copyright 1998-2015 by authors (see AUTHORS.txt)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+
+import gc
+import unittest
+import pyluxcore
+
+from pyluxcoreunittests.tests.utils import *
+
+################################################################################
+# Film channel access tests
+################################################################################
+
+def StartSession():
+	props = pyluxcore.Properties(LuxCoreTest.customConfigProps)
+	props.SetFromFile("resources/scenes/simple/simple.cfg")
+	props.Set(GetEngineProperties("PATHCPU"))
+
+	config = pyluxcore.RenderConfig(props)
+	session = pyluxcore.RenderSession(config)
+	session.Start()
+	session.WaitForDone()
+
+	return session
+
+class FilmChannels(LuxCoreTest):
+	def test_FilmChannels_View(self):
+		session = StartSession()
+		film = session.GetFilm()
+
+		channelType = pyluxcore.FilmChannelType.RADIANCE_PER_PIXEL_NORMALIZED
+		size = film.GetChannelSize(channelType)
+		self.assertEqual(size, film.GetWidth() * film.GetHeight() * 4)
+
+		view = film.GetChannelFloat(channelType)
+		self.assertEqual(view.format, "f")
+		self.assertTrue(view.readonly)
+		self.assertEqual(len(view), size)
+
+		# The copy has the same content of the view
+		buffer = array('f', [0.0] * size)
+		film.GetChannelFloat(channelType, buffer)
+		self.assertEqual(view.tolist(), buffer.tolist())
+
+		# A read-only buffer is not accepted
+		with self.assertRaises(RuntimeError):
+			film.GetChannelFloat(channelType, bytes(size * 4))
+
+		session.Stop()
+
+	def test_FilmChannels_ViewLifetime(self):
+		session = StartSession()
+		channelType = pyluxcore.FilmChannelType.RADIANCE_PER_PIXEL_NORMALIZED
+		view = session.GetFilm().GetChannelFloat(channelType)
+		session.Stop()
+		values = view.tolist()
+
+		# The view keeps the film and the session alive
+		del session
+		gc.collect()
+		self.assertEqual(view.tolist(), values)
+
+	def test_FilmChannels_NoResizeWithViews(self):
+		session = StartSession()
+		film = session.GetFilm()
+		channelType = pyluxcore.FilmChannelType.RADIANCE_PER_PIXEL_NORMALIZED
+		view = film.GetChannelFloat(channelType)
+
+		resizeProps = pyluxcore.Properties().SetFromString("""
+			film.width = 256
+			film.height = 192
+			""")
+		with self.assertRaises(RuntimeError):
+			session.Parse(resizeProps)
+		self.assertEqual(film.GetWidth(), 512)
+
+		# The film can be resized once the views are released
+		view.release()
+		del view
+		gc.collect()
+		session.Parse(resizeProps)
+		self.assertEqual(film.GetWidth(), 256)
+
+		session.Stop()
+
+	def test_FilmChannels_4xFloatNormalization(self):
+		# The alpha is the largest value and it must not be used to normalize
+		src = array('f', [1.0, 2.0, 0.5, 8.0,  4.0, 1.0, 2.0, 8.0])
+
+		l = pyluxcore.ConvertFilmChannelOutput_4xFloat_To_4xFloatList(2, 1, src, True)
+		dst = array('f', [0.0] * 8)
+		pyluxcore.ConvertFilmChannelOutput_4xFloat_To_4xFloatBuffer(2, 1, src, dst, True)
+
+		self.assertEqual([v for pixel in l for v in pixel], dst.tolist())
+		self.assertEqual(dst.tolist(), [0.25, 0.5, 0.125, 8.0,  1.0, 0.25, 0.5, 8.0])
@@ -0,0 +1,76 @@
+# -*- coding: utf-8 -*-
+################################################################################
+# Copyright 1998-2015 by authors (see AUTHORS.txt)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+
+import os
+import shutil
+import tempfile
+import unittest
+import pyluxcore
+
+from pyluxcoreunittests.tests.utils import *
+
+################################################################################
+# Image map tile cache tests
+################################################################################
+
+class ImageCache(LuxCoreTest):
+	def setUp(self):
+		self.cacheDir = tempfile.mkdtemp()
+
+	def tearDown(self):
+		shutil.rmtree(self.cacheDir, ignore_errors = True)
+
+	def GetTxFiles(self):
+		return [f for f in os.listdir(self.cacheDir) if f.endswith(".tx")]
+
+	def test_ImageCache_RenderConfig(self):
+		props = pyluxcore.Properties(LuxCoreTest.customConfigProps)
+		props.SetFromFile("resources/scenes/simple/texture-imagemap.cfg")
+		props.Set(GetEngineProperties("PATHCPU"))
+		props.Set(pyluxcore.Property("images.cache.enable", True))
+		props.Set(pyluxcore.Property("images.cache.maxmemory", 16))
+		props.Set(pyluxcore.Property("images.cache.dir", self.cacheDir))
+
+		config = pyluxcore.RenderConfig(props)
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
+
+		# The tiled version of the image has been written in the cache directory
+		self.assertEqual(len(self.GetTxFiles()), 1)
+
+	def test_ImageCache_Scene(self):
+		scene = pyluxcore.Scene()
+		scene.EnableImageCache(16 * 1024 * 1024, self.cacheDir)
+		# The cache can not be changed once enabled
+		with self.assertRaises(RuntimeError):
+			scene.EnableImageCache(32 * 1024 * 1024)
+
+		scene.Parse(pyluxcore.Properties().SetFromFile("resources/scenes/simple/texture-imagemap.scn").Set(
+			pyluxcore.Properties().SetFromString("""
+				scene.camera.lookat.orig = 7 -15 7
+				scene.camera.lookat.target = -1.0 0.0 2.0
+				""")))
+		self.assertEqual(len(self.GetTxFiles()), 1)
+
+		props = pyluxcore.Properties(LuxCoreTest.customConfigProps)
+		props.Set(GetEngineProperties("PATHCPU"))
+		props.Set(pyluxcore.Property("film.width", 512))
+		props.Set(pyluxcore.Property("film.height", 384))
+
+		config = pyluxcore.RenderConfig(props, scene)
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
@@ -0,0 +1,136 @@
+# -*- coding: utf-8 -*-
+################################################################################
+# Copyright 1998-2015 by authors (see AUTHORS.txt)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+
+import os
+import shutil
+import struct
+import tempfile
+import unittest
+import pyluxcore
+
+from pyluxcoreunittests.tests.utils import *
+
+################################################################################
+# LuxRays binary mesh format (.lxm) tests
+################################################################################
+
+# The mesh saved by the tests
+meshName = "resources/scenes/simple/simple-mat-cube1.ply"
+
+# The layout of the .lxm header: magic, version, byte order mark, vertex and
+# triangle counts and the offsets of the vertices, triangles, normals, UVs,
+# colors and alphas arrays
+lxmHeaderFormat = "=8sIIII6Q"
+
+def CreateConfig():
+	props = pyluxcore.Properties(LuxCoreTest.customConfigProps)
+	props.SetFromFile("resources/scenes/simple/simple.cfg")
+	props.Set(GetEngineProperties("PATHCPU"))
+
+	return pyluxcore.RenderConfig(props)
+
+def ReadFile(fileName):
+	with open(fileName, "rb") as f:
+		return f.read()
+
+def WriteFile(fileName, data):
+	with open(fileName, "wb") as f:
+		f.write(data)
+
+class LxmMesh(LuxCoreTest):
+	def setUp(self):
+		self.tmpDir = tempfile.mkdtemp()
+
+	def tearDown(self):
+		shutil.rmtree(self.tmpDir)
+
+	def SaveMesh(self):
+		lxmFileName = os.path.join(self.tmpDir, "mesh.lxm")
+		CreateConfig().GetScene().SaveMesh(meshName, lxmFileName)
+
+		return lxmFileName
+
+	def LoadMesh(self, config, fileName):
+		config.GetScene().Parse(pyluxcore.Properties().SetFromString("""
+			scene.objects.lxmbox.ply = """ + fileName + """
+			scene.objects.lxmbox.material = greenmatte
+			"""))
+
+	def test_LxmMesh_SaveLoad(self):
+		lxmFileName = self.SaveMesh()
+
+		header = struct.unpack_from(lxmHeaderFormat, ReadFile(lxmFileName))
+		self.assertEqual(header[0], b"LXMESH\0\0")
+		self.assertGreater(header[3], 0)
+		self.assertGreater(header[4], 0)
+
+		# The loaded mesh, saved again, must be identical
+		config = CreateConfig()
+		self.LoadMesh(config, lxmFileName)
+		lxmFileName2 = os.path.join(self.tmpDir, "mesh2.lxm")
+		config.GetScene().SaveMesh(lxmFileName, lxmFileName2)
+		self.assertEqual(ReadFile(lxmFileName2), ReadFile(lxmFileName))
+
+		# And the same of the original mesh saved as PLY
+		plyFileName = os.path.join(self.tmpDir, "mesh.ply")
+		plyFileName2 = os.path.join(self.tmpDir, "mesh2.ply")
+		config.GetScene().SaveMesh(meshName, plyFileName)
+		config.GetScene().SaveMesh(lxmFileName, plyFileName2)
+		self.assertEqual(ReadFile(plyFileName2), ReadFile(plyFileName))
+
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
+
+	def CheckCorruptedMesh(self, name, data):
+		fileName = os.path.join(self.tmpDir, name + ".lxm")
+		WriteFile(fileName, data)
+
+		config = CreateConfig()
+		with self.assertRaises(RuntimeError):
+			self.LoadMesh(config, fileName)
+
+	def test_LxmMesh_Corrupted(self):
+		data = ReadFile(self.SaveMesh())
+		header = list(struct.unpack_from(lxmHeaderFormat, data))
+		headerSize = struct.calcsize(lxmHeaderFormat)
+
+		# Truncated files
+		self.CheckCorruptedMesh("truncatedheader", data[:headerSize // 2])
+		self.CheckCorruptedMesh("truncated", data[:len(data) // 2])
+		self.CheckCorruptedMesh("truncatedlast", data[:-1])
+
+		# Offsets outside the file, including ones overflowing the checks
+		for i, offset in enumerate([len(data) + 64, 2 ** 64 - 64, 2 ** 63]):
+			for array in [5, 6]:
+				h = list(header)
+				h[array] = offset
+				self.CheckCorruptedMesh("badoffset%d%d" % (i, array), struct.pack(lxmHeaderFormat, *h) + data[headerSize:])
+
+		# Vertex and triangle counts larger than the arrays
+		for array, count in [(3, 2 ** 32 - 1), (4, 2 ** 32 - 1)]:
+			h = list(header)
+			h[array] = count
+			self.CheckCorruptedMesh("badcount%d" % array, struct.pack(lxmHeaderFormat, *h) + data[headerSize:])
+
+		# Out of range triangle index
+		trisOffset = header[6]
+		vertCount = header[3]
+		self.CheckCorruptedMesh("badindex", data[:trisOffset + 4] + struct.pack("=I", vertCount) + data[trisOffset + 8:])
+
+		# The original file is still valid
+		config = CreateConfig()
+		self.LoadMesh(config, os.path.join(self.tmpDir, "mesh.lxm"))
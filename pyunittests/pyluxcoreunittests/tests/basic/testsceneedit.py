@@ -58,3 +58,101 @@ class SceneEditRendering(ImageTest):
 		SceneEdit(self, session, frame)
 
 SceneEditRendering = AddTests(SceneEditRendering, TestSceneEditRendering, GetEngineListWithSamplers())
+
+################################################################################
+# Delete light test
+################################################################################
+
+class SceneDeleteLight(LuxCoreTest):
+	def test_SceneDeleteLight(self):
+		props = pyluxcore.Properties(LuxCoreTest.customConfigProps)
+		props.SetFromFile("resources/scenes/simple/light-point.cfg")
+		props.Set(GetEngineProperties("PATHCPU"))
+		config = pyluxcore.RenderConfig(props)
+		scene = config.GetScene()
+
+		# Add a second light and delete both, the first by name and the
+		# second by handle
+		scene.Parse(pyluxcore.Properties().SetFromString("""
+			scene.lights.l2.type = point
+			scene.lights.l2.position = 0.0 0.0 4.0
+			scene.lights.l2.gain = 50.0 50.0 50.0
+			scene.lights.l3.type = point
+			scene.lights.l3.position = 0.0 0.0 2.0
+			scene.lights.l3.gain = 50.0 50.0 50.0
+			"""))
+		self.assertEqual(scene.GetLightCount(), 3)
+
+		l1Handle = scene.GetLightHandle("l1")
+		l2Handle = scene.GetLightHandle("l2")
+		scene.DeleteLight("l1")
+		scene.DeleteLights([l2Handle])
+		self.assertEqual(scene.GetLightCount(), 1)
+
+		# Enumerate the remaining lights
+		sceneProps = scene.ToProperties()
+		self.assertEqual(sceneProps.GetAllUniqueSubNames("scene.lights"), ["scene.lights.l3"])
+
+		# Deleted lights can not be referenced anymore
+		self.assertRaises(RuntimeError, scene.GetLightHandle, "l1")
+		# An invalid handle doesn't delete anything
+		l3Handle = scene.GetLightHandle("l3")
+		self.assertRaises(RuntimeError, scene.DeleteLights, [l3Handle, l3Handle + 1000])
+		self.assertEqual(scene.GetLightCount(), 1)
+
+		# The handles of deleted lights stay invalid even when a new light
+		# reuses their slot
+		scene.Parse(pyluxcore.Properties().SetFromString("""
+			scene.lights.l4.type = point
+			scene.lights.l4.position = 0.0 0.0 4.0
+			scene.lights.l4.gain = 50.0 50.0 50.0
+			"""))
+		self.assertNotIn(scene.GetLightHandle("l4"), [l1Handle, l2Handle])
+		self.assertRaises(RuntimeError, scene.DeleteLights, [l1Handle])
+		self.assertRaises(RuntimeError, scene.DeleteLights, [l2Handle])
+		self.assertEqual(scene.GetLightCount(), 2)
+		scene.DeleteLight("l4")
+
+		# Render the edited scene
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
+
+################################################################################
+# Delete objects test
+################################################################################
+
+class SceneDeleteObjects(LuxCoreTest):
+	def test_SceneDeleteObjects(self):
+		props = pyluxcore.Properties(LuxCoreTest.customConfigProps)
+		props.SetFromFile("resources/scenes/simple/simple.cfg")
+		props.Set(GetEngineProperties("PATHCPU"))
+		config = pyluxcore.RenderConfig(props)
+		scene = config.GetScene()
+
+		box1Handle = scene.GetObjectHandle("box1")
+		lightHandle = scene.GetObjectHandle("lightplanes")
+		lightCount = scene.GetLightCount()
+
+		# An invalid handle doesn't delete anything
+		self.assertRaises(RuntimeError, scene.DeleteObjects, [box1Handle, lightHandle, box1Handle + 1000])
+		self.assertEqual(scene.GetObjectCount(), 5)
+		self.assertEqual(scene.GetLightCount(), lightCount)
+
+		# Duplicated handles are ignored
+		scene.DeleteObjects([box1Handle, lightHandle, box1Handle, lightHandle])
+		self.assertEqual(scene.GetObjectCount(), 3)
+		self.assertEqual(scene.GetLightCount(), 0)
+
+		# A stale handle doesn't reference the object defined after the delete
+		scene.Parse(pyluxcore.Properties().SetFromString("""
+			scene.objects.box5.ply = resources/scenes/simple/simple-mat-cube1.ply
+			scene.objects.box5.material = redmatte
+			"""))
+		self.assertNotIn(scene.GetObjectHandle("box5"), [box1Handle, lightHandle])
+		self.assertRaises(RuntimeError, scene.DeleteObjects, [box1Handle])
+		self.assertRaises(RuntimeError, scene.UpdateObjectTransformations, [lightHandle], [1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0])
+		self.assertEqual(scene.GetObjectCount(), 4)
+
+		# Render the edited scene
+		(size, imageBufferFloat) = Render(config)
+		self.assertEqual(size, (512, 384))
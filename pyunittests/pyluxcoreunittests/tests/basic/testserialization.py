@@ -0,0 +1,150 @@
+# -*- coding: utf-8 -*-
+################################################################################
+# Copyright 1998-2015 by authors (see AUTHORS.txt)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+
+import os
+import shutil
+import tempfile
+import unittest
+import pyluxcore
+
+from pyluxcoreunittests.tests.utils import *
+
+################################################################################
+# Film and render state serialization tests
+################################################################################
+
+class Serialization(LuxCoreTest):
+	def setUp(self):
+		self.tmpDir = tempfile.mkdtemp()
+
+	def tearDown(self):
+		shutil.rmtree(self.tmpDir)
+
+	def CreateConfig(self):
+		props = pyluxcore.Properties(LuxCoreTest.customConfigProps)
+		props.SetFromFile("resources/scenes/simple/simple.cfg")
+		props.Set(GetEngineProperties("PATHCPU"))
+
+		return pyluxcore.RenderConfig(props)
+
+	def test_Serialization_FilmAndRenderState(self):
+		filmFileName = os.path.join(self.tmpDir, "test.flm")
+		stateFileName = os.path.join(self.tmpDir, "test.rst")
+
+		# Render and save the film and the render state
+		config = self.CreateConfig()
+		session = pyluxcore.RenderSession(config)
+		session.Start()
+		session.WaitForDone()
+		session.Pause()
+
+		state = session.GetRenderState()
+		state.Save(stateFileName)
+		session.GetFilm().SaveFilm(filmFileName)
+
+		# The temporary file used while writing is gone
+		self.assertTrue(os.path.exists(filmFileName))
+		self.assertFalse(os.path.exists(filmFileName + ".tmp"))
+		self.assertFalse(os.path.exists(stateFileName + ".tmp"))
+
+		rendering = GetRendering(session)
+
+		session.Resume()
+		session.Stop()
+
+		# The loaded film must be identical
+		film = pyluxcore.Film(filmFileName)
+		self.assertEqual(film.GetWidth(), 512)
+		self.assertEqual(film.GetHeight(), 384)
+		self.assertEqual(GetFilmRendering(film), rendering)
+
+		# Resume the rendering from the saved film and render state
+		session = pyluxcore.RenderSession(self.CreateConfig(), stateFileName, filmFileName)
+		session.Start()
+		session.Stop()
+
+	def test_Serialization_OldFormat(self):
+		# A film and a PATHCPU render state saved in the gzip compressed format
+		# used before the chunk files. Each pixel of the film has 4 samples of
+		# (0.5, 0.25, 0.125).
+		filmFileName = "resources/serialization/oldformat.flm"
+		stateFileName = "resources/serialization/oldformat.rst"
+
+		channelType = pyluxcore.FilmChannelType.RADIANCE_PER_PIXEL_NORMALIZED
+		pixel = [2.0, 1.0, 0.5, 4.0]
+
+		film = pyluxcore.Film(filmFileName)
+		self.assertEqual(film.GetWidth(), 512)
+		self.assertEqual(film.GetHeight(), 384)
+
+		size = film.GetChannelSize(channelType)
+		pixels = array('f', [0.0] * size)
+		film.GetChannelFloat(channelType, pixels)
+		self.assertEqual(pixels[0:4].tolist(), pixel)
+		self.assertEqual(pixels[size - 4:size].tolist(), pixel)
+
+		# Saved again in the new format, it must be identical
+		newFilmFileName = os.path.join(self.tmpDir, "test.flm")
+		film.SaveFilm(newFilmFileName)
+		newPixels = array('f', [0.0] * size)
+		pyluxcore.Film(newFilmFileName).GetChannelFloat(channelType, newPixels)
+		self.assertEqual(newPixels, pixels)
+
+		# Resume the rendering from the old film and render state
+		session = pyluxcore.RenderSession(self.CreateConfig(), stateFileName, filmFileName)
+		session.Start()
+		session.Stop()
+
+	def test_Serialization_AsyncFilmSave(self):
+		filmFileName = os.path.join(self.tmpDir, "test.flm")
+
+		config = self.CreateConfig()
+		session = pyluxcore.RenderSession(config)
+		session.Start()
+		session.WaitForDone()
+
+		# The second save waits for the end of the first one
+		session.GetFilm().SaveFilm(filmFileName, True)
+		session.GetFilm().SaveFilm(filmFileName, False)
+		session.Stop()
+
+		film = pyluxcore.Film(filmFileName)
+		self.assertEqual(film.GetWidth(), 512)
+
+	def test_Serialization_CorruptedFilm(self):
+		filmFileName = os.path.join(self.tmpDir, "test.flm")
+
+		config = self.CreateConfig()
+		session = pyluxcore.RenderSession(config)
+		session.Start()
+		session.WaitForDone()
+		session.Stop()
+		session.GetFilm().SaveFilm(filmFileName)
+
+		# Flip a byte in the pixel data
+		with open(filmFileName, "r+b") as f:
+			f.seek(-16, os.SEEK_END)
+			b = f.read(1)
+			f.seek(-16, os.SEEK_END)
+			f.write(bytes([b[0] ^ 0xff]))
+		self.assertRaises(RuntimeError, pyluxcore.Film, filmFileName)
+
+		# Truncate the file
+		size = os.path.getsize(filmFileName)
+		with open(filmFileName, "r+b") as f:
+			f.truncate(size // 2)
+		self.assertRaises(RuntimeError, pyluxcore.Film, filmFileName)
@@ -153,3 +153,40 @@ class TestProperties(unittest.TestCase):
 		self.assertEqual(props.Get("test1.prop1").Get(), ["1", "2.0", "aa", "quoted"])
 		self.assertEqual(props.Get("test2.pr op2").Get(), ["1", "2.0", "quoted", "bb"])
 		self.assertEqual(props.Get("test2.prop3").Get(), ["1"])
+
+	def test_Properties_SetFromStringParser(self):
+		props = pyluxcore.Properties()
+		props.SetFromString("# comment\n\n  test1.prop1 = 1 \t 2\r\ntest1.prop2 = {[AAAA]}\n\t\ntest1.prop1 = 3 \"a b\"\n")
+		self.assertEqual(props.GetAllNames(), ["test1.prop1", "test1.prop2"])
+		self.assertEqual(props.Get("test1.prop1").Get(), ["3", "a b"])
+
+		with self.assertRaises(RuntimeError) as cm:
+			props.SetFromString("test1.prop1 = 1\n# comment\n\nsyntax error\n")
+		self.assertIn("line 4", str(cm.exception))
+
+		with self.assertRaises(RuntimeError):
+			props.SetFromString("test1.prop1 = 1 \"unterminated\n")
+
+	def test_Properties_SetFromStringLongLines(self):
+		# Lines longer than the parser chunk size, split across threads
+		count = 300000
+		values = [str(i) for i in range(count)]
+
+		lines = ["test1.prop1 = " + " \t ".join(values)]
+		lines.append("test1.prop2 = " + " ".join("'v " + v + "'" for v in values))
+		lines.append("test1.prop3 = 1")
+		lines += ["test2.prop%d = %d" % (i, i) for i in range(count)]
+		lines.append("syntax error")
+
+		props = pyluxcore.Properties()
+		with self.assertRaises(RuntimeError) as cm:
+			props.SetFromString("\n".join(lines))
+		self.assertIn("line %d" % (count + 4), str(cm.exception))
+
+		props = pyluxcore.Properties()
+		props.SetFromString("\n".join(lines[:-1]))
+		self.assertEqual(props.GetSize(), count + 3)
+		self.assertEqual(props.Get("test1.prop1").Get(), values)
+		self.assertEqual(props.Get("test1.prop2").Get(), ["v " + v for v in values])
+		self.assertEqual(props.Get("test1.prop3").Get(), ["1"])
+		self.assertEqual(props.Get("test2.prop%d" % (count - 1)).Get(), [str(count - 1)])
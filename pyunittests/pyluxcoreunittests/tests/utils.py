@@ -36,14 +36,16 @@ def AddTests(cls, testFunc, opts):
 		setattr(cls, test.__name__, test)
 	return cls
 
-def GetRendering(session):
+def GetFilmRendering(film):
 	# Get the rendering result
-	film = session.GetFilm()
 	imageBufferFloat = array('f', [0.0] * (film.GetWidth() * film.GetHeight() * 3))
-	session.GetFilm().GetOutputFloat(pyluxcore.FilmOutputType.RGB_TONEMAPPED, imageBufferFloat)
+	film.GetOutputFloat(pyluxcore.FilmOutputType.RGB_TONEMAPPED, imageBufferFloat)
 
 	return (film.GetWidth(), film.GetHeight()), imageBufferFloat
 
+def GetRendering(session):
+	return GetFilmRendering(session.GetFilm())
+
 def Render(config):
 	session = pyluxcore.RenderSession(config)
 
@@ -41,6 +41,7 @@ static void BatchSimpleMode(RenderConfig *config) {
 	const unsigned int haltTime = config->GetProperty("batch.halttime").Get<unsigned int>();
 	const unsigned int haltSpp = config->GetProperty("batch.haltspp").Get<unsigned int>();
 	const float haltThreshold = config->GetProperty("batch.haltthreshold").Get<float>();
+	const string periodicFilmFileName = config->GetProperty("batch.periodicsave.film.filename").Get<string>();
 
 	// Start the rendering
 	session->Start();
@@ -54,6 +55,10 @@ static void BatchSimpleMode(RenderConfig *config) {
 		if (session->NeedPeriodicFilmSave()) {
 			// Time to save the image and film
 			session->GetFilm().SaveOutputs();
+
+			// The film is written in background while the rendering goes on
+			if (periodicFilmFileName != "")
+				session->GetFilm().SaveFilm(periodicFilmFileName, true);
 		}
 
 		const double elapsedTime = stats.Get("stats.renderengine.time").Get<double>();
@@ -34,6 +34,7 @@ LightStrategyWindow::LightStrategyWindow(LuxCoreApp *a) : ObjectEditorWindow(a,
 		.Add("UNIFORM", 0)
 		.Add("POWER", 1)
 		.Add("LOG_POWER", 2)
+		.Add("LIGHT_TREE", 3)
 		.SetDefault("LOG_POWER");
 }
 
@@ -574,6 +574,11 @@ void LuxCoreApp::RunApp() {
 		if (session && session->NeedPeriodicFilmSave()) {
 			// Time to save the image and film
 			session->GetFilm().SaveOutputs();
+
+			// The film is written in background while the rendering goes on
+			const string periodicFilmFileName = config->GetProperties().Get(Property("batch.periodicsave.film.filename")("")).Get<string>();
+			if (periodicFilmFileName != "")
+				session->GetFilm().SaveFilm(periodicFilmFileName, true);
 		}
 
 		//----------------------------------------------------------------------
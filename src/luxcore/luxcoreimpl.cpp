@@ -42,10 +42,11 @@ using namespace luxcore::detail;
 //------------------------------------------------------------------------------
 
 FilmImpl::FilmImpl(const RenderSessionImpl &session) : renderSession(&session),
-		standAloneFilm(NULL) {
+		standAloneFilm(NULL), channelViewCount(0) {
 }
 
-FilmImpl::FilmImpl(const std::string &fileName) : renderSession(NULL) {
+FilmImpl::FilmImpl(const std::string &fileName) : renderSession(NULL),
+		channelViewCount(0) {
 	standAloneFilm = slg::Film::LoadSerialized(fileName);
 }
 
@@ -79,9 +80,9 @@ void FilmImpl::SaveOutput(const std::string &fileName, const FilmOutputType type
 	GetSLGFilm()->Output(fileName, (slg::FilmOutputs::FilmOutputType)type, &props);
 }
 
-void FilmImpl::SaveFilm(const string &fileName) const {
+void FilmImpl::SaveFilm(const string &fileName, const bool async) const {
 	if (renderSession)
-		renderSession->renderSession->SaveFilm(fileName);
+		renderSession->renderSession->SaveFilm(fileName, async);
 	else
 		slg::Film::SaveSerialized(fileName, standAloneFilm);
 }
@@ -124,6 +125,10 @@ unsigned int FilmImpl::GetChannelCount(const FilmChannelType type) const {
 	return GetSLGFilm()->GetChannelCount((slg::Film::FilmChannelType)type);
 }
 
+size_t FilmImpl::GetChannelSize(const FilmChannelType type) const {
+	return GetSLGFilm()->GetChannelSize((slg::Film::FilmChannelType)type);
+}
+
 const float *FilmImpl::GetChannelFloat(const FilmChannelType type, const unsigned int index) {
 	if (renderSession) {
 		boost::unique_lock<boost::mutex> lock(renderSession->renderSession->filmMutex);
@@ -142,6 +147,30 @@ const unsigned int *FilmImpl::GetChannelUInt(const FilmChannelType type, const u
 		return standAloneFilm->GetChannel<unsigned int>((slg::Film::FilmChannelType)type, index);
 }
 
+template<class T> static void CopyFilmChannel(slg::Film *film, const slg::Film::FilmChannelType type,
+		T *buffer, const unsigned int index) {
+	const T *channel = film->GetChannel<T>(type, index);
+	copy(channel, channel + film->GetChannelSize(type), buffer);
+}
+
+void FilmImpl::CopyChannelFloat(const FilmChannelType type, float *buffer, const unsigned int index) {
+	if (renderSession) {
+		boost::unique_lock<boost::mutex> lock(renderSession->renderSession->filmMutex);
+
+		CopyFilmChannel<float>(renderSession->renderSession->film, (slg::Film::FilmChannelType)type, buffer, index);
+	} else
+		CopyFilmChannel<float>(standAloneFilm, (slg::Film::FilmChannelType)type, buffer, index);
+}
+
+void FilmImpl::CopyChannelUInt(const FilmChannelType type, unsigned int *buffer, const unsigned int index) {
+	if (renderSession) {
+		boost::unique_lock<boost::mutex> lock(renderSession->renderSession->filmMutex);
+
+		CopyFilmChannel<u_int>(renderSession->renderSession->film, (slg::Film::FilmChannelType)type, buffer, index);
+	} else
+		CopyFilmChannel<u_int>(standAloneFilm, (slg::Film::FilmChannelType)type, buffer, index);
+}
+
 void FilmImpl::Parse(const luxrays::Properties &props) {
 	if (renderSession)
 		throw runtime_error("Film::Parse() can be used only with a stand alone Film");
@@ -261,10 +290,18 @@ bool SceneImpl::IsImageMapDefined(const std::string &imgMapName) const {
 	return scene->IsImageMapDefined(imgMapName);
 }
 
+void SceneImpl::EnableImageCache(const size_t maxMemorySize, const string &cacheDir) {
+	scene->imgMapCache.EnableTileCache(maxMemorySize, cacheDir);
+}
+
 void SceneImpl::SetDeleteMeshData(const bool v) {
 	scene->extMeshCache.SetDeleteMeshData(v);
 }
 
+bool SceneImpl::GetDeleteMeshData() const {
+	return scene->extMeshCache.GetDeleteMeshData();
+}
+
 void SceneImpl::DefineMesh(const std::string &meshName,
 		const long plyNbVerts, const long plyNbTris,
 		float *p, unsigned int *vi, float *n, float *uv,
@@ -279,7 +316,7 @@ void SceneImpl::DefineMesh(const std::string &meshName,
 
 void SceneImpl::SaveMesh(const string &meshName, const string &fileName) {
 	const ExtMesh *mesh = scene->extMeshCache.GetExtMesh(meshName);
-	mesh->WritePly(fileName);
+	mesh->Save(fileName);
 }
 
 void SceneImpl::DefineStrands(const string &shapeName, const cyHairFile &strandsFile,
@@ -323,18 +360,22 @@ void SceneImpl::Parse(const Properties &props) {
 	scene->Parse(props);
 }
 
-void SceneImpl::UpdateObjectTransformation(const std::string &objName, const float *transMat) {
-	// Invalidate the scene properties cache
-	scenePropertiesCache.Clear();
-
+static Transform ObjectTransformation(const float *transMat) {
 	// I have to transpose the matrix
 	const Matrix4x4 mat(
 		transMat[0], transMat[4], transMat[8], transMat[12],
 		transMat[1], transMat[5], transMat[9], transMat[13],
 		transMat[2], transMat[6], transMat[10], transMat[14],
 		transMat[3], transMat[7], transMat[11], transMat[15]);
-	const Transform trans(mat);
-	scene->UpdateObjectTransformation(objName, trans);
+
+	return Transform(mat);
+}
+
+void SceneImpl::UpdateObjectTransformation(const std::string &objName, const float *transMat) {
+	// Invalidate the scene properties cache
+	scenePropertiesCache.Clear();
+
+	scene->UpdateObjectTransformation(objName, ObjectTransformation(transMat));
 }
 
 void SceneImpl::UpdateObjectMaterial(const std::string &objName, const std::string &matName) {
@@ -358,6 +399,50 @@ void SceneImpl::DeleteLight(const string &lightName) {
 	scene->DeleteLight(lightName);
 }
 
+unsigned long long SceneImpl::GetObjectHandle(const std::string &objName) const {
+	return scene->objDefs.GetSceneObjectHandle(objName);
+}
+
+unsigned long long SceneImpl::GetMaterialHandle(const std::string &matName) const {
+	return scene->matDefs.GetMaterialHandle(matName);
+}
+
+unsigned long long SceneImpl::GetLightHandle(const std::string &lightName) const {
+	return scene->lightDefs.GetLightSourceHandle(lightName);
+}
+
+void SceneImpl::UpdateObjectTransformations(const unsigned int count,
+		const unsigned long long *objHandles, const float *transMats) {
+	// Invalidate the scene properties cache
+	scenePropertiesCache.Clear();
+
+	for (u_int i = 0; i < count; ++i)
+		scene->UpdateObjectTransformation(objHandles[i], ObjectTransformation(&transMats[i * 16]));
+}
+
+void SceneImpl::UpdateObjectMaterials(const unsigned int count,
+		const unsigned long long *objHandles, const unsigned long long *matHandles) {
+	// Invalidate the scene properties cache
+	scenePropertiesCache.Clear();
+
+	for (u_int i = 0; i < count; ++i)
+		scene->UpdateObjectMaterial(objHandles[i], matHandles[i]);
+}
+
+void SceneImpl::DeleteObjects(const unsigned int count, const unsigned long long *objHandles) {
+	// Invalidate the scene properties cache
+	scenePropertiesCache.Clear();
+
+	scene->DeleteObjects(vector<slg::SceneHandle>(objHandles, objHandles + count));
+}
+
+void SceneImpl::DeleteLights(const unsigned int count, const unsigned long long *lightHandles) {
+	// Invalidate the scene properties cache
+	scenePropertiesCache.Clear();
+
+	scene->DeleteLights(vector<slg::SceneHandle>(lightHandles, lightHandles + count));
+}
+
 void SceneImpl::RemoveUnusedImageMaps() {
 	// Invalidate the scene properties cache
 	scenePropertiesCache.Clear();
@@ -425,6 +510,11 @@ void SceneImpl::DefineMesh(const string &meshName, ExtTriangleMesh *mesh) {
 	scene->DefineMesh(meshName, mesh);
 }
 
+// Note: this method is not part of LuxCore API and it is used only internally
+void SceneImpl::SetMeshDataOwner(const string &meshName, slg::ExtMeshDataOwner *owner) {
+	scene->extMeshCache.SetExtMeshDataOwner(meshName, owner);
+}
+
 Point *SceneImpl::AllocVerticesBuffer(const unsigned int meshVertCount) {
 	return TriangleMesh::AllocVerticesBuffer(meshVertCount);
 }
@@ -765,5 +855,11 @@ const Properties &RenderSessionImpl::GetStats() const {
 }
 
 void RenderSessionImpl::Parse(const Properties &props) {
+	// The Python views on the film channels point to the film memory
+	if (film->HasChannelViews() &&
+			((props.IsDefined("film.width") && (props.Get("film.width").Get<u_int>() != film->GetWidth())) ||
+			(props.IsDefined("film.height") && (props.Get("film.height").Get<u_int>() != film->GetHeight()))))
+		throw runtime_error("The film can not be resized while there are views on its channels");
+
 	renderSession->Parse(props);
 }
@@ -443,7 +443,7 @@ static void Film_GetOutputFloat1(luxcore::detail::FilmImpl *film, const Film::Fi
 
 	if (PyObject_CheckBuffer(obj.ptr())) {
 		Py_buffer view;
-		if (!PyObject_GetBuffer(obj.ptr(), &view, PyBUF_SIMPLE)) {
+		if (!PyObject_GetBuffer(obj.ptr(), &view, PyBUF_WRITABLE)) {
 			if ((size_t)view.len >= outputSize) {
 				if(!film->HasOutput(type)) {
 					const string errorMsg = "Film Output not available: " + luxrays::ToString(type);
@@ -509,7 +509,7 @@ static void Film_GetOutputUInt1(luxcore::detail::FilmImpl *film, const Film::Fil
 		boost::python::object &obj, const u_int index) {
 	if (PyObject_CheckBuffer(obj.ptr())) {
 		Py_buffer view;
-		if (!PyObject_GetBuffer(obj.ptr(), &view, PyBUF_SIMPLE)) {
+		if (!PyObject_GetBuffer(obj.ptr(), &view, PyBUF_WRITABLE)) {
 			if ((size_t)view.len >= film->GetOutputSize(type) * sizeof(u_int)) {
 				if(!film->HasOutput(type)) {
 					const string errorMsg = "Film Output not available: " + luxrays::ToString(type);
@@ -544,6 +544,203 @@ static void Film_GetOutputUInt2(luxcore::detail::FilmImpl *film, const Film::Fil
 	Film_GetOutputUInt1(film, type, obj, 0);
 }
 
+//------------------------------------------------------------------------------
+// FilmChannelView: the object exporting a Film channel memory through the
+// buffer protocol
+//------------------------------------------------------------------------------
+
+// It holds a reference to the Python Film object (and so to the RenderSession
+// owning the film) and it stops the film from being resized while it is alive,
+// so the exported memory stays valid as long as any memoryview (or NumPy array)
+// uses it.
+typedef struct {
+	PyObject_HEAD
+	PyObject *filmObj;
+	luxcore::detail::FilmImpl *film;
+
+	void *buf;
+	Py_ssize_t len, itemSize;
+	Py_ssize_t shape[1];
+	const char *format;
+} FilmChannelView;
+
+static PyTypeObject FilmChannelViewType = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyBufferProcs FilmChannelViewBufferProcs;
+
+static int FilmChannelView_GetBuffer(PyObject *obj, Py_buffer *view, int flags) {
+	FilmChannelView *self = (FilmChannelView *)obj;
+
+	// PyBuffer_FillInfo() checks the flags (i.e. a writable view request)
+	if (PyBuffer_FillInfo(view, obj, self->buf, self->len, 1, flags))
+		return -1;
+
+	view->itemsize = self->itemSize;
+	if (flags & PyBUF_FORMAT)
+		view->format = const_cast<char *>(self->format);
+	if ((flags & PyBUF_ND) == PyBUF_ND)
+		view->shape = self->shape;
+	if ((flags & PyBUF_STRIDES) == PyBUF_STRIDES)
+		view->strides = &self->itemSize;
+
+	return 0;
+}
+
+static void FilmChannelView_Dealloc(PyObject *obj) {
+	FilmChannelView *self = (FilmChannelView *)obj;
+
+	self->film->RemoveChannelView();
+	Py_XDECREF(self->filmObj);
+
+	PyObject_Del(obj);
+}
+
+static void FilmChannelView_InitType() {
+	FilmChannelViewBufferProcs.bf_getbuffer = FilmChannelView_GetBuffer;
+	FilmChannelViewBufferProcs.bf_releasebuffer = NULL;
+
+	FilmChannelViewType.tp_name = "pyluxcore.FilmChannelView";
+	FilmChannelViewType.tp_basicsize = sizeof(FilmChannelView);
+	FilmChannelViewType.tp_dealloc = FilmChannelView_Dealloc;
+	FilmChannelViewType.tp_as_buffer = &FilmChannelViewBufferProcs;
+	FilmChannelViewType.tp_flags = Py_TPFLAGS_DEFAULT
+#if PY_MAJOR_VERSION < 3
+			| Py_TPFLAGS_HAVE_NEWBUFFER
+#endif
+			;
+	FilmChannelViewType.tp_doc = "The owner of the memory of a Film channel view";
+
+	if (PyType_Ready(&FilmChannelViewType) < 0)
+		throw_error_already_set();
+}
+
+// Returns a read-only memoryview of a Film channel, without any copy. The
+// memoryview points to the live film memory: the content is updated in place
+// by the rendering (i.e. by RenderSession.UpdateStats()), use the versions
+// with a buffer to get a consistent copy.
+template<class T> static boost::python::object Film_GetChannelView(boost::python::object &filmObj,
+		const Film::FilmChannelType type, const u_int index, const string &methodName, const char *format) {
+	luxcore::detail::FilmImpl *film = extract<luxcore::detail::FilmImpl *>(filmObj);
+
+	if (index >= film->GetChannelCount(type))
+		throw runtime_error("Film channel not available in Film." + methodName + "() method: " +
+				luxrays::ToString(type) + " #" + luxrays::ToString(index));
+
+	FilmChannelView *owner = PyObject_New(FilmChannelView, &FilmChannelViewType);
+	if (!owner)
+		throw_error_already_set();
+
+	// The film lock is used to get the channel pointer
+	owner->buf = (void *)film->GetChannel<T>(type, index);
+	owner->itemSize = sizeof(T);
+	owner->shape[0] = film->GetChannelSize(type);
+	owner->len = owner->shape[0] * sizeof(T);
+	owner->format = format;
+	owner->film = film;
+	owner->filmObj = filmObj.ptr();
+	Py_INCREF(owner->filmObj);
+	film->AddChannelView();
+
+	// The memoryview holds a reference to the owner
+	PyObject *memView = PyMemoryView_FromObject((PyObject *)owner);
+	Py_DECREF(owner);
+	if (!memView)
+		throw_error_already_set();
+
+	return boost::python::object(boost::python::handle<>(memView));
+}
+
+static void Film_CopyChannel(luxcore::detail::FilmImpl *film, const Film::FilmChannelType type,
+		float *buffer, const u_int index) {
+	film->CopyChannelFloat(type, buffer, index);
+}
+
+static void Film_CopyChannel(luxcore::detail::FilmImpl *film, const Film::FilmChannelType type,
+		unsigned int *buffer, const u_int index) {
+	film->CopyChannelUInt(type, buffer, index);
+}
+
+// Copies a Film channel in a caller supplied writable buffer (i.e. a NumPy
+// array) while holding the film lock
+template<class T> static void Film_GetChannelCopy(luxcore::detail::FilmImpl *film,
+		const Film::FilmChannelType type, boost::python::object &obj, const u_int index,
+		const string &methodName) {
+	if (!PyObject_CheckBuffer(obj.ptr())) {
+		const string objType = extract<string>((obj.attr("__class__")).attr("__name__"));
+		throw runtime_error("Unsupported data type in Film." + methodName + "() method: " + objType);
+	}
+
+	if (index >= film->GetChannelCount(type))
+		throw runtime_error("Film channel not available in Film." + methodName + "() method: " +
+				luxrays::ToString(type) + " #" + luxrays::ToString(index));
+
+	Py_buffer view;
+	if (PyObject_GetBuffer(obj.ptr(), &view, PyBUF_WRITABLE)) {
+		PyErr_Clear();
+
+		const string objType = extract<string>((obj.attr("__class__")).attr("__name__"));
+		throw runtime_error("Unable to get a writable data view in Film." + methodName + "() method: " + objType);
+	}
+
+	const size_t channelSize = film->GetChannelSize(type) * sizeof(T);
+	if ((size_t)view.len < channelSize) {
+		const string errorMsg = "Not enough space in the buffer of Film." + methodName + "() method: " +
+				luxrays::ToString(view.len) + " instead of " + luxrays::ToString(channelSize);
+		PyBuffer_Release(&view);
+
+		throw runtime_error(errorMsg);
+	}
+
+	Film_CopyChannel(film, type, (T *)view.buf, index);
+
+	PyBuffer_Release(&view);
+}
+
+static void Film_SaveFilm1(luxcore::detail::FilmImpl *film, const string &fileName) {
+	film->SaveFilm(fileName);
+}
+
+static void Film_SaveFilm2(luxcore::detail::FilmImpl *film, const string &fileName, const bool async) {
+	film->SaveFilm(fileName, async);
+}
+
+static boost::python::object Film_GetChannelFloat1(boost::python::object &filmObj, const Film::FilmChannelType type,
+		const u_int index) {
+	return Film_GetChannelView<float>(filmObj, type, index, "GetChannelFloat", "f");
+}
+
+static boost::python::object Film_GetChannelFloat2(boost::python::object &filmObj, const Film::FilmChannelType type) {
+	return Film_GetChannelFloat1(filmObj, type, 0);
+}
+
+static void Film_GetChannelFloat3(luxcore::detail::FilmImpl *film, const Film::FilmChannelType type,
+		boost::python::object &obj, const u_int index) {
+	Film_GetChannelCopy<float>(film, type, obj, index, "GetChannelFloat");
+}
+
+static void Film_GetChannelFloat4(luxcore::detail::FilmImpl *film, const Film::FilmChannelType type,
+		boost::python::object &obj) {
+	Film_GetChannelFloat3(film, type, obj, 0);
+}
+
+static boost::python::object Film_GetChannelUInt1(boost::python::object &filmObj, const Film::FilmChannelType type,
+		const u_int index) {
+	return Film_GetChannelView<unsigned int>(filmObj, type, index, "GetChannelUInt", "I");
+}
+
+static boost::python::object Film_GetChannelUInt2(boost::python::object &filmObj, const Film::FilmChannelType type) {
+	return Film_GetChannelUInt1(filmObj, type, 0);
+}
+
+static void Film_GetChannelUInt3(luxcore::detail::FilmImpl *film, const Film::FilmChannelType type,
+		boost::python::object &obj, const u_int index) {
+	Film_GetChannelCopy<unsigned int>(film, type, obj, index, "GetChannelUInt");
+}
+
+static void Film_GetChannelUInt4(luxcore::detail::FilmImpl *film, const Film::FilmChannelType type,
+		boost::python::object &obj) {
+	Film_GetChannelUInt3(film, type, obj, 0);
+}
+
 //------------------------------------------------------------------------------
 // Glue for Camera class
 //------------------------------------------------------------------------------
@@ -564,6 +761,15 @@ static luxcore::detail::CameraImpl &Scene_GetCamera(luxcore::detail::SceneImpl *
 	return (luxcore::detail::CameraImpl &)scene->GetCamera();
 }
 
+static void Scene_EnableImageCache1(luxcore::detail::SceneImpl *scene, const size_t maxMemorySize) {
+	scene->EnableImageCache(maxMemorySize);
+}
+
+static void Scene_EnableImageCache2(luxcore::detail::SceneImpl *scene, const size_t maxMemorySize,
+		const string &cacheDir) {
+	scene->EnableImageCache(maxMemorySize, cacheDir);
+}
+
 static void Scene_DefineImageMap(luxcore::detail::SceneImpl *scene, const string &imgMapName,
 		boost::python::object &obj, const float gamma,
 		const u_int channels, const u_int width, const u_int height) {
@@ -593,14 +799,182 @@ static void Scene_DefineImageMap(luxcore::detail::SceneImpl *scene, const string
 	}
 }
 
+// Used by Scene.DefineMesh() to allocate the copy of a buffer
+template<class T> static T *Scene_AllocMeshBuffer(const size_t size) {
+	return new T[size];
+}
+
+template<> luxrays::Point *Scene_AllocMeshBuffer<luxrays::Point>(const size_t size) {
+	return luxcore::detail::SceneImpl::AllocVerticesBuffer(size);
+}
+
+// The size of the padding at the end of a buffer
+template<class T> static size_t Scene_GetMeshBufferPadding() {
+	return 0;
+}
+
+template<> size_t Scene_GetMeshBufferPadding<luxrays::Point>() {
+	// Embree requires a float padding field at the end (see
+	// Scene::AllocVerticesBuffer())
+	return sizeof(float);
+}
+
+// The copies done by Scene.DefineMesh() are stored in capsules so they are
+// freed if there is an error or, when the Scene doesn't own the mesh data,
+// when the mesh is redefined or the Scene is deleted
+template<class T> static void Scene_DeleteMeshBuffer(PyObject *capsule) {
+	delete[] (T *)PyCapsule_GetPointer(capsule, NULL);
+}
+
+template<class T> static T *Scene_AddMeshBufferOwner(boost::python::list &owners, T *buffer) {
+	PyObject *capsule = PyCapsule_New(buffer, NULL, Scene_DeleteMeshBuffer<T>);
+	if (!capsule) {
+		delete[] buffer;
+		throw_error_already_set();
+	}
+
+	owners.append(boost::python::object(boost::python::handle<>(capsule)));
+
+	return buffer;
+}
+
+// Used by Scene.DefineMesh() to check if a buffer can be used in place: it
+// must be writable (the mesh can be transformed in place by scene edits),
+// C-contiguous and, for vertices, include the padding
+template<class T> static bool Scene_CanAdoptMeshBuffer(const Py_buffer &view, const size_t size) {
+	return !view.readonly && PyBuffer_IsContiguous(const_cast<Py_buffer *>(&view), 'C') &&
+			((size_t)view.len == size * sizeof(T) + Scene_GetMeshBufferPadding<T>());
+}
+
+// Reads the elements of a mesh buffer from an object exposing the buffer
+// protocol (i.e. a NumPy array of float32 or uint32) with a single copy. If
+// adopt is true, the buffer is used in place when possible. The owners of the
+// returned memory are appended to owners.
+template<class T> static T *Scene_GetMeshBuffer(const boost::python::object &obj,
+		const string &bufferName, const bool isFloat, const bool adopt,
+		boost::python::list &owners, long *size) {
+	Py_buffer view;
+	if (PyObject_GetBuffer(obj.ptr(), &view, PyBUF_STRIDES | PyBUF_FORMAT)) {
+		PyErr_Clear();
+
+		const string objType = extract<string>((obj.attr("__class__")).attr("__name__"));
+		throw runtime_error("Unable to get a data view for the " + bufferName +
+				" of method Scene.DefineMesh(): " + objType);
+	}
+
+	// Check the type of the buffer items
+	const string format = view.format ? view.format : "B";
+	const char itemType = format[format.length() - 1];
+	const bool isValidType = (view.itemsize == 4) && (isFloat ? (itemType == 'f') :
+		((itemType == 'i') || (itemType == 'I') || (itemType == 'l') || (itemType == 'L')));
+	if (!isValidType) {
+		PyBuffer_Release(&view);
+
+		throw runtime_error("Wrong data type for the buffer of the " + bufferName +
+				" of method Scene.DefineMesh(): " + format + " instead of " +
+				(isFloat ? "float32" : "uint32"));
+	}
+
+	// Check the buffer holds whole elements (plus the optional padding)
+	const size_t padding = Scene_GetMeshBufferPadding<T>();
+	const size_t remainder = view.len % sizeof(T);
+	if ((remainder != 0) && (remainder != padding)) {
+		const string errorMsg = "Wrong size for the buffer of the " + bufferName +
+				" of method Scene.DefineMesh(): " + luxrays::ToString(view.len) +
+				" bytes is not a multiple of " + luxrays::ToString(sizeof(T));
+		PyBuffer_Release(&view);
+
+		throw runtime_error(errorMsg);
+	}
+
+	const size_t count = view.len / sizeof(T);
+
+	T *buffer;
+	if (adopt && Scene_CanAdoptMeshBuffer<T>(view, count)) {
+		buffer = (T *)view.buf;
+
+		// The object must be alive as long as the mesh
+		owners.append(obj);
+	} else {
+		buffer = Scene_AddMeshBufferOwner(owners, Scene_AllocMeshBuffer<T>(count));
+
+		// PyBuffer_ToContiguous() handles strided buffers too. The copy
+		// includes the padding, if there is one, and the allocated buffer
+		// has room for it.
+		if (PyBuffer_ToContiguous(buffer, &view, view.len, 'C')) {
+			PyBuffer_Release(&view);
+			throw_error_already_set();
+		}
+	}
+
+	PyBuffer_Release(&view);
+
+	*size = count;
+	return buffer;
+}
+
+// Adopted vertex buffers must have the marker of TriangleMesh::AllocVerticesBuffer()
+// in the padding. The padding is not part of the vertex data so it is written
+// only once the buffer has been adopted.
+static void Scene_MarkVerticesBuffer(luxrays::Point *points, const long plyNbVerts) {
+	((float *)points)[3 * plyNbVerts] = 1234.1234f;
+}
+
+// Keeps alive the buffers used by a mesh when the Scene doesn't own the mesh
+// data. It is stored in the C++ Scene, and not in the Python object, because
+// each call to RenderConfig.GetScene() returns a new Python object.
+class PythonMeshDataOwner : public slg::ExtMeshDataOwner {
+public:
+	PythonMeshDataOwner(const boost::python::list &o) : owners(o.ptr()) {
+		Py_INCREF(owners);
+	}
+
+	virtual ~PythonMeshDataOwner() {
+		// The buffers are leaked if the interpreter has been already finalized
+		if (Py_IsInitialized()) {
+			PyGILState_STATE state = PyGILState_Ensure();
+			Py_DECREF(owners);
+			PyGILState_Release(state);
+		}
+	}
+
+private:
+	PyObject *owners;
+};
+
 static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &meshName,
 		const boost::python::object &p, const boost::python::object &vi,
 		const boost::python::object &n, const boost::python::object &uv,
 		const boost::python::object &cols, const boost::python::object &alphas,
 		const boost::python::object &transformation) {
-	// NOTE: I would like to use boost::scoped_array but
-	// some guy has decided that boost::scoped_array must not have
-	// a release() method for some ideological reason...
+	// Buffers (i.e. NumPy arrays) are used in place, instead of copied, if
+	// the Scene doesn't own the mesh data and they are not transformed
+	const bool adopt = !scene->GetDeleteMeshData() && transformation.is_none();
+	// The owners of all the arrays used by the mesh: the copies are freed
+	// by their capsules if there is an error (see Scene_AddMeshBufferOwner())
+	boost::python::list owners;
+
+	// Read the transformation first, so there is nothing to free on error
+	luxrays::Matrix4x4 mat;
+	if (!transformation.is_none()) {
+		extract<boost::python::list> getTransformationList(transformation);
+		if (getTransformationList.check()) {
+			const boost::python::list &l = getTransformationList();
+			const boost::python::ssize_t size = len(l);
+			if (size != 16) {
+				const string objType = extract<string>((transformation.attr("__class__")).attr("__name__"));
+				throw runtime_error("Wrong number of elements for the list of transformation values of method Scene.DefineMesh(): " + objType);
+			}
+
+			boost::python::ssize_t index = 0;
+			for (u_int j = 0; j < 4; ++j)
+				for (u_int i = 0; i < 4; ++i)
+					mat.m[i][j] = extract<float>(l[index++]);
+		} else {
+			const string objType = extract<string>((transformation.attr("__class__")).attr("__name__"));
+			throw runtime_error("Wrong data type for the list of transformation values of method Scene.DefineMesh(): " + objType);
+		}
+	}
 
 	// Translate all vertices
 	long plyNbVerts;
@@ -611,7 +985,7 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 		const boost::python::ssize_t size = len(l);
 		plyNbVerts = size;
 
-		points = (luxrays::Point *)luxcore::detail::SceneImpl::AllocVerticesBuffer(size);
+		points = Scene_AddMeshBufferOwner(owners, luxcore::detail::SceneImpl::AllocVerticesBuffer(size));
 		for (boost::python::ssize_t i = 0; i < size; ++i) {
 			extract<boost::python::tuple> getTuple(l[i]);
 			if (getTuple.check()) {
@@ -622,7 +996,9 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 				throw runtime_error("Wrong data type in the list of vertices of method Scene.DefineMesh() at position " + luxrays::ToString(i) +": " + objType);
 			}
 		}
-	} else {
+	} else if (PyObject_CheckBuffer(p.ptr()))
+		points = Scene_GetMeshBuffer<luxrays::Point>(p, "vertices", true, adopt, owners, &plyNbVerts);
+	else {
 		const string objType = extract<string>((p.attr("__class__")).attr("__name__"));
 		throw runtime_error("Wrong data type for the list of vertices of method Scene.DefineMesh(): " + objType);
 	}
@@ -636,7 +1012,7 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 		const boost::python::ssize_t size = len(l);
 		plyNbTris = size;
 
-		tris = (luxrays::Triangle *)luxcore::detail::SceneImpl::AllocTrianglesBuffer(size);
+		tris = Scene_AddMeshBufferOwner(owners, luxcore::detail::SceneImpl::AllocTrianglesBuffer(size));
 		for (boost::python::ssize_t i = 0; i < size; ++i) {
 			extract<boost::python::tuple> getTuple(l[i]);
 			if (getTuple.check()) {
@@ -647,7 +1023,9 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 				throw runtime_error("Wrong data type in the list of triangles of method Scene.DefineMesh() at position " + luxrays::ToString(i) +": " + objType);
 			}
 		}
-	} else {
+	} else if (PyObject_CheckBuffer(vi.ptr()))
+		tris = Scene_GetMeshBuffer<luxrays::Triangle>(vi, "triangles", false, adopt, owners, &plyNbTris);
+	else {
 		const string objType = extract<string>((vi.attr("__class__")).attr("__name__"));
 		throw runtime_error("Wrong data type for the list of triangles of method Scene.DefineMesh(): " + objType);
 	}
@@ -660,7 +1038,7 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 			const boost::python::list &l = getNList();
 			const boost::python::ssize_t size = len(l);
 
-			normals = new luxrays::Normal[size];
+			normals = Scene_AddMeshBufferOwner(owners, new luxrays::Normal[size]);
 			for (boost::python::ssize_t i = 0; i < size; ++i) {
 				extract<boost::python::tuple> getTuple(l[i]);
 				if (getTuple.check()) {
@@ -671,6 +1049,12 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 					throw runtime_error("Wrong data type in the list of triangles of method Scene.DefineMesh() at position " + luxrays::ToString(i) +": " + objType);
 				}
 			}
+		} else if (PyObject_CheckBuffer(n.ptr())) {
+			long size;
+			normals = Scene_GetMeshBuffer<luxrays::Normal>(n, "normals", true, adopt, owners, &size);
+			if (size < plyNbVerts)
+				throw runtime_error("Not enough normals in the buffer of method Scene.DefineMesh(): " +
+						luxrays::ToString(size) + " instead of " + luxrays::ToString(plyNbVerts));
 		} else {
 			const string objType = extract<string>((n.attr("__class__")).attr("__name__"));
 			throw runtime_error("Wrong data type for the list of triangles of method Scene.DefineMesh(): " + objType);
@@ -685,7 +1069,7 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 			const boost::python::list &l = getUVList();
 			const boost::python::ssize_t size = len(l);
 
-			uvs = new luxrays::UV[size];
+			uvs = Scene_AddMeshBufferOwner(owners, new luxrays::UV[size]);
 			for (boost::python::ssize_t i = 0; i < size; ++i) {
 				extract<boost::python::tuple> getTuple(l[i]);
 				if (getTuple.check()) {
@@ -696,6 +1080,12 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 					throw runtime_error("Wrong data type in the list of UVs of method Scene.DefineMesh() at position " + luxrays::ToString(i) +": " + objType);
 				}
 			}
+		} else if (PyObject_CheckBuffer(uv.ptr())) {
+			long size;
+			uvs = Scene_GetMeshBuffer<luxrays::UV>(uv, "UVs", true, adopt, owners, &size);
+			if (size < plyNbVerts)
+				throw runtime_error("Not enough UVs in the buffer of method Scene.DefineMesh(): " +
+						luxrays::ToString(size) + " instead of " + luxrays::ToString(plyNbVerts));
 		} else {
 			const string objType = extract<string>((uv.attr("__class__")).attr("__name__"));
 			throw runtime_error("Wrong data type for the list of UVs of method Scene.DefineMesh(): " + objType);
@@ -710,7 +1100,7 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 			const boost::python::list &l = getColList();
 			const boost::python::ssize_t size = len(l);
 
-			colors = new luxrays::Spectrum[size];
+			colors = Scene_AddMeshBufferOwner(owners, new luxrays::Spectrum[size]);
 			for (boost::python::ssize_t i = 0; i < size; ++i) {
 				extract<boost::python::tuple> getTuple(l[i]);
 				if (getTuple.check()) {
@@ -721,6 +1111,12 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 					throw runtime_error("Wrong data type in the list of colors of method Scene.DefineMesh() at position " + luxrays::ToString(i) +": " + objType);
 				}
 			}
+		} else if (PyObject_CheckBuffer(cols.ptr())) {
+			long size;
+			colors = Scene_GetMeshBuffer<luxrays::Spectrum>(cols, "colors", true, adopt, owners, &size);
+			if (size < plyNbVerts)
+				throw runtime_error("Not enough colors in the buffer of method Scene.DefineMesh(): " +
+						luxrays::ToString(size) + " instead of " + luxrays::ToString(plyNbVerts));
 		} else {
 			const string objType = extract<string>((cols.attr("__class__")).attr("__name__"));
 			throw runtime_error("Wrong data type for the list of colors of method Scene.DefineMesh(): " + objType);
@@ -735,42 +1131,50 @@ static void Scene_DefineMesh1(luxcore::detail::SceneImpl *scene, const string &m
 			const boost::python::list &l = getAlphaList();
 			const boost::python::ssize_t size = len(l);
 
-			as = new float[size];
+			as = Scene_AddMeshBufferOwner(owners, new float[size]);
 			for (boost::python::ssize_t i = 0; i < size; ++i)
 				as[i] = extract<float>(l[i]);
+		} else if (PyObject_CheckBuffer(alphas.ptr())) {
+			long size;
+			as = Scene_GetMeshBuffer<float>(alphas, "alphas", true, adopt, owners, &size);
+			if (size < plyNbVerts)
+				throw runtime_error("Not enough alphas in the buffer of method Scene.DefineMesh(): " +
+						luxrays::ToString(size) + " instead of " + luxrays::ToString(plyNbVerts));
 		} else {
 			const string objType = extract<string>((alphas.attr("__class__")).attr("__name__"));
 			throw runtime_error("Wrong data type for the list of alphas of method Scene.DefineMesh(): " + objType);
 		}
 	}
 
-	luxrays::ExtTriangleMesh *mesh = new luxrays::ExtTriangleMesh(plyNbVerts, plyNbTris, points, tris, normals, uvs, colors, as);
-	
-	// Apply the transformation if required
-	if (!transformation.is_none()) {
-		extract<boost::python::list> getTransformationList(transformation);
-		if (getTransformationList.check()) {
-			const boost::python::list &l = getTransformationList();
-			const boost::python::ssize_t size = len(l);
-			if (size != 16) {
-				const string objType = extract<string>((transformation.attr("__class__")).attr("__name__"));
-				throw runtime_error("Wrong number of elements for the list of transformation values of method Scene.DefineMesh(): " + objType);
-			}
+	Scene_MarkVerticesBuffer(points, plyNbVerts);
 
-			luxrays::Matrix4x4 mat;
-			boost::python::ssize_t index = 0;
-			for (u_int j = 0; j < 4; ++j)
-				for (u_int i = 0; i < 4; ++i)
-					mat.m[i][j] = extract<float>(l[index++]);
-
-			mesh->ApplyTransform(luxrays::Transform(mat));
-		} else {
-			const string objType = extract<string>((alphas.attr("__class__")).attr("__name__"));
-			throw runtime_error("Wrong data type for the list of transformation values of method Scene.DefineMesh(): " + objType);
+	// Check the triangle indices
+	for (long i = 0; i < plyNbTris; ++i) {
+		for (u_int j = 0; j < 3; ++j) {
+			if (tris[i].v[j] >= (u_int)plyNbVerts)
+				throw runtime_error("Out of range vertex index in the triangle " + luxrays::ToString(i) +
+						" of method Scene.DefineMesh(): " + luxrays::ToString(tris[i].v[j]) +
+						" (vertex count: " + luxrays::ToString(plyNbVerts) + ")");
 		}
 	}
 
+	luxrays::ExtTriangleMesh *mesh = new luxrays::ExtTriangleMesh(plyNbVerts, plyNbTris, points, tris, normals, uvs, colors, as);
+
+	// Apply the transformation if required
+	if (!transformation.is_none())
+		mesh->ApplyTransform(luxrays::Transform(mat));
+
 	scene->DefineMesh(meshName, mesh);
+
+	if (scene->GetDeleteMeshData()) {
+		// The Scene frees the copies now
+		for (boost::python::ssize_t i = 0; i < len(owners); ++i)
+			PyCapsule_SetDestructor(boost::python::object(owners[i]).ptr(), NULL);
+	} else {
+		// Keep the buffers alive as long as the mesh (the previous ones of
+		// a mesh with the same name are released)
+		scene->SetMeshDataOwner(meshName, new PythonMeshDataOwner(owners));
+	}
 }
 
 static void Scene_DefineMesh2(luxcore::detail::SceneImpl *scene, const string &meshName,
@@ -978,6 +1382,66 @@ static void Scene_DefineStrands(luxcore::detail::SceneImpl *scene, const string
 			useCameraPosition);
 }
 
+static vector<unsigned long long> Scene_GetHandles(const boost::python::list &l, const string &methodName) {
+	const boost::python::ssize_t size = len(l);
+
+	vector<unsigned long long> handles(size);
+	for (boost::python::ssize_t i = 0; i < size; ++i) {
+		extract<unsigned long long> getHandle(l[i]);
+		if (getHandle.check())
+			handles[i] = getHandle();
+		else {
+			const string objType = extract<string>((l[i].attr("__class__")).attr("__name__"));
+			throw runtime_error("Wrong data type in the list of handles of method Scene." + methodName +
+					"() at position " + luxrays::ToString(i) +": " + objType);
+		}
+	}
+
+	return handles;
+}
+
+static void Scene_UpdateObjectTransformations(luxcore::detail::SceneImpl *scene,
+		const boost::python::list &objHandles, const boost::python::list &transMats) {
+	const vector<unsigned long long> handles = Scene_GetHandles(objHandles, "UpdateObjectTransformations");
+	if ((size_t)len(transMats) != handles.size() * 16)
+		throw runtime_error("Wrong number of elements in the transformations of method Scene.UpdateObjectTransformations(): " +
+				luxrays::ToString(len(transMats)) + " instead of " + luxrays::ToString(handles.size() * 16));
+
+	vector<float> mats(handles.size() * 16);
+	for (u_int i = 0; i < mats.size(); ++i)
+		mats[i] = extract<float>(transMats[i]);
+
+	if (handles.size() > 0)
+		scene->UpdateObjectTransformations(handles.size(), &handles[0], &mats[0]);
+}
+
+static void Scene_UpdateObjectMaterials(luxcore::detail::SceneImpl *scene,
+		const boost::python::list &objHandles, const boost::python::list &matHandles) {
+	const vector<unsigned long long> objs = Scene_GetHandles(objHandles, "UpdateObjectMaterials");
+	const vector<unsigned long long> mats = Scene_GetHandles(matHandles, "UpdateObjectMaterials");
+	if (objs.size() != mats.size())
+		throw runtime_error("Different number of object and material handles in method Scene.UpdateObjectMaterials()");
+
+	if (objs.size() > 0)
+		scene->UpdateObjectMaterials(objs.size(), &objs[0], &mats[0]);
+}
+
+static void Scene_DeleteObjects(luxcore::detail::SceneImpl *scene,
+		const boost::python::list &objHandles) {
+	const vector<unsigned long long> handles = Scene_GetHandles(objHandles, "DeleteObjects");
+
+	if (handles.size() > 0)
+		scene->DeleteObjects(handles.size(), &handles[0]);
+}
+
+static void Scene_DeleteLights(luxcore::detail::SceneImpl *scene,
+		const boost::python::list &lightHandles) {
+	const vector<unsigned long long> handles = Scene_GetHandles(lightHandles, "DeleteLights");
+
+	if (handles.size() > 0)
+		scene->DeleteLights(handles.size(), &handles[0]);
+}
+
 //------------------------------------------------------------------------------
 // Glue for RenderConfig class
 //------------------------------------------------------------------------------
@@ -1027,6 +1491,8 @@ BOOST_PYTHON_MODULE(pyluxcore) {
 	package.attr("__doc__") = "New LuxRender Python bindings\n\n"
 			"Provides access to the new LuxRender API in python\n\n";
 
+	FilmChannelView_InitType();
+
 	def("Version", LuxCoreVersion, "Returns the LuxCore version");
 
 	def("Init", &LuxCore_Init);
@@ -1169,19 +1635,61 @@ BOOST_PYTHON_MODULE(pyluxcore) {
 		.value("BY_OBJECT_ID", Film::OUTPUT_BY_OBJECT_ID)
 	;
 
+	enum_<Film::FilmChannelType>("FilmChannelType")
+		.value("RADIANCE_PER_PIXEL_NORMALIZED", Film::CHANNEL_RADIANCE_PER_PIXEL_NORMALIZED)
+		.value("RADIANCE_PER_SCREEN_NORMALIZED", Film::CHANNEL_RADIANCE_PER_SCREEN_NORMALIZED)
+		.value("ALPHA", Film::CHANNEL_ALPHA)
+		.value("IMAGEPIPELINE", Film::CHANNEL_IMAGEPIPELINE)
+		.value("DEPTH", Film::CHANNEL_DEPTH)
+		.value("POSITION", Film::CHANNEL_POSITION)
+		.value("GEOMETRY_NORMAL", Film::CHANNEL_GEOMETRY_NORMAL)
+		.value("SHADING_NORMAL", Film::CHANNEL_SHADING_NORMAL)
+		.value("MATERIAL_ID", Film::CHANNEL_MATERIAL_ID)
+		.value("DIRECT_DIFFUSE", Film::CHANNEL_DIRECT_DIFFUSE)
+		.value("DIRECT_GLOSSY", Film::CHANNEL_DIRECT_GLOSSY)
+		.value("EMISSION", Film::CHANNEL_EMISSION)
+		.value("INDIRECT_DIFFUSE", Film::CHANNEL_INDIRECT_DIFFUSE)
+		.value("INDIRECT_GLOSSY", Film::CHANNEL_INDIRECT_GLOSSY)
+		.value("INDIRECT_SPECULAR", Film::CHANNEL_INDIRECT_SPECULAR)
+		.value("MATERIAL_ID_MASK", Film::CHANNEL_MATERIAL_ID_MASK)
+		.value("DIRECT_SHADOW_MASK", Film::CHANNEL_DIRECT_SHADOW_MASK)
+		.value("INDIRECT_SHADOW_MASK", Film::CHANNEL_INDIRECT_SHADOW_MASK)
+		.value("UV", Film::CHANNEL_UV)
+		.value("RAYCOUNT", Film::CHANNEL_RAYCOUNT)
+		.value("BY_MATERIAL_ID", Film::CHANNEL_BY_MATERIAL_ID)
+		.value("IRRADIANCE", Film::CHANNEL_IRRADIANCE)
+		.value("OBJECT_ID", Film::CHANNEL_OBJECT_ID)
+		.value("OBJECT_ID_MASK", Film::CHANNEL_OBJECT_ID_MASK)
+		.value("BY_OBJECT_ID", Film::CHANNEL_BY_OBJECT_ID)
+		.value("FRAMEBUFFER_MASK", Film::CHANNEL_FRAMEBUFFER_MASK)
+	;
+
     class_<luxcore::detail::FilmImpl>("Film", init<string>())
 		.def("GetWidth", &luxcore::detail::FilmImpl::GetWidth)
 		.def("GetHeight", &luxcore::detail::FilmImpl::GetHeight)
 		.def("Save", &luxcore::detail::FilmImpl::SaveOutputs) // Deprecated
 		.def("SaveOutputs", &luxcore::detail::FilmImpl::SaveOutputs)
 		.def("SaveOutput", &luxcore::detail::FilmImpl::SaveOutput)
-		.def("SaveFilm", &luxcore::detail::FilmImpl::SaveFilm)
+		.def("SaveFilm", &Film_SaveFilm1)
+		.def("SaveFilm", &Film_SaveFilm2)
 		.def("GetRadianceGroupCount", &luxcore::detail::FilmImpl::GetRadianceGroupCount)
 		.def("GetOutputSize", &luxcore::detail::FilmImpl::GetOutputSize)
 		.def("GetOutputFloat", &Film_GetOutputFloat1)
 		.def("GetOutputFloat", &Film_GetOutputFloat2)
 		.def("GetOutputUInt", &Film_GetOutputUInt1)
 		.def("GetOutputUInt", &Film_GetOutputUInt2)
+		.def("GetChannelCount", &luxcore::detail::FilmImpl::GetChannelCount)
+		.def("GetChannelSize", &luxcore::detail::FilmImpl::GetChannelSize)
+		// The versions with a buffer are registered first so they are tried
+		// last (i.e. an index is never converted to a buffer)
+		.def("GetChannelFloat", &Film_GetChannelFloat3)
+		.def("GetChannelFloat", &Film_GetChannelFloat4)
+		.def("GetChannelFloat", &Film_GetChannelFloat1)
+		.def("GetChannelFloat", &Film_GetChannelFloat2)
+		.def("GetChannelUInt", &Film_GetChannelUInt3)
+		.def("GetChannelUInt", &Film_GetChannelUInt4)
+		.def("GetChannelUInt", &Film_GetChannelUInt1)
+		.def("GetChannelUInt", &Film_GetChannelUInt2)
 		.def("Parse", &luxcore::detail::FilmImpl::Parse)
     ;
 
@@ -1214,6 +1722,10 @@ BOOST_PYTHON_MODULE(pyluxcore) {
 		.def("GetObjectCount", &luxcore::detail::SceneImpl::GetObjectCount)
 		.def("DefineImageMap", &Scene_DefineImageMap)
 		.def("IsImageMapDefined", &luxcore::detail::SceneImpl::IsImageMapDefined)
+		.def("EnableImageCache", &Scene_EnableImageCache1)
+		.def("EnableImageCache", &Scene_EnableImageCache2)
+		.def("SetDeleteMeshData", &luxcore::detail::SceneImpl::SetDeleteMeshData)
+		.def("GetDeleteMeshData", &luxcore::detail::SceneImpl::GetDeleteMeshData)
 		.def("DefineMesh", &Scene_DefineMesh1)
 		.def("DefineMesh", &Scene_DefineMesh2)
 		.def("SaveMesh", &luxcore::detail::SceneImpl::SaveMesh)
@@ -1228,6 +1740,13 @@ BOOST_PYTHON_MODULE(pyluxcore) {
 		.def("UpdateObjectMaterial", &luxcore::detail::SceneImpl::UpdateObjectMaterial)
 		.def("DeleteObject", &luxcore::detail::SceneImpl::DeleteObject)
 		.def("DeleteLight", &luxcore::detail::SceneImpl::DeleteLight)
+		.def("GetObjectHandle", &luxcore::detail::SceneImpl::GetObjectHandle)
+		.def("GetMaterialHandle", &luxcore::detail::SceneImpl::GetMaterialHandle)
+		.def("GetLightHandle", &luxcore::detail::SceneImpl::GetLightHandle)
+		.def("UpdateObjectTransformations", &Scene_UpdateObjectTransformations)
+		.def("UpdateObjectMaterials", &Scene_UpdateObjectMaterials)
+		.def("DeleteObjects", &Scene_DeleteObjects)
+		.def("DeleteLights", &Scene_DeleteLights)
 		.def("RemoveUnusedImageMaps", &luxcore::detail::SceneImpl::RemoveUnusedImageMaps)
 		.def("RemoveUnusedTextures", &luxcore::detail::SceneImpl::RemoveUnusedTextures)
 		.def("RemoveUnusedMaterials", &luxcore::detail::SceneImpl::RemoveUnusedMaterials)
@@ -1293,6 +1812,10 @@ BOOST_PYTHON_MODULE(pyluxcore) {
 	def("ConvertFilmChannelOutput_2xFloat_To_4xFloatList", &blender::ConvertFilmChannelOutput_2xFloat_To_4xFloatList);
 	def("ConvertFilmChannelOutput_3xFloat_To_4xFloatList", &blender::ConvertFilmChannelOutput_3xFloat_To_4xFloatList);
 	def("ConvertFilmChannelOutput_4xFloat_To_4xFloatList", &blender::ConvertFilmChannelOutput_4xFloat_To_4xFloatList);
+	def("ConvertFilmChannelOutput_1xFloat_To_4xFloatBuffer", &blender::ConvertFilmChannelOutput_1xFloat_To_4xFloatBuffer);
+	def("ConvertFilmChannelOutput_2xFloat_To_4xFloatBuffer", &blender::ConvertFilmChannelOutput_2xFloat_To_4xFloatBuffer);
+	def("ConvertFilmChannelOutput_3xFloat_To_4xFloatBuffer", &blender::ConvertFilmChannelOutput_3xFloat_To_4xFloatBuffer);
+	def("ConvertFilmChannelOutput_4xFloat_To_4xFloatBuffer", &blender::ConvertFilmChannelOutput_4xFloat_To_4xFloatBuffer);
 }
 
 }
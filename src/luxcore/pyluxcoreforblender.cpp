@@ -78,6 +78,23 @@ struct MTFace {
 
 //------------------------------------------------------------------------------
 
+// Returns the max. value of a channel with srcChannels floats per pixel, used
+// to normalize it. The 4th channel is the alpha and it is not included.
+static float GetMaxColorValue(const float *src, const size_t pixelCount, const u_int srcChannels) {
+	const u_int colorChannels = Min(srcChannels, 3u);
+
+	float maxValue = 0.f;
+	for (size_t i = 0; i < pixelCount; ++i) {
+		for (u_int c = 0; c < colorChannels; ++c) {
+			const float value = src[i * srcChannels + c];
+			if (!isinf(value) && !isnan(value) && (value > maxValue))
+				maxValue = value;
+		}
+	}
+
+	return maxValue;
+}
+
 void ConvertFilmChannelOutput_3xFloat_To_4xUChar(const u_int width, const u_int height,
 		boost::python::object &objSrc, boost::python::object &objDst, const bool normalize) {
 	if (!PyObject_CheckBuffer(objSrc.ptr())) {
@@ -113,13 +130,7 @@ void ConvertFilmChannelOutput_3xFloat_To_4xUChar(const u_int width, const u_int
 
 	if (normalize) {
 		// Look for the max. in source buffer
-
-		float maxValue = 0.f;
-		for (u_int i = 0; i < width * height * 3; ++i) {
-			const float value = src[i];
-			if (!isinf(value) && !isnan(value) && (value > maxValue))
-				maxValue = value;
-		}
+		const float maxValue = GetMaxColorValue(src, width * height, 3);
 		const float k = (maxValue == 0.f) ? 0.f : (255.f / maxValue);
 
 		for (u_int y = 0; y < height; ++y) {
@@ -202,13 +213,7 @@ boost::python::list ConvertFilmChannelOutput_1xFloat_To_4xFloatList(const u_int
 
 	if (normalize) {
 		// Look for the max. in source buffer
-
-		float maxValue = 0.f;
-		for (u_int i = 0; i < width * height; ++i) {
-			const float value = src[i];
-			if (!isinf(value) && !isnan(value) && (value > maxValue))
-				maxValue = value;
-		}
+		const float maxValue = GetMaxColorValue(src, width * height, 1);
 		const float k = (maxValue == 0.f) ? 0.f : (1.f / maxValue);
 
 		for (u_int y = 0; y < height; ++y) {
@@ -259,13 +264,7 @@ boost::python::list ConvertFilmChannelOutput_2xFloat_To_4xFloatList(const u_int
 
 	if (normalize) {
 		// Look for the max. in source buffer
-
-		float maxValue = 0.f;
-		for (u_int i = 0; i < width * height * 2; ++i) {
-			const float value = src[i];
-			if (!isinf(value) && !isnan(value) && (value > maxValue))
-				maxValue = value;
-		}
+		const float maxValue = GetMaxColorValue(src, width * height, 2);
 		const float k = (maxValue == 0.f) ? 0.f : (1.f / maxValue);
 
 		for (u_int y = 0; y < height; ++y) {
@@ -314,13 +313,7 @@ boost::python::list ConvertFilmChannelOutput_3xFloat_To_4xFloatList(const u_int
 
 	if (normalize) {
 		// Look for the max. in source buffer
-
-		float maxValue = 0.f;
-		for (u_int i = 0; i < width * height * 3; ++i) {
-			const float value = src[i];
-			if (!isinf(value) && !isnan(value) && (value > maxValue))
-				maxValue = value;
-		}
+		const float maxValue = GetMaxColorValue(src, width * height, 3);
 		const float k = (maxValue == 0.f) ? 0.f : (1.f / maxValue);
 
 		for (u_int y = 0; y < height; ++y) {
@@ -369,14 +362,7 @@ boost::python::list ConvertFilmChannelOutput_4xFloat_To_4xFloatList(const u_int
 
 	if (normalize) {
 		// Look for the max. in source buffer (only among RGB values, not Alpha)
-
-		float maxValue = 0.f;
-		for (u_int i = 0; i < width * height * 4; ++i) {
-			const float value = src[i];
-			// Leave out every multiple of 4 (alpha values)
-			if ((i % 4 != 0) && !isinf(value) && !isnan(value) && (value > maxValue))
-				maxValue = value;
-		}
+		const float maxValue = GetMaxColorValue(src, width * height, 4);
 		const float k = (maxValue == 0.f) ? 0.f : (1.f / maxValue);
 
 		for (u_int y = 0; y < height; ++y) {
@@ -404,6 +390,112 @@ boost::python::list ConvertFilmChannelOutput_4xFloat_To_4xFloatList(const u_int
 	return l;
 }
 
+// Writes a channel with srcChannels floats per pixel in a caller supplied
+// buffer with 4 floats per pixel (i.e. a NumPy array or a Blender pixel
+// buffer), without building any Python object
+static void ConvertFilmChannelOutput_NxFloat_To_4xFloatBuffer(const u_int width, const u_int height,
+		boost::python::object &objSrc, boost::python::object &objDst, const bool normalize,
+		const u_int srcChannels, const string &methodName) {
+	if (!PyObject_CheckBuffer(objSrc.ptr())) {
+		const string objType = extract<string>((objSrc.attr("__class__")).attr("__name__"));
+		throw runtime_error("Unsupported data type in source object of " + methodName + "(): " + objType);
+	}
+	if (!PyObject_CheckBuffer(objDst.ptr())) {
+		const string objType = extract<string>((objDst.attr("__class__")).attr("__name__"));
+		throw runtime_error("Unsupported data type in destination object of " + methodName + "(): " + objType);
+	}
+
+	Py_buffer srcView;
+	if (PyObject_GetBuffer(objSrc.ptr(), &srcView, PyBUF_SIMPLE)) {
+		const string objType = extract<string>((objSrc.attr("__class__")).attr("__name__"));
+		throw runtime_error("Unable to get a source data view in " + methodName + "(): " + objType);
+	}
+	Py_buffer dstView;
+	if (PyObject_GetBuffer(objDst.ptr(), &dstView, PyBUF_WRITABLE)) {
+		PyBuffer_Release(&srcView);
+
+		const string objType = extract<string>((objDst.attr("__class__")).attr("__name__"));
+		throw runtime_error("Unable to get a writable destination data view in " + methodName + "(): " + objType);
+	}
+
+	const size_t pixelCount = width * height;
+	if (((size_t)srcView.len < pixelCount * srcChannels * sizeof(float)) ||
+			((size_t)dstView.len < pixelCount * 4 * sizeof(float))) {
+		PyBuffer_Release(&srcView);
+		PyBuffer_Release(&dstView);
+		throw runtime_error("Wrong buffer size in " + methodName + "()");
+	}
+
+	const float *src = (float *)srcView.buf;
+	float *dst = (float *)dstView.buf;
+
+	float k = 1.f;
+	if (normalize) {
+		// The same normalization of the *_To_4xFloatList() versions
+		const float maxValue = GetMaxColorValue(src, pixelCount, srcChannels);
+		k = (maxValue == 0.f) ? 0.f : (1.f / maxValue);
+	}
+
+	for (size_t i = 0; i < pixelCount; ++i) {
+		const float *srcPixel = &src[i * srcChannels];
+		float *dstPixel = &dst[i * 4];
+
+		switch (srcChannels) {
+			case 1:
+				dstPixel[0] = srcPixel[0] * k;
+				dstPixel[1] = dstPixel[0];
+				dstPixel[2] = dstPixel[0];
+				dstPixel[3] = 1.f;
+				break;
+			case 2:
+				dstPixel[0] = srcPixel[0] * k;
+				dstPixel[1] = srcPixel[1] * k;
+				dstPixel[2] = 0.f;
+				dstPixel[3] = 1.f;
+				break;
+			case 3:
+				dstPixel[0] = srcPixel[0] * k;
+				dstPixel[1] = srcPixel[1] * k;
+				dstPixel[2] = srcPixel[2] * k;
+				dstPixel[3] = 1.f;
+				break;
+			default:
+				dstPixel[0] = srcPixel[0] * k;
+				dstPixel[1] = srcPixel[1] * k;
+				dstPixel[2] = srcPixel[2] * k;
+				dstPixel[3] = srcPixel[3];
+				break;
+		}
+	}
+
+	PyBuffer_Release(&srcView);
+	PyBuffer_Release(&dstView);
+}
+
+void ConvertFilmChannelOutput_1xFloat_To_4xFloatBuffer(const u_int width, const u_int height,
+		boost::python::object &objSrc, boost::python::object &objDst, const bool normalize) {
+	ConvertFilmChannelOutput_NxFloat_To_4xFloatBuffer(width, height, objSrc, objDst, normalize,
+			1, "ConvertFilmChannelOutput_1xFloat_To_4xFloatBuffer");
+}
+
+void ConvertFilmChannelOutput_2xFloat_To_4xFloatBuffer(const u_int width, const u_int height,
+		boost::python::object &objSrc, boost::python::object &objDst, const bool normalize) {
+	ConvertFilmChannelOutput_NxFloat_To_4xFloatBuffer(width, height, objSrc, objDst, normalize,
+			2, "ConvertFilmChannelOutput_2xFloat_To_4xFloatBuffer");
+}
+
+void ConvertFilmChannelOutput_3xFloat_To_4xFloatBuffer(const u_int width, const u_int height,
+		boost::python::object &objSrc, boost::python::object &objDst, const bool normalize) {
+	ConvertFilmChannelOutput_NxFloat_To_4xFloatBuffer(width, height, objSrc, objDst, normalize,
+			3, "ConvertFilmChannelOutput_3xFloat_To_4xFloatBuffer");
+}
+
+void ConvertFilmChannelOutput_4xFloat_To_4xFloatBuffer(const u_int width, const u_int height,
+		boost::python::object &objSrc, boost::python::object &objDst, const bool normalize) {
+	ConvertFilmChannelOutput_NxFloat_To_4xFloatBuffer(width, height, objSrc, objDst, normalize,
+			4, "ConvertFilmChannelOutput_4xFloat_To_4xFloatBuffer");
+}
+
 static bool Scene_DefineBlenderMesh(luxcore::detail::SceneImpl *scene, const string &name,
 		const size_t blenderFaceCount, const size_t blenderFacesPtr,
 		const size_t blenderVertCount, const size_t blenderVerticesPtr,
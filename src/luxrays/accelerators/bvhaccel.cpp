@@ -26,6 +26,7 @@
 #include <limits>
 
 #include "luxrays/accelerators/bvhaccel.h"
+#include "luxrays/core/bvh/bvhcache.h"
 #include "luxrays/utils/utils.h"
 #include "luxrays/core/context.h"
 
@@ -37,13 +38,27 @@ namespace luxrays {
 
 BVHAccel::BVHAccel(const Context *context) : ctx(context) {
 	params = ToBVHParams(ctx->GetConfig());
+	// 0 disables the refit and the tree is always rebuilt
+	refitSAHThreshold = ctx->GetConfig().Get(Property("accelerator.bvh.refit.sahthreshold")(1.5f)).Get<float>();
 
 	initialized = false;
 }
 
 BVHAccel::~BVHAccel() {
 	if (initialized)
-		delete bvhTree;
+		FreeTree();
+}
+
+void BVHAccel::FreeTree() {
+	// The tree loaded from the cache is in the mapped file
+	if (bvhTreeFile.is_open())
+		bvhTreeFile.close();
+	else
+		delete[] bvhTree;
+	bvhTree = NULL;
+
+	delete wideTree;
+	wideTree = NULL;
 }
 
 BVHParams BVHAccel::ToBVHParams(const Properties &props) {
@@ -82,6 +97,8 @@ void BVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totVert,
 		LR_LOG(ctx, "Empty BVH");
 		nNodes = 0;
 		bvhTree = NULL;
+		wideTree = NULL;
+		buildSAHCost = 0.f;
 		initialized = true;
 
 		return;
@@ -89,10 +106,76 @@ void BVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totVert,
 
 	const double t0 = WallClockTime();
 
+	const string builderType = ctx->GetConfig().Get(Property("accelerator.bvh.builder.type")(
+#if !defined(LUXCORE_DISABLE_EMBREE_BVH_BUILDER)
+		"EMBREE_BINNED_SAH"
+#else
+		"CLASSIC"
+#endif
+		)).Get<string>();
+	// The directory of the persistent BVH cache, an empty path disables it
+	const string cachePath = ctx->GetConfig().Get(Property("accelerator.bvh.cache.path")("")).Get<string>();
+
+	//--------------------------------------------------------------------------
+	// Look for the tree in the cache
+	//--------------------------------------------------------------------------
+
+	bvhTree = NULL;
+	string cacheKey;
+	if (cachePath != "") {
+		const double t1 = WallClockTime();
+
+		cacheKey = BVHCache::GetKey(params, builderType, meshes);
+		bvhTree = BVHCache(cachePath).Load(cacheKey, &nNodes, &bvhTreeFile);
+
+		LR_LOG(ctx, "BVH cache " << (bvhTree ? "hit" : "miss") << " (" << cacheKey << ") lookup time: " <<
+				int((WallClockTime() - t1) * 1000) << "ms");
+	}
+
+	//--------------------------------------------------------------------------
+	// Build the tree
+	//--------------------------------------------------------------------------
+
+	if (!bvhTree) {
+		BuildTree(builderType);
+
+		if (cachePath != "") {
+			// A failure to write the cache is not fatal
+			try {
+				BVHCache(cachePath).Save(cacheKey, bvhTree, nNodes);
+			} catch (std::exception &err) {
+				LR_LOG(ctx, "Unable to save the BVH in the cache: " << err.what());
+			}
+		}
+	}
+
+	buildSAHCost = EvaluateSAHCost();
+
+	//--------------------------------------------------------------------------
+	// Build the wide tree used by the CPU traversal
+	//--------------------------------------------------------------------------
+
+	BuildWideTree();
+
+	//--------------------------------------------------------------------------
+	// Done
+	//--------------------------------------------------------------------------
+
+	LR_LOG(ctx, "BVH total build time: " << int((WallClockTime() - t0) * 1000) << "ms");
+	const size_t totalMem = nNodes * sizeof(luxrays::ocl::BVHArrayNode) +
+			(wideTree ? wideTree->GetMemoryUsage() : 0);
+	LR_LOG(ctx, "Total BVH memory usage: " << totalMem / 1024 << "Kbytes");
+
+	initialized = true;
+}
+
+void BVHAccel::BuildTree(const string &builderType) {
 	//--------------------------------------------------------------------------
 	// Build the list of triangles
 	//--------------------------------------------------------------------------
-	
+
+	const double t0 = WallClockTime();
+
 	vector<BVHTreeNode> bvNodes(totalTriangleCount);
 	vector<BVHTreeNode *> bvList(totalTriangleCount, NULL);
 	u_int meshIndex = 0;
@@ -137,14 +220,6 @@ void BVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totVert,
 
 	const double t1 = WallClockTime();
 
-	const string builderType = ctx->GetConfig().Get(Property("accelerator.bvh.builder.type")(
-#if !defined(LUXCORE_DISABLE_EMBREE_BVH_BUILDER)
-		"EMBREE_BINNED_SAH"
-#else
-		"CLASSIC"
-#endif
-		)).Get<string>();
-
 	LR_LOG(ctx, "BVH builder: " << builderType);
 	if (builderType == "CLASSIC")
 		bvhTree = BuildBVH(params, &nNodes, &meshes, bvList);
@@ -158,20 +233,168 @@ void BVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totVert,
 		throw runtime_error("Unknown BVH builder type in BVHAccel::Init(): " + builderType);
 
 	LR_LOG(ctx, "BVH build hierarchy time: " << int((WallClockTime() - t1) * 1000) << "ms");
+}
 
-	//--------------------------------------------------------------------------
-	// Done
-	//--------------------------------------------------------------------------
+void BVHAccel::BuildWideTree() {
+	wideTree = NULL;
+	if ((params.treeType > 2) &&
+			ctx->GetConfig().Get(Property("accelerator.bvh.widetree.enable")(true)).Get<bool>()) {
+		const double t0 = WallClockTime();
 
-	LR_LOG(ctx, "BVH total build time: " << int((WallClockTime() - t0) * 1000) << "ms");
-	LR_LOG(ctx, "Total BVH memory usage: " << nNodes * sizeof(luxrays::ocl::BVHArrayNode) / 1024 << "Kbytes");
+		wideTree = BVHWideTree::Build(params.treeType, meshes, bvhTree, nNodes);
+		if (wideTree) {
+			LR_LOG(ctx, "BVH build " << wideTree->GetWidth() << "-ary wide tree time: " << int((WallClockTime() - t0) * 1000) << "ms");
+		} else {
+			LR_LOG(ctx, "BVH too large for a wide tree, using the binary tree");
+		}
+	}
+}
 
-	initialized = true;
+void BVHAccel::Rebuild() {
+	assert (initialized);
+
+	FreeTree();
+	initialized = false;
+
+	Init(meshes, totalVertexCount, totalTriangleCount);
+}
+
+void BVHAccel::UpdateMeshes(const deque<const Mesh *> &ms,
+		const u_longlong totVert, const u_longlong totTri,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes) {
+	assert (initialized);
+
+	// The tree can be refitted only if the list of meshes is the same and
+	// the meshes have only moved their vertices
+	bool canRefit = (ms == meshes);
+	bool isDeformed = false;
+	if (canRefit) {
+		BOOST_FOREACH(const Mesh *mesh, meshes) {
+			if (editedMeshes.count(mesh) > 0) {
+				canRefit = false;
+				break;
+			}
+
+			if (deformedMeshes.count(mesh) > 0)
+				isDeformed = true;
+		}
+	}
+
+	if (canRefit) {
+		if (isDeformed)
+			Refit();
+	} else {
+		meshes = ms;
+		totalVertexCount = totVert;
+		totalTriangleCount = totTri;
+
+		Rebuild();
+	}
+}
+
+void BVHAccel::Refit() {
+	assert (initialized);
+
+	if (!nNodes)
+		return;
+
+	if (refitSAHThreshold <= 0.f) {
+		Rebuild();
+		return;
+	}
+
+	const double t0 = WallClockTime();
+
+	RefitBBoxes();
+
+	// Check if the refitted tree is still good enough
+	const float sahCost = EvaluateSAHCost();
+	if (sahCost > buildSAHCost * refitSAHThreshold) {
+		LR_LOG(ctx, "BVH refit SAH cost " << sahCost << " is over the threshold (build SAH cost " << buildSAHCost << "), rebuilding the tree");
+		Rebuild();
+		return;
+	}
+
+	// The wide tree stores a copy of the vertices so it has to be rebuilt
+	delete wideTree;
+	BuildWideTree();
+
+	LR_LOG(ctx, "BVH refit time: " << int((WallClockTime() - t0) * 1000) << "ms (SAH cost " << sahCost << ", build SAH cost " << buildSAHCost << ")");
+}
+
+void BVHAccel::RefitBBoxes() {
+	vector<BBox> bboxes(nNodes);
+
+	// Leaf bounding boxes, computed the same way the builders do
+	#pragma omp parallel for
+	for (
+			// Visual C++ 2013 supports only OpenMP 2.5
+#if _OPENMP >= 200805
+			unsigned
+#endif
+			int i = 0; i < nNodes; ++i) {
+		const luxrays::ocl::BVHArrayNode &node = bvhTree[i];
+
+		if (BVHNodeData_IsLeaf(node.nodeData)) {
+			const Mesh *mesh = meshes[node.triangleLeaf.meshIndex];
+
+			BBox &bbox = bboxes[i];
+			bbox = Union(
+					BBox(mesh->GetVertex(0.f, node.triangleLeaf.v[0]), mesh->GetVertex(0.f, node.triangleLeaf.v[1])),
+					mesh->GetVertex(0.f, node.triangleLeaf.v[2]));
+			bbox.Expand(MachineEpsilon::E(bbox));
+		}
+	}
+
+	// Inner node bounding boxes, bottom-up. The children of a node are
+	// always stored after their parent so a backward scan visits the
+	// children first.
+	for (int i = (int)nNodes - 1; i >= 0; --i) {
+		luxrays::ocl::BVHArrayNode &node = bvhTree[i];
+
+		if (!BVHNodeData_IsLeaf(node.nodeData)) {
+			const u_int skipIndex = node.nodeData;
+
+			BBox &bbox = bboxes[i];
+			for (u_int child = i + 1; child < skipIndex; child = BVHNodeData_GetSkipIndex(bvhTree[child].nodeData))
+				bbox = Union(bbox, bboxes[child]);
+
+			node.bvhNode.bboxMin[0] = bbox.pMin.x;
+			node.bvhNode.bboxMin[1] = bbox.pMin.y;
+			node.bvhNode.bboxMin[2] = bbox.pMin.z;
+			node.bvhNode.bboxMax[0] = bbox.pMax.x;
+			node.bvhNode.bboxMax[1] = bbox.pMax.y;
+			node.bvhNode.bboxMax[2] = bbox.pMax.z;
+		}
+	}
+}
+
+// The SAH cost of the inner nodes, relative to the root node. The leaves are
+// not included because their cost depends only on the size of the triangles.
+float BVHAccel::EvaluateSAHCost() const {
+	if (!nNodes || BVHNodeData_IsLeaf(bvhTree[0].nodeData))
+		return 0.f;
+
+	double cost = 0.0;
+	for (u_int i = 0; i < nNodes; ++i) {
+		const luxrays::ocl::BVHArrayNode &node = bvhTree[i];
+
+		if (!BVHNodeData_IsLeaf(node.nodeData))
+			cost += BBox(Point(node.bvhNode.bboxMin), Point(node.bvhNode.bboxMax)).SurfaceArea();
+	}
+
+	const float rootArea = BBox(Point(bvhTree[0].bvhNode.bboxMin), Point(bvhTree[0].bvhNode.bboxMax)).SurfaceArea();
+
+	return (rootArea > 0.f) ? (float)(cost / rootArea) : 0.f;
 }
 
 bool BVHAccel::Intersect(const Ray *initialRay, RayHit *rayHit) const {
 	assert (initialized);
 
+	if (wideTree)
+		return wideTree->Intersect(*initialRay, rayHit);
+
 	rayHit->t = initialRay->maxt;
 	rayHit->SetMiss();
 	if (!nNodes)
@@ -224,4 +447,116 @@ bool BVHAccel::Intersect(const Ray *initialRay, RayHit *rayHit) const {
 	return !rayHit->Miss();
 }
 
+void BVHAccel::IntersectPacket(const Ray *rays, RayHit *rayHits, const u_int rayCount) const {
+	BVHRayPacket packet;
+	packet.Init(rays, rayCount);
+
+	for (u_int i = 0; i < rayCount; ++i) {
+		rayHits[i].t = rays[i].maxt;
+		rayHits[i].SetMiss();
+	}
+	if (!nNodes)
+		return;
+
+	u_int currentNode = 0; // Root Node
+	const u_int stopNode = BVHNodeData_GetSkipIndex(bvhTree[0].nodeData); // Non-existent
+
+	float t, b1, b2;
+	while (currentNode < stopNode) {
+		const luxrays::ocl::BVHArrayNode &node = bvhTree[currentNode];
+
+		const u_int nodeData = node.nodeData;
+		if (BVHNodeData_IsLeaf(nodeData)) {
+			// It is a leaf, fetch the triangle only once and check all rays
+			const Mesh *mesh = meshes[node.triangleLeaf.meshIndex];
+			const Point p0 = mesh->GetVertex(0.f, node.triangleLeaf.v[0]);
+			const Point p1 = mesh->GetVertex(0.f, node.triangleLeaf.v[1]);
+			const Point p2 = mesh->GetVertex(0.f, node.triangleLeaf.v[2]);
+
+			for (u_int i = 0; i < rayCount; ++i) {
+				Ray &ray = packet.rays[i];
+				if (Triangle::Intersect(ray, p0, p1, p2, &t, &b1, &b2)) {
+					if (t < rayHits[i].t) {
+						ray.maxt = t;
+						rayHits[i].t = t;
+						rayHits[i].b1 = b1;
+						rayHits[i].b2 = b2;
+						rayHits[i].meshIndex = node.triangleLeaf.meshIndex;
+						rayHits[i].triangleIndex = node.triangleLeaf.triangleIndex;
+					}
+				}
+			}
+
+			++currentNode;
+		} else {
+			// It is a node, check the bounding box against the whole packet
+			if (packet.IntersectP(&node.bvhNode.bboxMin[0], &node.bvhNode.bboxMax[0]))
+				++currentNode;
+			else {
+				// I don't need to use BVHNodeData_GetSkipIndex() here because
+				// I already know the leaf flag is 0
+				currentNode = nodeData;
+			}
+		}
+	}
+}
+
+void BVHAccel::IntersectBatch(const Ray *rays, RayHit *rayHits, const size_t rayCount) const {
+	assert (initialized);
+
+	if (wideTree) {
+		// The SIMD tests of the wide tree are faster than the packet
+		// traversal of the binary tree
+		for (size_t i = 0; i < rayCount; ++i)
+			wideTree->Intersect(rays[i], &rayHits[i]);
+		return;
+	}
+
+	for (size_t i = 0; i < rayCount; i += BVHACCEL_PACKET_SIZE) {
+		const u_int packetSize = (u_int)Min<size_t>(BVHACCEL_PACKET_SIZE, rayCount - i);
+		IntersectPacket(&rays[i], &rayHits[i], packetSize);
+	}
+}
+
+
+bool BVHAccel::Occluded(const Ray *ray) const {
+	assert (initialized);
+
+	if (wideTree)
+		return wideTree->Occluded(*ray);
+	if (!nNodes)
+		return false;
+
+	u_int currentNode = 0; // Root Node
+	const u_int stopNode = BVHNodeData_GetSkipIndex(bvhTree[0].nodeData); // Non-existent
+
+	float t, b1, b2;
+	while (currentNode < stopNode) {
+		const luxrays::ocl::BVHArrayNode &node = bvhTree[currentNode];
+
+		const u_int nodeData = node.nodeData;
+		if (BVHNodeData_IsLeaf(nodeData)) {
+			const Mesh *mesh = meshes[node.triangleLeaf.meshIndex];
+			const Point p0 = mesh->GetVertex(0.f, node.triangleLeaf.v[0]);
+			const Point p1 = mesh->GetVertex(0.f, node.triangleLeaf.v[1]);
+			const Point p2 = mesh->GetVertex(0.f, node.triangleLeaf.v[2]);
+
+			// Any hit is good enough
+			if (Triangle::Intersect(*ray, p0, p1, p2, &t, &b1, &b2))
+				return true;
+
+			++currentNode;
+		} else {
+			if (BBox::IntersectP(*ray,
+					*reinterpret_cast<const Point *>(&node.bvhNode.bboxMin[0]),
+					*reinterpret_cast<const Point *>(&node.bvhNode.bboxMax[0])))
+				++currentNode;
+			else
+				currentNode = nodeData;
+		}
+	}
+
+	return false;
+}
+
 }
@@ -26,6 +26,7 @@
 #include <boost/foreach.hpp>
 
 #include "luxrays/core/context.h"
+#include "luxrays/core/extcurvemesh.h"
 #include "luxrays/accelerators/embreeaccel.h"
 
 namespace luxrays {
@@ -60,10 +61,27 @@ void Embree_error_handler(const RTCError code, const char *str) {
 }
 
 EmbreeAccel::EmbreeAccel(const Context *context) : ctx(context),
+		uniqueGeomIDByMesh(MeshPtrCompare),
 		uniqueRTCSceneByMesh(MeshPtrCompare), uniqueInstIDByMesh(MeshPtrCompare),
 		uniqueInstMatrixByMesh(MeshPtrCompare) {
 	embreeDevice = rtcNewDevice(NULL);
 	embreeScene = NULL;
+
+	// Select the widest ray packet supported by the CPU and Embree build
+	sceneAlgorithmFlags = RTC_INTERSECT1;
+	packetSize = 1;
+	if (rtcDeviceGetParameter1i(embreeDevice, RTC_CONFIG_INTERSECT4)) {
+		sceneAlgorithmFlags |= RTC_INTERSECT4;
+		packetSize = 4;
+	}
+	if (rtcDeviceGetParameter1i(embreeDevice, RTC_CONFIG_INTERSECT8)) {
+		sceneAlgorithmFlags |= RTC_INTERSECT8;
+		packetSize = 8;
+	}
+	if (rtcDeviceGetParameter1i(embreeDevice, RTC_CONFIG_INTERSECT16)) {
+		sceneAlgorithmFlags |= RTC_INTERSECT16;
+		packetSize = 16;
+	}
 }
 
 EmbreeAccel::~EmbreeAccel() {
@@ -79,8 +97,9 @@ EmbreeAccel::~EmbreeAccel() {
 	rtcDeleteDevice(embreeDevice);
 }
 
-u_int EmbreeAccel::ExportTriangleMesh(const RTCScene embreeScene, const Mesh *mesh) const {
-	const u_int geomID = rtcNewTriangleMesh(embreeScene, RTC_GEOMETRY_STATIC,
+u_int EmbreeAccel::ExportTriangleMesh(const RTCScene embreeScene, const Mesh *mesh,
+		const RTCGeometryFlags geomFlags) const {
+	const u_int geomID = rtcNewTriangleMesh(embreeScene, geomFlags,
 			mesh->GetTotalTriangleCount(), mesh->GetTotalVertexCount(), 1);
 
 	// Share with Embree the mesh vertices
@@ -129,11 +148,63 @@ u_int EmbreeAccel::ExportMotionTriangleMesh(const RTCScene embreeScene, const Mo
 	return geomID;
 }
 
+// Returns the mesh if it is a curve mesh not yet tessellated, NULL otherwise
+static const ExtCurveMesh *GetCurveMesh(const Mesh *mesh) {
+	const ExtCurveMesh *curveMesh = dynamic_cast<const ExtCurveMesh *>(mesh);
+
+	return (curveMesh && !curveMesh->IsTessellated()) ? curveMesh : NULL;
+}
+
+u_int EmbreeAccel::ExportCurveMesh(const RTCScene embreeScene, const ExtCurveMesh *mesh) const {
+	const u_int geomID = rtcNewHairGeometry(embreeScene, RTC_GEOMETRY_STATIC,
+			mesh->GetCurveSegmentCount(), mesh->GetCurveVertexCount(), 1);
+
+	// Share with Embree the curve control points (x, y, z, radius)
+	rtcSetBuffer(embreeScene, geomID, RTC_VERTEX_BUFFER, mesh->GetCurveVertices(), 0, 4 * sizeof(float));
+
+	// Share with Embree the index of the first control point of each segment
+	rtcSetBuffer(embreeScene, geomID, RTC_INDEX_BUFFER, mesh->GetCurveSegments(), 0, sizeof(u_int));
+
+	return geomID;
+}
+
 void EmbreeAccel::Init(const std::deque<const Mesh *> &meshes,
 		const u_longlong totalVertexCount,
 		const u_longlong totalTriangleCount) {
 	const double t0 = WallClockTime();
 
+	//--------------------------------------------------------------------------
+	// Convert the meshes to an Embree Scene
+	//--------------------------------------------------------------------------
+
+	embreeScene = rtcDeviceNewScene(embreeDevice, RTC_SCENE_DYNAMIC, (RTCAlgorithmFlags)sceneAlgorithmFlags);
+
+	ExportMeshes(meshes, boost::unordered_set<const Mesh *>(), boost::unordered_set<const Mesh *>());
+
+	rtcCommit(embreeScene);
+
+	LR_LOG(ctx, "EmbreeAccel ray packet size: " << packetSize);
+	LR_LOG(ctx, "EmbreeAccel build time: " << int((WallClockTime() - t0) * 1000) << "ms");
+}
+
+void EmbreeAccel::UpdateMeshes(const std::deque<const Mesh *> &meshes,
+		const u_longlong totalVertexCount, const u_longlong totalTriangleCount,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes) {
+	const double t0 = WallClockTime();
+
+	// Only the geometries of new or edited meshes are rebuilt, the deformed
+	// ones are refitted
+	ExportMeshes(meshes, editedMeshes, deformedMeshes);
+
+	rtcCommit(embreeScene);
+
+	LR_LOG(ctx, "EmbreeAccel update time: " << int((WallClockTime() - t0) * 1000) << "ms");
+}
+
+void EmbreeAccel::ExportMeshes(const std::deque<const Mesh *> &meshes,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes) {
 	//--------------------------------------------------------------------------
 	// Extract the meshes min. and max. time. To normalize between 0.f and 1.f.
 	//--------------------------------------------------------------------------
@@ -158,61 +229,172 @@ void EmbreeAccel::Init(const std::deque<const Mesh *> &meshes,
 		timeScale = 1.f / (maxTime - minTime);
 
 	//--------------------------------------------------------------------------
-	// Convert the meshes to an Embree Scene
+	// Add the meshes to the Embree Scene, reusing the geometries of the
+	// previous export if the mesh has not been edited
 	//--------------------------------------------------------------------------
 
-	embreeScene = rtcDeviceNewScene(embreeDevice, RTC_SCENE_DYNAMIC, RTC_INTERSECT1);
+	MeshMap<u_int>::type oldGeomIDByMesh(MeshPtrCompare);
+	oldGeomIDByMesh.swap(uniqueGeomIDByMesh);
+	MeshMap<u_int>::type oldInstIDByMesh(MeshPtrCompare);
+	oldInstIDByMesh.swap(uniqueInstIDByMesh);
+	MeshMap<RTCScene>::type oldRTCSceneByMesh(MeshPtrCompare);
+	oldRTCSceneByMesh.swap(uniqueRTCSceneByMesh);
+
+	boost::unordered_set<const Mesh *> oldDeformableMeshes;
+	oldDeformableMeshes.swap(deformableMeshes);
+
+	// The instanced meshes with a new RTCScene
+	boost::unordered_set<const Mesh *> newRTCScenes;
 
+	std::vector<u_int> geomIDs;
+	geomIDs.reserve(meshes.size());
 	BOOST_FOREACH(const Mesh *mesh, meshes) {
+		const bool edited = (editedMeshes.count(mesh) > 0);
+
 		switch (mesh->GetType()) {
 			case TYPE_TRIANGLE:
 			case TYPE_EXT_TRIANGLE:
-				ExportTriangleMesh(embreeScene, mesh);
+			case TYPE_TRIANGLE_MOTION:
+			case TYPE_EXT_TRIANGLE_MOTION: {
+				const MotionTriangleMesh *mtm = dynamic_cast<const MotionTriangleMesh *>(mesh);
+				const ExtCurveMesh *curveMesh = GetCurveMesh(mesh);
+				// The vertices of motion meshes are copied and the curves
+				// are static geometries so they can not be just refitted
+				const bool deformed = (deformedMeshes.count(mesh) > 0);
+
+				u_int geomID;
+				MeshMap<u_int>::type::iterator oldIt = oldGeomIDByMesh.find(mesh);
+				if ((oldIt != oldGeomIDByMesh.end()) && !edited && !((mtm || curveMesh) && deformed)) {
+					geomID = oldIt->second;
+					oldGeomIDByMesh.erase(oldIt);
+
+					if (oldDeformableMeshes.count(mesh) > 0) {
+						// Embree refits the deformable geometries. The buffers
+						// are set again because a mesh redefined with the same
+						// topology swaps in new vertex and index arrays.
+						if (deformed) {
+							rtcSetBuffer(embreeScene, geomID, RTC_VERTEX_BUFFER, mesh->GetVertices(), 0, 3 * sizeof(float));
+							rtcSetBuffer(embreeScene, geomID, RTC_INDEX_BUFFER, mesh->GetTriangles(), 0, 3 * sizeof(int));
+							rtcUpdate(embreeScene, geomID);
+						}
+						deformableMeshes.insert(mesh);
+					} else if (deformed) {
+						// The first time a mesh is deformed, it is exported
+						// again as deformable so the next updates are
+						// only refits
+						rtcDeleteGeometry(embreeScene, geomID);
+						geomID = ExportTriangleMesh(embreeScene, mesh, RTC_GEOMETRY_DEFORMABLE);
+						deformableMeshes.insert(mesh);
+					}
+				} else {
+					if (mtm)
+						geomID = ExportMotionTriangleMesh(embreeScene, mtm);
+					else if (curveMesh)
+						geomID = ExportCurveMesh(embreeScene, curveMesh);
+					else
+						geomID = ExportTriangleMesh(embreeScene, mesh, RTC_GEOMETRY_STATIC);
+				}
+
+				uniqueGeomIDByMesh[mesh] = geomID;
+				geomIDs.push_back(geomID);
 				break;
+			}
 			case TYPE_TRIANGLE_INSTANCE:
 			case TYPE_EXT_TRIANGLE_INSTANCE: {
 				const InstanceTriangleMesh *itm = dynamic_cast<const InstanceTriangleMesh *>(mesh);
+				TriangleMesh *instancedMesh = itm->GetTriangleMesh();
 
 				// Check if a RTCScene has already been created
-				std::map<const Mesh *, RTCScene, bool (*)(const Mesh *, const Mesh *)>::iterator it =
-						uniqueRTCSceneByMesh.find(itm->GetTriangleMesh());
-
 				RTCScene instScene;
-				if (it == uniqueRTCSceneByMesh.end()) {
-					TriangleMesh *instancedMesh = itm->GetTriangleMesh();
-
-					// Create a new RTCScene
-					instScene = rtcDeviceNewScene(embreeDevice, RTC_SCENE_STATIC, RTC_INTERSECT1);
-					ExportTriangleMesh(instScene, instancedMesh);
-					rtcCommit(instScene);
-
-					uniqueRTCSceneByMesh[instancedMesh] = instScene;
-				} else
+				MeshMap<RTCScene>::type::iterator it = uniqueRTCSceneByMesh.find(instancedMesh);
+				if (it != uniqueRTCSceneByMesh.end())
 					instScene = it->second;
+				else {
+					MeshMap<RTCScene>::type::iterator oldIt = oldRTCSceneByMesh.find(instancedMesh);
+					// Static scenes can not be modified so the RTCScene of
+					// a deformed mesh has to be rebuilt too
+					if ((oldIt != oldRTCSceneByMesh.end()) && (editedMeshes.count(instancedMesh) == 0) &&
+							(deformedMeshes.count(instancedMesh) == 0)) {
+						// Reuse the RTCScene of the previous export
+						instScene = oldIt->second;
+						oldRTCSceneByMesh.erase(oldIt);
+					} else {
+						// Create a new RTCScene
+						instScene = rtcDeviceNewScene(embreeDevice, RTC_SCENE_STATIC, (RTCAlgorithmFlags)sceneAlgorithmFlags);
+						const ExtCurveMesh *curveMesh = GetCurveMesh(instancedMesh);
+						if (curveMesh)
+							ExportCurveMesh(instScene, curveMesh);
+						else
+							ExportTriangleMesh(instScene, instancedMesh, RTC_GEOMETRY_STATIC);
+						rtcCommit(instScene);
+
+						newRTCScenes.insert(instancedMesh);
+					}
 
-				const u_int instID = rtcNewInstance(embreeScene, instScene);
-				rtcSetTransform(embreeScene, instID, RTC_MATRIX_ROW_MAJOR, &(itm->GetTransformation().m.m[0][0]));
+					uniqueRTCSceneByMesh[instancedMesh] = instScene;
+				}
+
+				// The instance can be reused only if it still points to
+				// a valid RTCScene
+				u_int instID;
+				MeshMap<u_int>::type::iterator oldInstIt = oldInstIDByMesh.find(mesh);
+				if ((oldInstIt != oldInstIDByMesh.end()) && !edited &&
+						(newRTCScenes.count(instancedMesh) == 0)) {
+					// Reuse the instance of the previous export
+					instID = oldInstIt->second;
+					oldInstIDByMesh.erase(oldInstIt);
+
+					if (uniqueInstMatrixByMesh[mesh] != itm->GetTransformation().m) {
+						rtcSetTransform(embreeScene, instID, RTC_MATRIX_ROW_MAJOR, &(itm->GetTransformation().m.m[0][0]));
+						rtcUpdate(embreeScene, instID);
+					}
+				} else {
+					instID = rtcNewInstance(embreeScene, instScene);
+					rtcSetTransform(embreeScene, instID, RTC_MATRIX_ROW_MAJOR, &(itm->GetTransformation().m.m[0][0]));
+				}
 
 				// Save the instance ID
 				uniqueInstIDByMesh[mesh] = instID;
 				// Save the matrix
 				uniqueInstMatrixByMesh[mesh] = itm->GetTransformation().m;
-				break;
-			}
-			case TYPE_TRIANGLE_MOTION:
-			case TYPE_EXT_TRIANGLE_MOTION: {
-				const MotionTriangleMesh *mtm = dynamic_cast<const MotionTriangleMesh *>(mesh);
-				ExportMotionTriangleMesh(embreeScene, mtm);
+
+				geomIDs.push_back(instID);
 				break;
 			}
 			default:
-				throw std::runtime_error("Unknown Mesh type in EmbreeAccel::Init(): " + ToString(mesh->GetType()));
+				throw std::runtime_error("Unknown Mesh type in EmbreeAccel::ExportMeshes(): " + ToString(mesh->GetType()));
 		}
 	}
 
-	rtcCommit(embreeScene);
+	//--------------------------------------------------------------------------
+	// Delete all the geometries not used anymore
+	//--------------------------------------------------------------------------
 
-	LR_LOG(ctx, "EmbreeAccel build time: " << int((WallClockTime() - t0) * 1000) << "ms");
+	std::pair<const Mesh *, u_int> elem;
+	BOOST_FOREACH(elem, oldGeomIDByMesh)
+		rtcDeleteGeometry(embreeScene, elem.second);
+	BOOST_FOREACH(elem, oldInstIDByMesh) {
+		rtcDeleteGeometry(embreeScene, elem.second);
+		if (uniqueInstIDByMesh.count(elem.first) == 0)
+			uniqueInstMatrixByMesh.erase(elem.first);
+	}
+	// The instanced RTCScenes can be deleted only after the instances
+	std::pair<const Mesh *, RTCScene> sceneElem;
+	BOOST_FOREACH(sceneElem, oldRTCSceneByMesh)
+		rtcDeleteScene(sceneElem.second);
+
+	//--------------------------------------------------------------------------
+	// Build the geometry ID to mesh index translation table
+	//--------------------------------------------------------------------------
+
+	u_int maxGeomID = 0;
+	BOOST_FOREACH(const u_int geomID, geomIDs)
+		maxGeomID = Max(maxGeomID, geomID);
+
+	meshIndexByGeomID.clear();
+	meshIndexByGeomID.resize(maxGeomID + 1, NULL_INDEX);
+	for (u_int i = 0; i < geomIDs.size(); ++i)
+		meshIndexByGeomID[geomIDs[i]] = i;
 }
 
 void EmbreeAccel::Update() {
@@ -261,7 +443,7 @@ bool EmbreeAccel::Intersect(const Ray *ray, RayHit *hit) const {
 	rtcIntersect(embreeScene, embreeRay);
 
 	if (embreeRay.geomID != RTC_INVALID_GEOMETRY_ID) {
-		hit->meshIndex = (embreeRay.instID == RTC_INVALID_GEOMETRY_ID) ? embreeRay.geomID : embreeRay.instID;
+		hit->meshIndex = meshIndexByGeomID[(embreeRay.instID == RTC_INVALID_GEOMETRY_ID) ? embreeRay.geomID : embreeRay.instID];
 		hit->triangleIndex = embreeRay.primID;
 
 		hit->t = embreeRay.tfar;
@@ -274,4 +456,103 @@ bool EmbreeAccel::Intersect(const Ray *ray, RayHit *hit) const {
 		return false;
 }
 
+template<class RTCRayN, u_int N> void EmbreeAccel::IntersectPacket(
+		void (*rtcIntersectN)(const void *, RTCScene, RTCRayN &),
+		const Ray *rays, RayHit *hits, const u_int rayCount) const {
+	RTCRayN embreeRays;
+	RTCORE_ALIGN(64) int valid[N];
+
+	for (u_int i = 0; i < N; ++i) {
+		if (i < rayCount) {
+			const Ray *ray = &rays[i];
+
+			embreeRays.orgx[i] = ray->o.x;
+			embreeRays.orgy[i] = ray->o.y;
+			embreeRays.orgz[i] = ray->o.z;
+
+			embreeRays.dirx[i] = ray->d.x;
+			embreeRays.diry[i] = ray->d.y;
+			embreeRays.dirz[i] = ray->d.z;
+
+			embreeRays.tnear[i] = ray->mint;
+			embreeRays.tfar[i] = ray->maxt;
+
+			embreeRays.geomID[i] = RTC_INVALID_GEOMETRY_ID;
+			embreeRays.primID[i] = RTC_INVALID_GEOMETRY_ID;
+			embreeRays.instID[i] = RTC_INVALID_GEOMETRY_ID;
+			embreeRays.mask[i] = 0xFFFFFFFF;
+			embreeRays.time[i] = (ray->time - minTime) * timeScale;
+
+			valid[i] = -1;
+		} else
+			valid[i] = 0;
+	}
+
+	rtcIntersectN(valid, embreeScene, embreeRays);
+
+	for (u_int i = 0; i < rayCount; ++i) {
+		RayHit *hit = &hits[i];
+
+		if (embreeRays.geomID[i] != RTC_INVALID_GEOMETRY_ID) {
+			hit->meshIndex = meshIndexByGeomID[(embreeRays.instID[i] == RTC_INVALID_GEOMETRY_ID) ? embreeRays.geomID[i] : embreeRays.instID[i]];
+			hit->triangleIndex = embreeRays.primID[i];
+
+			hit->t = embreeRays.tfar[i];
+
+			hit->b1 = embreeRays.u[i];
+			hit->b2 = embreeRays.v[i];
+		} else
+			hit->SetMiss();
+	}
+}
+
+void EmbreeAccel::IntersectBatch(const Ray *rays, RayHit *hits, const size_t rayCount) const {
+	for (size_t i = 0; i < rayCount; i += packetSize) {
+		const u_int count = (u_int)Min<size_t>(packetSize, rayCount - i);
+
+		switch (packetSize) {
+			case 16:
+				IntersectPacket<RTCRay16, 16>(rtcIntersect16, &rays[i], &hits[i], count);
+				break;
+			case 8:
+				IntersectPacket<RTCRay8, 8>(rtcIntersect8, &rays[i], &hits[i], count);
+				break;
+			case 4:
+				IntersectPacket<RTCRay4, 4>(rtcIntersect4, &rays[i], &hits[i], count);
+				break;
+			default:
+				hits[i].SetMiss();
+				Intersect(&rays[i], &hits[i]);
+				break;
+		}
+	}
+}
+
+
+bool EmbreeAccel::Occluded(const Ray *ray) const {
+	RTCRay embreeRay;
+
+	embreeRay.org[0] = ray->o.x;
+	embreeRay.org[1] = ray->o.y;
+	embreeRay.org[2] = ray->o.z;
+
+	embreeRay.dir[0] = ray->d.x;
+	embreeRay.dir[1] = ray->d.y;
+	embreeRay.dir[2] = ray->d.z;
+
+	embreeRay.tnear = ray->mint;
+	embreeRay.tfar = ray->maxt;
+
+	embreeRay.geomID = RTC_INVALID_GEOMETRY_ID;
+	embreeRay.primID = RTC_INVALID_GEOMETRY_ID;
+	embreeRay.instID = RTC_INVALID_GEOMETRY_ID;
+	embreeRay.mask = 0xFFFFFFFF;
+	embreeRay.time = (ray->time - minTime) * timeScale;
+
+	rtcOccluded(embreeScene, embreeRay);
+
+	// rtcOccluded() sets geomID to 0 if the ray is occluded
+	return (embreeRay.geomID == 0);
+}
+
 }
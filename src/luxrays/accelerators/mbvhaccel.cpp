@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <limits>
 #include <boost/foreach.hpp>
+#include <boost/unordered_set.hpp>
 
 #include "luxrays/accelerators/mbvhaccel.h"
 #include "luxrays/utils/utils.h"
@@ -37,7 +38,8 @@ namespace luxrays {
 
 // MBVHAccel Method Definitions
 
-MBVHAccel::MBVHAccel(const Context *context) : ctx(context) {
+MBVHAccel::MBVHAccel(const Context *context) : uniqueLeafIndexByMesh(MeshPtrCompare),
+		ctx(context) {
 	params = BVHAccel::ToBVHParams(ctx->GetConfig());
 
 	initialized = false;
@@ -73,6 +75,31 @@ void MBVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totalVertex
 
 	const double t0 = WallClockTime();
 
+	BuildLeafs(boost::unordered_set<const Mesh *>(), boost::unordered_set<const Mesh *>());
+
+	bvhRootTree = NULL;
+	UpdateRootBVH();
+
+	LR_LOG(ctx, "MBVH build time: " << int((WallClockTime() - t0) * 1000) << "ms");
+
+	LogMemoryUsage();
+
+	initialized = true;
+}
+
+void MBVHAccel::BuildLeafs(const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes) {
+	// The leafs of the previous build can be reused if their mesh has not been
+	// edited and refitted if their mesh has been deformed
+	vector<BVHAccel *> oldLeafs;
+	oldLeafs.swap(uniqueLeafs);
+	LeafIndexByMeshMap oldLeafIndexByMesh(MeshPtrCompare);
+	oldLeafIndexByMesh.swap(uniqueLeafIndexByMesh);
+	vector<bool> oldLeafsReused(oldLeafs.size(), false);
+
+	uniqueLeafsTransform.clear();
+	uniqueLeafsMotionSystem.clear();
+
 	//--------------------------------------------------------------------------
 	// Build all BVH leafs
 	//--------------------------------------------------------------------------
@@ -85,9 +112,11 @@ void MBVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totalVertex
 	vector<u_int> leafsMotionSystemIndex;
 
 	leafsIndex.reserve(nLeafs);
+	leafsTransformIndex.reserve(nLeafs);
+	leafsMotionSystemIndex.reserve(nLeafs);
 
-	map<const Mesh *, u_int, bool (*)(const Mesh *, const Mesh *)> uniqueLeafIndexByMesh(MeshPtrCompare);
-
+	u_int reusedLeafsCount = 0;
+	u_int refittedLeafsCount = 0;
 	double lastPrint = WallClockTime();
 	for (u_int i = 0; i < nLeafs; ++i) {
 		const double now = WallClockTime();
@@ -98,17 +127,13 @@ void MBVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totalVertex
 
 		const Mesh *mesh = meshes[i];
 
+		// The mesh used to build the leaf BVH
+		const Mesh *leafMesh;
 		switch (mesh->GetType()) {
 			case TYPE_TRIANGLE:
 			case TYPE_EXT_TRIANGLE: {
-				BVHAccel *leaf = new BVHAccel(ctx);
-				deque<const Mesh *> mlist(1, mesh);
-				leaf->Init(mlist, mesh->GetTotalVertexCount(), mesh->GetTotalTriangleCount());
-
-				const u_int uniqueLeafIndex = uniqueLeafs.size();
-				uniqueLeafIndexByMesh[mesh] = uniqueLeafIndex;
-				uniqueLeafs.push_back(leaf);
-				leafsIndex.push_back(uniqueLeafIndex);
+				leafMesh = mesh;
+
 				leafsTransformIndex.push_back(NULL_INDEX);
 				leafsMotionSystemIndex.push_back(NULL_INDEX);
 				break;
@@ -116,27 +141,7 @@ void MBVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totalVertex
 			case TYPE_TRIANGLE_INSTANCE:
 			case TYPE_EXT_TRIANGLE_INSTANCE: {
 				const InstanceTriangleMesh *itm = dynamic_cast<const InstanceTriangleMesh *>(mesh);
-
-				// Check if a BVH has already been created
-				map<const Mesh *, u_int, bool (*)(const Mesh *, const Mesh *)>::iterator it =
-						uniqueLeafIndexByMesh.find(itm->GetTriangleMesh());
-
-				if (it == uniqueLeafIndexByMesh.end()) {
-					TriangleMesh *instancedMesh = itm->GetTriangleMesh();
-
-					// Create a new BVH
-					BVHAccel *leaf = new BVHAccel(ctx);
-					deque<const Mesh *> mlist(1, instancedMesh);
-					leaf->Init(mlist, instancedMesh->GetTotalVertexCount(), instancedMesh->GetTotalTriangleCount());
-
-					const u_int uniqueLeafIndex = uniqueLeafs.size();
-					uniqueLeafIndexByMesh[instancedMesh] = uniqueLeafIndex;
-					uniqueLeafs.push_back(leaf);
-					leafsIndex.push_back(uniqueLeafIndex);
-				} else {
-					//LR_LOG(ctx, "Cached BVH leaf");
-					leafsIndex.push_back(it->second);
-				}
+				leafMesh = itm->GetTriangleMesh();
 
 				leafsTransformIndex.push_back(uniqueLeafsTransform.size());
 				uniqueLeafsTransform.push_back(&itm->GetTransformation());
@@ -146,27 +151,7 @@ void MBVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totalVertex
 			case TYPE_TRIANGLE_MOTION:
 			case TYPE_EXT_TRIANGLE_MOTION: {
 				const MotionTriangleMesh *mtm = dynamic_cast<const MotionTriangleMesh *>(mesh);
-
-				// Check if a BVH has already been created
-				map<const Mesh *, u_int, bool (*)(const Mesh *, const Mesh *)>::iterator it =
-						uniqueLeafIndexByMesh.find(mtm->GetTriangleMesh());
-
-				if (it == uniqueLeafIndexByMesh.end()) {
-					TriangleMesh *motionMesh = mtm->GetTriangleMesh();
-
-					// Create a new BVH
-					BVHAccel *leaf = new BVHAccel(ctx);
-					deque<const Mesh *> mlist(1, motionMesh);
-					leaf->Init(mlist, motionMesh->GetTotalVertexCount(), motionMesh->GetTotalTriangleCount());
-
-					const u_int uniqueLeafIndex = uniqueLeafs.size();
-					uniqueLeafIndexByMesh[motionMesh] = uniqueLeafIndex;
-					uniqueLeafs.push_back(leaf);
-					leafsIndex.push_back(uniqueLeafIndex);
-				} else {
-					//LR_LOG(ctx, "Cached BVH leaf");
-					leafsIndex.push_back(it->second);
-				}
+				leafMesh = mtm->GetTriangleMesh();
 
 				leafsMotionSystemIndex.push_back(uniqueLeafsMotionSystem.size());
 				uniqueLeafsMotionSystem.push_back(&mtm->GetMotionSystem());
@@ -174,16 +159,58 @@ void MBVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totalVertex
 				break;
 			}
 			default:
-				throw runtime_error("Unknown Mesh type in MBVHAccel::Init(): " + ToString(mesh->GetType()));
+				throw runtime_error("Unknown Mesh type in MBVHAccel::BuildLeafs(): " + ToString(mesh->GetType()));
+		}
+
+		// Check if a BVH has already been created
+		LeafIndexByMeshMap::const_iterator it = uniqueLeafIndexByMesh.find(leafMesh);
+		if (it != uniqueLeafIndexByMesh.end()) {
+			//LR_LOG(ctx, "Cached BVH leaf");
+			leafsIndex.push_back(it->second);
+			continue;
+		}
+
+		BVHAccel *leaf;
+		LeafIndexByMeshMap::const_iterator oldIt = oldLeafIndexByMesh.find(leafMesh);
+		if ((oldIt != oldLeafIndexByMesh.end()) && (editedMeshes.count(leafMesh) == 0)) {
+			// Reuse the BVH of the previous build
+			leaf = oldLeafs[oldIt->second];
+			oldLeafsReused[oldIt->second] = true;
+
+			if (deformedMeshes.count(leafMesh) > 0) {
+				leaf->Refit();
+				++refittedLeafsCount;
+			} else
+				++reusedLeafsCount;
+		} else {
+			// Create a new BVH
+			BVHAccel *newLeaf = new BVHAccel(ctx);
+			deque<const Mesh *> mlist(1, leafMesh);
+			newLeaf->Init(mlist, leafMesh->GetTotalVertexCount(), leafMesh->GetTotalTriangleCount());
+			leaf = newLeaf;
 		}
+
+		const u_int uniqueLeafIndex = uniqueLeafs.size();
+		uniqueLeafIndexByMesh[leafMesh] = uniqueLeafIndex;
+		uniqueLeafs.push_back(leaf);
+		leafsIndex.push_back(uniqueLeafIndex);
+	}
+
+	// Free the leafs not used anymore
+	for (u_int i = 0; i < oldLeafs.size(); ++i) {
+		if (!oldLeafsReused[i])
+			delete oldLeafs[i];
+	}
+
+	if (oldLeafs.size() > 0) {
+		LR_LOG(ctx, "MBVH reused leafs: " << reusedLeafsCount << "/" << uniqueLeafs.size() <<
+				" (refitted leafs: " << refittedLeafsCount << ")");
 	}
 
 	//--------------------------------------------------------------------------
-	// Build the root BVH
+	// Build the list of root BVH leafs
 	//--------------------------------------------------------------------------
 
-	LR_LOG(ctx, "Building Multilevel Bounding Volume Hierarchy root tree");
-
 	bvhLeafs.resize(nLeafs);
 	bvhLeafsList.resize(nLeafs, NULL);
 	for (u_int i = 0; i < nLeafs; ++i) {
@@ -198,19 +225,18 @@ void MBVHAccel::Init(const deque<const Mesh *> &ms, const u_longlong totalVertex
 		bvhLeaf->rightSibling = NULL;
 		bvhLeafsList[i] = bvhLeaf;
 	}
+}
 
-	bvhRootTree = NULL;
-	UpdateRootBVH();
-
-	LR_LOG(ctx, "MBVH build time: " << int((WallClockTime() - t0) * 1000) << "ms");
-
+void MBVHAccel::LogMemoryUsage() const {
 	size_t totalMem = nRootNodes;
 	BOOST_FOREACH(const BVHAccel *bvh, uniqueLeafs)
 		totalMem += bvh->nNodes;
 	totalMem *= sizeof(luxrays::ocl::BVHArrayNode);
+	BOOST_FOREACH(const BVHAccel *bvh, uniqueLeafs) {
+		if (bvh->wideTree)
+			totalMem += bvh->wideTree->GetMemoryUsage();
+	}
 	LR_LOG(ctx, "Total Multilevel BVH memory usage: " << totalMem / 1024 << "Kbytes");
-
-	initialized = true;
 }
 
 void MBVHAccel::UpdateRootBVH() {
@@ -238,6 +264,47 @@ void MBVHAccel::UpdateRootBVH() {
 		throw runtime_error("Unknown BVH builder type in MBVHAccel::UpdateRootBVH(): " + builderType);
 }
 
+void MBVHAccel::UpdateMeshes(const deque<const Mesh *> &ms, const u_longlong totalVertexCount,
+		const u_longlong totalTriangleCount, const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes) {
+	assert (initialized);
+
+	const double t0 = WallClockTime();
+
+	meshes = ms;
+
+	// Handle the empty DataSet case
+	if (totalTriangleCount == 0) {
+		LR_LOG(ctx, "Empty MBVH");
+
+		BOOST_FOREACH(const BVHAccel *bvh, uniqueLeafs)
+			delete bvh;
+		uniqueLeafs.clear();
+		uniqueLeafIndexByMesh.clear();
+		uniqueLeafsTransform.clear();
+		uniqueLeafsMotionSystem.clear();
+		bvhLeafs.clear();
+		bvhLeafsList.clear();
+
+		delete bvhRootTree;
+		bvhRootTree = NULL;
+		nRootNodes = 0;
+
+		return;
+	}
+
+	// Rebuild only the leafs of new or edited meshes and refit the leafs
+	// of deformed meshes
+	BuildLeafs(editedMeshes, deformedMeshes);
+
+	// Rebuild the root BVH tree
+	UpdateRootBVH();
+
+	LR_LOG(ctx, "MBVH update time: " << int((WallClockTime() - t0) * 1000) << "ms");
+
+	LogMemoryUsage();
+}
+
 void MBVHAccel::Update() {
 	// Update the BVH leaf bounding box
 	const u_int nLeafs = meshes.size();
@@ -322,26 +389,43 @@ bool MBVHAccel::Intersect(const Ray *ray, RayHit *rayHit) const {
 				++currentNode;
 			} else {
 				// I have to check a leaf tree
-				currentTree = uniqueLeafs[node.bvhLeaf.leafIndex]->bvhTree;
+				const BVHAccel *leafBVH = uniqueLeafs[node.bvhLeaf.leafIndex];
 
 				// Transform the ray in the local coordinate system
+				Ray localRay;
 				if (node.bvhLeaf.transformIndex != NULL_INDEX)
-					currentRay = Ray(Inverse(*uniqueLeafsTransform[node.bvhLeaf.transformIndex]) * (*ray));
+					localRay = Ray(Inverse(*uniqueLeafsTransform[node.bvhLeaf.transformIndex]) * (*ray));
 				else if (node.bvhLeaf.motionIndex != NULL_INDEX)
-					currentRay = Ray(uniqueLeafsMotionSystem[node.bvhLeaf.motionIndex]->Sample(ray->time) * (*ray));
+					localRay = Ray(uniqueLeafsMotionSystem[node.bvhLeaf.motionIndex]->Sample(ray->time) * (*ray));
 				else
-					currentRay = (*ray);
+					localRay = (*ray);
+
+				localRay.maxt = rayHit->t;
+
+				if (leafBVH->wideTree) {
+					// The leaf has a wide tree, I can check it in one go
+					// and stay in the root tree
+					RayHit leafHit;
+					if (leafBVH->wideTree->Intersect(localRay, &leafHit)) {
+						*rayHit = leafHit;
+						rayHit->meshIndex += node.bvhLeaf.meshOffsetIndex;
+						currentRay.maxt = leafHit.t;
+					}
 
-				currentRay.maxt = rayHit->t;
+					++currentNode;
+				} else {
+					currentTree = leafBVH->bvhTree;
+					currentRay = localRay;
 
-				currentMeshOffset = node.bvhLeaf.meshOffsetIndex;
+					currentMeshOffset = node.bvhLeaf.meshOffsetIndex;
 
-				currentRootNode = currentNode + 1;
-				currentNode = 0;
-				currentStopNode = BVHNodeData_GetSkipIndex(currentTree[0].nodeData);
+					currentRootNode = currentNode + 1;
+					currentNode = 0;
+					currentStopNode = BVHNodeData_GetSkipIndex(currentTree[0].nodeData);
 
-				// Now, I'm inside a leaf tree
-				insideLeafTree = true;
+					// Now, I'm inside a leaf tree
+					insideLeafTree = true;
+				}
 			}
 		} else {
 			// It is a node, check the bounding box
@@ -360,4 +444,213 @@ bool MBVHAccel::Intersect(const Ray *ray, RayHit *rayHit) const {
 	return !rayHit->Miss();
 }
 
+void MBVHAccel::IntersectLeafPacket(const luxrays::ocl::BVHArrayNode &leafNode,
+		const Ray *rays, RayHit *rayHits, const u_int rayCount) const {
+	const BVHAccel *leafBVH = uniqueLeafs[leafNode.bvhLeaf.leafIndex];
+	const luxrays::ocl::BVHArrayNode *leafTree = leafBVH->bvhTree;
+	const u_int meshOffset = leafNode.bvhLeaf.meshOffsetIndex;
+
+	// Transform the rays in the local coordinate system
+	BVHRayPacket packet;
+	packet.rayCount = rayCount;
+	if (leafNode.bvhLeaf.transformIndex != NULL_INDEX) {
+		// The inverse transformation is the same for all rays of the packet
+		const Transform invTrans = Inverse(*uniqueLeafsTransform[leafNode.bvhLeaf.transformIndex]);
+		for (u_int i = 0; i < rayCount; ++i)
+			packet.SetRay(i, Ray(invTrans * rays[i]));
+	} else if (leafNode.bvhLeaf.motionIndex != NULL_INDEX) {
+		const MotionSystem *ms = uniqueLeafsMotionSystem[leafNode.bvhLeaf.motionIndex];
+		for (u_int i = 0; i < rayCount; ++i)
+			packet.SetRay(i, Ray(ms->Sample(rays[i].time) * rays[i]));
+	} else {
+		for (u_int i = 0; i < rayCount; ++i)
+			packet.SetRay(i, rays[i]);
+	}
+
+	for (u_int i = 0; i < rayCount; ++i)
+		packet.rays[i].maxt = rayHits[i].t;
+
+	if (leafBVH->wideTree) {
+		// The SIMD tests of the wide tree are faster than the packet
+		// traversal of the binary tree
+		RayHit leafHit;
+		for (u_int i = 0; i < rayCount; ++i) {
+			if (leafBVH->wideTree->Intersect(packet.rays[i], &leafHit)) {
+				rayHits[i] = leafHit;
+				rayHits[i].meshIndex += meshOffset;
+			}
+		}
+
+		return;
+	}
+
+	u_int currentNode = 0;
+	const u_int stopNode = BVHNodeData_GetSkipIndex(leafTree[0].nodeData); // Non-existent
+
+	float t, b1, b2;
+	while (currentNode < stopNode) {
+		const luxrays::ocl::BVHArrayNode &node = leafTree[currentNode];
+
+		const u_int nodeData = node.nodeData;
+		if (BVHNodeData_IsLeaf(nodeData)) {
+			const u_int absoluteMeshIndex = node.triangleLeaf.meshIndex + meshOffset;
+			// I use GetVertices() in order to have access to not
+			// transformed vertices in the case of instances
+			const Point *vertices = meshes[absoluteMeshIndex]->GetVertices();
+			const Point &p0 = vertices[node.triangleLeaf.v[0]];
+			const Point &p1 = vertices[node.triangleLeaf.v[1]];
+			const Point &p2 = vertices[node.triangleLeaf.v[2]];
+
+			for (u_int i = 0; i < rayCount; ++i) {
+				Ray &ray = packet.rays[i];
+				if (Triangle::Intersect(ray, p0, p1, p2, &t, &b1, &b2)) {
+					if (t < rayHits[i].t) {
+						ray.maxt = t;
+						rayHits[i].t = t;
+						rayHits[i].b1 = b1;
+						rayHits[i].b2 = b2;
+						rayHits[i].meshIndex = absoluteMeshIndex;
+						rayHits[i].triangleIndex = node.triangleLeaf.triangleIndex;
+					}
+				}
+			}
+
+			++currentNode;
+		} else {
+			if (packet.IntersectP(&node.bvhNode.bboxMin[0], &node.bvhNode.bboxMax[0]))
+				++currentNode;
+			else
+				currentNode = nodeData;
+		}
+	}
+}
+
+void MBVHAccel::IntersectPacket(const Ray *rays, RayHit *rayHits, const u_int rayCount) const {
+	BVHRayPacket packet;
+	packet.Init(rays, rayCount);
+
+	for (u_int i = 0; i < rayCount; ++i) {
+		rayHits[i].t = rays[i].maxt;
+		rayHits[i].SetMiss();
+	}
+	if (!nRootNodes)
+		return;
+
+	u_int currentNode = 0;
+	const u_int stopNode = BVHNodeData_GetSkipIndex(bvhRootTree[0].nodeData); // Non-existent
+
+	while (currentNode < stopNode) {
+		const luxrays::ocl::BVHArrayNode &node = bvhRootTree[currentNode];
+
+		const u_int nodeData = node.nodeData;
+		if (BVHNodeData_IsLeaf(nodeData)) {
+			// I have to check a leaf tree with the whole packet
+			IntersectLeafPacket(node, rays, rayHits, rayCount);
+
+			// Shrink the root tree rays to the closest hits found so far
+			for (u_int i = 0; i < rayCount; ++i)
+				packet.rays[i].maxt = rayHits[i].t;
+
+			++currentNode;
+		} else {
+			if (packet.IntersectP(&node.bvhNode.bboxMin[0], &node.bvhNode.bboxMax[0]))
+				++currentNode;
+			else
+				currentNode = nodeData;
+		}
+	}
+}
+
+void MBVHAccel::IntersectBatch(const Ray *rays, RayHit *rayHits, const size_t rayCount) const {
+	assert (initialized);
+
+	for (size_t i = 0; i < rayCount; i += BVHACCEL_PACKET_SIZE) {
+		const u_int packetSize = (u_int)Min<size_t>(BVHACCEL_PACKET_SIZE, rayCount - i);
+		IntersectPacket(&rays[i], &rayHits[i], packetSize);
+	}
+}
+
+
+bool MBVHAccel::OccludedLeaf(const luxrays::ocl::BVHArrayNode &leafNode, const Ray &ray) const {
+	const BVHAccel *leafBVH = uniqueLeafs[leafNode.bvhLeaf.leafIndex];
+	const luxrays::ocl::BVHArrayNode *leafTree = leafBVH->bvhTree;
+	const u_int meshOffset = leafNode.bvhLeaf.meshOffsetIndex;
+
+	// Transform the ray in the local coordinate system
+	Ray localRay;
+	if (leafNode.bvhLeaf.transformIndex != NULL_INDEX)
+		localRay = Ray(Inverse(*uniqueLeafsTransform[leafNode.bvhLeaf.transformIndex]) * ray);
+	else if (leafNode.bvhLeaf.motionIndex != NULL_INDEX)
+		localRay = Ray(uniqueLeafsMotionSystem[leafNode.bvhLeaf.motionIndex]->Sample(ray.time) * ray);
+	else
+		localRay = ray;
+
+	if (leafBVH->wideTree)
+		return leafBVH->wideTree->Occluded(localRay);
+
+	u_int currentNode = 0;
+	const u_int stopNode = BVHNodeData_GetSkipIndex(leafTree[0].nodeData); // Non-existent
+
+	float t, b1, b2;
+	while (currentNode < stopNode) {
+		const luxrays::ocl::BVHArrayNode &node = leafTree[currentNode];
+
+		const u_int nodeData = node.nodeData;
+		if (BVHNodeData_IsLeaf(nodeData)) {
+			// I use GetVertices() in order to have access to not
+			// transformed vertices in the case of instances
+			const Point *vertices = meshes[node.triangleLeaf.meshIndex + meshOffset]->GetVertices();
+			const Point &p0 = vertices[node.triangleLeaf.v[0]];
+			const Point &p1 = vertices[node.triangleLeaf.v[1]];
+			const Point &p2 = vertices[node.triangleLeaf.v[2]];
+
+			// Any hit is good enough
+			if (Triangle::Intersect(localRay, p0, p1, p2, &t, &b1, &b2))
+				return true;
+
+			++currentNode;
+		} else {
+			if (BBox::IntersectP(localRay,
+					*reinterpret_cast<const Point *>(&node.bvhNode.bboxMin[0]),
+					*reinterpret_cast<const Point *>(&node.bvhNode.bboxMax[0])))
+				++currentNode;
+			else
+				currentNode = nodeData;
+		}
+	}
+
+	return false;
+}
+
+bool MBVHAccel::Occluded(const Ray *ray) const {
+	assert (initialized);
+
+	if (!nRootNodes)
+		return false;
+
+	u_int currentNode = 0;
+	const u_int stopNode = BVHNodeData_GetSkipIndex(bvhRootTree[0].nodeData); // Non-existent
+
+	while (currentNode < stopNode) {
+		const luxrays::ocl::BVHArrayNode &node = bvhRootTree[currentNode];
+
+		const u_int nodeData = node.nodeData;
+		if (BVHNodeData_IsLeaf(nodeData)) {
+			if (OccludedLeaf(node, *ray))
+				return true;
+
+			++currentNode;
+		} else {
+			if (BBox::IntersectP(*ray,
+					*reinterpret_cast<const Point *>(&node.bvhNode.bboxMin[0]),
+					*reinterpret_cast<const Point *>(&node.bvhNode.bboxMax[0])))
+				++currentNode;
+			else
+				currentNode = nodeData;
+		}
+	}
+
+	return false;
+}
+
 }
@@ -21,6 +21,20 @@
 using namespace std;
 using namespace luxrays;
 
+void Accelerator::IntersectBatch(const Ray *rays, RayHit *hits, const size_t rayCount) const {
+	for (size_t i = 0; i < rayCount; ++i) {
+		hits[i].SetMiss();
+		Intersect(&rays[i], &hits[i]);
+	}
+}
+
+bool Accelerator::Occluded(const Ray *ray) const {
+	RayHit hit;
+	hit.SetMiss();
+
+	return Intersect(ray, &hit);
+}
+
 string Accelerator::AcceleratorType2String(const AcceleratorType type) {
 	switch(type) {
 		case ACCEL_AUTO:
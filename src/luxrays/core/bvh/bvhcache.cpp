@@ -0,0 +1,241 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#include <cstring>
+#include <cstdio>
+
+#include <boost/foreach.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/filesystem.hpp>
+
+#include "luxrays/core/bvh/bvhcache.h"
+#include "luxrays/core/epsilon.h"
+
+using namespace std;
+
+namespace luxrays {
+
+#define BVHCACHE_MAGIC "LXBVH\0\0\0"
+#define BVHCACHE_VERSION 2u
+#define BVHCACHE_FILE_EXTENSION ".bvh"
+
+typedef struct {
+	char magic[8];
+	u_int version;
+	u_int nodeSize;
+	u_int nNodes;
+	// To align the nodes to 32 bytes
+	u_int pad[3];
+} BVHCacheHeader;
+
+BOOST_STATIC_ASSERT(sizeof(BVHCacheHeader) == 32);
+
+//------------------------------------------------------------------------------
+// A 128bit hash of the data used to build a tree. It is a MurmurHash3 like
+// function mixing 8 bytes at time.
+//------------------------------------------------------------------------------
+
+class BVHCacheHasher {
+public:
+	BVHCacheHasher() : h1(0x9368e53c2f6af274ull), h2(0x586dcd208f7cd3fdull) { }
+
+	void Add(const void *data, const size_t size) {
+		const u_char *bytes = (const u_char *)data;
+
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8) {
+			u_longlong k;
+			memcpy(&k, &bytes[i], 8);
+			Mix(k);
+		}
+
+		// The remaining bytes
+		if (i < size) {
+			u_longlong k = 0;
+			memcpy(&k, &bytes[i], size - i);
+			Mix(k);
+		}
+	}
+
+	template <class T> void Add(const T &value) {
+		Add(&value, sizeof(T));
+	}
+
+	string GetDigest() const {
+		char buf[33];
+		sprintf(buf, "%016llx%016llx", FMix(h1 ^ h2), FMix(h2 + h1));
+
+		return string(buf);
+	}
+
+private:
+	static u_longlong RotL(const u_longlong x, const int r) {
+		return (x << r) | (x >> (64 - r));
+	}
+
+	static u_longlong FMix(u_longlong k) {
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccdull;
+		k ^= k >> 33;
+		k *= 0xc4ceb9fe1a85ec53ull;
+		k ^= k >> 33;
+
+		return k;
+	}
+
+	void Mix(u_longlong k) {
+		static const u_longlong c1 = 0x87c37b91114253d5ull;
+		static const u_longlong c2 = 0x4cf5ad432745937full;
+
+		u_longlong k1 = k * c1;
+		k1 = RotL(k1, 31);
+		k1 *= c2;
+		h1 ^= k1;
+		h1 = RotL(h1, 27);
+		h1 += h2;
+		h1 = h1 * 5 + 0x52dce729;
+
+		u_longlong k2 = k * c2;
+		k2 = RotL(k2, 33);
+		k2 *= c1;
+		h2 ^= k2;
+		h2 = RotL(h2, 31);
+		h2 += h1;
+		h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	u_longlong h1, h2;
+};
+
+//------------------------------------------------------------------------------
+// BVHCache
+//------------------------------------------------------------------------------
+
+BVHCache::BVHCache(const string &dir) : cacheDir(dir) {
+}
+
+string BVHCache::GetKey(const BVHParams &params, const string &builderType,
+		const deque<const Mesh *> &meshes) {
+	BVHCacheHasher hasher;
+
+	// The build settings
+	hasher.Add(builderType.c_str(), builderType.length());
+	hasher.Add(params.treeType);
+	hasher.Add(params.costSamples);
+	hasher.Add(params.isectCost);
+	hasher.Add(params.traversalCost);
+	hasher.Add(params.emptyBonus);
+	// The leaf bounding boxes are expanded by the epsilon
+	hasher.Add(MachineEpsilon::GetMin());
+	hasher.Add(MachineEpsilon::GetMax());
+
+	// The meshes
+	hasher.Add((u_int)meshes.size());
+	BOOST_FOREACH(const Mesh *mesh, meshes) {
+		const u_int vertexCount = mesh->GetTotalVertexCount();
+		const u_int triangleCount = mesh->GetTotalTriangleCount();
+		hasher.Add(vertexCount);
+		hasher.Add(triangleCount);
+
+		// Vertices are read with GetVertex() because they are used in
+		// global coordinates by the BVH build
+		for (u_int i = 0; i < vertexCount; ++i) {
+			const Point p = mesh->GetVertex(0.f, i);
+			hasher.Add(&p, 3 * sizeof(float));
+		}
+
+		hasher.Add(mesh->GetTriangles(), triangleCount * sizeof(Triangle));
+	}
+
+	return hasher.GetDigest();
+}
+
+string BVHCache::GetFileName(const string &key) const {
+	return (boost::filesystem::path(cacheDir) / (key + BVHCACHE_FILE_EXTENSION)).generic_string();
+}
+
+luxrays::ocl::BVHArrayNode *BVHCache::Load(const string &key, u_int *nNodes,
+		boost::iostreams::mapped_file *mappedFile) const {
+	const string fileName = GetFileName(key);
+	if (!boost::filesystem::exists(fileName))
+		return NULL;
+
+	// A private (copy-on-write) mapping, so the tree can be still refitted
+	boost::iostreams::mapped_file_params params(fileName);
+	params.flags = boost::iostreams::mapped_file::priv;
+
+	try {
+		mappedFile->open(params);
+	} catch (std::exception &) {
+		return NULL;
+	}
+	if (!mappedFile->is_open())
+		return NULL;
+
+	// A wrong file is ignored and it will be overwritten with a new build
+	BVHCacheHeader header;
+	if (mappedFile->size() >= sizeof(BVHCacheHeader)) {
+		memcpy(&header, mappedFile->const_data(), sizeof(BVHCacheHeader));
+
+		if ((memcmp(header.magic, BVHCACHE_MAGIC, 8) == 0) &&
+				(header.version == BVHCACHE_VERSION) &&
+				(header.nodeSize == sizeof(luxrays::ocl::BVHArrayNode)) &&
+				(header.nNodes > 0) &&
+				(mappedFile->size() == sizeof(BVHCacheHeader) + header.nNodes * (size_t)header.nodeSize)) {
+			*nNodes = header.nNodes;
+
+			return (luxrays::ocl::BVHArrayNode *)(mappedFile->data() + sizeof(BVHCacheHeader));
+		}
+	}
+
+	mappedFile->close();
+
+	return NULL;
+}
+
+void BVHCache::Save(const string &key, const luxrays::ocl::BVHArrayNode *bvhTree,
+		const u_int nNodes) const {
+	boost::filesystem::create_directories(cacheDir);
+
+	BVHCacheHeader header;
+	memset(&header, 0, sizeof(BVHCacheHeader));
+	memcpy(header.magic, BVHCACHE_MAGIC, 8);
+	header.version = BVHCACHE_VERSION;
+	header.nodeSize = sizeof(luxrays::ocl::BVHArrayNode);
+	header.nNodes = nNodes;
+
+	const boost::filesystem::path tmpFileName = boost::filesystem::path(cacheDir) /
+			boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.tmp");
+
+	BOOST_OFSTREAM file(tmpFileName, ios::out | ios::binary | ios::trunc);
+	if (!file.is_open())
+		throw runtime_error("Unable to open BVH cache file: " + tmpFileName.generic_string());
+
+	file.write((const char *)&header, sizeof(BVHCacheHeader));
+	file.write((const char *)bvhTree, nNodes * sizeof(luxrays::ocl::BVHArrayNode));
+	file.close();
+
+	if (!file.good()) {
+		boost::filesystem::remove(tmpFileName);
+		throw runtime_error("Unable to write BVH cache file: " + tmpFileName.generic_string());
+	}
+
+	boost::filesystem::rename(tmpFileName, GetFileName(key));
+}
+
+}
@@ -0,0 +1,445 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#include <vector>
+#include <limits>
+#include <stdexcept>
+
+#include <xmmintrin.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include "luxrays/core/bvh/bvhwidetree.h"
+#include "luxrays/core/epsilon.h"
+#include "luxrays/core/geometry/triangle.h"
+#include "luxrays/utils/utils.h"
+
+using namespace std;
+
+namespace luxrays {
+
+// A child reference is the index of an inner node or, if the most significant
+// bit is set, the first triangle and the triangle count of a leaf
+#define BVHWIDETREE_EMPTY_CHILD 0xffffffffu
+#define BVHWideTree_IsLeaf(child) ((child) & 0x80000000u)
+#define BVHWideTree_MakeLeaf(first, count) (0x80000000u | ((first) << 3) | (count))
+#define BVHWideTree_GetLeafFirst(child) (((child) & 0x7fffffffu) >> 3)
+#define BVHWideTree_GetLeafCount(child) ((child) & 0x7u)
+// Max. number of triangles addressable with the above encoding
+#define BVHWIDETREE_MAX_TRIANGLE_COUNT (1u << 28)
+
+//------------------------------------------------------------------------------
+// Data types
+//------------------------------------------------------------------------------
+
+template<u_int WIDTH> struct BVHWideNode {
+	// Children bounding boxes in SoA form: bboxMin[axis][child]
+	float bboxMin[3][WIDTH];
+	float bboxMax[3][WIDTH];
+	u_int children[WIDTH];
+};
+
+struct BVHWideTriangle {
+	Point p0, p1, p2;
+	u_int meshIndex, triangleIndex;
+};
+
+// The ray data broadcasted in SIMD registers
+class BVHWideRay {
+public:
+	BVHWideRay(const Ray &ray) {
+		for (u_int i = 0; i < 3; ++i) {
+			org4[i] = _mm_set1_ps(ray.o[i]);
+			invDir4[i] = _mm_set1_ps(1.f / ray.d[i]);
+#if defined(__AVX__)
+			org8[i] = _mm256_set1_ps(ray.o[i]);
+			invDir8[i] = _mm256_set1_ps(1.f / ray.d[i]);
+#endif
+		}
+		mint4 = _mm_set1_ps(ray.mint);
+#if defined(__AVX__)
+		mint8 = _mm256_set1_ps(ray.mint);
+#endif
+	}
+
+	__m128 org4[3], invDir4[3], mint4;
+#if defined(__AVX__)
+	__m256 org8[3], invDir8[3], mint8;
+#endif
+};
+
+//------------------------------------------------------------------------------
+// Children bounding boxes test
+//
+// Return the bit mask of the children hit by the ray and store their entry
+// distances in tNear. The order of the min()/max() operands is chosen so a
+// NaN slab (i.e. 0 * inf) is ignored exactly like in BBox::IntersectP().
+//------------------------------------------------------------------------------
+
+template<u_int WIDTH> static inline u_int IntersectChildren(const BVHWideNode<WIDTH> &node,
+		const BVHWideRay &ray, const float maxt, float *tNear) {
+	const __m128 maxt4 = _mm_set1_ps(maxt);
+
+	u_int mask = 0;
+	for (u_int g = 0; g < WIDTH; g += 4) {
+		__m128 t0 = ray.mint4;
+		__m128 t1 = maxt4;
+		for (u_int i = 0; i < 3; ++i) {
+			const __m128 tA = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.bboxMin[i][g]), ray.org4[i]), ray.invDir4[i]);
+			const __m128 tB = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.bboxMax[i][g]), ray.org4[i]), ray.invDir4[i]);
+			t0 = _mm_max_ps(_mm_min_ps(tB, tA), t0);
+			t1 = _mm_min_ps(_mm_max_ps(tA, tB), t1);
+		}
+
+		_mm_storeu_ps(&tNear[g], t0);
+		mask |= ((u_int)_mm_movemask_ps(_mm_cmple_ps(t0, t1))) << g;
+	}
+
+	return mask;
+}
+
+#if defined(__AVX__)
+template<> inline u_int IntersectChildren<8>(const BVHWideNode<8> &node,
+		const BVHWideRay &ray, const float maxt, float *tNear) {
+	__m256 t0 = ray.mint8;
+	__m256 t1 = _mm256_set1_ps(maxt);
+	for (u_int i = 0; i < 3; ++i) {
+		const __m256 tA = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&node.bboxMin[i][0]), ray.org8[i]), ray.invDir8[i]);
+		const __m256 tB = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&node.bboxMax[i][0]), ray.org8[i]), ray.invDir8[i]);
+		t0 = _mm256_max_ps(_mm256_min_ps(tB, tA), t0);
+		t1 = _mm256_min_ps(_mm256_max_ps(tA, tB), t1);
+	}
+
+	_mm256_storeu_ps(tNear, t0);
+	return (u_int)_mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ));
+}
+#endif
+
+//------------------------------------------------------------------------------
+// BVHWideTreeImpl
+//------------------------------------------------------------------------------
+
+template<u_int WIDTH> class BVHWideTreeImpl : public BVHWideTree {
+public:
+	BVHWideTreeImpl() : root(BVHWIDETREE_EMPTY_CHILD), maxDepth(0), tooWide(false) { }
+	virtual ~BVHWideTreeImpl() { }
+
+	virtual u_int GetWidth() const { return WIDTH; }
+	virtual size_t GetMemoryUsage() const {
+		return nodes.size() * sizeof(BVHWideNode<WIDTH>) +
+				triangles.size() * sizeof(BVHWideTriangle);
+	}
+
+	bool BuildTree(const deque<const Mesh *> &meshes,
+			const luxrays::ocl::BVHArrayNode *bvhTree, const u_int nNodes) {
+		buildMeshes = &meshes;
+		buildTree = bvhTree;
+
+		// Count the triangles below each binary node: leafCount[i] is the
+		// number of triangle leaves before node i
+		leafCount.resize(nNodes + 1);
+		leafCount[0] = 0;
+		for (u_int i = 0; i < nNodes; ++i)
+			leafCount[i + 1] = leafCount[i] + (BVHNodeData_IsLeaf(bvhTree[i].nodeData) ? 1 : 0);
+
+		if (leafCount[nNodes] >= BVHWIDETREE_MAX_TRIANGLE_COUNT)
+			return false;
+		triangles.reserve(leafCount[nNodes]);
+
+		BBox bbox;
+		root = BuildChild(0, 1, &bbox);
+
+		vector<u_int>().swap(leafCount);
+
+		// Check if the traversal stack is large enough
+		return !tooWide && (maxDepth * (WIDTH - 1) + 1 <= BVHWIDETREE_STACK_SIZE);
+	}
+
+	virtual bool Intersect(const Ray &initialRay, RayHit *rayHit) const {
+		rayHit->t = initialRay.maxt;
+		rayHit->SetMiss();
+		if (root == BVHWIDETREE_EMPTY_CHILD)
+			return false;
+
+		Ray ray(initialRay);
+		const BVHWideRay wideRay(ray);
+
+		u_int stackNode[BVHWIDETREE_STACK_SIZE];
+		float stackNear[BVHWIDETREE_STACK_SIZE];
+		stackNode[0] = root;
+		stackNear[0] = ray.mint;
+		u_int stackSize = 1;
+
+		float t, b1, b2;
+		while (stackSize > 0) {
+			--stackSize;
+			// Skip the nodes farther than the closest hit found so far
+			if (stackNear[stackSize] > ray.maxt)
+				continue;
+
+			const u_int child = stackNode[stackSize];
+			if (BVHWideTree_IsLeaf(child)) {
+				const BVHWideTriangle *tri = &triangles[BVHWideTree_GetLeafFirst(child)];
+				const u_int count = BVHWideTree_GetLeafCount(child);
+
+				for (u_int i = 0; i < count; ++i, ++tri) {
+					if (Triangle::Intersect(ray, tri->p0, tri->p1, tri->p2, &t, &b1, &b2)) {
+						if (t < rayHit->t) {
+							ray.maxt = t;
+							rayHit->t = t;
+							rayHit->b1 = b1;
+							rayHit->b2 = b2;
+							rayHit->meshIndex = tri->meshIndex;
+							rayHit->triangleIndex = tri->triangleIndex;
+						}
+					}
+				}
+			} else {
+				const BVHWideNode<WIDTH> &node = nodes[child];
+
+				float tNear[WIDTH];
+				const u_int mask = IntersectChildren<WIDTH>(node, wideRay, ray.maxt, tNear);
+
+				// Push the hit children sorted from the farthest to the closest
+				// so the closest is visited first
+				const u_int stackBase = stackSize;
+				for (u_int i = 0; i < WIDTH; ++i) {
+					if ((mask & (1u << i)) && (node.children[i] != BVHWIDETREE_EMPTY_CHILD)) {
+						u_int j = stackSize++;
+						while ((j > stackBase) && (stackNear[j - 1] < tNear[i])) {
+							stackNode[j] = stackNode[j - 1];
+							stackNear[j] = stackNear[j - 1];
+							--j;
+						}
+						stackNode[j] = node.children[i];
+						stackNear[j] = tNear[i];
+					}
+				}
+			}
+		}
+
+		return !rayHit->Miss();
+	}
+
+	virtual bool Occluded(const Ray &ray) const {
+		if (root == BVHWIDETREE_EMPTY_CHILD)
+			return false;
+
+		const BVHWideRay wideRay(ray);
+
+		u_int stack[BVHWIDETREE_STACK_SIZE];
+		stack[0] = root;
+		u_int stackSize = 1;
+
+		float t, b1, b2;
+		while (stackSize > 0) {
+			const u_int child = stack[--stackSize];
+
+			if (BVHWideTree_IsLeaf(child)) {
+				const BVHWideTriangle *tri = &triangles[BVHWideTree_GetLeafFirst(child)];
+				const u_int count = BVHWideTree_GetLeafCount(child);
+
+				// Any hit is good enough
+				for (u_int i = 0; i < count; ++i, ++tri) {
+					if (Triangle::Intersect(ray, tri->p0, tri->p1, tri->p2, &t, &b1, &b2))
+						return true;
+				}
+			} else {
+				const BVHWideNode<WIDTH> &node = nodes[child];
+
+				float tNear[WIDTH];
+				const u_int mask = IntersectChildren<WIDTH>(node, wideRay, ray.maxt, tNear);
+
+				for (u_int i = 0; i < WIDTH; ++i) {
+					if ((mask & (1u << i)) && (node.children[i] != BVHWIDETREE_EMPTY_CHILD))
+						stack[stackSize++] = node.children[i];
+				}
+			}
+		}
+
+		return false;
+	}
+
+private:
+	u_int GetTriangleCount(const u_int index) const {
+		return leafCount[BVHNodeData_GetSkipIndex(buildTree[index].nodeData)] - leafCount[index];
+	}
+
+	bool IsWideLeaf(const u_int index) const {
+		return BVHNodeData_IsLeaf(buildTree[index].nodeData) ||
+				(GetTriangleCount(index) <= BVHWIDETREE_MAX_LEAF_SIZE);
+	}
+
+	void GetBinaryChildren(const u_int index, vector<u_int> &children) const {
+		// The children of an inner node are stored one after the other,
+		// each one at the skip index of the previous
+		const u_int stopNode = BVHNodeData_GetSkipIndex(buildTree[index].nodeData);
+		for (u_int i = index + 1; i < stopNode; i = BVHNodeData_GetSkipIndex(buildTree[i].nodeData))
+			children.push_back(i);
+	}
+
+	u_int BuildChild(const u_int index, const u_int depth, BBox *bbox) {
+		maxDepth = Max(maxDepth, depth);
+
+		if (IsWideLeaf(index))
+			return BuildLeaf(index, bbox);
+		else
+			return BuildNode(index, depth, bbox);
+	}
+
+	u_int BuildLeaf(const u_int index, BBox *bbox) {
+		// Gather the vertices of all triangles in the binary sub-tree
+		const u_int first = triangles.size();
+		const u_int stopNode = BVHNodeData_GetSkipIndex(buildTree[index].nodeData);
+		for (u_int i = index; i < stopNode; ++i) {
+			const luxrays::ocl::BVHArrayNode &node = buildTree[i];
+			if (!BVHNodeData_IsLeaf(node.nodeData))
+				continue;
+
+			const Mesh *mesh = (*buildMeshes)[node.triangleLeaf.meshIndex];
+
+			BVHWideTriangle tri;
+			tri.p0 = mesh->GetVertex(0.f, node.triangleLeaf.v[0]);
+			tri.p1 = mesh->GetVertex(0.f, node.triangleLeaf.v[1]);
+			tri.p2 = mesh->GetVertex(0.f, node.triangleLeaf.v[2]);
+			tri.meshIndex = node.triangleLeaf.meshIndex;
+			tri.triangleIndex = node.triangleLeaf.triangleIndex;
+			triangles.push_back(tri);
+
+			*bbox = Union(Union(Union(*bbox, tri.p0), tri.p1), tri.p2);
+		}
+		// NOTE - Ratow - Expand bbox a little to make sure rays collide
+		bbox->Expand(MachineEpsilon::E(*bbox));
+
+		return BVHWideTree_MakeLeaf(first, (u_int)triangles.size() - first);
+	}
+
+	u_int BuildNode(const u_int index, const u_int depth, BBox *bbox) {
+		// Collapse the binary tree: replace the child with the largest surface
+		// area by its own children until there is no more room
+		vector<u_int> children;
+		GetBinaryChildren(index, children);
+		if (children.size() > WIDTH) {
+			// The source tree has a larger arity than this one
+			tooWide = true;
+			children.resize(WIDTH);
+		}
+
+		vector<u_int> grandChildren;
+		while (children.size() < WIDTH) {
+			int bestChild = -1;
+			float bestArea = -1.f;
+			for (u_int i = 0; i < children.size(); ++i) {
+				if (IsWideLeaf(children[i]))
+					continue;
+
+				grandChildren.clear();
+				GetBinaryChildren(children[i], grandChildren);
+				if (children.size() - 1 + grandChildren.size() > WIDTH)
+					continue;
+
+				const luxrays::ocl::BVHArrayNode &node = buildTree[children[i]];
+				const BBox childBBox(*reinterpret_cast<const Point *>(&node.bvhNode.bboxMin[0]),
+						*reinterpret_cast<const Point *>(&node.bvhNode.bboxMax[0]));
+				const float area = childBBox.SurfaceArea();
+				if (area > bestArea) {
+					bestChild = i;
+					bestArea = area;
+				}
+			}
+
+			if (bestChild < 0)
+				break;
+
+			grandChildren.clear();
+			GetBinaryChildren(children[bestChild], grandChildren);
+			children.erase(children.begin() + bestChild);
+			children.insert(children.end(), grandChildren.begin(), grandChildren.end());
+		}
+
+		// I can not keep a reference to the node because nodes is resized
+		// by the recursive calls
+		const u_int nodeIndex = nodes.size();
+		nodes.resize(nodeIndex + 1);
+
+		for (u_int i = 0; i < WIDTH; ++i) {
+			BBox childBBox;
+			u_int child = BVHWIDETREE_EMPTY_CHILD;
+			if (i < children.size()) {
+				child = BuildChild(children[i], depth + 1, &childBBox);
+				*bbox = Union(*bbox, childBBox);
+			}
+
+			BVHWideNode<WIDTH> &node = nodes[nodeIndex];
+			node.children[i] = child;
+			for (u_int j = 0; j < 3; ++j) {
+				node.bboxMin[j][i] = childBBox.pMin[j];
+				node.bboxMax[j][i] = childBBox.pMax[j];
+			}
+		}
+
+		return nodeIndex;
+	}
+
+	vector<BVHWideNode<WIDTH> > nodes;
+	vector<BVHWideTriangle> triangles;
+	u_int root;
+
+	// Used only during the build
+	const deque<const Mesh *> *buildMeshes;
+	const luxrays::ocl::BVHArrayNode *buildTree;
+	vector<u_int> leafCount;
+	u_int maxDepth;
+	bool tooWide;
+};
+
+//------------------------------------------------------------------------------
+// BVHWideTree
+//------------------------------------------------------------------------------
+
+BVHWideTree *BVHWideTree::Build(const u_int width, const deque<const Mesh *> &meshes,
+		const luxrays::ocl::BVHArrayNode *bvhTree, const u_int nNodes) {
+	BVHWideTree *tree;
+	bool success;
+	switch (width) {
+		case 4: {
+			BVHWideTreeImpl<4> *tree4 = new BVHWideTreeImpl<4>();
+			success = tree4->BuildTree(meshes, bvhTree, nNodes);
+			tree = tree4;
+			break;
+		}
+		case 8: {
+			BVHWideTreeImpl<8> *tree8 = new BVHWideTreeImpl<8>();
+			success = tree8->BuildTree(meshes, bvhTree, nNodes);
+			tree = tree8;
+			break;
+		}
+		default:
+			throw runtime_error("Unsupported width in BVHWideTree::Build(): " + ToString(width));
+	}
+
+	if (!success) {
+		delete tree;
+		return NULL;
+	}
+
+	return tree;
+}
+
+}
@@ -26,6 +26,7 @@
 #include "luxrays/core/dataset.h"
 #include "luxrays/core/context.h"
 #include "luxrays/core/trianglemesh.h"
+#include "luxrays/core/extcurvemesh.h"
 #include "luxrays/accelerators/bvhaccel.h"
 #include "luxrays/accelerators/mbvhaccel.h"
 #include "luxrays/accelerators/embreeaccel.h"
@@ -46,6 +47,7 @@ DataSet::DataSet(const Context *luxRaysContext) {
 
 	totalVertexCount = 0;
 	totalTriangleCount = 0;
+	totalCurveSegmentCount = 0;
 
 	preprocessed = false;
 	hasInstances = false;
@@ -68,16 +70,31 @@ TriangleMeshID DataSet::Add(const Mesh *mesh) {
 
 	const TriangleMeshID id = meshes.size();
 	meshes.push_back(mesh);
+	AddMeshInfo(mesh);
 
+	return id;
+}
+
+// Returns the number of segments of the curves not yet tessellated
+static u_int GetCurveSegmentCount(const Mesh *mesh) {
+	const ExtCurveMesh *curveMesh = dynamic_cast<const ExtCurveMesh *>(mesh);
+
+	return (curveMesh && !curveMesh->IsTessellated()) ? curveMesh->GetCurveSegmentCount() : 0;
+}
+
+void DataSet::AddMeshInfo(const Mesh *mesh) {
 	totalVertexCount += mesh->GetTotalVertexCount();
 	totalTriangleCount += mesh->GetTotalTriangleCount();
 
-	if ((mesh->GetType() == TYPE_TRIANGLE_INSTANCE) || (mesh->GetType() == TYPE_EXT_TRIANGLE_INSTANCE))
+	if ((mesh->GetType() == TYPE_TRIANGLE_INSTANCE) || (mesh->GetType() == TYPE_EXT_TRIANGLE_INSTANCE)) {
 		hasInstances = true;
-	else if ((mesh->GetType() == TYPE_TRIANGLE_MOTION) || (mesh->GetType() == TYPE_EXT_TRIANGLE_MOTION))
-		hasMotionBlur = true;
 
-	return id;
+		const InstanceTriangleMesh *itm = dynamic_cast<const InstanceTriangleMesh *>(mesh);
+		totalCurveSegmentCount += GetCurveSegmentCount(itm->GetTriangleMesh());
+	} else if ((mesh->GetType() == TYPE_TRIANGLE_MOTION) || (mesh->GetType() == TYPE_EXT_TRIANGLE_MOTION))
+		hasMotionBlur = true;
+	else
+		totalCurveSegmentCount += GetCurveSegmentCount(mesh);
 }
 
 void DataSet::Preprocess() {
@@ -86,6 +103,7 @@ void DataSet::Preprocess() {
 	LR_LOG(context, "Preprocessing DataSet");
 	LR_LOG(context, "Total vertex count: " << totalVertexCount);
 	LR_LOG(context, "Total triangle count: " << totalTriangleCount);
+	LR_LOG(context, "Total curve segment count: " << totalCurveSegmentCount);
 
 	DataSet::UpdateBBoxes();
 
@@ -94,7 +112,8 @@ void DataSet::Preprocess() {
 }
 
 void DataSet::UpdateBBoxes() {
-	if (totalTriangleCount == 0) {
+	bbox = BBox();
+	if ((totalTriangleCount == 0) && (totalCurveSegmentCount == 0)) {
 		// Just initialize with some default value to avoid problems
 		bbox = Union(Union(bbox, Point(-1.f, -1.f, -1.f)), Point(1.f, 1.f, 1.f));
 	} else {
@@ -161,6 +180,43 @@ void DataSet::UpdateAccelerators() {
 	}
 }
 
+bool DataSet::DoesAllAcceleratorsSupportMeshesUpdate() const {
+	for (boost::unordered_map<AcceleratorType, Accelerator *>::const_iterator it = accels.begin(); it != accels.end(); ++it) {
+		if (!it->second->DoesSupportMeshesUpdate())
+			return false;
+	}
+
+	return true;
+}
+
+void DataSet::UpdateMeshes(const deque<const Mesh *> &newMeshes,
+		const boost::unordered_set<const Mesh *> &editedMeshes,
+		const boost::unordered_set<const Mesh *> &deformedMeshes) {
+	assert (preprocessed);
+
+	meshes = newMeshes;
+
+	totalVertexCount = 0;
+	totalTriangleCount = 0;
+	totalCurveSegmentCount = 0;
+	hasInstances = false;
+	hasMotionBlur = false;
+	BOOST_FOREACH(const Mesh *mesh, meshes)
+		AddMeshInfo(mesh);
+
+	LR_LOG(context, "Updating DataSet: " << editedMeshes.size() << " edited meshes, " <<
+			deformedMeshes.size() << " deformed meshes");
+	LR_LOG(context, "Total vertex count: " << totalVertexCount);
+	LR_LOG(context, "Total triangle count: " << totalTriangleCount);
+
+	UpdateBBoxes();
+
+	for (boost::unordered_map<AcceleratorType, Accelerator *>::const_iterator it = accels.begin(); it != accels.end(); ++it) {
+		assert(it->second->DoesSupportMeshesUpdate());
+		it->second->UpdateMeshes(meshes, totalVertexCount, totalTriangleCount, editedMeshes, deformedMeshes);
+	}
+}
+
 bool DataSet::IsEqual(const DataSet *dataSet) const {
 	return (dataSet != NULL) && (dataSetID == dataSet->dataSetID);
 }
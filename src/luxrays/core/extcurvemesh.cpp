@@ -0,0 +1,267 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#include <memory>
+
+#include "luxrays/core/extcurvemesh.h"
+
+using namespace std;
+using namespace luxrays;
+
+//------------------------------------------------------------------------------
+// ExtCurveMesh
+//------------------------------------------------------------------------------
+
+ExtCurveMesh::ExtCurveMesh(const u_int vertCount, const u_int segmentCount,
+		float *verts, u_int *segments, u_int *segPoints,
+		UV *uvs, Spectrum *cols, float *alphas) :
+		ExtTriangleMesh(0, 0, AllocVerticesBuffer(0), AllocTrianglesBuffer(0)) {
+	curveVertCount = vertCount;
+	curveSegmentCount = segmentCount;
+	curveVertices = verts;
+	curveSegments = segments;
+	segmentPoints = segPoints;
+	pointUVs = uvs;
+	pointCols = cols;
+	pointAlphas = alphas;
+
+	tessellated = false;
+}
+
+void ExtCurveMesh::Delete() {
+	ExtTriangleMesh::Delete();
+	DeleteCurves();
+}
+
+void ExtCurveMesh::DeleteCurves() {
+	delete[] curveVertices;
+	delete[] curveSegments;
+	delete[] segmentPoints;
+	delete[] pointUVs;
+	delete[] pointCols;
+	delete[] pointAlphas;
+
+	curveVertices = NULL;
+	curveSegments = NULL;
+	segmentPoints = NULL;
+	pointUVs = NULL;
+	pointCols = NULL;
+	pointAlphas = NULL;
+}
+
+void ExtCurveMesh::Tessellate() {
+	if (tessellated)
+		return;
+
+	// Free the empty triangle buffers
+	ExtTriangleMesh::Delete();
+
+	TessellateCurves(&vertCount, &triCount, &vertices, &tris, &normals, &uvs,
+			&cols, &alphas);
+	triNormals = new Normal[triCount];
+	Preprocess();
+	cachedBBoxValid = false;
+
+	// The curves are not used anymore
+	DeleteCurves();
+	curveVertCount = 0;
+	curveSegmentCount = 0;
+
+	tessellated = true;
+}
+
+BBox ExtCurveMesh::GetBBox() const {
+	if (tessellated)
+		return ExtTriangleMesh::GetBBox();
+
+	if (!cachedBBoxValid) {
+		// The curve is inside the convex hull of its control points
+		BBox bbox;
+		for (u_int i = 0; i < curveVertCount; ++i) {
+			const float *v = &curveVertices[i * 4];
+
+			BBox vertBBox(Point(v[0], v[1], v[2]));
+			vertBBox.Expand(v[3]);
+			bbox = Union(bbox, vertBBox);
+		}
+		cachedBBox = bbox;
+
+		cachedBBoxValid = true;
+	}
+
+	return cachedBBox;
+}
+
+void ExtCurveMesh::ApplyTransform(const Transform &trans) {
+	ExtTriangleMesh::ApplyTransform(trans);
+
+	if (!tessellated) {
+		// The radius is scaled by the average scale of the transformation
+		const float radiusScale = ((trans * Vector(1.f, 0.f, 0.f)).Length() +
+				(trans * Vector(0.f, 1.f, 0.f)).Length() +
+				(trans * Vector(0.f, 0.f, 1.f)).Length()) * (1.f / 3.f);
+
+		for (u_int i = 0; i < curveVertCount; ++i) {
+			float *v = &curveVertices[i * 4];
+
+			const Point p = trans * Point(v[0], v[1], v[2]);
+			v[0] = p.x;
+			v[1] = p.y;
+			v[2] = p.z;
+			v[3] *= radiusScale;
+		}
+
+		cachedBBoxValid = false;
+	}
+}
+
+ExtTriangleMesh *ExtCurveMesh::AllocTessellatedMesh() const {
+	u_int meshVertCount, meshTriCount;
+	Point *meshVerts;
+	Triangle *meshTris;
+	Normal *meshNorms;
+	UV *meshUVs;
+	Spectrum *meshCols;
+	float *meshAlphas;
+	TessellateCurves(&meshVertCount, &meshTriCount, &meshVerts, &meshTris,
+			&meshNorms, &meshUVs, &meshCols, &meshAlphas);
+
+	return new ExtTriangleMesh(meshVertCount, meshTriCount, meshVerts, meshTris,
+			meshNorms, meshUVs, meshCols, meshAlphas);
+}
+
+void ExtCurveMesh::WritePly(const string &fileName) const {
+	if (tessellated) {
+		ExtTriangleMesh::WritePly(fileName);
+		return;
+	}
+
+	// PLY files can store only triangles so write a temporary tessellation
+	auto_ptr<ExtTriangleMesh> mesh(AllocTessellatedMesh());
+	mesh->WritePly(fileName);
+	mesh->Delete();
+}
+
+void ExtCurveMesh::WriteBinary(const string &fileName) const {
+	if (tessellated) {
+		ExtTriangleMesh::WriteBinary(fileName);
+		return;
+	}
+
+	// Like PLY files, binary files can store only triangles
+	auto_ptr<ExtTriangleMesh> mesh(AllocTessellatedMesh());
+	mesh->WriteBinary(fileName);
+	mesh->Delete();
+}
+
+static void EvaluateBezier(const float *cp, const float u,
+		Point *p, Vector *dpdu, float *radius) {
+	const float *cp0 = &cp[0];
+	const float *cp1 = &cp[4];
+	const float *cp2 = &cp[8];
+	const float *cp3 = &cp[12];
+
+	const float u1 = 1.f - u;
+	const float b0 = u1 * u1 * u1;
+	const float b1 = 3.f * u1 * u1 * u;
+	const float b2 = 3.f * u1 * u * u;
+	const float b3 = u * u * u;
+
+	const float d0 = 3.f * u1 * u1;
+	const float d1 = 6.f * u1 * u;
+	const float d2 = 3.f * u * u;
+
+	*p = Point(
+			b0 * cp0[0] + b1 * cp1[0] + b2 * cp2[0] + b3 * cp3[0],
+			b0 * cp0[1] + b1 * cp1[1] + b2 * cp2[1] + b3 * cp3[1],
+			b0 * cp0[2] + b1 * cp1[2] + b2 * cp2[2] + b3 * cp3[2]);
+	*dpdu = Vector(
+			d0 * (cp1[0] - cp0[0]) + d1 * (cp2[0] - cp1[0]) + d2 * (cp3[0] - cp2[0]),
+			d0 * (cp1[1] - cp0[1]) + d1 * (cp2[1] - cp1[1]) + d2 * (cp3[1] - cp2[1]),
+			d0 * (cp1[2] - cp0[2]) + d1 * (cp2[2] - cp1[2]) + d2 * (cp3[2] - cp2[2]));
+	*radius = b0 * cp0[3] + b1 * cp1[3] + b2 * cp2[3] + b3 * cp3[3];
+}
+
+void ExtCurveMesh::GetCurveHitGeometry(const u_int segmentIndex, const float u,
+		const Point &hitPoint, const Point &rayStart, const Vector &rayDir,
+		Normal *geometryN, Normal *shadeN, Vector *dpdu, Vector *dpdv) const {
+	Point curvePoint;
+	Vector curveDir;
+	float radius;
+	EvaluateBezier(&curveVertices[curveSegments[segmentIndex] * 4], u,
+			&curvePoint, &curveDir, &radius);
+
+	// Build a frame with the curve direction and the direction facing the ray
+	Vector tangent, facing, side;
+	if (curveDir.LengthSquared() > 0.f)
+		tangent = Normalize(curveDir);
+	else
+		CoordinateSystem(-rayDir, &tangent, &side);
+
+	facing = -rayDir - Dot(-rayDir, tangent) * tangent;
+	if (facing.LengthSquared() > 0.f) {
+		facing = Normalize(facing);
+		side = Cross(tangent, facing);
+	} else
+		CoordinateSystem(tangent, &facing, &side);
+
+	// The ribbon goes through the curve axis so a ray starting inside the
+	// tube (i.e. a ray transmitted by the previous hit on the same curve) is
+	// leaving it: the outside of the tube is on the other side of the ribbon
+	const Vector startOffset = rayStart - curvePoint;
+	const Vector startRadial = startOffset - Dot(startOffset, tangent) * tangent;
+	if (startRadial.LengthSquared() < radius * radius) {
+		facing = -facing;
+		side = -side;
+	}
+
+	*geometryN = Normal(facing);
+
+	// The shading normal turns around the curve, across the ribbon width,
+	// like on the surface of a tube
+	const float s = (radius > 0.f) ?
+		Clamp(Dot(hitPoint - curvePoint, side) / radius, -1.f, 1.f) : 0.f;
+	*shadeN = Normal(Normalize(s * side + sqrtf(Max(0.f, 1.f - s * s)) * facing));
+
+	*dpdu = tangent;
+	*dpdv = Cross(Vector(*shadeN), tangent);
+}
+
+UV ExtCurveMesh::InterpolateCurveUV(const u_int segmentIndex, const float u) const {
+	if (pointUVs) {
+		const u_int index = segmentPoints[segmentIndex];
+		return (1.f - u) * pointUVs[index] + u * pointUVs[index + 1];
+	} else
+		return UV(0.f, 0.f);
+}
+
+Spectrum ExtCurveMesh::InterpolateCurveColor(const u_int segmentIndex, const float u) const {
+	if (pointCols) {
+		const u_int index = segmentPoints[segmentIndex];
+		return (1.f - u) * pointCols[index] + u * pointCols[index + 1];
+	} else
+		return Spectrum(1.f);
+}
+
+float ExtCurveMesh::InterpolateCurveAlpha(const u_int segmentIndex, const float u) const {
+	if (pointAlphas) {
+		const u_int index = segmentPoints[segmentIndex];
+		return (1.f - u) * pointAlphas[index] + u * pointAlphas[index + 1];
+	} else
+		return 1.f;
+}
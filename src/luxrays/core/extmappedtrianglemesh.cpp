@@ -0,0 +1,220 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#include <cstring>
+#include <fstream>
+
+#include "luxrays/core/extmappedtrianglemesh.h"
+
+using namespace std;
+using namespace luxrays;
+
+//------------------------------------------------------------------------------
+// ExtMappedTriangleMesh
+//------------------------------------------------------------------------------
+
+template<class T> static T *GetMappedArray(const boost::iostreams::mapped_file &file,
+		const u_longlong offset) {
+	return offset ? ((T *)(file.data() + offset)) : NULL;
+}
+
+ExtMappedTriangleMesh::ExtMappedTriangleMesh(const boost::iostreams::mapped_file &file,
+		const LxmHeader &header) :
+		ExtTriangleMesh(header.vertCount, header.triCount,
+			GetMappedArray<Point>(file, header.verticesOffset),
+			GetMappedArray<Triangle>(file, header.trisOffset),
+			GetMappedArray<Normal>(file, header.normalsOffset),
+			GetMappedArray<UV>(file, header.uvsOffset),
+			GetMappedArray<Spectrum>(file, header.colsOffset),
+			GetMappedArray<float>(file, header.alphasOffset)),
+		mappedFile(file) {
+}
+
+bool ExtMappedTriangleMesh::IsMapped(const void *p) const {
+	return (p >= mappedFile.const_data()) && (p < mappedFile.const_data() + mappedFile.size());
+}
+
+void ExtMappedTriangleMesh::Delete() {
+	if (!IsMapped(vertices))
+		delete[] vertices;
+	if (!IsMapped(tris))
+		delete[] tris;
+	if (!IsMapped(normals))
+		delete[] normals;
+	if (!IsMapped(triNormals))
+		delete[] triNormals;
+	if (!IsMapped(uvs))
+		delete[] uvs;
+	if (!IsMapped(cols))
+		delete[] cols;
+	if (!IsMapped(alphas))
+		delete[] alphas;
+
+	vertices = NULL;
+	tris = NULL;
+	normals = NULL;
+	triNormals = NULL;
+	uvs = NULL;
+	cols = NULL;
+	alphas = NULL;
+
+	mappedFile.close();
+}
+
+bool ExtMappedTriangleMesh::IsLxmFile(const string &fileName) {
+	BOOST_IFSTREAM file(fileName.c_str(), ios::in | ios::binary);
+	if (!file.is_open())
+		return false;
+
+	char magic[8];
+	file.read(magic, 8);
+
+	return file.good() && (memcmp(magic, LXM_MAGIC, 8) == 0);
+}
+
+// Checks if an array of count elements (plus extraSize bytes) is inside the
+// file. The values are read from the header of a file that can be corrupted
+// so the checks are written to avoid any overflow.
+static bool IsValidArray(const u_longlong fileSize, const u_longlong offset,
+		const u_longlong count, const u_longlong elementSize, const u_longlong extraSize,
+		const bool required) {
+	if (offset == 0)
+		return !required;
+
+	if ((offset % LXM_ALIGNMENT != 0) || (offset > fileSize))
+		return false;
+
+	const u_longlong availableSize = fileSize - offset;
+	return (extraSize <= availableSize) && (count <= (availableSize - extraSize) / elementSize);
+}
+
+ExtMappedTriangleMesh *ExtMappedTriangleMesh::Load(const string &fileName) {
+	// A private (copy-on-write) mapping, so the mesh can be still transformed
+	// in place
+	boost::iostreams::mapped_file_params params(fileName);
+	params.flags = boost::iostreams::mapped_file::priv;
+
+	boost::iostreams::mapped_file file;
+	try {
+		file.open(params);
+	} catch (std::exception &err) {
+		throw runtime_error("Unable to map LXM mesh file '" + fileName + "': " + err.what());
+	}
+	if (!file.is_open())
+		throw runtime_error("Unable to map LXM mesh file '" + fileName + "'");
+
+	if (file.size() < sizeof(LxmHeader))
+		throw runtime_error("Wrong LXM mesh file size: " + fileName);
+
+	LxmHeader header;
+	memcpy(&header, file.const_data(), sizeof(LxmHeader));
+	if (memcmp(header.magic, LXM_MAGIC, 8) != 0)
+		throw runtime_error("Not a LXM mesh file: " + fileName);
+	if (header.version != LXM_VERSION)
+		throw runtime_error("Unsupported LXM mesh file version " + boost::lexical_cast<string>(header.version) + ": " + fileName);
+	if (header.byteOrderMark != LXM_BYTE_ORDER_MARK)
+		throw runtime_error("LXM mesh file written with a different byte order: " + fileName);
+
+	const u_longlong fileSize = file.size();
+	const u_longlong vertCount = header.vertCount;
+	const u_longlong triCount = header.triCount;
+	if (!IsValidArray(fileSize, header.verticesOffset, vertCount, sizeof(Point), sizeof(float), true) ||
+			!IsValidArray(fileSize, header.trisOffset, triCount, sizeof(Triangle), 0, true) ||
+			!IsValidArray(fileSize, header.normalsOffset, vertCount, sizeof(Normal), 0, false) ||
+			!IsValidArray(fileSize, header.uvsOffset, vertCount, sizeof(UV), 0, false) ||
+			!IsValidArray(fileSize, header.colsOffset, vertCount, sizeof(Spectrum), 0, false) ||
+			!IsValidArray(fileSize, header.alphasOffset, vertCount, sizeof(float), 0, false))
+		throw runtime_error("Corrupted LXM mesh file: " + fileName);
+
+	// The triangle indices are used without any other check so they must be
+	// in range
+	const Triangle *tris = GetMappedArray<const Triangle>(file, header.trisOffset);
+	for (u_longlong i = 0; i < triCount; ++i) {
+		if ((tris[i].v[0] >= vertCount) || (tris[i].v[1] >= vertCount) || (tris[i].v[2] >= vertCount))
+			throw runtime_error("Out of range vertex index in triangle " + boost::lexical_cast<string>(i) +
+					" of LXM mesh file: " + fileName);
+	}
+
+	return new ExtMappedTriangleMesh(file, header);
+}
+
+// Writes an array of the file, aligned to LXM_ALIGNMENT bytes
+static void WriteArray(BOOST_OFSTREAM &file, const void *data, const u_longlong size) {
+	static const char padding[LXM_ALIGNMENT] = { 0 };
+
+	const u_longlong pos = file.tellp();
+	if (pos % LXM_ALIGNMENT)
+		file.write(padding, LXM_ALIGNMENT - pos % LXM_ALIGNMENT);
+
+	file.write((const char *)data, size);
+}
+
+static u_longlong GetArrayOffset(u_longlong *pos, const bool available, const u_longlong size) {
+	if (!available)
+		return 0;
+
+	const u_longlong offset = ((*pos + LXM_ALIGNMENT - 1) / LXM_ALIGNMENT) * LXM_ALIGNMENT;
+	*pos = offset + size;
+
+	return offset;
+}
+
+void ExtMappedTriangleMesh::Write(const string &fileName, const ExtTriangleMesh &mesh) {
+	const u_longlong vertCount = mesh.GetTotalVertexCount();
+	const u_longlong triCount = mesh.GetTotalTriangleCount();
+	const u_longlong verticesSize = vertCount * sizeof(Point);
+
+	LxmHeader header;
+	memset(&header, 0, sizeof(LxmHeader));
+	memcpy(header.magic, LXM_MAGIC, 8);
+	header.version = LXM_VERSION;
+	header.byteOrderMark = LXM_BYTE_ORDER_MARK;
+	header.vertCount = vertCount;
+	header.triCount = triCount;
+
+	u_longlong pos = sizeof(LxmHeader);
+	header.verticesOffset = GetArrayOffset(&pos, true, verticesSize + sizeof(float));
+	header.trisOffset = GetArrayOffset(&pos, true, triCount * sizeof(Triangle));
+	header.normalsOffset = GetArrayOffset(&pos, mesh.HasNormals(), vertCount * sizeof(Normal));
+	header.uvsOffset = GetArrayOffset(&pos, mesh.HasUVs(), vertCount * sizeof(UV));
+	header.colsOffset = GetArrayOffset(&pos, mesh.HasColors(), vertCount * sizeof(Spectrum));
+	header.alphasOffset = GetArrayOffset(&pos, mesh.HasAlphas(), vertCount * sizeof(float));
+
+	BOOST_OFSTREAM file(fileName.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!file.is_open())
+		throw runtime_error("Unable to open: " + fileName);
+
+	file.write((const char *)&header, sizeof(LxmHeader));
+
+	// The vertices include the padding float required by Embree
+	WriteArray(file, mesh.GetVertices(), verticesSize + sizeof(float));
+	WriteArray(file, mesh.GetTriangles(), triCount * sizeof(Triangle));
+	if (mesh.HasNormals())
+		WriteArray(file, mesh.GetNormals(), vertCount * sizeof(Normal));
+	if (mesh.HasUVs())
+		WriteArray(file, mesh.GetUVs(), vertCount * sizeof(UV));
+	if (mesh.HasColors())
+		WriteArray(file, mesh.GetCols(), vertCount * sizeof(Spectrum));
+	if (mesh.HasAlphas())
+		WriteArray(file, mesh.GetAlphas(), vertCount * sizeof(float));
+
+	if (!file.good())
+		throw runtime_error("Unable to write LXM mesh file: " + fileName);
+
+	file.close();
+}
@@ -21,8 +21,11 @@
 #include <cstring>
 
 #include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include "luxrays/core/exttrianglemesh.h"
+#include "luxrays/core/extmappedtrianglemesh.h"
 #include "luxrays/utils/ply/rply.h"
 
 using namespace std;
@@ -32,6 +35,15 @@ using namespace luxrays;
 // ExtMesh
 //------------------------------------------------------------------------------
 
+void ExtMesh::Save(const string &fileName) const {
+	const string ext = boost::filesystem::path(fileName).extension().generic_string();
+
+	if (boost::iequals(ext, LXM_FILE_EXTENSION))
+		WriteBinary(fileName);
+	else
+		WritePly(fileName);
+}
+
 void ExtMesh::GetDifferentials(const float time, const u_int triIndex, const Normal &shadeNormal,
         Vector *dpdu, Vector *dpdv,
         Normal *dndu, Normal *dndv) const {
@@ -272,6 +284,10 @@ static int FaceCB(p_ply_argument argument) {
 }
 
 ExtTriangleMesh *ExtTriangleMesh::LoadExtTriangleMesh(const string &fileName) {
+	// Binary meshes are memory mapped instead of parsed
+	if (ExtMappedTriangleMesh::IsLxmFile(fileName))
+		return ExtMappedTriangleMesh::Load(fileName);
+
 	p_ply plyfile = ply_open(fileName.c_str(), NULL);
 	if (!plyfile) {
 		stringstream ss;
@@ -525,6 +541,30 @@ void ExtTriangleMesh::WritePly(const string &fileName) const {
 	plyFile.close();
 }
 
+void ExtTriangleMesh::WriteBinary(const string &fileName) const {
+	ExtMappedTriangleMesh::Write(fileName, *this);
+}
+
+bool ExtTriangleMesh::HasSameTopology(const ExtTriangleMesh &mesh) const {
+	return (vertCount == mesh.vertCount) && (triCount == mesh.triCount) &&
+			(HasNormals() == mesh.HasNormals()) && (HasUVs() == mesh.HasUVs()) &&
+			(HasColors() == mesh.HasColors()) && (HasAlphas() == mesh.HasAlphas()) &&
+			((tris == mesh.tris) || !memcmp(tris, mesh.tris, triCount * sizeof(Triangle)));
+}
+
+void ExtTriangleMesh::SwapData(ExtTriangleMesh &mesh) {
+	std::swap(vertices, mesh.vertices);
+	std::swap(tris, mesh.tris);
+	std::swap(normals, mesh.normals);
+	std::swap(uvs, mesh.uvs);
+	std::swap(cols, mesh.cols);
+	std::swap(alphas, mesh.alphas);
+
+	// Update the triangle normals and the area
+	Preprocess();
+	mesh.Preprocess();
+}
+
 ExtTriangleMesh *ExtTriangleMesh::Copy(Point *meshVertices, Triangle *meshTris, Normal *meshNormals, UV *meshUV,
 			Spectrum *meshCols, float *meshAlpha) const {
 	Point *vs = meshVertices;
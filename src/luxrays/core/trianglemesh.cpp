@@ -31,8 +31,8 @@ using namespace luxrays;
 TriangleMesh::TriangleMesh(const u_int meshVertCount,
 		const u_int meshTriCount, Point *meshVertices,
 		Triangle *meshTris) {
-	assert (meshVertCount > 0);
-	assert (meshTriCount > 0);
+	// Note: curve meshes (see ExtCurveMesh) have no triangles until they
+	// are tessellated
 	assert (meshVertices != NULL);
 	assert (meshTris != NULL);
 
@@ -157,10 +157,7 @@ void NativeThreadIntersectionDevice::IntersectionThread(NativeThreadIntersection
 			const Ray *rb = rayBuffer->GetRayBuffer();
 			RayHit *hb = rayBuffer->GetHitBuffer();
 			const size_t rayCount = rayBuffer->GetRayCount();
-			for (unsigned int i = 0; i < rayCount; ++i) {
-				hb[i].SetMiss();
-				renderDevice->accel->Intersect(&rb[i], &hb[i]);
-			}
+			renderDevice->accel->IntersectBatch(rb, hb, rayCount);
 			renderDevice->threadTotalDataParallelRayCount[threadIndex] += rayCount;
 			queue->PushDone(rayBuffer);
 
@@ -17,6 +17,8 @@
  ***************************************************************************/
 
 #include <set>
+#include <deque>
+#include <cstring>
 #include <vector>
 #include <algorithm>
 #include <iostream>
@@ -31,6 +33,8 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/regex.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/archive/iterators/base64_from_binary.hpp>
 #include <boost/archive/iterators/binary_from_base64.hpp>
 #include <boost/archive/iterators/transform_width.hpp>
@@ -597,28 +601,31 @@ template<> Property &Property::Add<Matrix4x4>(const Matrix4x4 &m) {
 
 //------------------------------------------------------------------------------
 
-void Property::FromString(string &line) {
-	const size_t idx = line.find('=');
-	if (idx == string::npos)
-		throw runtime_error("Syntax error in property string: " + line);
+// The size of the text parsed (or of a value tokenized) by each thread
+#define PROPERTIES_PARSER_CHUNK_SIZE (1024 * 1024)
 
-	// Check if it is a valid name
-	name = line.substr(0, idx);
-	boost::trim(name);
+// The same characters removed by boost::trim()
+static inline bool IsSpace(const char c) {
+	return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') || (c == '\v') || (c == '\f');
+}
 
-	values.clear();
+static inline void Trim(const char *&begin, const char *&end) {
+	while ((begin < end) && IsSpace(*begin))
+		++begin;
+	while ((end > begin) && IsSpace(*(end - 1)))
+		--end;
+}
 
-	string value(line.substr(idx + 1));
-	// Check if the last char is a LF or a CR and remove that (in case of
-	// a DOS file read under Linux/MacOS)
-	if ((value.size() > 0) && ((value[value.size() - 1] == '\n') || (value[value.size() - 1] == '\r')))
-		value.resize(value.size() - 1);
-	boost::trim(value);
+// The characters separating the fields of a value
+static inline bool IsFieldSeparator(const char c) {
+	return (c == ' ') || (c == '\t');
+}
 
-	// Iterate over value and extract all field (handling quotes)
+// Iterates over value and extracts all fields (handling quotes)
+static void TokenizeFields(const string &name, const char *value, const unsigned int len,
+		PropertyValues &values) {
 	unsigned int first = 0;
 	unsigned int last = 0;
-	const unsigned int len = value.length();
 	while (first < len) {
 		// Check if it is a blob field
 		if ((first + 5 < len) && (value[first] == '{') && (value[first + 1] == '[')) {
@@ -628,8 +635,8 @@ void Property::FromString(string &line) {
 			while (last < len - 1) {
 				if ((value[last] == ']') || (value[last + 1] == '}')) {
 					const size_t size = last - first;
-					const Blob blob(value.substr(first, size).c_str(), size);
-					Add(blob);
+					const Blob blob(&value[first], size);
+					values.push_back(PropertyValue(blob));
 					found = true;
 					++last;
 
@@ -652,12 +659,14 @@ void Property::FromString(string &line) {
 			bool found = false;
 			while (last < len) {
 				if ((value[last] == '"') || (value[last] == '\'')) {
+					string s(&value[first], last - first);
 					// Replace any escaped " or '
-					string s = value.substr(first, last - first);
-					boost::replace_all(s,"\\\"", "\"");
-					boost::replace_all(s,"\\\'", "'");
+					if (s.find('\\') != string::npos) {
+						boost::replace_all(s,"\\\"", "\"");
+						boost::replace_all(s,"\\\'", "'");
+					}
 
-					Add(s);
+					values.push_back(PropertyValue(s));
 					found = true;
 					++last;
 
@@ -676,13 +685,11 @@ void Property::FromString(string &line) {
 			last = first;
 			while (last < len) {
 				if ((value[last] == ' ') || (value[last] == '\t') || (last == len - 1)) {
-					string field;
 					if (last == len - 1) {
-						field = value.substr(first, last - first + 1);
+						values.push_back(PropertyValue(string(&value[first], last - first + 1)));
 						++last;
 					} else
-						field = value.substr(first, last - first);
-					Add(field);
+						values.push_back(PropertyValue(string(&value[first], last - first)));
 
 					// Eat all additional spaces
 					while ((last < len) && ((value[last] == ' ') || (value[last] == '\t')))
@@ -698,6 +705,82 @@ void Property::FromString(string &line) {
 	}
 }
 
+void Property::FromString(string &line) {
+	FromString(line.data(), line.data() + line.size());
+}
+
+void Property::FromString(const char *line, const char *lineEnd) {
+	const char *idx = (const char *)memchr(line, '=', lineEnd - line);
+	if (!idx)
+		throw runtime_error("Syntax error in property string: " + string(line, lineEnd));
+
+	const char *nameBegin = line;
+	const char *nameEnd = idx;
+	Trim(nameBegin, nameEnd);
+	name.assign(nameBegin, nameEnd);
+
+	values.clear();
+
+	// Trim() removes the LF or the CR too (in case of a DOS file read under
+	// Linux/MacOS)
+	const char *valueBegin = idx + 1;
+	const char *valueEnd = lineEnd;
+	Trim(valueBegin, valueEnd);
+	const char *value = valueBegin;
+	const unsigned int len = valueEnd - valueBegin;
+
+	// A long list of plain fields (i.e. the inline vertices of a mesh) is split
+	// at field boundaries and the pieces are tokenized in parallel. Quoted and
+	// blob fields can include spaces so they are always tokenized serially.
+	static const char quoteOrBlobChars[] = { '"', '\'', '{' };
+	if ((len > PROPERTIES_PARSER_CHUNK_SIZE) &&
+			(find_first_of(value, valueEnd, quoteOrBlobChars, quoteOrBlobChars + 3) == valueEnd)) {
+		const unsigned int pieceCount = len / PROPERTIES_PARSER_CHUNK_SIZE;
+
+		vector<const char *> pieceBegins(pieceCount + 1);
+		pieceBegins[0] = value;
+		pieceBegins[pieceCount] = valueEnd;
+		for (unsigned int i = 1; i < pieceCount; ++i) {
+			// Move the begin of the piece to the begin of the next field
+			const char *p = Max(value + i * (size_t)PROPERTIES_PARSER_CHUNK_SIZE, pieceBegins[i - 1]);
+			while ((p < valueEnd) && !IsFieldSeparator(*p))
+				++p;
+			while ((p < valueEnd) && IsFieldSeparator(*p))
+				++p;
+
+			pieceBegins[i] = p;
+		}
+
+		vector<PropertyValues> pieceValues(pieceCount);
+		#pragma omp parallel for schedule(dynamic)
+		for (
+				// Visual C++ 2013 supports only OpenMP 2.5
+#if _OPENMP >= 200805
+				unsigned
+#endif
+				int i = 0; i < pieceCount; ++i) {
+			// Remove the separators before the next piece
+			const char *pieceEnd = pieceBegins[i + 1];
+			while ((pieceEnd > pieceBegins[i]) && IsFieldSeparator(*(pieceEnd - 1)))
+				--pieceEnd;
+
+			TokenizeFields(name, pieceBegins[i], pieceEnd - pieceBegins[i], pieceValues[i]);
+		}
+
+		size_t valueCount = 0;
+		for (unsigned int i = 0; i < pieceCount; ++i)
+			valueCount += pieceValues[i].size();
+
+		values.reserve(valueCount);
+		for (unsigned int i = 0; i < pieceCount; ++i) {
+			values.insert(values.end(), pieceValues[i].begin(), pieceValues[i].end());
+			// Free the memory as soon as possible
+			PropertyValues().swap(pieceValues[i]);
+		}
+	} else
+		TokenizeFields(name, value, len, values);
+}
+
 string Property::ToString() const {
 	stringstream ss;
 
@@ -756,10 +839,36 @@ string Property::ExtractPrefix(const string &name, const unsigned int count) {
 // Properties class
 //------------------------------------------------------------------------------
 
-Properties::Properties(const string &fileName) {
+Properties::Properties(const string &fileName) : nextInsertionIndex(0) {
 	SetFromFile(fileName);
 }
 
+void Properties::GetRange(const string &prefix, PropertiesMap::const_iterator &begin,
+		PropertiesMap::const_iterator &end) const {
+	// All names starting with the prefix are a contiguous range of the map
+	begin = props.lower_bound(prefix);
+
+	end = begin;
+	while ((end != props.end()) && (end->first.compare(0, prefix.length(), prefix) == 0))
+		++end;
+}
+
+vector<string> Properties::GetSortedNames(const PropertiesMap::const_iterator &begin,
+		const PropertiesMap::const_iterator &end) const {
+	// Sort the names by insertion order
+	vector<pair<unsigned long long, const string *> > sortedNames;
+	for (PropertiesMap::const_iterator it = begin; it != end; ++it)
+		sortedNames.push_back(make_pair(it->second.first, &(it->first)));
+	sort(sortedNames.begin(), sortedNames.end());
+
+	vector<string> result;
+	result.reserve(sortedNames.size());
+	for (size_t i = 0; i < sortedNames.size(); ++i)
+		result.push_back(*(sortedNames[i].second));
+
+	return result;
+}
+
 unsigned int Properties::GetSize() const {
 	return names.size();
 }
@@ -780,37 +889,168 @@ Properties &Properties::Set(const Properties &props, const string &prefix) {
 	return *this;	
 }
 
-Properties &Properties::SetFromStream(istream &stream) {
-	string line;
+//------------------------------------------------------------------------------
+// Properties parser
+//------------------------------------------------------------------------------
 
-	for (int lineNumber = 1;; ++lineNumber) {
-		if (stream.eof())
-			break;
+// The size of the blocks read from a stream
+#define PROPERTIES_STREAM_BLOCK_SIZE (16 * PROPERTIES_PARSER_CHUNK_SIZE)
 
-		getline(stream, line);
-		if (stream.bad())
-			throw runtime_error("Error while reading from a properties stream at line " + luxrays::ToString(lineNumber));
+namespace luxrays {
 
-		// Ignore comments
-		if (line[0] == '#')
-			continue;
+class PropertiesChunk {
+public:
+	PropertiesChunk() : begin(NULL), end(NULL), errorLine(0) { }
+
+	void Parse() {
+		try {
+			unsigned int lineNumber = 1;
+			for (const char *line = begin; line < end; ++lineNumber) {
+				const char *lineEnd = (const char *)memchr(line, '\n', end - line);
+				if (!lineEnd)
+					lineEnd = end;
+
+				// Ignore comments
+				if (*line != '#') {
+					const char *first = line;
+					const char *last = lineEnd;
+					Trim(first, last);
+
+					// Ignore empty lines
+					if (first < last) {
+						if (!memchr(first, '=', last - first)) {
+							errorLine = lineNumber;
+							return;
+						}
+
+						props.push_back(Property());
+						if (last - first > PROPERTIES_PARSER_CHUNK_SIZE) {
+							// Long lines are tokenized later, outside of the
+							// parallel loop, so their values can be split
+							// across all the threads
+							longLines.push_back(LongLine(props.size() - 1, first, last));
+						} else
+							props.back().FromString(first, last);
+					}
+				}
+
+				line = lineEnd + 1;
+			}
+		} catch (runtime_error &err) {
+			errorMsg = err.what();
+		}
+	}
 
-		boost::trim(line);
+	class LongLine {
+	public:
+		LongLine(const size_t i, const char *b, const char *e) : index(i), begin(b), end(e) { }
+
+		size_t index;
+		const char *begin, *end;
+	};
+
+	const char *begin, *end;
+	// A deque, instead of a vector, avoids to copy all Property when it grows
+	deque<Property> props;
+	// The lines not yet tokenized, the index is the one of the Property
+	vector<LongLine> longLines;
+
+	// A syntax error at the line (relative to the begin of the chunk) or
+	// the message of any other error
+	unsigned int errorLine;
+	string errorMsg;
+};
+
+}
+
+// Splits the text in chunks at line boundaries, parses them in parallel and
+// sets the results in the original order. firstLine is the number of lines
+// before the buffer and it is used only for the error messages. Returns the
+// number of lines in the buffer.
+static unsigned int SetFromBuffer(Properties &props, const char *buffer, const size_t size,
+		const unsigned int firstLine) {
+	const size_t chunkCount = Max<size_t>(size / PROPERTIES_PARSER_CHUNK_SIZE, 1);
+
+	vector<PropertiesChunk> chunks(chunkCount);
+	const char *bufferEnd = buffer + size;
+	const char *chunkBegin = buffer;
+	for (size_t i = 0; i < chunkCount; ++i) {
+		const char *chunkEnd = bufferEnd;
+		if (i < chunkCount - 1) {
+			// Move the end of the chunk after the end of the line
+			chunkEnd = Max(buffer + (i + 1) * PROPERTIES_PARSER_CHUNK_SIZE, chunkBegin);
+			const char *lineEnd = (const char *)memchr(chunkEnd, '\n', bufferEnd - chunkEnd);
+			chunkEnd = lineEnd ? (lineEnd + 1) : bufferEnd;
+		}
 
-		// Ignore empty lines
-		if (line.length() == 0)
-			continue;
+		chunks[i].begin = chunkBegin;
+		chunks[i].end = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
 
-		const size_t idx = line.find('=');
-		if (idx == string::npos)
-			throw runtime_error("Syntax error in a Properties at line " + luxrays::ToString(lineNumber));
+	#pragma omp parallel for schedule(dynamic)
+	for (
+			// Visual C++ 2013 supports only OpenMP 2.5
+#if _OPENMP >= 200805
+			unsigned
+#endif
+			int i = 0; i < chunkCount; ++i)
+		chunks[i].Parse();
+
+	unsigned int lineCount = 0;
+	for (size_t i = 0; i < chunkCount; ++i) {
+		PropertiesChunk &chunk = chunks[i];
+
+		if (chunk.errorLine > 0)
+			throw runtime_error("Syntax error in a Properties at line " + luxrays::ToString(firstLine + lineCount + chunk.errorLine));
+		if (chunk.errorMsg.length() > 0)
+			throw runtime_error(chunk.errorMsg);
+
+		// Each long line is tokenized in parallel
+		BOOST_FOREACH(const PropertiesChunk::LongLine &longLine, chunk.longLines)
+			chunk.props[longLine.index].FromString(longLine.begin, longLine.end);
+
+		BOOST_FOREACH(const Property &prop, chunk.props)
+			props.Set(prop);
+		// Free the memory as soon as possible
+		deque<Property>().swap(chunk.props);
+
+		lineCount += count(chunk.begin, chunk.end, '\n');
+	}
 
-		Property prop;
-		prop.FromString(line);
+	return lineCount;
+}
 
-		Set(prop);
+Properties &Properties::SetFromStream(istream &stream) {
+	// The stream is read and parsed in blocks of complete lines so only a
+	// block of text is in memory at a time
+	vector<char> buffer;
+	unsigned int lineCount = 0;
+	while (stream.good()) {
+		const size_t size = buffer.size();
+		buffer.resize(size + PROPERTIES_STREAM_BLOCK_SIZE);
+		stream.read(&buffer[size], PROPERTIES_STREAM_BLOCK_SIZE);
+		if (stream.bad())
+			throw runtime_error("Error while reading from a properties stream at line " + luxrays::ToString(lineCount + 1));
+		buffer.resize(size + stream.gcount());
+
+		if (stream.good()) {
+			// Parse only up to the last LF, the rest of the line is in the
+			// next block. The text left by the previous block has no LF.
+			const vector<char>::reverse_iterator lastLF = find(buffer.rbegin(), buffer.rend() - size, '\n');
+			if (lastLF == buffer.rend() - size)
+				continue;
+
+			const size_t parsedSize = buffer.rend() - lastLF;
+			lineCount += SetFromBuffer(*this, &buffer[0], parsedSize, lineCount);
+			buffer.erase(buffer.begin(), buffer.begin() + parsedSize);
+		}
 	}
 
+	// Parse the last line
+	if (buffer.size() > 0)
+		SetFromBuffer(*this, &buffer[0], buffer.size(), lineCount);
+
 	return *this;
 }
 
@@ -818,19 +1058,31 @@ Properties &Properties::SetFromFile(const string &fileName) {
 	BOOST_IFSTREAM file(fileName.c_str(), ios::in);
 	if (file.fail())
 		throw runtime_error("Unable to open properties file: " + fileName);
+	file.close();
 
-	return SetFromStream(file);
+	// Memory map the file so the text is never copied
+	if (boost::filesystem::file_size(fileName) > 0) {
+		boost::iostreams::mapped_file_source mappedFile(fileName);
+		if (!mappedFile.is_open())
+			throw runtime_error("Unable to map properties file: " + fileName);
+
+		SetFromBuffer(*this, mappedFile.data(), mappedFile.size(), 0);
+	}
+
+	return *this;
 }
 
 Properties &Properties::SetFromString(const string &propDefinitions) {
-	istringstream stream(propDefinitions);
+	SetFromBuffer(*this, propDefinitions.data(), propDefinitions.size(), 0);
 
-	return SetFromStream(stream);
+	return *this;
 }
 
 Properties &Properties::Clear() {
 	names.clear();
+	nameIndices.clear();
 	props.clear();
+	nextInsertionIndex = 0;
 
 	return *this;
 }
@@ -840,13 +1092,10 @@ const vector<string> &Properties::GetAllNames() const {
 }
 
 vector<string> Properties::GetAllNames(const string &prefix) const {
-	vector<string> namesSubset;
-	BOOST_FOREACH(const string &name, names) {
-		if (name.find(prefix) == 0)
-			namesSubset.push_back(name);
-	}
+	PropertiesMap::const_iterator begin, end;
+	GetRange(prefix, begin, end);
 
-	return namesSubset;
+	return GetSortedNames(begin, end);
 }
 
 vector<string> Properties::GetAllNamesRE(const string &regularExpression) const {
@@ -864,30 +1113,36 @@ vector<string> Properties::GetAllNamesRE(const string &regularExpression) const
 vector<string> Properties::GetAllUniqueSubNames(const string &prefix) const {
 	const size_t fieldsCount = count(prefix.begin(), prefix.end(), '.') + 2;
 
-	set<string> definedNames;
-	vector<string> namesSubset;
-	BOOST_FOREACH(const string &name, names) {
-		if (name.find(prefix) == 0) {
-			// Check if it has been already defined
+	PropertiesMap::const_iterator begin, end;
+	GetRange(prefix, begin, end);
 
-			const string s = Property::ExtractPrefix(name, fieldsCount);
-			if ((s.length() > 0) && (definedNames.count(s) == 0)) {
-				namesSubset.push_back(s);
-				definedNames.insert(s);
-			}
-		}
+	// The names with the same sub-name are contiguous in the map too so
+	// each sub-name is ordered by the first insertion of one of its names
+	vector<pair<unsigned long long, string> > subNames;
+	for (PropertiesMap::const_iterator it = begin; it != end; ++it) {
+		const string s = Property::ExtractPrefix(it->first, fieldsCount);
+		if (s.length() == 0)
+			continue;
+
+		if ((subNames.size() > 0) && (subNames.back().second == s))
+			subNames.back().first = Min(subNames.back().first, it->second.first);
+		else
+			subNames.push_back(make_pair(it->second.first, s));
 	}
+	sort(subNames.begin(), subNames.end());
+
+	vector<string> namesSubset;
+	namesSubset.reserve(subNames.size());
+	for (size_t i = 0; i < subNames.size(); ++i)
+		namesSubset.push_back(subNames[i].second);
 
 	return namesSubset;
 }
 
 bool Properties::HaveNames(const string &prefix) const {
-	BOOST_FOREACH(const string &name, names) {
-		if (name.find(prefix) == 0)
-			return true;
-	}
+	PropertiesMap::const_iterator it = props.lower_bound(prefix);
 
-	return false;
+	return (it != props.end()) && (it->first.compare(0, prefix.length(), prefix) == 0);
 }
 
 bool Properties::HaveNamesRE(const string &regularExpression) const {
@@ -903,10 +1158,8 @@ bool Properties::HaveNamesRE(const string &regularExpression) const {
 
 Properties Properties::GetAllProperties(const string &prefix) const {
 	Properties subset;
-	BOOST_FOREACH(const string &name, names) {
-		if (name.find(prefix) == 0)
-			subset.Set(Get(name));
-	}
+	BOOST_FOREACH(const string &name, GetAllNames(prefix))
+		subset.Set(Get(name));
 
 	return subset;
 }
@@ -916,39 +1169,82 @@ bool Properties::IsDefined(const string &propName) const {
 }
 
 const Property &Properties::Get(const string &propName) const {
-	std::map<string, Property>::const_iterator it = props.find(propName);
+	PropertiesMap::const_iterator it = props.find(propName);
 	if (it == props.end())
 		throw runtime_error("Undefined property in Properties::Get(): " + propName);
 
-	return it->second;
+	return it->second.second;
 }
 
 const Property &Properties::Get(const Property &prop) const {
-	std::map<string, Property>::const_iterator it = props.find(prop.GetName());
+	PropertiesMap::const_iterator it = props.find(prop.GetName());
 	if (it == props.end())
 		return prop;
 
-	return it->second;
+	return it->second.second;
 }
 
 void Properties::Delete(const string &propName) {
-	vector<string>::iterator it = find(names.begin(), names.end(), propName);
-	if (it != names.end())
-		names.erase(it);
+	PropertiesMap::iterator it = props.find(propName);
+	if (it == props.end())
+		return;
+
+	// nameIndices is sorted so a binary search can be used
+	const size_t pos = lower_bound(nameIndices.begin(), nameIndices.end(), it->second.first) -
+			nameIndices.begin();
+	names.erase(names.begin() + pos);
+	nameIndices.erase(nameIndices.begin() + pos);
 
-	props.erase(propName);
+	props.erase(it);
 }
 
 void Properties::DeleteAll(const vector<string> &propNames) {
-	BOOST_FOREACH(const string &n, propNames)
-		Delete(n);
+	if (propNames.size() < 2) {
+		BOOST_FOREACH(const string &n, propNames)
+			Delete(n);
+		return;
+	}
+
+	// Remove all the names from the map and than compact the vectors of names
+	// only once
+	vector<unsigned long long> deletedIndices;
+	BOOST_FOREACH(const string &n, propNames) {
+		PropertiesMap::iterator it = props.find(n);
+		if (it != props.end()) {
+			deletedIndices.push_back(it->second.first);
+			props.erase(it);
+		}
+	}
+
+	if (deletedIndices.size() == 0)
+		return;
+	sort(deletedIndices.begin(), deletedIndices.end());
+
+	size_t dst = lower_bound(nameIndices.begin(), nameIndices.end(), deletedIndices[0]) -
+			nameIndices.begin();
+	size_t deletedIndex = 0;
+	for (size_t src = dst; src < names.size(); ++src) {
+		if ((deletedIndex < deletedIndices.size()) && (nameIndices[src] == deletedIndices[deletedIndex])) {
+			// Skip the deleted name
+			++deletedIndex;
+			continue;
+		}
+
+		if (src != dst) {
+			names[dst].swap(names[src]);
+			nameIndices[dst] = nameIndices[src];
+		}
+		++dst;
+	}
+	names.resize(dst);
+	nameIndices.resize(dst);
 }
 
 string Properties::ToString() const {
 	stringstream ss;
 
 	for (vector<string>::const_iterator i = names.begin(); i != names.end(); ++i)
-		ss << props.at(*i).ToString() << "\n";
+		ss << Get(*i).ToString() << "\n";
 
 	return ss.str();
 }
@@ -956,15 +1252,18 @@ string Properties::ToString() const {
 Properties &Properties::Set(const Property &prop) {
 	const string &propName = prop.GetName();
 
-	if (!IsDefined(propName)) {
+	PropertiesMap::iterator it = props.lower_bound(propName);
+	if ((it == props.end()) || (it->first != propName)) {
 		// It is a new name
 		names.push_back(propName);
-	} else {
-		// boost::unordered_set::insert() doesn't overwrite an existing entry
-		props.erase(propName);
+		nameIndices.push_back(nextInsertionIndex);
+		it = props.insert(it, PropertiesMap::value_type(propName,
+				make_pair(nextInsertionIndex++, Property())));
 	}
 
-	props.insert(pair<string, Property>(propName, prop));
+	// Keep the original insertion order of an existing Property and copy
+	// the values only once
+	it->second.second = prop;
 
 	return *this;
 }
@@ -16,6 +16,7 @@
  * limitations under the License.                                          *
  ***************************************************************************/
 
+#include "luxrays/core/extcurvemesh.h"
 #include "slg/bsdf/bsdf.h"
 #include "slg/scene/scene.h"
 
@@ -24,12 +25,14 @@ using namespace slg;
 
 // Used when hitting a surface
 void BSDF::Init(const bool fixedFromLight, const Scene &scene, const Ray &ray,
-		const RayHit &rayHit, const float passThroughEvent, const PathVolumeInfo *volInfo) {
+		const RayHit &rayHit, const float passThroughEvent, const PathVolumeInfo *volInfo,
+		const float footprint) {
 	hitPoint.fromLight = fixedFromLight;
 	hitPoint.passThroughEvent = passThroughEvent;
 
 	hitPoint.p = ray(rayHit.t);
 	hitPoint.fixedDir = -ray.d;
+	hitPoint.footprint = footprint;
 
 	// Get the scene object
 	sceneObject = scene.objDefs.GetSceneObject(rayHit.meshIndex);
@@ -43,9 +46,48 @@ void BSDF::Init(const bool fixedFromLight, const Scene &scene, const Ray &ray,
 	// Get the material
 	material = sceneObject->GetMaterial();
 
-	// Interpolate face normal
-	hitPoint.geometryN = mesh->GetGeometryNormal(ray.time, rayHit.triangleIndex);
-	hitPoint.shadeN = mesh->InterpolateTriNormal(ray.time, rayHit.triangleIndex, rayHit.b1, rayHit.b2);
+	const ExtCurveMesh *curveMesh = mesh->GetCurveMesh();
+	if (curveMesh) {
+		// The hit is on a curve segment at the curve parameter b1
+		Transform local2World;
+		mesh->GetLocal2World(ray.time, local2World);
+		const Transform world2Local = Inverse(local2World);
+
+		// The normals are flipped if the ray segment starts inside the curve
+		Normal geometryN, shadeN;
+		Vector dpdu, dpdv;
+		curveMesh->GetCurveHitGeometry(rayHit.triangleIndex, rayHit.b1,
+				world2Local * hitPoint.p, world2Local * ray(ray.mint), world2Local * ray.d,
+				&geometryN, &shadeN, &dpdu, &dpdv);
+
+		hitPoint.geometryN = Normalize(local2World * geometryN);
+		hitPoint.shadeN = Normalize(local2World * shadeN);
+		hitPoint.dpdu = local2World * dpdu;
+		hitPoint.dpdv = local2World * dpdv;
+		hitPoint.dndu = hitPoint.dndv = Normal(0.f, 0.f, 0.f);
+
+		hitPoint.color = curveMesh->InterpolateCurveColor(rayHit.triangleIndex, rayHit.b1);
+		hitPoint.alpha = curveMesh->InterpolateCurveAlpha(rayHit.triangleIndex, rayHit.b1);
+		hitPoint.uv = curveMesh->InterpolateCurveUV(rayHit.triangleIndex, rayHit.b1);
+	} else {
+		// Interpolate face normal
+		hitPoint.geometryN = mesh->GetGeometryNormal(ray.time, rayHit.triangleIndex);
+		hitPoint.shadeN = mesh->InterpolateTriNormal(ray.time, rayHit.triangleIndex, rayHit.b1, rayHit.b2);
+
+		// Interpolate color
+		hitPoint.color = mesh->InterpolateTriColor(rayHit.triangleIndex, rayHit.b1, rayHit.b2);
+
+		// Interpolate alpha
+		hitPoint.alpha = mesh->InterpolateTriAlpha(rayHit.triangleIndex, rayHit.b1, rayHit.b2);
+
+		// Interpolate UV coordinates
+		hitPoint.uv = mesh->InterpolateTriUV(rayHit.triangleIndex, rayHit.b1, rayHit.b2);
+
+		// Compute geometry differentials
+		mesh->GetDifferentials(ray.time, rayHit.triangleIndex, hitPoint.shadeN,
+			&hitPoint.dpdu, &hitPoint.dpdv,
+			&hitPoint.dndu, &hitPoint.dndv);
+	}
 	hitPoint.intoObject = (Dot(ray.d, hitPoint.geometryN) < 0.f);
 
 	// Set interior and exterior volumes
@@ -54,26 +96,12 @@ void BSDF::Init(const bool fixedFromLight, const Scene &scene, const Ray &ray,
 			material->GetExteriorVolume(hitPoint, hitPoint.passThroughEvent),
 			scene.defaultWorldVolume);
 
-	// Interpolate color
-	hitPoint.color = mesh->InterpolateTriColor(rayHit.triangleIndex, rayHit.b1, rayHit.b2);
-
-	// Interpolate alpha
-	hitPoint.alpha = mesh->InterpolateTriAlpha(rayHit.triangleIndex, rayHit.b1, rayHit.b2);
-
 	// Check if it is a light source
 	if (material->IsLightSource())
 		triangleLightSource = scene.lightDefs.GetLightSourceByMeshIndex(rayHit.meshIndex);
 	else
 		triangleLightSource = NULL;
 
-	// Interpolate UV coordinates
-	hitPoint.uv = mesh->InterpolateTriUV(rayHit.triangleIndex, rayHit.b1, rayHit.b2);
-
-	// Compute geometry differentials
-	mesh->GetDifferentials(ray.time, rayHit.triangleIndex, hitPoint.shadeN,
-		&hitPoint.dpdu, &hitPoint.dpdv,
-		&hitPoint.dndu, &hitPoint.dndv);
-
 	// Apply bump or normal mapping
 	material->Bump(&hitPoint);
 
@@ -89,6 +117,7 @@ void BSDF::Init(const bool fixedFromLight, const Scene &scene, const luxrays::Ra
 
 	hitPoint.p = ray(t);
 	hitPoint.fixedDir = -ray.d;
+	hitPoint.footprint = 0.f;
 
 	sceneObject = NULL;
 	mesh = NULL;
@@ -118,6 +147,16 @@ u_int BSDF::GetObjectID() const {
 	return (sceneObject) ? sceneObject->GetID() : std::numeric_limits<u_int>::max();
 }
 
+Normal BSDF::GetLightSamplingNormal() const {
+	if (IsVolume() || (material->GetEventTypes() & TRANSMIT))
+		return Normal();
+
+	// Only the light arriving from the same side of the fixed direction can
+	// be reflected (see the side test in BSDF::Evaluate())
+	return (Dot(hitPoint.fixedDir, hitPoint.geometryN) > 0.f) ?
+		hitPoint.geometryN : -hitPoint.geometryN;
+}
+
 Spectrum BSDF::Evaluate(const Vector &generatedDir,
 		BSDFEvent *event, float *directPdfW, float *reversePdfW) const {
 	const Vector &eyeDir = hitPoint.fromLight ? generatedDir : hitPoint.fixedDir;
@@ -171,6 +171,11 @@ float EnvironmentCamera::GetPDF(const Vector &eyeDir, const float filmX, const f
 	return cameraPdfW;
 }
 
+void EnvironmentCamera::GetPixelFootprint(float *width, float *spread) const {
+	*width = 0.f;
+	*spread = 2.f * M_PI / filmWidth;
+}
+
 void EnvironmentCamera::InitCameraTransforms(CameraTransforms *trans) {
 	// This is a trick I use from LuxCoreRenderer to set cameraToWorld to
 	// identity matrix.
@@ -134,6 +134,12 @@ float OrthographicCamera::GetPDF(const Vector &eyeDir, const float filmX, const
 	return cameraPDF;
 }
 
+void OrthographicCamera::GetPixelFootprint(float *width, float *spread) const {
+	// The size of a pixel doesn't depend on the distance
+	*width = 1.f / sqrtf(cameraPDF);
+	*spread = 0.f;
+}
+
 Properties OrthographicCamera::ToProperties() const {
 	Properties props = ProjectiveCamera::ToProperties();
 
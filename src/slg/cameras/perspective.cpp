@@ -148,6 +148,12 @@ float PerspectiveCamera::GetPDF(const Vector &eyeDir, const float filmX, const f
 	return cameraPdfW;
 }
 
+void PerspectiveCamera::GetPixelFootprint(float *width, float *spread) const {
+	// pixelArea is the area of the whole screen window at distance 1
+	*width = 0.f;
+	*spread = sqrtf(pixelArea / (filmWidth * filmHeight));
+}
+
 Properties PerspectiveCamera::ToProperties() const {
 	Properties props = ProjectiveCamera::ToProperties();
 
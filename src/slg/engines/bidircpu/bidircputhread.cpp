@@ -90,11 +90,9 @@ void BiDirCPURenderThread::ConnectVertices(const float time,
 					p2pDistance,
 					time);
 			p2pRay.UpdateMinMaxWithEpsilon();
-			RayHit p2pRayHit;
-			BSDF bsdfConn;
 			Spectrum connectionThroughput;
 			PathVolumeInfo volInfo = eyeVertex.volInfo; // I need to use a copy here
-			if (!scene->Intersect(device, true, &volInfo, u0, &p2pRay, &p2pRayHit, &bsdfConn,
+			if (!scene->Occluded(device, true, &volInfo, u0, &p2pRay,
 					&connectionThroughput)) {
 				// Nothing was hit, the light path vertex is visible
 
@@ -161,12 +159,10 @@ void BiDirCPURenderThread::ConnectToEye(const float time,
 			Ray traceRay(lightVertex.bsdf.hitPoint.p, -eyeRay.d,
 					0.f, eyeRay.maxt);
 			traceRay.UpdateMinMaxWithEpsilon();
-			RayHit traceRayHit;
 
-			BSDF bsdfConn;
 			Spectrum connectionThroughput;
 			PathVolumeInfo volInfo = lightVertex.volInfo; // I need to use a copy here
-			if (!scene->Intersect(device, true, &volInfo, u0, &traceRay, &traceRayHit, &bsdfConn,
+			if (!scene->Occluded(device, true, &volInfo, u0, &traceRay,
 					&connectionThroughput)) {
 				// Nothing was hit, the light path vertex is visible
 
@@ -215,7 +211,8 @@ void BiDirCPURenderThread::DirectLightSampling(const float time,
 	if (!eyeVertex.bsdf.IsDelta()) {
 		// Pick a light source to sample
 		float lightPickPdf;
-		const LightSource *light = scene->lightDefs.GetIlluminateLightStrategy()->SampleLights(u0, &lightPickPdf);
+		const LightSource *light = scene->lightDefs.GetIlluminateLightStrategy()->SampleLights(u0,
+				eyeVertex.bsdf.hitPoint.p, eyeVertex.bsdf.GetLightSamplingNormal(), &lightPickPdf);
 
 		if (light) {
 			Vector lightRayDir;
@@ -235,12 +232,10 @@ void BiDirCPURenderThread::DirectLightSampling(const float time,
 							distance,
 							time);
 					shadowRay.UpdateMinMaxWithEpsilon();
-					RayHit shadowRayHit;
-					BSDF shadowBsdf;
 					Spectrum connectionThroughput;
 					PathVolumeInfo volInfo = eyeVertex.volInfo; // I need to use a copy here
 					// Check if the light source is visible
-					if (!scene->Intersect(device, false, &volInfo, u4, &shadowRay, &shadowRayHit, &shadowBsdf, &connectionThroughput)) {
+					if (!scene->Occluded(device, false, &volInfo, u4, &shadowRay, &connectionThroughput)) {
 						// I'm ignoring volume emission because it is not sampled in
 						// direct light step.
 
@@ -284,7 +279,8 @@ void BiDirCPURenderThread::DirectLightSampling(const float time,
 void BiDirCPURenderThread::DirectHitLight(
 		const LightSource *light, const Spectrum &lightRadiance,
 		const float directPdfA, const float emissionPdfW,
-		const PathVertexVM &eyeVertex, Spectrum *radiance) const {
+		const PathVertexVM &eyeVertex, const Point &lastHitPoint,
+		const Normal &lastLightSamplingN, Spectrum *radiance) const {
 	if (lightRadiance.Black())
 		return;
 
@@ -297,7 +293,8 @@ void BiDirCPURenderThread::DirectHitLight(
 	Scene *scene = engine->renderConfig->scene;
 
 	const float lightEmitPickPdf = scene->lightDefs.GetEmitLightStrategy()->SampleLightPdf(light);
-	const float lightIlluminatePickPdf = scene->lightDefs.GetIlluminateLightStrategy()->SampleLightPdf(light);
+	const float lightIlluminatePickPdf = scene->lightDefs.GetIlluminateLightStrategy()->SampleLightPdf(light,
+			lastHitPoint, lastLightSamplingN);
 
 	// MIS weight
 	const float weightCamera = MIS(directPdfA * lightIlluminatePickPdf) * eyeVertex.dVCM +
@@ -308,7 +305,8 @@ void BiDirCPURenderThread::DirectHitLight(
 }
 
 void BiDirCPURenderThread::DirectHitLight(const bool finiteLightSource,
-		const PathVertexVM &eyeVertex, SampleResult &eyeSampleResult) const {
+		const PathVertexVM &eyeVertex, const Point &lastHitPoint,
+		const Normal &lastLightSamplingN, SampleResult &eyeSampleResult) const {
 	BiDirCPURenderEngine *engine = (BiDirCPURenderEngine *)renderEngine;
 	Scene *scene = engine->renderConfig->scene;
 
@@ -316,11 +314,13 @@ void BiDirCPURenderThread::DirectHitLight(const bool finiteLightSource,
 	if (finiteLightSource) {
 		const Spectrum lightRadiance = eyeVertex.bsdf.GetEmittedRadiance(&directPdfA, &emissionPdfW);
 		DirectHitLight(eyeVertex.bsdf.GetLightSource(), lightRadiance, directPdfA, emissionPdfW,
-				eyeVertex, &eyeSampleResult.radiance[eyeVertex.bsdf.GetLightID()]);
+				eyeVertex, lastHitPoint, lastLightSamplingN,
+				&eyeSampleResult.radiance[eyeVertex.bsdf.GetLightID()]);
 	} else {
 		BOOST_FOREACH(EnvLightSource *el, scene->lightDefs.GetEnvLightSources()) {
 			const Spectrum lightRadiance = el->GetRadiance(*scene, eyeVertex.bsdf.hitPoint.fixedDir, &directPdfA, &emissionPdfW);
-			DirectHitLight(el, lightRadiance, directPdfA, emissionPdfW, eyeVertex, &eyeSampleResult.radiance[el->GetID()]);
+			DirectHitLight(el, lightRadiance, directPdfA, emissionPdfW, eyeVertex,
+					lastHitPoint, lastLightSamplingN, &eyeSampleResult.radiance[el->GetID()]);
 		}
 	}
 }
@@ -514,7 +514,10 @@ void BiDirCPURenderThread::RenderFunc() {
 	misVmWeightFactor = 0.f;
 	misVcWeightFactor = 0.f;
 
+	// The results are reused by all samples: one for each light path vertex
+	// connected to the camera and one for the eye path
 	vector<SampleResult> sampleResults;
+	sampleResults.reserve(engine->maxLightPathDepth + 1);
 	vector<PathVertexVM> lightPathVertices;
 	// I can not use engine->renderConfig->GetProperty() here because the
 	// RenderConfig properties cache is not thread safe
@@ -571,6 +574,12 @@ void BiDirCPURenderThread::RenderFunc() {
 		eyeVertex.dVC = 0.f;
 		eyeVertex.dVM = 0.f;
 
+		// The eye path vertex where the last direct light sampling was done
+		Point lastHitPoint;
+		Normal lastLightSamplingN;
+
+		PathFootprint eyePathFootprint(*camera);
+
 		eyeVertex.depth = 1;
 		while (eyeVertex.depth <= engine->maxEyePathDepth) {
 			eyeSampleResult.firstPathVertex = (eyeVertex.depth == 1);
@@ -586,7 +595,8 @@ void BiDirCPURenderThread::RenderFunc() {
 			const bool hit = scene->Intersect(device, false,
 					&eyeVertex.volInfo, sampler->GetSample(sampleOffset),
 					&eyeRay, &eyeRayHit, &eyeVertex.bsdf,
-					&connectionThroughput, &eyeVertex.throughput, &eyeSampleResult);
+					&connectionThroughput, &eyeVertex.throughput, &eyeSampleResult,
+					&eyePathFootprint);
 
 			if (!hit) {
 				// Nothing was hit, look for infinitelight
@@ -596,7 +606,7 @@ void BiDirCPURenderThread::RenderFunc() {
 				eyeVertex.bsdf.hitPoint.fixedDir = -eyeRay.d;
 				eyeVertex.throughput *= connectionThroughput;
 
-				DirectHitLight(false, eyeVertex, eyeSampleResult);
+				DirectHitLight(false, eyeVertex, lastHitPoint, lastLightSamplingN, eyeSampleResult);
 
 				if (eyeSampleResult.firstPathVertex) {
 					eyeSampleResult.alpha = 0.f;
@@ -620,7 +630,7 @@ void BiDirCPURenderThread::RenderFunc() {
 
 			// Check if it is a light source
 			if (eyeVertex.bsdf.IsLightSource()) {
-				DirectHitLight(true, eyeVertex, eyeSampleResult);
+				DirectHitLight(true, eyeVertex, lastHitPoint, lastLightSamplingN, eyeSampleResult);
 
 				// SLG light sources are like black bodies
 				break;
@@ -655,6 +665,13 @@ void BiDirCPURenderThread::RenderFunc() {
 			// Build the next vertex path ray
 			//------------------------------------------------------------------
 
+			lastHitPoint = eyeVertex.bsdf.hitPoint.p;
+			lastLightSamplingN = eyeVertex.bsdf.GetLightSamplingNormal();
+
+			// The sampled event is not available here so the footprint is reset
+			// if the material can have any specular bounce
+			eyePathFootprint.Bounce(eyeRayHit.t, eyeVertex.bsdf.GetEventTypes());
+
 			if (!Bounce(time, sampler, sampleOffset + 7, &eyeVertex, &eyeRay))
 				break;
 
@@ -155,6 +155,12 @@ void BiDirVMCPURenderThread::RenderFuncVM() {
 			eyeVertex.dVC = 1.f;
 			eyeVertex.dVM = 1.f;
 
+			// The eye path vertex where the last direct light sampling was done
+			Point lastHitPoint;
+			Normal lastLightSamplingN;
+
+			PathFootprint eyePathFootprint(*camera);
+
 			eyeVertex.depth = 1;
 			while (eyeVertex.depth <= engine->maxEyePathDepth) {
 				eyeSampleResult.firstPathVertex = (eyeVertex.depth == 1);
@@ -170,7 +176,8 @@ void BiDirVMCPURenderThread::RenderFuncVM() {
 				const bool hit = scene->Intersect(device, false,
 						&eyeVertex.volInfo, sampler->GetSample(sampleOffset),
 						&eyeRay, &eyeRayHit, &eyeVertex.bsdf,
-						&connectionThroughput, &eyeVertex.throughput, &eyeSampleResult);
+						&connectionThroughput, &eyeVertex.throughput, &eyeSampleResult,
+						&eyePathFootprint);
 
 				if (!hit) {
 					// Nothing was hit, look for infinitelight
@@ -180,7 +187,7 @@ void BiDirVMCPURenderThread::RenderFuncVM() {
 					eyeVertex.bsdf.hitPoint.fixedDir = -eyeRay.d;
 					eyeVertex.throughput *= connectionThroughput;
 
-					DirectHitLight(false, eyeVertex, eyeSampleResult);
+					DirectHitLight(false, eyeVertex, lastHitPoint, lastLightSamplingN, eyeSampleResult);
 
 					if (eyeSampleResult.firstPathVertex) {
 						eyeSampleResult.alpha = 0.f;
@@ -204,7 +211,7 @@ void BiDirVMCPURenderThread::RenderFuncVM() {
 
 				// Check if it is a light source
 				if (eyeVertex.bsdf.IsLightSource())
-					DirectHitLight(true, eyeVertex, eyeSampleResult);
+					DirectHitLight(true, eyeVertex, lastHitPoint, lastLightSamplingN, eyeSampleResult);
 
 				// Note: pass-through check is done inside Scene::Intersect()
 
@@ -243,6 +250,13 @@ void BiDirVMCPURenderThread::RenderFuncVM() {
 				// Build the next vertex path ray
 				//--------------------------------------------------------------
 
+				lastHitPoint = eyeVertex.bsdf.hitPoint.p;
+				lastLightSamplingN = eyeVertex.bsdf.GetLightSamplingNormal();
+
+				// The sampled event is not available here so the footprint is reset
+				// if the material can have any specular bounce
+				eyePathFootprint.Bounce(eyeRayHit.t, eyeVertex.bsdf.GetEventTypes());
+
 				if (!Bounce(time, sampler, sampleOffset + 7, &eyeVertex, &eyeRay))
 					break;
 			}
@@ -16,6 +16,7 @@
  * limitations under the License.                                          *
  ***************************************************************************/
 
+#include <xmmintrin.h>
 #include <boost/format.hpp>
 
 #include "slg/engines/bidirvmcpu/bidirvmcpu.h"
@@ -51,34 +52,51 @@ void HashGrid::Build(vector<vector<PathVertexVM> > &pathsVertices, const float r
 	const float cellSize = radius * 2.f;
 	invCellSize = 1.f / cellSize;
 
-	gridSize = vertexCount;	
-	cellEnds.resize(gridSize);
-	fill(cellEnds.begin(), cellEnds.end(), 0);
-	lightVertices.resize(gridSize, NULL);
+	gridSize = vertexCount;
 
+	// Note: the vectors are reused by all passes so they are not reallocated
+	// once they have reached their max. size
+
+	// Count the vertices of each cell
+	vertexCells.resize(vertexCount);
+	cellStarts.resize(gridSize + 1);
+	fill(cellStarts.begin(), cellStarts.end(), 0);
 	for (u_int i = 0, k = 0; i < pathsVertices.size(); ++i) {
 		for (u_int j = 0; j < pathsVertices[i].size(); ++j, ++k) {
-			const PathVertexVM *vertex = &pathsVertices[i][j];
+			const u_int cellIndex = Hash(pathsVertices[i][j].bsdf.hitPoint.p);
 
-			cellEnds[Hash(vertex->bsdf.hitPoint.p)]++;
+			vertexCells[k] = cellIndex;
+			cellStarts[cellIndex + 1]++;
 		}
 	}
 
-	int sum = 0;
-	for (u_int i = 0; i < cellEnds.size(); ++i) {
-		int temp = cellEnds[i];
-		cellEnds[i] = sum;
-		sum += temp;
-	}
-	
-	for (u_int i = 0; i < pathsVertices.size(); ++i) {
-		for (u_int j = 0; j < pathsVertices[i].size(); ++j) {
+	for (u_int i = 1; i <= gridSize; ++i)
+		cellStarts[i] += cellStarts[i - 1];
+
+	// Sort the vertices by cell
+	lightVertices.resize(vertexCount);
+	vertexX.resize(vertexCount);
+	vertexY.resize(vertexCount);
+	vertexZ.resize(vertexCount);
+
+	// cellStarts is used to track the next free slot of each cell and it
+	// is shifted by one cell at the end
+	for (u_int i = 0, k = 0; i < pathsVertices.size(); ++i) {
+		for (u_int j = 0; j < pathsVertices[i].size(); ++j, ++k) {
 			const PathVertexVM *vertex = &pathsVertices[i][j];
+			const Point &p = vertex->bsdf.hitPoint.p;
 
-			const int targetIdx = cellEnds[Hash(vertex->bsdf.hitPoint.p)]++;
-            lightVertices[targetIdx] = vertex;
+			const u_int targetIdx = cellStarts[vertexCells[k]]++;
+			lightVertices[targetIdx] = vertex;
+			vertexX[targetIdx] = p.x;
+			vertexY[targetIdx] = p.y;
+			vertexZ[targetIdx] = p.z;
 		}
 	}
+
+	for (u_int i = gridSize; i > 0; --i)
+		cellStarts[i] = cellStarts[i - 1];
+	cellStarts[0] = 0;
 }
 
 void HashGrid::Process(const BiDirVMCPURenderThread *thread,
@@ -101,84 +119,120 @@ void HashGrid::Process(const BiDirVMCPURenderThread *thread,
 	const int pyo = py + ((fractCoord.y < .5f) ? -1 : +1);
 	const int pzo = pz + ((fractCoord.z < .5f) ? -1 : +1);
 
-	int i0, i1;
-	HashRange(Hash(px, py, pz), &i0, &i1);
-	Process(thread, eyeVertex, i0, i1, radiance);
-	HashRange(Hash(px, py, pzo), &i0, &i1);
-	Process(thread, eyeVertex, i0, i1, radiance);
-	HashRange(Hash(px, pyo, pz), &i0, &i1);
-	Process(thread, eyeVertex, i0, i1, radiance);
-	HashRange(Hash(px, pyo, pzo), &i0, &i1);
-	Process(thread, eyeVertex, i0, i1, radiance);
-	HashRange(Hash(pxo, py, pz), &i0, &i1);
-	Process(thread, eyeVertex, i0, i1, radiance);
-	HashRange(Hash(pxo, py, pzo), &i0, &i1);
-	Process(thread, eyeVertex, i0, i1, radiance);
-	HashRange(Hash(pxo, pyo, pz), &i0, &i1);
-	Process(thread, eyeVertex, i0, i1, radiance);
-	HashRange(Hash(pxo, pyo, pzo), &i0, &i1);
-	Process(thread, eyeVertex, i0, i1, radiance);
+	const u_int cellIndices[8] = {
+		Hash(px, py, pz),
+		Hash(px, py, pzo),
+		Hash(px, pyo, pz),
+		Hash(px, pyo, pzo),
+		Hash(pxo, py, pz),
+		Hash(pxo, py, pzo),
+		Hash(pxo, pyo, pz),
+		Hash(pxo, pyo, pzo)
+	};
+
+	for (u_int i = 0; i < 8; ++i) {
+		// Different cells can have the same hash, each vertex has to be
+		// merged only once
+		bool processed = false;
+		for (u_int j = 0; j < i; ++j) {
+			if (cellIndices[j] == cellIndices[i]) {
+				processed = true;
+				break;
+			}
+		}
+
+		if (!processed)
+			Process(thread, eyeVertex, cellIndices[i], radiance);
+	}
 }
 
 void HashGrid::Process(const BiDirVMCPURenderThread *thread,
-		const PathVertexVM &eyeVertex, const int i0, const int i1,
+		const PathVertexVM &eyeVertex, const u_int cellIndex,
 		Spectrum *radiance) const {
-	for (int i = i0; i < i1; ++i) {
-		const PathVertexVM *lightVertex = lightVertices[i];
-		Process(thread, eyeVertex, lightVertex, radiance);
+	const u_int i0 = cellStarts[cellIndex];
+	const u_int i1 = cellStarts[cellIndex + 1];
+
+	const Point &p = eyeVertex.bsdf.hitPoint.p;
+	const __m128 px4 = _mm_set1_ps(p.x);
+	const __m128 py4 = _mm_set1_ps(p.y);
+	const __m128 pz4 = _mm_set1_ps(p.z);
+	const __m128 radius24 = _mm_set1_ps(radius2);
+
+	u_int i = i0;
+	for (; i + 4 <= i1; i += 4) {
+		const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&vertexX[i]), px4);
+		const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&vertexY[i]), py4);
+		const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&vertexZ[i]), pz4);
+		const __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+				_mm_mul_ps(dz, dz));
+
+		const u_int mask = (u_int)_mm_movemask_ps(_mm_cmple_ps(distance2, radius24));
+		if (mask) {
+			for (u_int j = 0; j < 4; ++j) {
+				if (mask & (1u << j))
+					Process(thread, eyeVertex, lightVertices[i + j], radiance);
+			}
+		}
+	}
+
+	// The remaining vertices
+	for (; i < i1; ++i) {
+		const float dx = vertexX[i] - p.x;
+		const float dy = vertexY[i] - p.y;
+		const float dz = vertexZ[i] - p.z;
+
+		if (dx * dx + dy * dy + dz * dz <= radius2)
+			Process(thread, eyeVertex, lightVertices[i], radiance);
 	}
 }
 
 void HashGrid::Process(const BiDirVMCPURenderThread *thread,
 		const PathVertexVM &eyeVertex, const PathVertexVM *lightVertex,
 		Spectrum *radiance) const {
-	const float distance2 = (lightVertex->bsdf.hitPoint.p - eyeVertex.bsdf.hitPoint.p).LengthSquared();
-
-	if (distance2 <= radius2) {
-		float eyeBsdfPdfW, eyeBsdfRevPdfW;
-		BSDFEvent eyeEvent;
-		// I need to remove the dotN term from the result (see below)
-		Spectrum eyeBsdfEval = eyeVertex.bsdf.Evaluate(lightVertex->bsdf.hitPoint.fixedDir,
-				&eyeEvent, &eyeBsdfPdfW, &eyeBsdfRevPdfW);
-		if(eyeBsdfEval.Black())
-			return;
-		
-		// Volume BSDF doesn't multiply BSDF::Evaluate() by dotN so I need
-		// to remove the term only if it isn't a Volume
-		if (!eyeVertex.bsdf.IsVolume())
-			eyeBsdfEval /= AbsDot(lightVertex->bsdf.hitPoint.fixedDir, eyeVertex.bsdf.hitPoint.geometryN);
-
-		BiDirVMCPURenderEngine *engine = (BiDirVMCPURenderEngine *)thread->renderEngine;
-		if (eyeVertex.depth >= engine->rrDepth) {
-			// Russian Roulette
-			const float prob = RenderEngine::RussianRouletteProb(eyeBsdfEval, engine->rrImportanceCap);
-			eyeBsdfPdfW *= prob;
-			eyeBsdfRevPdfW *= prob; // Note: SmallVCM uses light prob here
-		}
-
-		// MIS weights
-		const float weightLight = lightVertex->dVCM * thread->misVcWeightFactor +
-			lightVertex->dVM * BiDirVMCPURenderThread::MIS(eyeBsdfPdfW);
-		const float weightCamera = eyeVertex.dVCM * thread->misVcWeightFactor +
-			eyeVertex.dVM * BiDirVMCPURenderThread::MIS(eyeBsdfRevPdfW);
-		const float misWeight = 1.f / (weightLight + 1.f + weightCamera);
-
-		radiance[lightVertex->lightID] += (thread->vmNormalization * misWeight) *
-				eyeVertex.throughput * eyeBsdfEval * lightVertex->throughput;
-
-		// Statistics
-		/*if (eyeVertex.bsdf.IsVolume()) {
-			if (lightVertex->bsdf.IsVolume())
-				++mergeHitsV2V;
-			else
-				++mergeHitsV2S;
-		} else {
-			if (lightVertex->bsdf.IsVolume())
-				++mergeHitsV2S;
-			else
-				++mergeHitsS2S;			
-		}*/
+	// The distance has been already checked by the caller
+	float eyeBsdfPdfW, eyeBsdfRevPdfW;
+	BSDFEvent eyeEvent;
+	// I need to remove the dotN term from the result (see below)
+	Spectrum eyeBsdfEval = eyeVertex.bsdf.Evaluate(lightVertex->bsdf.hitPoint.fixedDir,
+			&eyeEvent, &eyeBsdfPdfW, &eyeBsdfRevPdfW);
+	if(eyeBsdfEval.Black())
+		return;
+	
+	// Volume BSDF doesn't multiply BSDF::Evaluate() by dotN so I need
+	// to remove the term only if it isn't a Volume
+	if (!eyeVertex.bsdf.IsVolume())
+		eyeBsdfEval /= AbsDot(lightVertex->bsdf.hitPoint.fixedDir, eyeVertex.bsdf.hitPoint.geometryN);
+
+	BiDirVMCPURenderEngine *engine = (BiDirVMCPURenderEngine *)thread->renderEngine;
+	if (eyeVertex.depth >= engine->rrDepth) {
+		// Russian Roulette
+		const float prob = RenderEngine::RussianRouletteProb(eyeBsdfEval, engine->rrImportanceCap);
+		eyeBsdfPdfW *= prob;
+		eyeBsdfRevPdfW *= prob; // Note: SmallVCM uses light prob here
 	}
+
+	// MIS weights
+	const float weightLight = lightVertex->dVCM * thread->misVcWeightFactor +
+		lightVertex->dVM * BiDirVMCPURenderThread::MIS(eyeBsdfPdfW);
+	const float weightCamera = eyeVertex.dVCM * thread->misVcWeightFactor +
+		eyeVertex.dVM * BiDirVMCPURenderThread::MIS(eyeBsdfRevPdfW);
+	const float misWeight = 1.f / (weightLight + 1.f + weightCamera);
+
+	radiance[lightVertex->lightID] += (thread->vmNormalization * misWeight) *
+			eyeVertex.throughput * eyeBsdfEval * lightVertex->throughput;
+
+	// Statistics
+	/*if (eyeVertex.bsdf.IsVolume()) {
+		if (lightVertex->bsdf.IsVolume())
+			++mergeHitsV2V;
+		else
+			++mergeHitsV2S;
+	} else {
+		if (lightVertex->bsdf.IsVolume())
+			++mergeHitsV2S;
+		else
+			++mergeHitsS2S;			
+	}*/
 }
 
 /*void HashGrid::PrintStatistics() const {
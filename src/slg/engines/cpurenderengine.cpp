@@ -203,21 +203,33 @@ const Properties &CPURenderEngine::GetDefaultProps() {
 CPUNoTileRenderThread::CPUNoTileRenderThread(CPUNoTileRenderEngine *engine,
 		const u_int index, IntersectionDevice *dev) : CPURenderThread(engine, index, dev) {
 	threadFilm = NULL;
+	useSharedFilm = false;
 }
 
 CPUNoTileRenderThread::~CPUNoTileRenderThread() {
-	delete threadFilm;
+	if (!useSharedFilm)
+		delete threadFilm;
 }
 
 void CPUNoTileRenderThread::StartRenderThread() {
 	CPUNoTileRenderEngine *cpuNoTileEngine = (CPUNoTileRenderEngine *)renderEngine;
 
+	if (!useSharedFilm)
+		delete threadFilm;
+
+	useSharedFilm = cpuNoTileEngine->useSharedFilm;
+	if (useSharedFilm) {
+		// The start film, if there is one, is already in the engine film
+		threadFilm = cpuNoTileEngine->film;
+
+		CPURenderThread::StartRenderThread();
+		return;
+	}
+
 	const u_int filmWidth = cpuNoTileEngine->film->GetWidth();
 	const u_int filmHeight = cpuNoTileEngine->film->GetHeight();
 	const u_int *filmSubRegion = cpuNoTileEngine->film->GetSubRegion();
 
-	delete threadFilm;
-
 	threadFilm = new Film(filmWidth, filmHeight, filmSubRegion);
 	threadFilm->CopyDynamicSettings(*(cpuNoTileEngine->film));
 	threadFilm->RemoveChannel(Film::IMAGEPIPELINE);
@@ -239,6 +251,7 @@ void CPUNoTileRenderThread::StartRenderThread() {
 CPUNoTileRenderEngine::CPUNoTileRenderEngine(const RenderConfig *cfg, Film *flm, boost::mutex *flmMutex) :
 	CPURenderEngine(cfg, flm, flmMutex) {
 	samplerSharedData = NULL;
+	useSharedFilm = false;
 	hasStartFilm = false;
 }
 
@@ -248,31 +261,63 @@ CPUNoTileRenderEngine::~CPUNoTileRenderEngine() {
 
 void CPUNoTileRenderEngine::StartLockLess() {
 	samplerSharedData = renderConfig->AllocSamplerSharedData(&seedBaseGenerator, film);
-	
+
+	useSharedFilm = IsSharedFilmSupported() &&
+			renderConfig->cfg.Get(GetDefaultProps().Get("native.film.shared.enable")).Get<bool>();
+	if (useSharedFilm) {
+		SLG_LOG("Render threads share the same film");
+
+		// Without a start film, the first merge of the thread films would
+		// clear the engine film
+		if (!hasStartFilm)
+			film->Reset();
+		film->SetThreadSafeAddSample(true);
+	}
+
 	CPURenderEngine::StartLockLess();
 }
 
 void CPUNoTileRenderEngine::StopLockLess() {
 	CPURenderEngine::StopLockLess();
 
+	if (useSharedFilm)
+		film->SetThreadSafeAddSample(false);
+
 	delete samplerSharedData;
 	samplerSharedData = NULL;
 }
 
+void CPUNoTileRenderEngine::EndSceneEditLockLess(const EditActionList &editActions) {
+	// The thread films are cleared when the threads are restarted, the
+	// shared one has to be cleared here
+	if (useSharedFilm)
+		film->Reset();
+
+	CPURenderEngine::EndSceneEditLockLess(editActions);
+}
+
 void CPUNoTileRenderEngine::UpdateFilmLockLess() {
 	boost::unique_lock<boost::mutex> lock(*filmMutex);
 
-	film->Reset();
+	if (useSharedFilm) {
+		// The samples are already in the film
+		film->FlushSampleCount();
+		return;
+	}
 
-	// Merge all thread films
+	// Merge all thread films, only the rows modified since the last update
+	// are merged again
+	vector<Film *> threadFilms;
 	for (size_t i = 0; i < renderThreads.size(); ++i) {
 		if (!renderThreads[i])
 			continue;
 
-		const Film *threadFilm = ((CPUNoTileRenderThread *)renderThreads[i])->threadFilm;
+		Film *threadFilm = ((CPUNoTileRenderThread *)renderThreads[i])->threadFilm;
 		if (threadFilm)
-			film->AddFilm(*threadFilm);
+			threadFilms.push_back(threadFilm);
 	}
+
+	film->MergeFilms(threadFilms);
 }
 
 void CPUNoTileRenderEngine::UpdateCounters() {
@@ -291,11 +336,14 @@ void CPUNoTileRenderEngine::UpdateCounters() {
 }
 
 Properties CPUNoTileRenderEngine::ToProperties(const Properties &cfg) {
-	return CPURenderEngine::ToProperties(cfg);
+	return CPURenderEngine::ToProperties(cfg) <<
+			cfg.Get(GetDefaultProps().Get("native.film.shared.enable"));
 }
 
 const Properties &CPUNoTileRenderEngine::GetDefaultProps() {
-	static Properties props;
+	static Properties props = Properties() <<
+			Property("native.film.shared.enable")(false);
+
 	return props;
 }
 
@@ -77,11 +77,9 @@ void LightCPURenderThread::ConnectToEye(const float u0, const LightSource &light
 			Ray traceRay(bsdf.hitPoint.p, -eyeRay.d,
 					0.f, eyeRay.maxt);
 			traceRay.UpdateMinMaxWithEpsilon();
-			RayHit traceRayHit;
 
-			BSDF bsdfConn;
 			Spectrum connectionThroughput;
-			if (!scene->Intersect(device, true, &volInfo, u0, &traceRay, &traceRayHit, &bsdfConn,
+			if (!scene->Occluded(device, true, &volInfo, u0, &traceRay,
 					&connectionThroughput)) {
 				// Nothing was hit, the light path vertex is visible
 
@@ -115,6 +113,7 @@ void LightCPURenderThread::TraceEyePath(const float time,
 		sampler->GetSample(10), sampler->GetSample(11), time);
 
 	Spectrum eyePathThroughput(1.f);
+	PathFootprint eyePathFootprint(*camera);
 	int depth = 1;
 	while (depth <= engine->maxPathDepth) {
 		sampleResult.firstPathVertex = (depth == 1);
@@ -128,7 +127,7 @@ void LightCPURenderThread::TraceEyePath(const float time,
 		const bool hit = scene->Intersect(device, false,
 				&volInfo, sampler->GetSample(sampleOffset),
 				&eyeRay, &eyeRayHit, &bsdf, &connectionThroughput,
-				&eyePathThroughput, &sampleResult);
+				&eyePathThroughput, &sampleResult, &eyePathFootprint);
 
 		if (!hit) {
 			// Nothing was hit, check infinite lights (including sun)
@@ -175,6 +174,7 @@ void LightCPURenderThread::TraceEyePath(const float time,
 				eyePathThroughput *= connectionThroughput * bsdfSample;
 				assert (!eyePathThroughput.IsNaN() && !eyePathThroughput.IsInf());
 
+				eyePathFootprint.Bounce(eyeRayHit.t, event);
 				eyeRay.Update(bsdf.hitPoint.p, sampledDir);
 			}
 
@@ -215,7 +215,10 @@ void LightCPURenderThread::RenderFunc() {
 	const u_int haltDebug = engine->renderConfig->cfg.Get(Property("batch.haltdebug")(0u)).Get<u_int>() *
 		film->GetWidth() * film->GetHeight();
 	
+	// The results are reused by all samples: one for each light path vertex
+	// connected to the camera and one for the eye path
 	vector<SampleResult> sampleResults;
+	sampleResults.reserve(engine->maxPathDepth + 1);
 	Spectrum lightPathFlux;
 	for(u_int steps = 0; !boost::this_thread::interruption_requested(); ++steps) {
 		// Check if we are in pause mode
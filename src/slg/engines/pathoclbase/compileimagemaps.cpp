@@ -71,6 +71,9 @@ void CompiledScene::CompileImageMaps() {
 		const ImageMap *im = ims[i];
 		slg::ocl::ImageMap *imd = &imageMapDescs[i];
 
+		if (im->IsTiled())
+			throw runtime_error("Tiled image maps are not supported by OpenCL render engines (disable images.cache.enable)");
+
 		const u_int pixelCount = im->GetWidth() * im->GetHeight();
 		const size_t memSize = RoundUp(im->GetStorage()->GetMemorySize(), sizeof(float));
 
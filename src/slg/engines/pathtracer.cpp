@@ -111,7 +111,8 @@ bool PathTracer::DirectLightSampling(
 		
 		// Pick a light source to sample
 		float lightPickPdf;
-		const LightSource *light = lightStrategy->SampleLights(u0, &lightPickPdf);
+		const LightSource *light = lightStrategy->SampleLights(u0,
+				bsdf.hitPoint.p, bsdf.GetLightSamplingNormal(), &lightPickPdf);
 
 		if (light) {
 			Vector lightRayDir;
@@ -136,12 +137,10 @@ bool PathTracer::DirectLightSampling(
 							distance,
 							time);
 					shadowRay.UpdateMinMaxWithEpsilon();
-					RayHit shadowRayHit;
-					BSDF shadowBsdf;
 					Spectrum connectionThroughput;
 					// Check if the light source is visible
-					if (!scene->Intersect(device, false, &volInfo, u4, &shadowRay,
-							&shadowRayHit, &shadowBsdf, &connectionThroughput)) {
+					if (!scene->Occluded(device, false, &volInfo, u4, &shadowRay,
+							&connectionThroughput)) {
 						// Add the light contribution only if it is not a shadow catcher
 						// (because, if the light is visible, the material will be
 						// transparent in the case of a shadow catcher).
@@ -193,14 +192,16 @@ bool PathTracer::DirectLightSampling(
 
 void PathTracer::DirectHitFiniteLight(const Scene *scene, const BSDFEvent lastBSDFEvent,
 		const Spectrum &pathThroughput, const float distance, const BSDF &bsdf,
-		const float lastPdfW, SampleResult *sampleResult) const {
+		const float lastPdfW, const Point &lastHitPoint, const Normal &lastLightSamplingN,
+		SampleResult *sampleResult) const {
 	float directPdfA;
 	const Spectrum emittedRadiance = bsdf.GetEmittedRadiance(&directPdfA);
 
 	if (!emittedRadiance.Black()) {
 		float weight;
 		if (!(lastBSDFEvent & SPECULAR)) {
-			const float lightPickProb = scene->lightDefs.GetIlluminateLightStrategy()->SampleLightPdf(bsdf.GetLightSource());
+			const float lightPickProb = scene->lightDefs.GetIlluminateLightStrategy()->SampleLightPdf(bsdf.GetLightSource(),
+					lastHitPoint, lastLightSamplingN);
 			const float directPdfW = PdfAtoW(directPdfA, distance,
 				AbsDot(bsdf.hitPoint.fixedDir, bsdf.hitPoint.shadeN));
 
@@ -282,9 +283,13 @@ void PathTracer::RenderSample(luxrays::IntersectionDevice *device, const Scene *
 
 	BSDFEvent lastBSDFEvent = SPECULAR; // SPECULAR is required to avoid MIS
 	float lastPdfW = 1.f;
+	// The path vertex where the last direct light sampling was done
+	Point lastHitPoint;
+	Normal lastLightSamplingN;
 	Spectrum pathThroughput(1.f);
 	PathVolumeInfo volInfo;
 	PathDepthInfo depthInfo;
+	PathFootprint pathFootprint(*scene->camera);
 	BSDF bsdf;
 	for (;;) {
 		sampleResult.firstPathVertex = (depthInfo.depth == 0);
@@ -295,7 +300,7 @@ void PathTracer::RenderSample(luxrays::IntersectionDevice *device, const Scene *
 		const bool hit = scene->Intersect(device, false,
 				&volInfo, sampler->GetSample(sampleOffset),
 				&eyeRay, &eyeRayHit, &bsdf, &connectionThroughput,
-				&pathThroughput, &sampleResult);
+				&pathThroughput, &sampleResult, &pathFootprint);
 		pathThroughput *= connectionThroughput;
 		// Note: pass-through check is done inside Scene::Intersect()
 
@@ -345,7 +350,7 @@ void PathTracer::RenderSample(luxrays::IntersectionDevice *device, const Scene *
 		// Check if it is a light source
 		if (bsdf.IsLightSource()) {
 			DirectHitFiniteLight(scene, lastBSDFEvent, pathThroughput, eyeRayHit.t,
-					bsdf, lastPdfW, &sampleResult);
+					bsdf, lastPdfW, lastHitPoint, lastLightSamplingN, &sampleResult);
 		}
 
 		//------------------------------------------------------------------
@@ -434,6 +439,11 @@ void PathTracer::RenderSample(luxrays::IntersectionDevice *device, const Scene *
 		// Increment path depth informations
 		depthInfo.IncDepths(lastBSDFEvent);
 
+		pathFootprint.Bounce(eyeRayHit.t, lastBSDFEvent);
+
+		lastHitPoint = bsdf.hitPoint.p;
+		lastLightSamplingN = bsdf.GetLightSamplingNormal();
+
 		eyeRay.Update(bsdf.hitPoint.p, sampledDir);
 	}
 
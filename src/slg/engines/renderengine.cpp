@@ -60,10 +60,19 @@ RenderEngine::RenderEngine(const RenderConfig *cfg, Film *flm, boost::mutex *flm
 
 	// Create LuxRays context
 	const Properties cfgProps = renderConfig->ToProperties();
+
+	// Strands are rendered as native curves only by Embree, OpenCL render
+	// engines need them tessellated
+	const RenderEngineType engineType = String2RenderEngineType(
+			cfgProps.Get("renderengine.type").Get<string>());
+	const bool enableCurves = cfgProps.Get("accelerator.curves.enable").Get<bool>() &&
+			(engineType != PATHOCL) && (engineType != RTPATHOCL) && (engineType != TILEPATHOCL);
+
 	ctx = new Context(LuxRays_DebugHandler ? LuxRays_DebugHandler : NullDebugHandler,
 			Properties() <<
 			cfgProps.Get("opencl.platform.index") <<
 			cfgProps.GetAllProperties("accelerator.") <<
+			Property("accelerator.curves.enable")(enableCurves) <<
 			cfgProps.GetAllProperties("context."));
 
 	// Force a complete preprocessing
@@ -110,6 +119,8 @@ void RenderEngine::Start() {
 	
 	// Only at this point I can safely trace the auto-focus ray
 	renderConfig->scene->camera->UpdateFocus(renderConfig->scene);
+	// And the env. light source visibility map rays
+	renderConfig->scene->UpdateEnvLightVisibilityMaps(film->GetWidth(), film->GetHeight());
 
 	StartLockLess();
 
@@ -188,6 +199,8 @@ void RenderEngine::EndSceneEdit(const EditActionList &editActions) {
 	// Only at this point I can safely trace the auto-focus ray
 	if (editActions.Has(CAMERA_EDIT))
 		renderConfig->scene->camera->UpdateFocus(renderConfig->scene);
+	// And the env. light source visibility map rays
+	renderConfig->scene->UpdateEnvLightVisibilityMaps(film->GetWidth(), film->GetHeight());
 
 	samplesCount = 0;
 	elapsedTime = 0.0f;
@@ -244,7 +257,8 @@ void RenderEngine::UpdateFilm() {
 		UpdateCounters();
 
 		const float haltthreshold = renderConfig->GetProperty("batch.haltthreshold").Get<float>();
-		if (haltthreshold >= 0.f) {
+		// The convergence test updates also the noise map used by adaptive samplers
+		if ((haltthreshold >= 0.f) || film->IsNoiseMapUpdate()) {
 			// Check if it is time to run the convergence test again
 			const u_int imgWidth = film->GetWidth();
 			const u_int imgHeight = film->GetHeight();
@@ -256,7 +270,9 @@ void RenderEngine::UpdateFilm() {
 
 			if ((samplesCount  - lastConvergenceTestSamplesCount > pixelCount * testStep) &&
 					((now - lastConvergenceTestTime) * 1000.0 >= renderConfig->GetProperty("screen.refresh.interval").Get<u_int>())) {
-				convergence = 1.f - film->RunConvergenceTest(haltthreshold) / (float)pixelCount;
+				const u_int todoPixelsCount = film->RunConvergenceTest(Max(haltthreshold, 0.f));
+				if (haltthreshold >= 0.f)
+					convergence = 1.f - todoPixelsCount / (float)pixelCount;
 				lastConvergenceTestTime = now;
 				lastConvergenceTestSamplesCount = samplesCount;
 			}
@@ -172,6 +172,7 @@ void RTPathOCLRenderThread::RenderThreadImpl() {
 
 		bool pendingFilmClear = false;
 		tile = NULL;
+		tileRound = 0;
 		while (!boost::this_thread::interruption_requested()) {
 			cl::CommandQueue &currentQueue = intersectionDevice->GetOpenCLQueue();
 
@@ -180,7 +181,7 @@ void RTPathOCLRenderThread::RenderThreadImpl() {
 			// in RTPATHOCL)
 			//------------------------------------------------------------------
 
-			engine->tileRepository->NextTile(engine->film, engine->filmMutex, &tile, threadFilms[0]->film);
+			engine->tileRepository->NextTile(engine->film, engine->filmMutex, &tile, &tileRound, threadFilms[0]->film, threadIndex);
 
 			// tile can be NULL after a scene edit
 			if (tile) {
@@ -226,7 +227,7 @@ void RTPathOCLRenderThread::RenderThreadImpl() {
 					RTPathOCLRenderThread *thread = (RTPathOCLRenderThread *)(engine->renderThreads[i]);
 
 					if (thread->tile) {
-						engine->tileRepository->NextTile(engine->film, engine->filmMutex, &thread->tile, thread->threadFilms[0]->film);
+						engine->tileRepository->MergeTile(engine->film, engine->filmMutex, thread->tile, thread->tileRound, thread->threadFilms[0]->film);
 
 						// There is only one tile for each device in RTPATHOCL
 						thread->tile = NULL;
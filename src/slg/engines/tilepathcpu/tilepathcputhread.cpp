@@ -72,8 +72,9 @@ void TilePathCPURenderThread::RenderFunc() {
 	//--------------------------------------------------------------------------
 
 	TileRepository::Tile *tile = NULL;
+	u_int tileRound = 0;
 	bool interruptionRequested = boost::this_thread::interruption_requested();
-	while (engine->tileRepository->NextTile(engine->film, engine->filmMutex, &tile, tileFilm) && !interruptionRequested) {
+	while (engine->tileRepository->NextTile(engine->film, engine->filmMutex, &tile, &tileRound, tileFilm, threadIndex) && !interruptionRequested) {
 		// Check if we are in pause mode
 		if (engine->pauseMode) {
 			// Check every 100ms if I have to continue the rendering
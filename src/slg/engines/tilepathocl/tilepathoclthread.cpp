@@ -128,6 +128,7 @@ void TilePathOCLRenderThread::RenderThreadImpl() {
 		//----------------------------------------------------------------------
 
 		vector<TileRepository::Tile *> tiles(1, NULL);
+		vector<u_int> tileRounds(1, 0);
 		while (!boost::this_thread::interruption_requested()) {
 			// Check if we are in pause mode
 			if (engine->pauseMode) {
@@ -145,7 +146,7 @@ void TilePathOCLRenderThread::RenderThreadImpl() {
 
 			bool allTileDone = true;
 			for (u_int i = 0; i < tiles.size(); ++i) {
-				if (engine->tileRepository->NextTile(engine->film, engine->filmMutex, &tiles[i], threadFilms[i]->film)) {
+				if (engine->tileRepository->NextTile(engine->film, engine->filmMutex, &tiles[i], &tileRounds[i], threadFilms[i]->film, threadIndex)) {
 					//const u_int tileW = Min(engine->tileRepository->tileWidth, engine->film->GetWidth() - tiles[i]->xStart);
 					//const u_int tileH = Min(engine->tileRepository->tileHeight, engine->film->GetHeight() - tiles[i]->yStart);
 					//SLG_LOG("[TilePathOCLRenderThread::" << threadIndex << "] Tile: "
@@ -183,6 +184,7 @@ void TilePathOCLRenderThread::RenderThreadImpl() {
 					(intersectionDevice->GetDeviceDesc()->GetType() != DEVICE_TYPE_OPENCL_CPU)) {
 				IncThreadFilms();
 				tiles.push_back(NULL);
+				tileRounds.push_back(0);
 
 				SLG_LOG("[TilePathOCLRenderThread::" << threadIndex << "] Increased the number of rendered tiles to: " << tiles.size());
 			}
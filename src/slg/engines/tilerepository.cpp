@@ -17,7 +17,9 @@
  ***************************************************************************/
 
 #include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
 
+#include "luxrays/utils/atomic.h"
 #include "slg/engines/tilerepository.h"
 #include "slg/film/imagepipeline/plugins/gammacorrection.h"
 #include "slg/film/imagepipeline/plugins/tonemaps/linear.h"
@@ -37,7 +39,8 @@ TileRepository::Tile::Tile(TileRepository *repo, const Film &film, const u_int t
 			tileRepository(repo),
 			xStart(tileX), yStart(tileY), pass(0), error(numeric_limits<float>::infinity()),
 			done(false), allPassFilm(NULL), evenPassFilm(NULL),
-			allPassFilmTotalYValue(0.f), hasEnoughWarmUpSample(false) {
+			allPassFilmTotalYValue(0.f), hasEnoughWarmUpSample(false),
+			renderingCount(0), scheduledRound(0), completedRound(0) {
 	const u_int *filmSubRegion = film.GetSubRegion();
 
 	tileWidth = Min(xStart + tileRepository->tileWidth, filmSubRegion[1] + 1) - xStart;
@@ -54,7 +57,7 @@ TileRepository::Tile::Tile(TileRepository *repo, const Film &film, const u_int t
 		InitTileFilm(film, &evenPassFilm);
 }
 
-TileRepository::Tile::Tile() {
+TileRepository::Tile::Tile() : renderingCount(0), scheduledRound(0), completedRound(0) {
 }
 
 TileRepository::Tile::~Tile() {
@@ -186,8 +189,9 @@ void TileRepository::Tile::UpdateTileStats() {
 		}
 	}
 
-	// Remove old avg. luminance value and add the new one
-	tileRepository->filmTotalYValue += totalYValue - allPassFilmTotalYValue;
+	// Remove old avg. luminance value and add the new one (the other tiles
+	// can be updated at the same time)
+	AtomicAdd(&tileRepository->filmTotalYValue, totalYValue - allPassFilmTotalYValue);
 	allPassFilmTotalYValue = totalYValue;
 }
 
@@ -283,13 +287,50 @@ template<class Archive> void TileRepository::Tile::save(Archive &ar, const u_int
 	ar & hasEnoughWarmUpSample;
 }
 
+//------------------------------------------------------------------------------
+// TileWorkQueue
+//------------------------------------------------------------------------------
+
+bool TileRepository::TileWorkQueue::PopFront(u_int *roundTag, u_int *index) {
+	unsigned long long r = range.load();
+	for (;;) {
+		u_int tag, first, last;
+		Unpack(r, &tag, &first, &last);
+		if (first >= last)
+			return false;
+
+		if (range.compare_exchange_weak(r, Pack(tag, first + 1, last))) {
+			*roundTag = tag;
+			*index = first;
+			return true;
+		}
+	}
+}
+
+bool TileRepository::TileWorkQueue::PopBack(u_int *roundTag, u_int *index) {
+	unsigned long long r = range.load();
+	for (;;) {
+		u_int tag, first, last;
+		Unpack(r, &tag, &first, &last);
+		if (first >= last)
+			return false;
+
+		if (range.compare_exchange_weak(r, Pack(tag, first, last - 1))) {
+			*roundTag = tag;
+			*index = last - 1;
+			return true;
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 // TileRepository
 //------------------------------------------------------------------------------
 
 BOOST_CLASS_EXPORT_IMPLEMENT(slg::TileRepository)
 
-TileRepository::TileRepository(const u_int tileW, const u_int tileH) {
+TileRepository::TileRepository(const u_int tileW, const u_int tileH) :
+		roundTiles(NULL), roundTilesCapacity(0), roundIndex(0), roundPendingCount(0) {
 	tileWidth = tileW;
 	tileHeight = tileH;
 
@@ -302,58 +343,163 @@ TileRepository::TileRepository(const u_int tileW, const u_int tileH) {
 
 	done = false;
 	filmTotalYValue = 0.f;
+
+	InitWorkQueues();
 }
 
-TileRepository::TileRepository() {
+TileRepository::TileRepository() : roundTiles(NULL), roundTilesCapacity(0),
+		roundIndex(0), roundPendingCount(0) {
+	InitWorkQueues();
 }
 
 TileRepository::~TileRepository() {
 	Clear();
+
+	BOOST_FOREACH(TileWorkQueue *queue, workQueues)
+		delete queue;
+	delete[] roundTiles;
+}
+
+void TileRepository::InitWorkQueues() {
+	// One queue for each hardware thread: the render threads use the queue
+	// of their index (modulo the number of queues)
+	const u_int count = Max(1u, boost::thread::hardware_concurrency());
+	for (u_int i = 0; i < count; ++i)
+		workQueues.push_back(new TileWorkQueue());
 }
 
 void TileRepository::Clear() {
-	// Free all tiles in the 3 lists
+	boost::unique_lock<boost::mutex> lock(tileMutex);
+
+	BOOST_FOREACH(TileWorkQueue *queue, workQueues)
+		queue->Reset(0, 0, 0);
+	roundPendingCount = 0;
 
 	BOOST_FOREACH(Tile *tile, tileList) {
 		delete tile;
 	}
 	
 	tileList.clear();
-	todoTiles.clear();
-	pendingTiles.clear();
-	convergedTiles.clear();
 }
 
-void TileRepository::Restart(const u_int startPass) {
-	todoTiles.clear();
-	pendingTiles.clear();
-	convergedTiles.clear();
-
+void TileRepository::RestartTiles(const u_int startPass) {
 	BOOST_FOREACH(Tile *tile, tileList) {
+		boost::unique_lock<boost::mutex> lock(tile->tileMutex);
 		tile->Restart(startPass);
-		todoTiles.push(tile);		
 	}
-	
+
 	done = false;
 	filmTotalYValue = 0.f;
+
+	StartRound(tileList);
+}
+
+void TileRepository::Restart(const u_int startPass) {
+	boost::unique_lock<boost::mutex> lock(tileMutex);
+
+	RestartTiles(startPass);
+}
+
+void TileRepository::StartRound(const vector<Tile *> &tiles) {
+	const u_int tileCount = tiles.size();
+	if (tileCount > TileWorkQueue::MAX_TILE_COUNT)
+		throw runtime_error("Too many tiles in TileRepository: " + ToString(tileCount));
+
+	// The round tiles are always a subset of the tile list so the array is
+	// reallocated only by InitTiles() and by the serialization, when no
+	// thread is rendering
+	if (tileCount > roundTilesCapacity) {
+		delete[] roundTiles;
+		roundTiles = new boost::atomic<Tile *>[tileCount];
+		roundTilesCapacity = tileCount;
+	}
+
+	const u_int newRound = roundIndex + 1;
+	BOOST_FOREACH(Tile *tile, tiles) {
+		boost::unique_lock<boost::mutex> lock(tile->tileMutex);
+		tile->scheduledRound = newRound;
+	}
+
+	// The order is important: the round index is updated before overwriting
+	// roundTiles so PopTile() can detect an index of a past round and a tile
+	// can be popped only after the round counters have been updated
+	roundIndex = newRound;
+	for (u_int i = 0; i < tileCount; ++i)
+		roundTiles[i] = tiles[i];
+	roundPendingCount = tileCount;
+
+	// Split the tiles between the queues, each queue has a continuous
+	// piece of the Hilbert curve
+	const u_int queueCount = workQueues.size();
+	for (u_int i = 0; i < queueCount; ++i)
+		workQueues[i]->Reset(newRound, i * tileCount / queueCount, (i + 1) * tileCount / queueCount);
+
+	// Wake up the threads waiting for the end of the previous round
+	roundCondition.notify_all();
+}
+
+bool TileRepository::StartNextRound() {
+	vector<Tile *> tiles;
+	BOOST_FOREACH(Tile *tile, tileList) {
+		boost::unique_lock<boost::mutex> lock(tile->tileMutex);
+		if (!tile->done)
+			tiles.push_back(tile);
+	}
+
+	if (tiles.size() > 0) {
+		StartRound(tiles);
+		return true;
+	}
+
+	// All tiles are done
+	if (enableMultipassRendering && (convergenceTestThresholdReduction > 0.f)) {
+		// Reduce the target threshold and continue the rendering
+		if (enableRenderingDonePrint) {
+			const double elapsedTime = WallClockTime() - startTime;
+			SLG_LOG(boost::format("Threshold256 %.4f reached: %.2f secs") % (256.f * convergenceTestThreshold) % elapsedTime);
+		}
+
+		convergenceTestThreshold *= convergenceTestThresholdReduction;
+
+		// Restart the rendering for all tiles
+		RestartTiles(0);
+
+		return true;
+	} else {
+		// Rendering done
+		SetDone();
+
+		return false;
+	}
 }
 
 void TileRepository::GetPendingTiles(deque<const Tile *> &tiles) {
 	boost::unique_lock<boost::mutex> lock(tileMutex);
 
-	tiles.insert(tiles.end(), pendingTiles.begin(), pendingTiles.end());
+	BOOST_FOREACH(const Tile *tile, tileList) {
+		if (tile->renderingCount > 0)
+			tiles.push_back(tile);
+	}
 }
 
 void TileRepository::GetNotConvergedTiles(deque<const Tile *> &tiles) {
 	boost::unique_lock<boost::mutex> lock(tileMutex);
 
-	tiles.insert(tiles.end(), todoTiles.begin(), todoTiles.end());
+	BOOST_FOREACH(Tile *tile, tileList) {
+		boost::unique_lock<boost::mutex> tileLock(tile->tileMutex);
+		if (!tile->done && (tile->renderingCount == 0))
+			tiles.push_back(tile);
+	}
 }
 
 void TileRepository::GetConvergedTiles(deque<const Tile *> &tiles) {
 	boost::unique_lock<boost::mutex> lock(tileMutex);
 
-	tiles.insert(tiles.end(), convergedTiles.begin(), convergedTiles.end());
+	BOOST_FOREACH(Tile *tile, tileList) {
+		boost::unique_lock<boost::mutex> tileLock(tile->tileMutex);
+		if (tile->done)
+			tiles.push_back(tile);
+	}
 }
 
 void TileRepository::HilberCurveTiles(
@@ -391,6 +537,8 @@ void TileRepository::HilberCurveTiles(
 }
 
 void TileRepository::InitTiles(const Film &film) {
+	boost::unique_lock<boost::mutex> lock(tileMutex);
+
 	const u_int *filmSubRegion = film.GetSubRegion();
 	filmRegionWidth = filmSubRegion[1] - filmSubRegion[0] + 1;
 	filmRegionHeight = filmSubRegion[3] - filmSubRegion[2] + 1;
@@ -404,8 +552,7 @@ void TileRepository::InitTiles(const Film &film) {
 			tileWidth, 0,
 			filmSubRegion[1] + 1, filmSubRegion[3] + 1);
 
-	BOOST_FOREACH(Tile *tile, tileList)
-		todoTiles.push(tile);
+	StartRound(tileList);
 
 	done = false;
 	startTime = WallClockTime();
@@ -423,126 +570,146 @@ void TileRepository::SetDone() {
 	}
 }
 
-bool TileRepository::GetToDoTile(Tile **tile) {
-	if (todoTiles.size() > 0) {
-		// Get the next tile to render
-		*tile = todoTiles.top();
-		todoTiles.pop();
-		pendingTiles.push_back(*tile);
+bool TileRepository::PopTile(const u_int threadIndex, Tile **tile, u_int *tileRound) {
+	const u_int queueCount = workQueues.size();
+	const u_int queueIndex = threadIndex % queueCount;
+
+	for (;;) {
+		// Look for a tile in my queue first and than steal one from the other
+		// queues
+		u_int roundTag, index;
+		bool found = workQueues[queueIndex]->PopFront(&roundTag, &index);
+		for (u_int i = 1; !found && (i < queueCount); ++i)
+			found = workQueues[(queueIndex + i) % queueCount]->PopBack(&roundTag, &index);
+
+		if (!found)
+			return false;
+
+		// A new round can start while I'm here: the index is always inside
+		// roundTiles but, if the round has changed, it can point to a tile
+		// of the new round. The round index is read after the tile because
+		// StartRound() updates it before overwriting roundTiles.
+		Tile *t = roundTiles[index];
+		const u_int round = roundIndex;
+		if (TileWorkQueue::RoundTag(round) != roundTag) {
+			// The index is from a past round, discard it
+			continue;
+		}
+
+		++(t->renderingCount);
+		*tile = t;
+		*tileRound = round;
 
 		return true;
-	} else {
-		// This should never happen
-		SLG_LOG("WARNING: out of tiles to render");
+	}
+}
 
-		return false;
+bool TileRepository::GetPendingNotDoneTile(const u_int round, Tile **tile, u_int *tileRound) {
+	// tileList is never modified while rendering
+	BOOST_FOREACH(Tile *t, tileList) {
+		if (t->renderingCount > 0) {
+			boost::unique_lock<boost::mutex> lock(t->tileMutex);
+
+			if (!t->done && (t->scheduledRound == round)) {
+				++(t->renderingCount);
+				*tile = t;
+				*tileRound = round;
+
+				return true;
+			}
+		}
 	}
+
+	return false;
 }
 
-bool TileRepository::NextTile(Film *film, boost::mutex *filmMutex,
-		Tile **tile, Film *tileFilm) {
-	// Now I have to lock the repository
-	boost::unique_lock<boost::mutex> lock(tileMutex);
+void TileRepository::MergeTile(Film *film, boost::mutex *filmMutex,
+		Tile *tile, const u_int tileRound, Film *tileFilm) {
+	// Only the threads rendering the same tile have to wait here
+	bool firstRoundPass;
+	{
+		boost::unique_lock<boost::mutex> lock(tile->tileMutex);
 
-	// Check if I have to add the tile to the film
-	if (*tile) {
 		if (varianceClamping.hasClamping()) {
 			// Apply variance clamping
-			(*tile)->VarianceClamp(*tileFilm);
+			tile->VarianceClamp(*tileFilm);
 		}
 
 		// Add the pass to the tile
-		(*tile)->AddPass(*tileFilm);
-
-		// Remove the first copy of tile from pending list (there can be multiple copy of the same tile)
-		pendingTiles.erase(find(pendingTiles.begin(), pendingTiles.end(), *tile));
-
-		if ((*tile)->done) {
-			// All done for this tile
-			convergedTiles.push_back(*tile);
-		} else {
-			// Re-add to the todoTiles priority queue, if it is not already there
-			if (find(todoTiles.begin(), todoTiles.end(), *tile) == todoTiles.end())
-				todoTiles.push(*tile);
-		}
+		tile->AddPass(*tileFilm);
+
+		// There can be multiple threads rendering the same tile, only the
+		// first pass completed in this round is counted. A pass of a tile
+		// taken in a past round is still added but it isn't counted.
+		firstRoundPass = (tileRound == roundIndex) && (tile->completedRound != tileRound);
+		if (firstRoundPass)
+			tile->completedRound = tileRound;
+	}
 
-		// Add the tile also to the global film
+	// Add the tile also to the global film
+	{
 		boost::unique_lock<boost::mutex> lock(*filmMutex);
 
 		film->AddFilm(*tileFilm,
 				0, 0,
-				Min(tileWidth, film->GetWidth() - (*tile)->xStart),
-				Min(tileHeight, film->GetHeight() - (*tile)->yStart),
-				(*tile)->xStart, (*tile)->yStart);
+				Min(tileWidth, film->GetWidth() - tile->xStart),
+				Min(tileHeight, film->GetHeight() - tile->yStart),
+				tile->xStart, tile->yStart);
 	}
 
-	if (todoTiles.size() == 0) {
-		if (!enableMultipassRendering) {
-			if (pendingTiles.size() == 0) {
-				// Rendering done
-				SetDone();
-			}
+	--(tile->renderingCount);
 
-			return false;
-		}
+	// This must be the last step: the round can end now
+	if (firstRoundPass && (--roundPendingCount == 0)) {
+		// Wake up the threads waiting for the end of the round. The lock
+		// avoids to signal a thread before it starts to wait.
+		boost::unique_lock<boost::mutex> lock(tileMutex);
+		roundCondition.notify_all();
+	}
+}
 
-		// Multi-pass rendering enabled
-		
-		// Check the status of pending tiles (one or more of them could be a
-		// copy of mine and now done)
-		bool pendingAllDone = true;
-		Tile *pendingNotYetDoneTile = NULL;
-		BOOST_FOREACH(Tile *tile, pendingTiles) {
-			if (!tile->done) {
-				pendingNotYetDoneTile = tile;
-				pendingAllDone = false;
-				break;
-			}
-		}
+bool TileRepository::NextTile(Film *film, boost::mutex *filmMutex,
+		Tile **tile, u_int *tileRound, Film *tileFilm, const u_int threadIndex) {
+	// Check if I have to add the tile to the film
+	if (*tile) {
+		MergeTile(film, filmMutex, *tile, *tileRound, tileFilm);
+		*tile = NULL;
+	}
 
-		if (pendingAllDone) {
-			if (convergenceTestThresholdReduction > 0.f) {
-				// Reduce the target threshold and continue the rendering				
-				if (enableRenderingDonePrint) {
-					const double elapsedTime = WallClockTime() - startTime;
-					SLG_LOG(boost::format("Threshold256 %.4f reached: %.2f secs") % (256.f * convergenceTestThreshold) % elapsedTime);
-				}
-
-				convergenceTestThreshold *= convergenceTestThresholdReduction;
-
-				// Restart the rendering for all tiles
-
-				// I need to save a copy of the current pending tile list because
-				// it can be not empty. I could just avoid to clear the list but is
-				// more readable (an safer for the Restart() method) to work in this
-				// way.
-				deque<Tile *> currentPendingTiles = pendingTiles;
-				Restart();
-				pendingTiles = currentPendingTiles;
-
-				// Get the next tile to render
-				return GetToDoTile(tile);
-			} else {
-				if (pendingTiles.size() == 0) {
-					// Rendering done
-					SetDone();
-				}
+	for (;;) {
+		const u_int round = roundIndex;
 
-				return false;
-			}
-		} else {
-			// No todo tiles but some still pending, I will just return one of the
-			// not yet done pending tiles to render
+		// Get the next tile to render
+		if (PopTile(threadIndex, tile, tileRound))
+			return true;
 
-			*tile = pendingNotYetDoneTile;
-			// I add again the tile to the list so it is counted multiple times
-			pendingTiles.push_back(*tile);
+		if (roundPendingCount > 0) {
+			// No todo tiles but some still pending
+			if (!enableMultipassRendering)
+				return false;
 
-			return true;
+			// I will just return one of the not yet done pending tiles to
+			// render (it can be rendered by multiple threads)
+			if (GetPendingNotDoneTile(round, tile, tileRound))
+				return true;
+
+			// The last pending tile passes are being completed, wait for
+			// the end of the round
+			boost::unique_lock<boost::mutex> lock(tileMutex);
+			while ((roundIndex == round) && (roundPendingCount > 0))
+				roundCondition.wait(lock);
+			continue;
 		}
-	} else {
-		// Get the next tile to render
-		return GetToDoTile(tile);
+
+		// The round is over, now I have to lock the repository
+		boost::unique_lock<boost::mutex> lock(tileMutex);
+
+		// Check if another thread has already started a new round
+		if (roundIndex != round)
+			continue;
+
+		if (done || !StartNextRound())
+			return false;
 	}
 }
 
@@ -633,18 +800,19 @@ template<class Archive> void TileRepository::load(Archive &ar, const u_int versi
 
 	u_int todoListSize;
 	ar & todoListSize;
-	for (u_int i = 0; i < todoListSize; ++i) {
-		Tile *todoTile;
-		ar & todoTile;
-		todoTiles.push(todoTile);
-	}
+	vector<Tile *> todoTiles(todoListSize);
+	for (u_int i = 0; i < todoListSize; ++i)
+		ar & todoTiles[i];
 
-	pendingTiles.resize(0);
+	// The converged tiles have the done flag set
+	deque<Tile *> convergedTiles;
 	ar & convergedTiles;
 
 	// Initialize the Tile::tileRepository field
 	BOOST_FOREACH(Tile *tile, tileList)
 		tile->tileRepository = this;
+
+	StartRound(todoTiles);
 }
 
 template<class Archive> void TileRepository::save(Archive &ar, const u_int version) const {
@@ -667,12 +835,21 @@ template<class Archive> void TileRepository::save(Archive &ar, const u_int versi
 	ar & filmTotalYValue;
 	ar & tileList;
 
-	const u_int count = todoTiles.size() + pendingTiles.size();
+	// The todo list includes the pending tiles
+	vector<Tile *> todoTiles;
+	deque<Tile *> convergedTiles;
+	BOOST_FOREACH(Tile *tile, tileList) {
+		boost::unique_lock<boost::mutex> tileLock(tile->tileMutex);
+		if (tile->done)
+			convergedTiles.push_back(tile);
+		else
+			todoTiles.push_back(tile);
+	}
+
+	const u_int count = todoTiles.size();
 	ar & count;
 	BOOST_FOREACH(Tile *tile, todoTiles)
 		ar & tile;
-	BOOST_FOREACH(Tile *tile, pendingTiles)
-		ar & tile;
 
 	ar & convergedTiles;
 }
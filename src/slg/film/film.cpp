@@ -73,6 +73,12 @@ Film::Film() {
 
 	convTest = NULL;
 
+	statsPendingSampleCount = 0;
+	rowLocks = NULL;
+	threadSafeAddSample = false;
+	dirtyRows = NULL;
+	noiseMapUpdate = false;
+
 	enabledOverlappedScreenBufferUpdate = true;
 
 	// Initialize variables to NULL
@@ -119,6 +125,12 @@ Film::Film(const u_int w, const u_int h, const u_int *sr) {
 
 	convTest = NULL;
 
+	statsPendingSampleCount = 0;
+	rowLocks = NULL;
+	threadSafeAddSample = false;
+	dirtyRows = NULL;
+	noiseMapUpdate = false;
+
 	enabledOverlappedScreenBufferUpdate = true;
 
 	// Initialize variables to NULL
@@ -138,6 +150,8 @@ Film::~Film() {
 	delete convTest;
 
 	FreeChannels();
+	FreeRowLocks();
+	FreeDirtyRows();
 }
 
 void Film::FreeChannels() {
@@ -280,6 +294,13 @@ void Film::Resize(const u_int w, const u_int h) {
 	// Delete all already allocated channels
 	FreeChannels();
 
+	FreeRowLocks();
+	if (threadSafeAddSample)
+		AllocRowLocks();
+
+	FreeDirtyRows();
+	AllocDirtyRows();
+
 	// Allocate all required channels
 	hasDataChannel = false;
 	hasComposingChannel = false;
@@ -436,10 +457,47 @@ void Film::Resize(const u_int w, const u_int h) {
 
 	// Initialize the statistics
 	statsTotalSampleCount = 0.0;
+	statsPendingSampleCount = 0;
 	statsAvgSampleSec = 0.0;
 	statsStartSampleTime = WallClockTime();
 }
 
+void Film::AllocRowLocks() {
+	rowLocks = new boost::mutex[height];
+}
+
+void Film::FreeRowLocks() {
+	delete[] rowLocks;
+	rowLocks = NULL;
+}
+
+void Film::AllocDirtyRows() {
+	dirtyRows = new boost::atomic<u_char>[height];
+	for (u_int y = 0; y < height; ++y)
+		dirtyRows[y].store(1, boost::memory_order_relaxed);
+}
+
+void Film::FreeDirtyRows() {
+	delete[] dirtyRows;
+	dirtyRows = NULL;
+}
+
+void Film::SetThreadSafeAddSample(const bool enable) {
+	if (enable == threadSafeAddSample)
+		return;
+
+	FlushSampleCount();
+
+	threadSafeAddSample = enable;
+	FreeRowLocks();
+	if (threadSafeAddSample && initialized)
+		AllocRowLocks();
+}
+
+void Film::FlushSampleCount() {
+	statsTotalSampleCount += statsPendingSampleCount.exchange(0);
+}
+
 void Film::SetRadianceChannelScale(const u_int index, const RadianceChannelScale &scale) {
 	radianceChannelScales.resize(Max<size_t>(radianceChannelScales.size(), index + 1));
 
@@ -447,73 +505,82 @@ void Film::SetRadianceChannelScale(const u_int index, const RadianceChannelScale
 	radianceChannelScales[index].Init();
 }
 
-void Film::Reset() {
+void Film::ResetRows(const u_int rowStart, const u_int rowCount) {
 	if (HasChannel(RADIANCE_PER_PIXEL_NORMALIZED)) {
 		for (u_int i = 0; i < radianceGroupCount; ++i)
-			channel_RADIANCE_PER_PIXEL_NORMALIZEDs[i]->Clear();
+			channel_RADIANCE_PER_PIXEL_NORMALIZEDs[i]->ClearRows(rowStart, rowCount);
 	}
 	if (HasChannel(RADIANCE_PER_SCREEN_NORMALIZED)) {
 		for (u_int i = 0; i < radianceGroupCount; ++i)
-			channel_RADIANCE_PER_SCREEN_NORMALIZEDs[i]->Clear();
+			channel_RADIANCE_PER_SCREEN_NORMALIZEDs[i]->ClearRows(rowStart, rowCount);
 	}
 	if (HasChannel(ALPHA))
-		channel_ALPHA->Clear();
+		channel_ALPHA->ClearRows(rowStart, rowCount);
 	if (HasChannel(DEPTH))
-		channel_DEPTH->Clear(numeric_limits<float>::infinity());
+		channel_DEPTH->ClearRows(rowStart, rowCount, numeric_limits<float>::infinity());
 	if (HasChannel(POSITION))
-		channel_POSITION->Clear(numeric_limits<float>::infinity());
+		channel_POSITION->ClearRows(rowStart, rowCount, numeric_limits<float>::infinity());
 	if (HasChannel(GEOMETRY_NORMAL))
-		channel_GEOMETRY_NORMAL->Clear(numeric_limits<float>::infinity());
+		channel_GEOMETRY_NORMAL->ClearRows(rowStart, rowCount, numeric_limits<float>::infinity());
 	if (HasChannel(SHADING_NORMAL))
-		channel_SHADING_NORMAL->Clear(numeric_limits<float>::infinity());
+		channel_SHADING_NORMAL->ClearRows(rowStart, rowCount, numeric_limits<float>::infinity());
 	if (HasChannel(MATERIAL_ID))
-		channel_MATERIAL_ID->Clear(numeric_limits<u_int>::max());
+		channel_MATERIAL_ID->ClearRows(rowStart, rowCount, numeric_limits<u_int>::max());
 	if (HasChannel(DIRECT_DIFFUSE))
-		channel_DIRECT_DIFFUSE->Clear();
+		channel_DIRECT_DIFFUSE->ClearRows(rowStart, rowCount);
 	if (HasChannel(DIRECT_GLOSSY))
-		channel_DIRECT_GLOSSY->Clear();
+		channel_DIRECT_GLOSSY->ClearRows(rowStart, rowCount);
 	if (HasChannel(EMISSION))
-		channel_EMISSION->Clear();
+		channel_EMISSION->ClearRows(rowStart, rowCount);
 	if (HasChannel(INDIRECT_DIFFUSE))
-		channel_INDIRECT_DIFFUSE->Clear();
+		channel_INDIRECT_DIFFUSE->ClearRows(rowStart, rowCount);
 	if (HasChannel(INDIRECT_GLOSSY))
-		channel_INDIRECT_GLOSSY->Clear();
+		channel_INDIRECT_GLOSSY->ClearRows(rowStart, rowCount);
 	if (HasChannel(INDIRECT_SPECULAR))
-		channel_INDIRECT_SPECULAR->Clear();
+		channel_INDIRECT_SPECULAR->ClearRows(rowStart, rowCount);
 	if (HasChannel(MATERIAL_ID_MASK)) {
 		for (u_int i = 0; i < channel_MATERIAL_ID_MASKs.size(); ++i)
-			channel_MATERIAL_ID_MASKs[i]->Clear();
+			channel_MATERIAL_ID_MASKs[i]->ClearRows(rowStart, rowCount);
 	}
 	if (HasChannel(DIRECT_SHADOW_MASK))
-		channel_DIRECT_SHADOW_MASK->Clear();
+		channel_DIRECT_SHADOW_MASK->ClearRows(rowStart, rowCount);
 	if (HasChannel(INDIRECT_SHADOW_MASK))
-		channel_INDIRECT_SHADOW_MASK->Clear();
+		channel_INDIRECT_SHADOW_MASK->ClearRows(rowStart, rowCount);
 	if (HasChannel(UV))
-		channel_UV->Clear();
+		channel_UV->ClearRows(rowStart, rowCount);
 	if (HasChannel(RAYCOUNT))
-		channel_RAYCOUNT->Clear();
+		channel_RAYCOUNT->ClearRows(rowStart, rowCount);
 	if (HasChannel(BY_MATERIAL_ID)) {
 		for (u_int i = 0; i < channel_BY_MATERIAL_IDs.size(); ++i)
-			channel_BY_MATERIAL_IDs[i]->Clear();
+			channel_BY_MATERIAL_IDs[i]->ClearRows(rowStart, rowCount);
 	}
 	if (HasChannel(IRRADIANCE))
-		channel_IRRADIANCE->Clear();
+		channel_IRRADIANCE->ClearRows(rowStart, rowCount);
 	if (HasChannel(OBJECT_ID))
-		channel_OBJECT_ID->Clear(numeric_limits<u_int>::max());
+		channel_OBJECT_ID->ClearRows(rowStart, rowCount, numeric_limits<u_int>::max());
 	if (HasChannel(OBJECT_ID_MASK)) {
 		for (u_int i = 0; i < channel_OBJECT_ID_MASKs.size(); ++i)
-			channel_OBJECT_ID_MASKs[i]->Clear();
+			channel_OBJECT_ID_MASKs[i]->ClearRows(rowStart, rowCount);
 	}
 	if (HasChannel(BY_OBJECT_ID)) {
 		for (u_int i = 0; i < channel_BY_OBJECT_IDs.size(); ++i)
-			channel_BY_OBJECT_IDs[i]->Clear();
+			channel_BY_OBJECT_IDs[i]->ClearRows(rowStart, rowCount);
 	}
+
+	for (u_int y = rowStart; y < rowStart + rowCount; ++y)
+		SetRowDirty(y);
+}
+
+void Film::Reset() {
+	ResetRows(0, height);
+
 	if (HasChannel(FRAMEBUFFER_MASK))
 		channel_FRAMEBUFFER_MASK->Clear();
 
 	// convTest has to be reset explicitly
 
 	statsTotalSampleCount = 0.0;
+	statsPendingSampleCount = 0;
 	statsAvgSampleSec = 0.0;
 	statsStartSampleTime = WallClockTime();
 }
@@ -540,8 +607,56 @@ void Film::AddFilm(const Film &film,
 		const u_int srcOffsetX, const u_int srcOffsetY,
 		const u_int srcWidth, const u_int srcHeight,
 		const u_int dstOffsetX, const u_int dstOffsetY) {
-	statsTotalSampleCount += film.statsTotalSampleCount;
+	statsTotalSampleCount += film.GetTotalSampleCount();
 
+	AddFilmChannels(film, srcOffsetX, srcOffsetY, srcWidth, srcHeight, dstOffsetX, dstOffsetY);
+}
+
+void Film::MergeFilms(const vector<Film *> &films) {
+	// Collect the rows modified in any of the source films since the last
+	// merge (or in this film, for instance by a Reset())
+	vector<u_int> rows;
+	for (u_int y = 0; y < height; ++y) {
+		bool dirty = dirtyRows[y].load(boost::memory_order_relaxed);
+		for (u_int i = 0; i < films.size(); ++i) {
+			// The flag is cleared before reading the row so any sample
+			// added during the merge marks the row again for the next one.
+			// The acquire pairs with the release in SetRowDirty() so the
+			// writes done before marking the row are visible here.
+			if (films[i]->dirtyRows[y].exchange(0, boost::memory_order_acquire))
+				dirty = true;
+		}
+
+		if (dirty)
+			rows.push_back(y);
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for (
+			// Visual C++ 2013 supports only OpenMP 2.5
+#if _OPENMP >= 200805
+			unsigned
+#endif
+			int i = 0; i < rows.size(); ++i) {
+		const u_int y = rows[i];
+
+		ResetRows(y, 1);
+		for (u_int j = 0; j < films.size(); ++j)
+			AddFilmChannels(*films[j], 0, y, width, 1, 0, y);
+	}
+	for (u_int y = 0; y < height; ++y)
+		dirtyRows[y].store(0, boost::memory_order_relaxed);
+
+	double totalSampleCount = 0.0;
+	for (u_int i = 0; i < films.size(); ++i)
+		totalSampleCount += films[i]->GetTotalSampleCount();
+	SetSampleCount(totalSampleCount);
+}
+
+void Film::AddFilmChannels(const Film &film,
+		const u_int srcOffsetX, const u_int srcOffsetY,
+		const u_int srcWidth, const u_int srcHeight,
+		const u_int dstOffsetX, const u_int dstOffsetY) {
 	if (HasChannel(RADIANCE_PER_PIXEL_NORMALIZED) && film.HasChannel(RADIANCE_PER_PIXEL_NORMALIZED)) {
 		for (u_int i = 0; i < Min(radianceGroupCount, film.radianceGroupCount); ++i) {
 			for (u_int y = 0; y < srcHeight; ++y) {
@@ -858,6 +973,9 @@ void Film::AddFilm(const Film &film,
 			}
 		}
 	}
+
+	for (u_int y = dstOffsetY; y < dstOffsetY + srcHeight; ++y)
+		SetRowDirty(y);
 }
 
 u_int Film::GetChannelCount(const FilmChannelType type) const {
@@ -919,6 +1037,70 @@ u_int Film::GetChannelCount(const FilmChannelType type) const {
 	}
 }
 
+// Returns the number of values (not bytes) of a frame buffer
+template<class T> static size_t GetFrameBufferSize(const T *frameBuffer) {
+	return frameBuffer ? (frameBuffer->GetSize() / sizeof(*(frameBuffer->GetPixels()))) : 0;
+}
+
+size_t Film::GetChannelSize(const FilmChannelType type) const {
+	switch (type) {
+		case RADIANCE_PER_PIXEL_NORMALIZED:
+			return (channel_RADIANCE_PER_PIXEL_NORMALIZEDs.size() > 0) ? GetFrameBufferSize(channel_RADIANCE_PER_PIXEL_NORMALIZEDs[0]) : 0;
+		case RADIANCE_PER_SCREEN_NORMALIZED:
+			return (channel_RADIANCE_PER_SCREEN_NORMALIZEDs.size() > 0) ? GetFrameBufferSize(channel_RADIANCE_PER_SCREEN_NORMALIZEDs[0]) : 0;
+		case ALPHA:
+			return GetFrameBufferSize(channel_ALPHA);
+		case IMAGEPIPELINE:
+			return (channel_IMAGEPIPELINEs.size() > 0) ? GetFrameBufferSize(channel_IMAGEPIPELINEs[0]) : 0;
+		case DEPTH:
+			return GetFrameBufferSize(channel_DEPTH);
+		case POSITION:
+			return GetFrameBufferSize(channel_POSITION);
+		case GEOMETRY_NORMAL:
+			return GetFrameBufferSize(channel_GEOMETRY_NORMAL);
+		case SHADING_NORMAL:
+			return GetFrameBufferSize(channel_SHADING_NORMAL);
+		case MATERIAL_ID:
+			return GetFrameBufferSize(channel_MATERIAL_ID);
+		case DIRECT_DIFFUSE:
+			return GetFrameBufferSize(channel_DIRECT_DIFFUSE);
+		case DIRECT_GLOSSY:
+			return GetFrameBufferSize(channel_DIRECT_GLOSSY);
+		case EMISSION:
+			return GetFrameBufferSize(channel_EMISSION);
+		case INDIRECT_DIFFUSE:
+			return GetFrameBufferSize(channel_INDIRECT_DIFFUSE);
+		case INDIRECT_GLOSSY:
+			return GetFrameBufferSize(channel_INDIRECT_GLOSSY);
+		case INDIRECT_SPECULAR:
+			return GetFrameBufferSize(channel_INDIRECT_SPECULAR);
+		case MATERIAL_ID_MASK:
+			return (channel_MATERIAL_ID_MASKs.size() > 0) ? GetFrameBufferSize(channel_MATERIAL_ID_MASKs[0]) : 0;
+		case DIRECT_SHADOW_MASK:
+			return GetFrameBufferSize(channel_DIRECT_SHADOW_MASK);
+		case INDIRECT_SHADOW_MASK:
+			return GetFrameBufferSize(channel_INDIRECT_SHADOW_MASK);
+		case UV:
+			return GetFrameBufferSize(channel_UV);
+		case RAYCOUNT:
+			return GetFrameBufferSize(channel_RAYCOUNT);
+		case BY_MATERIAL_ID:
+			return (channel_BY_MATERIAL_IDs.size() > 0) ? GetFrameBufferSize(channel_BY_MATERIAL_IDs[0]) : 0;
+		case IRRADIANCE:
+			return GetFrameBufferSize(channel_IRRADIANCE);
+		case OBJECT_ID:
+			return GetFrameBufferSize(channel_OBJECT_ID);
+		case OBJECT_ID_MASK:
+			return (channel_OBJECT_ID_MASKs.size() > 0) ? GetFrameBufferSize(channel_OBJECT_ID_MASKs[0]) : 0;
+		case BY_OBJECT_ID:
+			return (channel_BY_OBJECT_IDs.size() > 0) ? GetFrameBufferSize(channel_BY_OBJECT_IDs[0]) : 0;
+		case FRAMEBUFFER_MASK:
+			return GetFrameBufferSize(channel_FRAMEBUFFER_MASK);
+		default:
+			throw runtime_error("Unknown FilmChannelType in Film::GetChannelSize(): " + ToString(type));
+	}
+}
+
 template<> const float *Film::GetChannel<float>(const FilmChannelType type, const u_int index) {
 	switch (type) {
 		case RADIANCE_PER_PIXEL_NORMALIZED:
@@ -1005,7 +1187,7 @@ void Film::GetPixelFromMergedSampleBuffers(const u_int index, float *c) const {
 	}
 
 	if (channel_RADIANCE_PER_SCREEN_NORMALIZEDs.size() > 0) {
-		const float factor = statsTotalSampleCount / pixelCount;
+		const float factor = GetTotalSampleCount() / pixelCount;
 		for (u_int i = 0; i < channel_RADIANCE_PER_SCREEN_NORMALIZEDs.size(); ++i) {
 			if (radianceChannelScales[i].enabled) {
 				const float *src = channel_RADIANCE_PER_SCREEN_NORMALIZEDs[i]->GetPixel(index);
@@ -1107,7 +1289,7 @@ void Film::MergeSampleBuffers(const u_int index) {
 	}
 
 	if (HasChannel(RADIANCE_PER_SCREEN_NORMALIZED)) {
-		const float factor = pixelCount / statsTotalSampleCount;
+		const float factor = pixelCount / GetTotalSampleCount();
 
 		for (u_int i = 0; i < radianceGroupCount; ++i) {
 			if (radianceChannelScales[i].enabled) {
@@ -1143,7 +1325,7 @@ void Film::MergeSampleBuffers(const u_int index) {
 	}
 }
 
-void Film::AddSampleResultColor(const u_int x, const u_int y,
+void Film::AddSampleResultColorLockLess(const u_int x, const u_int y,
 		const SampleResult &sampleResult, const float weight)  {
 	if ((channel_RADIANCE_PER_PIXEL_NORMALIZEDs.size() > 0) && sampleResult.HasChannel(RADIANCE_PER_PIXEL_NORMALIZED)) {
 		for (u_int i = 0; i < Min(sampleResult.radiance.size(), channel_RADIANCE_PER_PIXEL_NORMALIZEDs.size()); ++i) {
@@ -1265,9 +1447,12 @@ void Film::AddSampleResultColor(const u_int x, const u_int y,
 			}
 		}
 	}
+
+	// Marked after the writes, see SetRowDirty()
+	SetRowDirty(y);
 }
 
-void Film::AddSampleResultData(const u_int x, const u_int y,
+void Film::AddSampleResultDataLockLess(const u_int x, const u_int y,
 		const SampleResult &sampleResult)  {
 	bool depthWrite = true;
 
@@ -1304,13 +1489,42 @@ void Film::AddSampleResultData(const u_int x, const u_int y,
 
 	if (channel_RAYCOUNT && sampleResult.HasChannel(RAYCOUNT))
 		channel_RAYCOUNT->AddPixel(x, y, &sampleResult.rayCount);
+
+	// Marked after the writes, see SetRowDirty()
+	SetRowDirty(y);
+}
+
+void Film::AddSampleResultColor(const u_int x, const u_int y,
+		const SampleResult &sampleResult, const float weight)  {
+	if (rowLocks) {
+		boost::unique_lock<boost::mutex> lock(rowLocks[y]);
+		AddSampleResultColorLockLess(x, y, sampleResult, weight);
+	} else
+		AddSampleResultColorLockLess(x, y, sampleResult, weight);
+}
+
+void Film::AddSampleResultData(const u_int x, const u_int y,
+		const SampleResult &sampleResult)  {
+	if (rowLocks) {
+		boost::unique_lock<boost::mutex> lock(rowLocks[y]);
+		AddSampleResultDataLockLess(x, y, sampleResult);
+	} else
+		AddSampleResultDataLockLess(x, y, sampleResult);
 }
 
 void Film::AddSample(const u_int x, const u_int y,
 		const SampleResult &sampleResult, const float weight) {
-	AddSampleResultColor(x, y, sampleResult, weight);
-	if (hasDataChannel)
-		AddSampleResultData(x, y, sampleResult);
+	if (rowLocks) {
+		boost::unique_lock<boost::mutex> lock(rowLocks[y]);
+
+		AddSampleResultColorLockLess(x, y, sampleResult, weight);
+		if (hasDataChannel)
+			AddSampleResultDataLockLess(x, y, sampleResult);
+	} else {
+		AddSampleResultColorLockLess(x, y, sampleResult, weight);
+		if (hasDataChannel)
+			AddSampleResultDataLockLess(x, y, sampleResult);
+	}
 }
 
 void Film::ResetConvergenceTest() {
@@ -1325,6 +1539,21 @@ u_int Film::RunConvergenceTest(const float threshold) {
 	return convTest->Test(threshold);
 }
 
+u_int Film::GetNoiseMapVersion() const {
+	return convTest ? convTest->GetNoiseMapVersion() : 0;
+}
+
+void Film::GetNoiseMap(const u_int blockSize, vector<float> &map,
+		u_int *mapWidth, u_int *mapHeight) const {
+	if (convTest)
+		convTest->GetNoiseMap(subRegion, blockSize, map, mapWidth, mapHeight);
+	else {
+		*mapWidth = 1;
+		*mapHeight = 1;
+		map.assign(1, 0.f);
+	}
+}
+
 Film::FilmChannelType Film::String2FilmChannelType(const std::string &type) {
 	if (type == "RADIANCE_PER_PIXEL_NORMALIZED")
 		return RADIANCE_PER_PIXEL_NORMALIZED;
@@ -29,16 +29,18 @@ using namespace slg;
 // FilmConvTest
 //------------------------------------------------------------------------------
 
-FilmConvTest::FilmConvTest(const Film *flm) : film(flm) {
+FilmConvTest::FilmConvTest(const Film *flm) : film(flm), noiseMap(NULL), noiseMapVersion(0) {
 	referenceImage = new GenericFrameBuffer<3, 0, float>(film->GetWidth(), film->GetHeight());
 
 	Reset();
 }
 
-FilmConvTest::FilmConvTest() {
+FilmConvTest::FilmConvTest() : film(NULL), referenceImage(NULL), noiseMap(NULL), noiseMapVersion(0) {
 }
 
 FilmConvTest::~FilmConvTest() {
+	delete referenceImage;
+	delete noiseMap;
 }
 
 void FilmConvTest::Reset() {
@@ -47,6 +49,38 @@ void FilmConvTest::Reset() {
 
 	referenceImage->Clear(0.f);
 	firstTest = true;
+
+	{
+		boost::unique_lock<boost::mutex> lock(noiseMapMutex);
+
+		delete noiseMap;
+		noiseMap = NULL;
+	}
+	++noiseMapVersion;
+}
+
+void FilmConvTest::GetNoiseMap(const u_int *region, const u_int blockSize,
+		vector<float> &map, u_int *mapWidth, u_int *mapHeight) const {
+	const u_int regionWidth = region[1] - region[0] + 1;
+	const u_int regionHeight = region[3] - region[2] + 1;
+	*mapWidth = (regionWidth + blockSize - 1) / blockSize;
+	*mapHeight = (regionHeight + blockSize - 1) / blockSize;
+
+	map.assign(*mapWidth * *mapHeight, 0.f);
+
+	boost::unique_lock<boost::mutex> lock(noiseMapMutex);
+
+	// No map is available before the second test
+	if (!noiseMap)
+		return;
+
+	for (u_int y = 0; y < regionHeight; ++y) {
+		const float *noise = noiseMap->GetPixel(region[0], region[2] + y);
+		float *block = &map[(y / blockSize) * *mapWidth];
+
+		for (u_int x = 0; x < regionWidth; ++x)
+			block[x / blockSize] = Max(block[x / blockSize], noise[x]);
+	}
 }
 
 u_int FilmConvTest::Test(const float threshold) {
@@ -68,16 +102,24 @@ u_int FilmConvTest::Test(const float threshold) {
 		todoPixelsCount = 0;
 		maxError = 0.f;
 
+		boost::unique_lock<boost::mutex> lock(noiseMapMutex);
+		if (!noiseMap)
+			noiseMap = new GenericFrameBuffer<1, 0, float>(film->GetWidth(), film->GetHeight());
+		float *noise = noiseMap->GetPixels();
+
 		for (u_int i = 0; i < pixelsCount; ++i) {
 			const float dr = fabsf((*img++) - (*ref++));
 			const float dg = fabsf((*img++) - (*ref++));
 			const float db = fabsf((*img++) - (*ref++));
 			const float diff = Max(Max(dr, dg), db);
 			maxError = Max(maxError, diff);
+			*noise++ = diff;
 
 			if (diff > threshold)
 				++todoPixelsCount;
 		}
+		lock.unlock();
+		++noiseMapVersion;
 		
 		// Copy the current image
 		referenceImage->Copy(film->channel_IMAGEPIPELINEs[0]);
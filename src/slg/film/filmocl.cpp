@@ -285,7 +285,7 @@ void Film::MergeSampleBuffersOCL(const u_int index) {
 	}
 
 	if (HasChannel(RADIANCE_PER_SCREEN_NORMALIZED)) {
-		const float factor = pixelCount / statsTotalSampleCount;
+		const float factor = pixelCount / GetTotalSampleCount();
 
 		for (u_int i = 0; i < radianceGroupCount; ++i) {
 			if (radianceChannelScales[i].enabled) {
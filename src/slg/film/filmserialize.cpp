@@ -17,6 +17,7 @@
  ***************************************************************************/
 
 #include <memory>
+#include <sstream>
 
 #include <boost/lexical_cast.hpp>
 #include <boost/foreach.hpp>
@@ -24,18 +25,141 @@
 #include <boost/iostreams/filter/gzip.hpp>
 
 #include "slg/film/film.h"
+#include "slg/utils/chunkfile.h"
 
 using namespace std;
 using namespace luxrays;
 using namespace slg;
 
+//------------------------------------------------------------------------------
+// Frame buffer visitors used by the chunk file format: the pixels are stored
+// in raw blocks outside of the serialization archive
+//------------------------------------------------------------------------------
+
+template<class Visitor, class FrameBuffer> static void VisitFrameBuffer(Visitor &visitor,
+		FrameBuffer *frameBuffer) {
+	if (frameBuffer)
+		visitor(frameBuffer);
+}
+
+template<class Visitor, class FrameBuffer> static void VisitFrameBuffer(Visitor &visitor,
+		const vector<FrameBuffer *> &frameBuffers) {
+	BOOST_FOREACH(FrameBuffer *frameBuffer, frameBuffers)
+		visitor(frameBuffer);
+}
+
+// Calls the visitor for each frame buffer of the film, always in the same order
+template<class Visitor> static void VisitFrameBuffers(Film *film, Visitor &visitor) {
+	VisitFrameBuffer(visitor, film->channel_RADIANCE_PER_PIXEL_NORMALIZEDs);
+	VisitFrameBuffer(visitor, film->channel_RADIANCE_PER_SCREEN_NORMALIZEDs);
+	VisitFrameBuffer(visitor, film->channel_ALPHA);
+	VisitFrameBuffer(visitor, film->channel_IMAGEPIPELINEs);
+	VisitFrameBuffer(visitor, film->channel_DEPTH);
+	VisitFrameBuffer(visitor, film->channel_POSITION);
+	VisitFrameBuffer(visitor, film->channel_GEOMETRY_NORMAL);
+	VisitFrameBuffer(visitor, film->channel_SHADING_NORMAL);
+	VisitFrameBuffer(visitor, film->channel_MATERIAL_ID);
+	VisitFrameBuffer(visitor, film->channel_DIRECT_DIFFUSE);
+	VisitFrameBuffer(visitor, film->channel_DIRECT_GLOSSY);
+	VisitFrameBuffer(visitor, film->channel_EMISSION);
+	VisitFrameBuffer(visitor, film->channel_INDIRECT_DIFFUSE);
+	VisitFrameBuffer(visitor, film->channel_INDIRECT_GLOSSY);
+	VisitFrameBuffer(visitor, film->channel_INDIRECT_SPECULAR);
+	VisitFrameBuffer(visitor, film->channel_MATERIAL_ID_MASKs);
+	VisitFrameBuffer(visitor, film->channel_DIRECT_SHADOW_MASK);
+	VisitFrameBuffer(visitor, film->channel_INDIRECT_SHADOW_MASK);
+	VisitFrameBuffer(visitor, film->channel_UV);
+	VisitFrameBuffer(visitor, film->channel_RAYCOUNT);
+	VisitFrameBuffer(visitor, film->channel_BY_MATERIAL_IDs);
+	VisitFrameBuffer(visitor, film->channel_IRRADIANCE);
+	VisitFrameBuffer(visitor, film->channel_OBJECT_ID);
+	VisitFrameBuffer(visitor, film->channel_OBJECT_ID_MASKs);
+	VisitFrameBuffer(visitor, film->channel_BY_OBJECT_IDs);
+	VisitFrameBuffer(visitor, film->channel_FRAMEBUFFER_MASK);
+}
+
+namespace {
+
+class FrameBufferBlockWriter {
+public:
+	FrameBufferBlockWriter(ChunkFileWriter &w) : writer(w) { }
+
+	template<u_int CHANNELS, u_int WEIGHT_CHANNELS, class T> void operator()(
+			GenericFrameBuffer<CHANNELS, WEIGHT_CHANNELS, T> *frameBuffer) {
+		writer.AddBlock(frameBuffer->GetPixels(), frameBuffer->GetSize());
+	}
+
+private:
+	ChunkFileWriter &writer;
+};
+
+class FrameBufferBlockReader {
+public:
+	FrameBufferBlockReader(ChunkFileReader &r, const u_int firstBlockIndex) :
+		reader(r), blockIndex(firstBlockIndex) { }
+
+	template<u_int CHANNELS, u_int WEIGHT_CHANNELS, class T> void operator()(
+			GenericFrameBuffer<CHANNELS, WEIGHT_CHANNELS, T> *frameBuffer) {
+		vector<T> pixels(frameBuffer->GetWidth() * frameBuffer->GetHeight() * CHANNELS);
+		if ((blockIndex >= reader.GetBlockCount()) ||
+				(reader.GetBlockSize(blockIndex) != pixels.size() * sizeof(T)))
+			throw runtime_error("Wrong frame buffer size in a serialized film");
+
+		reader.ReadBlock(blockIndex++, &pixels[0]);
+		frameBuffer->SwapPixels(pixels);
+	}
+
+private:
+	ChunkFileReader &reader;
+	u_int blockIndex;
+};
+
+}
+
 //------------------------------------------------------------------------------
 // Film serialization
 //------------------------------------------------------------------------------
 
 BOOST_CLASS_EXPORT_IMPLEMENT(slg::Film)
 
+boost::thread_specific_ptr<bool> FrameBufferSkipPixelsSerialization::skipPixels;
+
 Film *Film::LoadSerialized(const std::string &fileName) {
+	if (ChunkFileReader::IsChunkFile(fileName)) {
+		// The file is memory mapped
+		ChunkFileReader reader(fileName);
+
+		// The first block is the archive with everything but the pixels
+		if (reader.GetBlockCount() == 0)
+			throw runtime_error("Error while loading serialized film: " + fileName);
+		string archiveData(reader.GetBlockSize(0), '\0');
+		if (archiveData.size() > 0)
+			reader.ReadBlock(0, &archiveData[0]);
+
+		istringstream inStream(archiveData);
+		eos::polymorphic_portable_iarchive inArchive(inStream);
+
+		Film *film;
+		inArchive >> film;
+
+		if (!inStream.good()) {
+			delete film;
+			throw runtime_error("Error while loading serialized film: " + fileName);
+		}
+
+		// Followed by the pixels of each frame buffer
+		try {
+			FrameBufferBlockReader blockReader(reader, 1);
+			VisitFrameBuffers(film, blockReader);
+		} catch (...) {
+			delete film;
+			throw;
+		}
+
+		return film;
+	}
+
+	// The old format: a gzip compressed portable archive
 	BOOST_IFSTREAM inFile;
 	inFile.exceptions(ofstream::failbit | ofstream::badbit | ofstream::eofbit);
 	inFile.open(fileName.c_str(), BOOST_IFSTREAM::binary);
@@ -60,32 +184,40 @@ Film *Film::LoadSerialized(const std::string &fileName) {
 	return film;
 }
 
-void Film::SaveSerialized(const std::string &fileName, const Film *film) {
-	// Serialize the film
-	BOOST_OFSTREAM outFile;
-	outFile.exceptions(ofstream::failbit | ofstream::badbit | ofstream::eofbit);
-	outFile.open(fileName.c_str(), BOOST_OFSTREAM::binary);
+ChunkFileWriter *Film::AllocSerializedSnapshot(const Film *film, const bool compress) {
+	// Serialize everything but the pixels with the portable archive
+	ostringstream outStream;
+	{
+		FrameBufferSkipPixelsSerialization skipPixels;
 
-	const streampos startPosition = outFile.tellp();
-	
-	// Enable compression
-	boost::iostreams::filtering_ostream outStream;
-	outStream.push(boost::iostreams::gzip_compressor(4));
-	outStream.push(outFile);
+		eos::polymorphic_portable_oarchive outArchive(outStream);
+		outArchive << film;
+	}
 
-	// Use portable archive
-	eos::polymorphic_portable_oarchive outArchive(outStream);
-	//boost::archive::binary_oarchive outArchive(outStream);
+	if (!outStream.good())
+		throw runtime_error("Error while serializing a film");
 
-	outArchive << film;
+	// Copy the archive and the pixels of each frame buffer in the snapshot.
+	// The film is only read so, with a shared film, the render threads can
+	// keep adding samples while the pixels are copied.
+	auto_ptr<ChunkFileWriter> writer(new ChunkFileWriter(compress));
 
-	if (!outStream.good())
-		throw runtime_error("Error while saving serialized film: " + fileName);
+	const string archiveData = outStream.str();
+	writer->AddBlock(archiveData.data(), archiveData.size());
+
+	FrameBufferBlockWriter blockWriter(*writer);
+	VisitFrameBuffers(const_cast<Film *>(film), blockWriter);
+
+	return writer.release();
+}
 
-	flush(outStream);
+void Film::SaveSerialized(const std::string &fileName, const Film *film) {
+	auto_ptr<ChunkFileWriter> writer(AllocSerializedSnapshot(film));
+
+	const double startTime = WallClockTime();
+	writer->Write(fileName);
 
-	const streamoff size = outFile.tellp() - startPosition;
-	SLG_LOG("Film saved: " << (size / 1024) << " Kbytes");
+	SLG_LOG("Film saved in " << (WallClockTime() - startTime) << " secs");
 }
 
 template<class Archive> void Film::load(Archive &ar, const u_int version) {
@@ -141,6 +273,9 @@ template<class Archive> void Film::load(Archive &ar, const u_int version) {
 	ar & initialized;
 	ar & enabledOverlappedScreenBufferUpdate;
 
+	FreeDirtyRows();
+	AllocDirtyRows();
+
 	SetUpOCL();
 }
 
@@ -184,7 +319,9 @@ template<class Archive> void Film::save(Archive &ar, const u_int version) const
 	ar & maskMaterialIDs;
 	ar & byMaterialIDs;
 
-	ar & statsTotalSampleCount;
+	// Include the samples counted in thread safe mode
+	const double totalSampleCount = GetTotalSampleCount();
+	ar & totalSampleCount;
 	ar & statsStartSampleTime;
 	ar & statsAvgSampleSec;
 
@@ -30,6 +30,7 @@
 
 #include "slg/imagemap/imagemap.h"
 #include "slg/imagemap/imagemapcache.h"
+#include "slg/imagemap/imagemaptilecache.h"
 #include "slg/core/sdl.h"
 #include "luxrays/utils/properties.h"
 
@@ -90,6 +91,29 @@ ImageMapStorage::ChannelSelectionType ImageMapStorage::String2ChannelSelectionTy
 		throw runtime_error("Unknown channel selection type in imagemap: " + type);
 }
 
+string ImageMapStorage::ChannelSelectionType2String(const ChannelSelectionType type) {
+	switch (type) {
+		case ImageMapStorage::DEFAULT:
+			return "default";
+		case ImageMapStorage::RED:
+			return "red";
+		case ImageMapStorage::GREEN:
+			return "green";
+		case ImageMapStorage::BLUE:
+			return "blue";
+		case ImageMapStorage::ALPHA:
+			return "alpha";
+		case ImageMapStorage::MEAN:
+			return "mean";
+		case ImageMapStorage::WEIGHTED_MEAN:
+			return "colored_mean";
+		case ImageMapStorage::RGB:
+			return "rgb";
+		default:
+			throw runtime_error("Unknown channel selection type in ImageMapStorage::ChannelSelectionType2String(): " + ToString(type));
+	}
+}
+
 //------------------------------------------------------------------------------
 // ImageMapStorageImpl
 //------------------------------------------------------------------------------
@@ -521,8 +545,35 @@ float ImageMap::CalcSpectrumMeanY() const {
 }
 
 void ImageMap::Preprocess() {
-	imageMean = CalcSpectrumMean();
-	imageMeanY = CalcSpectrumMeanY();
+	const ImageMapTiledStorage *tiledStorage = dynamic_cast<const ImageMapTiledStorage *>(pixelStorage);
+	if (tiledStorage) {
+		// Avoid to read all the tiles of the image
+		const Spectrum mean = tiledStorage->GetSpectrumMean();
+		imageMean = mean.Filter();
+		imageMeanY = mean.Y();
+	} else {
+		imageMean = CalcSpectrumMean();
+		imageMeanY = CalcSpectrumMeanY();
+	}
+}
+
+bool ImageMap::IsTiled() const {
+	return (dynamic_cast<const ImageMapTiledStorage *>(pixelStorage) != NULL);
+}
+
+ImageMap *ImageMap::AllocTiledImageMap(ImageMapTileCache *tileCache,
+		const string &fileName, const float gamma,
+		const ImageMapStorage::StorageType storageType) {
+	ImageMapTiledStorage *tiledStorage = ImageMapTiledStorage::Create(tileCache, fileName, storageType);
+	if (!tiledStorage)
+		return NULL;
+
+	tiledStorage->ReverseGammaCorrection(gamma);
+
+	ImageMap *imgMap = new ImageMap(tiledStorage, gamma);
+	imgMap->Preprocess();
+
+	return imgMap;
 }
 
 void ImageMap::SelectChannel(const ImageMapStorage::ChannelSelectionType selectionType) {
@@ -549,6 +600,13 @@ void ImageMap::Resize(const u_int newWidth, const u_int newHeight) {
 	if ((width == newWidth) && (height == newHeight))
 		return;
 
+	// The MIP levels of tiled image maps are already used to reduce the
+	// memory usage
+	if (IsTiled()) {
+		SDL_LOG("Tiled image maps can not be resized");
+		return;
+	}
+
 	ImageMapStorage::StorageType storageType = pixelStorage->GetStorageType();
 	const u_int channelCount = pixelStorage->GetChannelCount();
 
@@ -621,6 +679,11 @@ string ImageMap::GetFileExtension() const {
 }
 
 void ImageMap::WriteImage(const string &fileName) const {
+	if (IsTiled()) {
+		((const ImageMapTiledStorage *)pixelStorage)->WriteImage(fileName);
+		return;
+	}
+
 	ImageOutput *out = ImageOutput::create(fileName);
 	if (out) {
 		ImageMapStorage::StorageType storageType = pixelStorage->GetStorageType();
@@ -686,6 +749,22 @@ ImageMap *ImageMap::Copy() const {
 Properties ImageMap::ToProperties(const std::string &prefix) const {
 	Properties props;
 
+	if (IsTiled()) {
+		// A reference to the tiled MIP-mapped file, the pixels are not loaded
+		const ImageMapTiledStorage *tiledStorage = (const ImageMapTiledStorage *)pixelStorage;
+		const vector<ImageMapStorage::ChannelSelectionType> &channelSelections = tiledStorage->GetChannelSelections();
+
+		props <<
+				Property(prefix + ".file")(tiledStorage->GetFileName()) <<
+				Property(prefix + ".gamma")(tiledStorage->GetGamma()) <<
+				Property(prefix + ".storage")(ImageMapStorage::StorageType2String(pixelStorage->GetStorageType()));
+		// ImageMapCache selects the channel only once
+		if (channelSelections.size() > 0)
+			props << Property(prefix + ".channel")(ImageMapStorage::ChannelSelectionType2String(channelSelections.back()));
+
+		return props;
+	}
+
 	props <<
 			Property(prefix + ".gamma")(1.f) <<
 			Property(prefix + ".storage")(ImageMapStorage::StorageType2String(pixelStorage->GetStorageType())) <<
@@ -20,6 +20,7 @@
 #include <boost/lexical_cast.hpp>
 
 #include "slg/imagemap/imagemapcache.h"
+#include "slg/imagemap/imagemaptilecache.h"
 #include "slg/core/sdl.h"
 
 using namespace std;
@@ -32,18 +33,34 @@ using namespace slg;
 
 ImageMapCache::ImageMapCache() {
 	allImageScale = 1.f;
+	tileCache = NULL;
 }
 
 ImageMapCache::~ImageMapCache() {
 	BOOST_FOREACH(ImageMap *m, maps)
 		delete m;
+
+	// The tile cache has to be deleted after the tiled image maps
+	delete tileCache;
+}
+
+void ImageMapCache::EnableTileCache(const size_t maxMemorySize, const string &cacheDir) {
+	if (tileCache) {
+		if ((tileCache->GetMaxMemorySize() == maxMemorySize) &&
+				(tileCache->GetCacheDir() == cacheDir))
+			return;
+		throw runtime_error("The image map tile cache can not be changed once enabled");
+	}
+
+	SDL_LOG("Image map tile cache size: " << (maxMemorySize / (1024 * 1024)) << " Mbytes");
+	tileCache = new ImageMapTileCache(maxMemorySize, cacheDir);
 }
 
 string ImageMapCache::GetCacheKey(const string &fileName, const float gamma,
 		const ImageMapStorage::ChannelSelectionType selectionType,
-		const ImageMapStorage::StorageType storageType) const {
+		const ImageMapStorage::StorageType storageType, const bool tiled) const {
 	return fileName + "_#_" + ToString(gamma) + "_#_" + ToString(selectionType) +
-			"_#_" + ToString(storageType);
+			"_#_" + ToString(storageType) + (tiled ? "_#_tiled" : "");
 }
 
 string ImageMapCache::GetCacheKey(const string &fileName) const {
@@ -52,7 +69,8 @@ string ImageMapCache::GetCacheKey(const string &fileName) const {
 
 ImageMap *ImageMapCache::GetImageMap(const string &fileName, const float gamma,
 		const ImageMapStorage::ChannelSelectionType selectionType,
-		const ImageMapStorage::StorageType storageType) {
+		const ImageMapStorage::StorageType storageType,
+		const bool enableTileCache) {
 	// Compose the cache key
 	string key = GetCacheKey(fileName);
 
@@ -66,7 +84,10 @@ ImageMap *ImageMapCache::GetImageMap(const string &fileName, const float gamma,
 	}
 
 	// Check if it is a reference to a file
-	key = GetCacheKey(fileName, gamma, selectionType, storageType);
+	// (the tiled image maps can not be used everywhere so they have their own
+	// cache entries)
+	const bool tiled = enableTileCache && tileCache;
+	key = GetCacheKey(fileName, gamma, selectionType, storageType, tiled);
 	it = mapByName.find(key);
 
 	if (it != mapByName.end()) {
@@ -77,7 +98,20 @@ ImageMap *ImageMapCache::GetImageMap(const string &fileName, const float gamma,
 
 	// I haven't yet loaded the file
 
-	ImageMap *im = new ImageMap(fileName, gamma, storageType);
+	ImageMap *im = NULL;
+	if (tiled) {
+		im = ImageMap::AllocTiledImageMap(tileCache, fileName, gamma, storageType);
+		if (im) {
+			im->SelectChannel(selectionType);
+
+			mapByName.insert(make_pair(key, im));
+			maps.push_back(im);
+
+			return im;
+		}
+	}
+
+	im = new ImageMap(fileName, gamma, storageType);
 	im->SelectChannel(selectionType);
 
 	// Scale the image if required
@@ -0,0 +1,743 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+
+#include <memory>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+
+#include <OpenImageIO/imagebufalgo.h>
+
+#include "slg/imagemap/imagemaptilecache.h"
+#include "slg/core/sdl.h"
+
+using namespace std;
+using namespace luxrays;
+using namespace slg;
+OIIO_NAMESPACE_USING
+
+//------------------------------------------------------------------------------
+// ImageMapTileCache
+//------------------------------------------------------------------------------
+
+boost::atomic<u_int> ImageMapTileCache::generation(0);
+
+ImageMapTileCache::ImageMapTileCache(const size_t maxSize, const string &dir) :
+		maxMemorySize(maxSize), cacheDir(dir) {
+	maxShardMemorySize = maxMemorySize / IMAGEMAPTILECACHE_SHARD_COUNT;
+
+	generation.fetch_add(1, boost::memory_order_release);
+}
+
+ImageMapTileCache::~ImageMapTileCache() {
+}
+
+const ImageMapStorage *ImageMapTileCache::GetTile(const ImageMapTiledStorage *storage,
+		const u_int level, const u_int tileX, const u_int tileY) {
+	const TileKey key(storage, level, tileX, tileY);
+
+	ThreadTileCache *threadCache = threadTileCaches.get();
+	if (!threadCache) {
+		threadCache = new ThreadTileCache();
+		threadTileCaches.reset(threadCache);
+	}
+
+	// The generation is read before looking up the shard so a tile fetched
+	// while another thread is flushing its image map is not used again
+	const u_int currentGeneration = generation.load(boost::memory_order_acquire);
+	for (u_int i = 0; i < IMAGEMAPTILECACHE_THREAD_TILE_COUNT; ++i) {
+		if (threadCache->tiles[i] && (threadCache->generations[i] == currentGeneration) &&
+				(threadCache->keys[i] == key))
+			return threadCache->tiles[i].get();
+	}
+
+	const u_int index = threadCache->nextTile;
+	threadCache->nextTile = (index + 1) % IMAGEMAPTILECACHE_THREAD_TILE_COUNT;
+
+	threadCache->keys[index] = key;
+	threadCache->generations[index] = currentGeneration;
+	threadCache->tiles[index] = GetSharedTile(key);
+
+	return threadCache->tiles[index].get();
+}
+
+boost::shared_ptr<const ImageMapStorage> ImageMapTileCache::GetSharedTile(const TileKey &key) {
+	Shard &shard = shards[hash_value(key) % IMAGEMAPTILECACHE_SHARD_COUNT];
+
+	{
+		boost::unique_lock<boost::mutex> lock(shard.shardMutex);
+
+		boost::unordered_map<TileKey, TileList::iterator>::const_iterator it = shard.tilesByKey.find(key);
+		if (it != shard.tilesByKey.end()) {
+			// Move the tile at the beginning of the LRU list
+			shard.tiles.splice(shard.tiles.begin(), shard.tiles, it->second);
+			return it->second->second;
+		}
+	}
+
+	// The tile is loaded without holding the lock so the other threads can
+	// keep on using the shard
+	boost::shared_ptr<const ImageMapStorage> tile(key.storage->LoadTile(key.level, key.tileX, key.tileY));
+
+	boost::unique_lock<boost::mutex> lock(shard.shardMutex);
+
+	// Another thread may have loaded the same tile in the meantime
+	boost::unordered_map<TileKey, TileList::iterator>::const_iterator it = shard.tilesByKey.find(key);
+	if (it != shard.tilesByKey.end()) {
+		shard.tiles.splice(shard.tiles.begin(), shard.tiles, it->second);
+		return it->second->second;
+	}
+
+	shard.tiles.push_front(make_pair(key, tile));
+	shard.tilesByKey.insert(make_pair(key, shard.tiles.begin()));
+	shard.memorySize += tile->GetMemorySize();
+
+	// Evict the least recently used tiles if required (the tiles still in use
+	// are freed by the last shared_ptr)
+	while ((shard.memorySize > maxShardMemorySize) && (shard.tiles.size() > 1)) {
+		const TileList::value_type &lru = shard.tiles.back();
+
+		shard.memorySize -= lru.second->GetMemorySize();
+		shard.tilesByKey.erase(lru.first);
+		shard.tiles.pop_back();
+	}
+
+	return tile;
+}
+
+void ImageMapTileCache::Flush(const ImageMapTiledStorage *storage) {
+	for (u_int i = 0; i < IMAGEMAPTILECACHE_SHARD_COUNT; ++i) {
+		Shard &shard = shards[i];
+		boost::unique_lock<boost::mutex> lock(shard.shardMutex);
+
+		for (TileList::iterator it = shard.tiles.begin(); it != shard.tiles.end();) {
+			if (it->first.storage == storage) {
+				shard.memorySize -= it->second->GetMemorySize();
+				shard.tilesByKey.erase(it->first);
+				it = shard.tiles.erase(it);
+			} else
+				++it;
+		}
+	}
+
+	// Invalidate the tiles in the thread caches
+	generation.fetch_add(1, boost::memory_order_release);
+}
+
+size_t ImageMapTileCache::GetMemorySize() {
+	size_t size = 0;
+	for (u_int i = 0; i < IMAGEMAPTILECACHE_SHARD_COUNT; ++i) {
+		boost::unique_lock<boost::mutex> lock(shards[i].shardMutex);
+		size += shards[i].memorySize;
+	}
+
+	return size;
+}
+
+//------------------------------------------------------------------------------
+// ImageMapTiledStorage
+//------------------------------------------------------------------------------
+
+static size_t GetStorageTypeSize(const ImageMapStorage::StorageType storageType) {
+	switch (storageType) {
+		case ImageMapStorage::BYTE:
+			return sizeof(u_char);
+		case ImageMapStorage::HALF:
+			return sizeof(half);
+		case ImageMapStorage::FLOAT:
+			return sizeof(float);
+		default:
+			throw runtime_error("Unsupported storage type in an ImageMapTiledStorage: " + ToString(storageType));
+	}
+}
+
+static TypeDesc::BASETYPE GetStorageTypeDesc(const ImageMapStorage::StorageType storageType) {
+	switch (storageType) {
+		case ImageMapStorage::BYTE:
+			return TypeDesc::UCHAR;
+		case ImageMapStorage::HALF:
+			return TypeDesc::HALF;
+		case ImageMapStorage::FLOAT:
+			return TypeDesc::FLOAT;
+		default:
+			throw runtime_error("Unsupported storage type in an ImageMapTiledStorage: " + ToString(storageType));
+	}
+}
+
+static ImageMapStorage *AllocStorage(const ImageMapStorage::StorageType storageType,
+		const u_int channels, const u_int width, const u_int height) {
+	switch (storageType) {
+		case ImageMapStorage::BYTE:
+			return AllocImageMapStorage<u_char>(channels, width, height);
+		case ImageMapStorage::HALF:
+			return AllocImageMapStorage<half>(channels, width, height);
+		case ImageMapStorage::FLOAT:
+			return AllocImageMapStorage<float>(channels, width, height);
+		default:
+			throw runtime_error("Unsupported storage type in an ImageMapTiledStorage: " + ToString(storageType));
+	}
+}
+
+// ImageMapStorageImpl::ReverseGammaCorrection() uses OpenMP and it isn't a
+// good idea to start a parallel region for each tile loaded by a rendering
+// thread
+template <class T, u_int CHANNELS> static void TileReverseGammaCorrection(void *pixelsData,
+		const u_int pixelCount, const float gamma) {
+	ImageMapPixel<T, CHANNELS> *pixels = (ImageMapPixel<T, CHANNELS> *)pixelsData;
+	for (u_int i = 0; i < pixelCount; ++i)
+		pixels[i].ReverseGammaCorrection(gamma);
+}
+
+template <class T> static void TileReverseGammaCorrection(ImageMapStorage *tile, const float gamma) {
+	const u_int pixelCount = tile->width * tile->height;
+
+	switch (tile->GetChannelCount()) {
+		case 1:
+			TileReverseGammaCorrection<T, 1>(tile->GetPixelsData(), pixelCount, gamma);
+			break;
+		case 2:
+			TileReverseGammaCorrection<T, 2>(tile->GetPixelsData(), pixelCount, gamma);
+			break;
+		case 3:
+			TileReverseGammaCorrection<T, 3>(tile->GetPixelsData(), pixelCount, gamma);
+			break;
+		case 4:
+			TileReverseGammaCorrection<T, 4>(tile->GetPixelsData(), pixelCount, gamma);
+			break;
+		default:
+			throw runtime_error("Unsupported number of channels in an ImageMapTiledStorage: " + ToString(tile->GetChannelCount()));
+	}
+}
+
+static u_int SelectChannelCount(const u_int channelCount,
+		const ImageMapStorage::ChannelSelectionType selectionType) {
+	// It must match what ImageMapStorageImpl::SelectChannel() does
+	switch (selectionType) {
+		case ImageMapStorage::DEFAULT:
+			return channelCount;
+		case ImageMapStorage::RED:
+		case ImageMapStorage::GREEN:
+		case ImageMapStorage::BLUE:
+		case ImageMapStorage::ALPHA:
+		case ImageMapStorage::MEAN:
+		case ImageMapStorage::WEIGHTED_MEAN:
+			return 1;
+		case ImageMapStorage::RGB:
+			return (channelCount == 4) ? 3 : channelCount;
+		default:
+			throw runtime_error("Unknown channel selection type in an ImageMap: " + ToString(selectionType));
+	}
+}
+
+static string GetTxFileName(const string &fileName, const string &cacheDir) {
+	if (cacheDir.empty())
+		return fileName + ".tx";
+
+	// The hash of the full path avoids the collisions among the images with
+	// the same name in different directories
+	const boost::filesystem::path filePath = boost::filesystem::absolute(fileName);
+	const size_t pathHash = boost::hash<string>()(filePath.generic_string());
+
+	boost::filesystem::create_directories(cacheDir);
+
+	return (boost::filesystem::path(cacheDir) /
+			(filePath.stem().string() + "-" + (boost::format("%016x") % (u_longlong)pathHash).str() +
+			filePath.extension().string() + ".tx")).generic_string();
+}
+
+static bool IsTiledMipMapped(const string &fileName) {
+	auto_ptr<ImageInput> in(ImageInput::open(fileName));
+	if (!in.get())
+		return false;
+
+	ImageSpec spec;
+	const bool result = (in->spec().tile_width > 0) && (in->spec().tile_height > 0) &&
+			in->seek_subimage(0, 1, spec);
+	in->close();
+
+	return result;
+}
+
+ImageMapTiledStorage::ImageMapTiledStorage(ImageMapTileCache *tc, const string &txName,
+		const StorageType st, const u_int fileChannels,
+		const u_int tileW, const u_int tileH,
+		const vector<MipLevel> &ls) : ImageMapStorage(ls[0].width, ls[0].height),
+		tileCache(tc), txFileName(txName), storageType(st),
+		fileChannelCount(fileChannels), channelCount(fileChannels),
+		tileWidth(tileW), tileHeight(tileH), levels(ls), gamma(1.f) {
+}
+
+ImageMapTiledStorage::~ImageMapTiledStorage() {
+	tileCache->Flush(this);
+}
+
+ImageMapTiledStorage *ImageMapTiledStorage::Create(ImageMapTileCache *tileCache,
+		const string &fileName, const StorageType storageType) {
+	if (!boost::filesystem::exists(fileName))
+		throw runtime_error("ImageMap file doesn't exist: " + fileName);
+
+	// Use the image file directly if it is already tiled and MIP-mapped or
+	// write a .tx version otherwise
+	string txFileName = fileName;
+	if (!IsTiledMipMapped(fileName)) {
+		txFileName = GetTxFileName(fileName, tileCache->GetCacheDir());
+
+		if (!boost::filesystem::exists(txFileName) ||
+				(boost::filesystem::last_write_time(txFileName) < boost::filesystem::last_write_time(fileName))) {
+			SDL_LOG("Writing tiled MIP-mapped texture map: " << txFileName);
+
+			ImageSpec config;
+			config.tile_width = 64;
+			config.tile_height = 64;
+			config.tile_depth = 1;
+			config.attribute("oiio:UnassociatedAlpha", 1);
+			if (!ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, fileName, txFileName, config)) {
+				SDL_LOG("WARNING: unable to write the tiled MIP-mapped texture map " << txFileName <<
+						" (" << OIIO::geterror() << "), the image will be loaded in memory");
+				return NULL;
+			}
+		}
+	}
+
+	SDL_LOG("Reading tiled texture map: " << txFileName);
+
+	ImageSpec config;
+	config.attribute("oiio:UnassociatedAlpha", 1);
+	auto_ptr<ImageInput> in(ImageInput::open(txFileName, &config));
+	if (!in.get())
+		throw runtime_error("Unknown image file format: " + txFileName);
+
+	const ImageSpec &spec = in->spec();
+	const u_int channelCount = spec.nchannels;
+	if ((channelCount != 1) && (channelCount != 2) &&
+			(channelCount != 3) && (channelCount != 4))
+		throw runtime_error("Unsupported number of channels in an ImageMap: " + ToString(channelCount));
+
+	const u_int tileWidth = spec.tile_width;
+	const u_int tileHeight = spec.tile_height;
+	if ((tileWidth == 0) || (tileHeight == 0)) {
+		SDL_LOG("WARNING: the texture map " << txFileName << " isn't tiled, the image will be loaded in memory");
+		return NULL;
+	}
+
+	// Anything not TypeDesc::UCHAR or TypeDesc::HALF, is stored in float format
+	StorageType selectedStorageType = storageType;
+	if (selectedStorageType == ImageMapStorage::AUTO) {
+		if (spec.format == TypeDesc::UCHAR)
+			selectedStorageType = ImageMapStorage::BYTE;
+		else if (spec.format == TypeDesc::HALF)
+			selectedStorageType = ImageMapStorage::HALF;
+		else
+			selectedStorageType = ImageMapStorage::FLOAT;
+	}
+
+	vector<MipLevel> levels;
+	ImageSpec levelSpec;
+	for (int level = 0; in->seek_subimage(0, level, levelSpec); ++level) {
+		MipLevel l;
+		l.width = levelSpec.width;
+		l.height = levelSpec.height;
+		l.tileCountX = (l.width + tileWidth - 1) / tileWidth;
+		l.tileCountY = (l.height + tileHeight - 1) / tileHeight;
+
+		levels.push_back(l);
+	}
+	in->close();
+
+	return new ImageMapTiledStorage(tileCache, txFileName, selectedStorageType,
+			channelCount, tileWidth, tileHeight, levels);
+}
+
+ImageMapStorage *ImageMapTiledStorage::LoadTile(const u_int level,
+		const u_int tileX, const u_int tileY) const {
+	auto_ptr<ImageMapStorage> tile(AllocStorage(storageType, fileChannelCount, tileWidth, tileHeight));
+
+	{
+		boost::unique_lock<boost::mutex> lock(imageInputMutex);
+
+		if (!imageInput.get()) {
+			ImageSpec config;
+			config.attribute("oiio:UnassociatedAlpha", 1);
+			imageInput.reset(ImageInput::open(txFileName, &config));
+			if (!imageInput.get())
+				throw runtime_error("Unable to open the texture map: " + txFileName);
+		}
+
+		ImageSpec spec;
+		if (!imageInput->seek_subimage(0, level, spec))
+			throw runtime_error("Unable to read the MIP level " + ToString(level) + " of the texture map: " + txFileName);
+
+		if (!imageInput->read_tile(spec.x + tileX * tileWidth, spec.y + tileY * tileHeight, spec.z,
+				GetStorageTypeDesc(storageType), tile->GetPixelsData()))
+			throw runtime_error("Error while reading a tile of the texture map " + txFileName +
+					": " + imageInput->geterror());
+	}
+
+	if (gamma != 1.f) {
+		switch (storageType) {
+			case ImageMapStorage::BYTE:
+				TileReverseGammaCorrection<u_char>(tile.get(), gamma);
+				break;
+			case ImageMapStorage::HALF:
+				TileReverseGammaCorrection<half>(tile.get(), gamma);
+				break;
+			case ImageMapStorage::FLOAT:
+				TileReverseGammaCorrection<float>(tile.get(), gamma);
+				break;
+			default:
+				throw runtime_error("Unsupported storage type in an ImageMapTiledStorage: " + ToString(storageType));
+		}
+	}
+
+	BOOST_FOREACH(const ChannelSelectionType selectionType, channelSelections) {
+		ImageMapStorage *newTile = tile->SelectChannel(selectionType);
+		if (newTile)
+			tile.reset(newTile);
+	}
+
+	return tile.release();
+}
+
+ImageMapStorage *ImageMapTiledStorage::SelectChannel(const ChannelSelectionType selectionType) const {
+	const u_int newChannelCount = SelectChannelCount(channelCount, selectionType);
+	if (newChannelCount == channelCount) {
+		// Nothing to do
+		return NULL;
+	}
+
+	ImageMapTiledStorage *storage = (ImageMapTiledStorage *)Copy();
+	storage->channelSelections.push_back(selectionType);
+	storage->channelCount = newChannelCount;
+
+	return storage;
+}
+
+size_t ImageMapTiledStorage::GetMemorySize() const {
+	return width * height * channelCount * GetStorageTypeSize(storageType);
+}
+
+void ImageMapTiledStorage::ReverseGammaCorrection(const float g) {
+	// The gamma correction is applied before the channel selection: it is
+	// the same order used by ImageMap
+	if (g != 1.f) {
+		gamma *= g;
+		tileCache->Flush(this);
+	}
+}
+
+ImageMapStorage *ImageMapTiledStorage::Copy() const {
+	ImageMapTiledStorage *storage = new ImageMapTiledStorage(tileCache, txFileName,
+			storageType, fileChannelCount, tileWidth, tileHeight, levels);
+	storage->channelCount = channelCount;
+	storage->gamma = gamma;
+	storage->channelSelections = channelSelections;
+
+	return storage;
+}
+
+const ImageMapStorage *ImageMapTiledStorage::GetTexelTile(const u_int level,
+		const int s, const int t, u_int *index) const {
+	const MipLevel &l = levels[level];
+	const u_int u = Mod<int>(s, l.width);
+	const u_int v = Mod<int>(t, l.height);
+
+	const u_int tileX = u / tileWidth;
+	const u_int tileY = v / tileHeight;
+	*index = (v - tileY * tileHeight) * tileWidth + (u - tileX * tileWidth);
+
+	return tileCache->GetTile(this, level, tileX, tileY);
+}
+
+void ImageMapTiledStorage::GetBilinearTexels(const u_int level, const UV &uv,
+		const ImageMapStorage *tiles[4],
+		u_int indices[4], float weights[4]) const {
+	const MipLevel &l = levels[level];
+
+	const float s = uv.u * l.width - .5f;
+	const float t = uv.v * l.height - .5f;
+
+	const int s0 = Floor2Int(s);
+	const int t0 = Floor2Int(t);
+
+	const float ds = s - s0;
+	const float dt = t - t0;
+
+	const float ids = 1.f - ds;
+	const float idt = 1.f - dt;
+
+	const u_int u[2] = { (u_int)Mod<int>(s0, l.width), (u_int)Mod<int>(s0 + 1, l.width) };
+	const u_int v[2] = { (u_int)Mod<int>(t0, l.height), (u_int)Mod<int>(t0 + 1, l.height) };
+	weights[0] = ids * idt;
+	weights[1] = ids * dt;
+	weights[2] = ds * idt;
+	weights[3] = ds * dt;
+
+	// The 4 texels are usually in the same tile so the cache is looked up
+	// only when the tile changes
+	u_int lastTileX = 0, lastTileY = 0;
+	for (u_int i = 0; i < 4; ++i) {
+		const u_int x = u[i >> 1];
+		const u_int y = v[i & 1];
+		const u_int tileX = x / tileWidth;
+		const u_int tileY = y / tileHeight;
+
+		if ((i > 0) && (tileX == lastTileX) && (tileY == lastTileY))
+			tiles[i] = tiles[i - 1];
+		else {
+			tiles[i] = tileCache->GetTile(this, level, tileX, tileY);
+			lastTileX = tileX;
+			lastTileY = tileY;
+		}
+
+		indices[i] = (y - tileY * tileHeight) * tileWidth + (x - tileX * tileWidth);
+	}
+}
+
+float ImageMapTiledStorage::GetTexelFloat(const u_int level, const int s, const int t) const {
+	u_int index;
+	const ImageMapStorage *tile = GetTexelTile(level, s, t, &index);
+
+	return tile->GetFloat(index);
+}
+
+float ImageMapTiledStorage::GetFloat(const u_int level, const UV &uv) const {
+	const ImageMapStorage *tiles[4];
+	u_int indices[4];
+	float weights[4];
+	GetBilinearTexels(level, uv, tiles, indices, weights);
+
+	return weights[0] * tiles[0]->GetFloat(indices[0]) +
+			weights[1] * tiles[1]->GetFloat(indices[1]) +
+			weights[2] * tiles[2]->GetFloat(indices[2]) +
+			weights[3] * tiles[3]->GetFloat(indices[3]);
+}
+
+Spectrum ImageMapTiledStorage::GetSpectrum(const u_int level, const UV &uv) const {
+	const ImageMapStorage *tiles[4];
+	u_int indices[4];
+	float weights[4];
+	GetBilinearTexels(level, uv, tiles, indices, weights);
+
+	return weights[0] * tiles[0]->GetSpectrum(indices[0]) +
+			weights[1] * tiles[1]->GetSpectrum(indices[1]) +
+			weights[2] * tiles[2]->GetSpectrum(indices[2]) +
+			weights[3] * tiles[3]->GetSpectrum(indices[3]);
+}
+
+float ImageMapTiledStorage::GetAlpha(const u_int level, const UV &uv) const {
+	const ImageMapStorage *tiles[4];
+	u_int indices[4];
+	float weights[4];
+	GetBilinearTexels(level, uv, tiles, indices, weights);
+
+	return weights[0] * tiles[0]->GetAlpha(indices[0]) +
+			weights[1] * tiles[1]->GetAlpha(indices[1]) +
+			weights[2] * tiles[2]->GetAlpha(indices[2]) +
+			weights[3] * tiles[3]->GetAlpha(indices[3]);
+}
+
+u_int ImageMapTiledStorage::GetMipLevels(const float footprint, u_int *level1, float *t) const {
+	const u_int maxLevel = levels.size() - 1;
+	const float level = Clamp(Log2(Max(footprint * Max(width, height), 1.f)), 0.f, (float)maxLevel);
+
+	const u_int level0 = Min(Floor2UInt(level), maxLevel);
+	*level1 = Min(level0 + 1, maxLevel);
+	*t = level - level0;
+
+	return level0;
+}
+
+float ImageMapTiledStorage::GetFloat(const UV &uv) const {
+	return GetFloat(0u, uv);
+}
+
+float ImageMapTiledStorage::GetFloat(const u_int index) const {
+	u_int tileIndex;
+	const ImageMapStorage *tile = GetTexelTile(0, index % width, index / width, &tileIndex);
+
+	return tile->GetFloat(tileIndex);
+}
+
+float ImageMapTiledStorage::GetFloat(const UV &uv, const float footprint) const {
+	u_int level1;
+	float t;
+	const u_int level0 = GetMipLevels(footprint, &level1, &t);
+
+	const float v0 = GetFloat(level0, uv);
+	return (t > 0.f) ? Lerp(t, v0, GetFloat(level1, uv)) : v0;
+}
+
+Spectrum ImageMapTiledStorage::GetSpectrum(const UV &uv) const {
+	return GetSpectrum(0u, uv);
+}
+
+Spectrum ImageMapTiledStorage::GetSpectrum(const u_int index) const {
+	u_int tileIndex;
+	const ImageMapStorage *tile = GetTexelTile(0, index % width, index / width, &tileIndex);
+
+	return tile->GetSpectrum(tileIndex);
+}
+
+Spectrum ImageMapTiledStorage::GetSpectrum(const UV &uv, const float footprint) const {
+	u_int level1;
+	float t;
+	const u_int level0 = GetMipLevels(footprint, &level1, &t);
+
+	const Spectrum v0 = GetSpectrum(level0, uv);
+	return (t > 0.f) ? Lerp(t, v0, GetSpectrum(level1, uv)) : v0;
+}
+
+float ImageMapTiledStorage::GetAlpha(const UV &uv) const {
+	return GetAlpha(0u, uv);
+}
+
+float ImageMapTiledStorage::GetAlpha(const u_int index) const {
+	u_int tileIndex;
+	const ImageMapStorage *tile = GetTexelTile(0, index % width, index / width, &tileIndex);
+
+	return tile->GetAlpha(tileIndex);
+}
+
+float ImageMapTiledStorage::GetAlpha(const UV &uv, const float footprint) const {
+	u_int level1;
+	float t;
+	const u_int level0 = GetMipLevels(footprint, &level1, &t);
+
+	const float v0 = GetAlpha(level0, uv);
+	return (t > 0.f) ? Lerp(t, v0, GetAlpha(level1, uv)) : v0;
+}
+
+UV ImageMapTiledStorage::GetDuv(const UV &uv) const {
+	const float s = uv.u * width;
+	const float t = uv.v * height;
+
+	const int is = Floor2Int(s);
+	const int it = Floor2Int(t);
+
+	const float as = s - is;
+	const float at = t - it;
+
+	int s0, s1;
+	if (as < .5f) {
+		s0 = is - 1;
+		s1 = is;
+	} else {
+		s0 = is;
+		s1 = is + 1;
+	}
+	int t0, t1;
+	if (at < .5f) {
+		t0 = it - 1;
+		t1 = it;
+	} else {
+		t0 = it;
+		t1 = it + 1;
+	}
+
+	UV duv;
+	duv.u = Lerp(at, GetTexelFloat(0, s1, it) - GetTexelFloat(0, s0, it),
+		GetTexelFloat(0, s1, it + 1) - GetTexelFloat(0, s0, it + 1)) *
+		width;
+	duv.v = Lerp(as, GetTexelFloat(0, is, t1) - GetTexelFloat(0, is, t0),
+		GetTexelFloat(0, is + 1, t1) - GetTexelFloat(0, is + 1, t0)) *
+		height;
+	return duv;
+}
+
+UV ImageMapTiledStorage::GetDuv(const u_int index) const {
+	const UV uv(((index % width) + .5f) / width, ((index / width) + .5f) / height);
+	return GetDuv(uv);
+}
+
+Spectrum ImageMapTiledStorage::GetSpectrumMean() const {
+	// Use the first MIP level small enough to be read quickly
+	u_int level = 0;
+	while ((level < levels.size() - 1) &&
+			(levels[level].width * levels[level].height > tileWidth * tileHeight * 16))
+		++level;
+
+	const MipLevel &l = levels[level];
+	Spectrum mean;
+	for (u_int tileY = 0; tileY < l.tileCountY; ++tileY) {
+		for (u_int tileX = 0; tileX < l.tileCountX; ++tileX) {
+			auto_ptr<ImageMapStorage> tile(LoadTile(level, tileX, tileY));
+
+			const u_int x0 = tileX * tileWidth;
+			const u_int y0 = tileY * tileHeight;
+			const u_int x1 = Min(x0 + tileWidth, l.width);
+			const u_int y1 = Min(y0 + tileHeight, l.height);
+			for (u_int y = y0; y < y1; ++y)
+				for (u_int x = x0; x < x1; ++x)
+					mean += tile->GetSpectrum((y - y0) * tileWidth + (x - x0));
+		}
+	}
+
+	return mean / (l.width * l.height);
+}
+
+void ImageMapTiledStorage::WriteImage(const string &fileName) const {
+	auto_ptr<ImageOutput> out(ImageOutput::create(fileName));
+	if (!out.get())
+		throw runtime_error("Failed image save: " + fileName);
+
+	// OIIO 1 channel EXR output is apparently not working, I write 3 channels
+	// as temporary workaround (like ImageMap::WriteImage())
+	const u_int outChannelCount = ((storageType == ImageMapStorage::FLOAT) && (channelCount == 1)) ?
+		3 : channelCount;
+	const TypeDesc::BASETYPE typeDesc = GetStorageTypeDesc(storageType);
+	const size_t channelSize = GetStorageTypeSize(storageType);
+	const size_t pixelSize = channelCount * channelSize;
+	const size_t outPixelSize = outChannelCount * channelSize;
+
+	ImageSpec spec(width, height, outChannelCount, typeDesc);
+	if (!out->open(fileName, spec))
+		throw runtime_error("Failed image save: " + fileName + " (" + out->geterror() + ")");
+
+	// A row of tiles
+	vector<char> rows(width * tileHeight * outPixelSize);
+
+	const MipLevel &l = levels[0];
+	for (u_int tileY = 0; tileY < l.tileCountY; ++tileY) {
+		const u_int y0 = tileY * tileHeight;
+		const u_int rowCount = Min(tileHeight, height - y0);
+
+		for (u_int tileX = 0; tileX < l.tileCountX; ++tileX) {
+			// The tile is not stored in the cache to not evict the ones in use
+			auto_ptr<ImageMapStorage> tile(LoadTile(0, tileX, tileY));
+			const char *src = (const char *)tile->GetPixelsData();
+
+			const u_int x0 = tileX * tileWidth;
+			const u_int rowWidth = Min(tileWidth, width - x0);
+			for (u_int y = 0; y < rowCount; ++y) {
+				for (u_int x = 0; x < rowWidth; ++x) {
+					const char *srcPixel = &src[(y * tileWidth + x) * pixelSize];
+					char *dstPixel = &rows[(y * width + x0 + x) * outPixelSize];
+
+					for (u_int c = 0; c < outChannelCount; ++c)
+						memcpy(&dstPixel[c * channelSize], &srcPixel[Min(c, channelCount - 1) * channelSize], channelSize);
+				}
+			}
+		}
+
+		if (!out->write_scanlines(y0, y0 + rowCount, 0, typeDesc, &rows[0]))
+			throw runtime_error("Error while writing the image " + fileName + ": " + out->geterror());
+	}
+
+	out->close();
+}
@@ -17,8 +17,10 @@
  ***************************************************************************/
 
 #include <boost/format.hpp>
+#include <boost/foreach.hpp>
 
 #include "slg/lights/infinitelight.h"
+#include "slg/bsdf/bsdf.h"
 #include "slg/scene/scene.h"
 
 using namespace std;
@@ -30,7 +32,9 @@ using namespace slg;
 //------------------------------------------------------------------------------
 
 InfiniteLight::InfiniteLight() :
-	imageMap(NULL), mapping(1.f, 1.f, 0.f, 0.f), sampleUpperHemisphereOnly(false) {
+	imageMap(NULL), mapping(1.f, 1.f, 0.f, 0.f), sampleUpperHemisphereOnly(false),
+	useVisibilityMap(false), visibilityMapWidth(64), visibilityMapHeight(32),
+	visibilityMapSamples(64), imageMapDistribution(NULL) {
 }
 
 InfiniteLight::~InfiniteLight() {
@@ -38,6 +42,13 @@ InfiniteLight::~InfiniteLight() {
 }
 
 void InfiniteLight::Preprocess() {
+	// With the visibility map, the distribution is built only once by
+	// UpdateVisibilityMap()
+	if (!useVisibilityMap)
+		BuildImageMapDistribution();
+}
+
+void InfiniteLight::BuildImageMapDistribution() {
 	const ImageMapStorage *imageMapStorage = imageMap->GetStorage();
 
 	vector<float> data(imageMap->GetWidth() * imageMap->GetHeight());
@@ -62,9 +73,122 @@ void InfiniteLight::Preprocess() {
 		}
 	}
 
+	if (useVisibilityMap && (visibilityMap.size() == visibilityMapWidth * visibilityMapHeight)) {
+		// The directions never found visible keep a small weight because
+		// they may be visible from the points not sampled
+		const float minVisibility = .5f / visibilityMapSamples;
+
+		for (u_int y = 0; y < imageMap->GetHeight(); ++y) {
+			const u_int mapY = Min(y * visibilityMapHeight / imageMap->GetHeight(), visibilityMapHeight - 1);
+
+			for (u_int x = 0; x < imageMap->GetWidth(); ++x) {
+				const u_int mapX = Min(x * visibilityMapWidth / imageMap->GetWidth(), visibilityMapWidth - 1);
+				const u_int index = x + y * imageMap->GetWidth();
+
+				data[index] *= Max(visibilityMap[mapX + mapY * visibilityMapWidth], minVisibility);
+			}
+		}
+	}
+
+	delete imageMapDistribution;
 	imageMapDistribution = new Distribution2D(&data[0], imageMap->GetWidth(), imageMap->GetHeight());
 }
 
+// Traces the ray like Scene::Intersect() does, passing through the pass-through
+// and shadow transparent surfaces (i.e. null and archglass materials, alpha
+// maps, etc.). Volumes are ignored.
+static bool IntersectVisibilityRay(const Scene *scene, const Accelerator *accel,
+		const float initialPassThrough, Ray *ray, RayHit *rayHit,
+		Spectrum *connectionThroughput) {
+	*connectionThroughput = Spectrum(1.f);
+
+	float passThrough = initialPassThrough;
+	for (;;) {
+		if (!accel->Intersect(ray, rayHit))
+			return false;
+
+		// Look at the material before evaluating the BSDF
+		const Material *mat = scene->objDefs.GetSceneObject(rayHit->meshIndex)->GetMaterial();
+		if (!mat->IsShadowTransparent())
+			return true;
+
+		PathVolumeInfo volInfo;
+		BSDF bsdf;
+		bsdf.Init(false, *scene, *ray, *rayHit, passThrough, &volInfo);
+
+		const Spectrum transp = bsdf.GetPassThroughTransparency();
+		if (transp.Black())
+			return true;
+		*connectionThroughput *= transp;
+
+		// It is a transparent material, continue to trace the ray
+		ray->mint = rayHit->t + MachineEpsilon::E(rayHit->t);
+
+		// A safety check
+		if (ray->mint >= ray->maxt)
+			return false;
+
+		passThrough = fabsf(passThrough - .5f) * 2.f;
+	}
+}
+
+void InfiniteLight::UpdateVisibilityMap(const Scene *scene,
+		const u_int filmWidth, const u_int filmHeight) {
+	if (!useVisibilityMap)
+		return;
+
+	// Use the accelerator of the intersection devices. FILESAVER engine
+	// doesn't initialize any accelerator.
+	const Accelerator *accel = scene->dataSet->GetAccelerator();
+
+	// Look for the points seen by the camera
+	RandomGenerator rndGen(131);
+	vector<Point> points;
+	for (u_int i = 0; accel && (i < visibilityMapSamples); ++i) {
+		Ray eyeRay;
+		scene->camera->GenerateRay(rndGen.floatValue() * filmWidth, rndGen.floatValue() * filmHeight,
+				&eyeRay, rndGen.floatValue(), rndGen.floatValue(), rndGen.floatValue());
+
+		RayHit eyeRayHit;
+		Spectrum eyeThroughput;
+		if (IntersectVisibilityRay(scene, accel, rndGen.floatValue(), &eyeRay, &eyeRayHit, &eyeThroughput)) {
+			// Move the point a bit toward the camera to avoid self-intersections
+			points.push_back(eyeRay(.999f * eyeRayHit.t));
+		}
+	}
+
+	if (points.size() == 0) {
+		// Nothing is seen by the camera, use the image map luminance only
+		visibilityMap.clear();
+	} else {
+		// Trace a jittered direction inside each cell from each point
+		visibilityMap.resize(visibilityMapWidth * visibilityMapHeight);
+		for (u_int y = 0; y < visibilityMapHeight; ++y) {
+			for (u_int x = 0; x < visibilityMapWidth; ++x) {
+				float visibility = 0.f;
+				BOOST_FOREACH(const Point &p, points) {
+					const float phi = (x + rndGen.floatValue()) * 2.f * M_PI / visibilityMapWidth;
+					const float theta = (y + rndGen.floatValue()) * M_PI / visibilityMapHeight;
+					const Vector dir = Normalize(lightToWorld * SphericalDirection(sinf(theta), cosf(theta), phi));
+
+					// The transparent surfaces let the light pass, like for
+					// the shadow rays traced while rendering
+					Ray shadowRay(p, dir, MachineEpsilon::E(p));
+					RayHit shadowRayHit;
+					Spectrum connectionThroughput;
+					if (!IntersectVisibilityRay(scene, accel, rndGen.floatValue(), &shadowRay, &shadowRayHit, &connectionThroughput))
+						visibility += Min(connectionThroughput.Filter(), 1.f);
+				}
+
+				visibilityMap[x + y * visibilityMapWidth] = visibility / points.size();
+			}
+		}
+	}
+
+	// Rebuild the distribution
+	BuildImageMapDistribution();
+}
+
 void InfiniteLight::GetPreprocessedData(const Distribution2D **imageMapDistributionData) const {
 	if (imageMapDistributionData)
 		*imageMapDistributionData = imageMapDistribution;
@@ -179,6 +303,10 @@ Properties InfiniteLight::ToProperties(const ImageMapCache &imgMapCache) const {
 	props.Set(Property(prefix + ".gamma")(1.f));
 	props.Set(Property(prefix + ".shift")(mapping.uDelta, mapping.vDelta));
 	props.Set(Property(prefix + ".sampleupperhemisphereonly")(sampleUpperHemisphereOnly));
+	props.Set(Property(prefix + ".visibilitymap.enable")(useVisibilityMap));
+	props.Set(Property(prefix + ".visibilitymap.width")(visibilityMapWidth));
+	props.Set(Property(prefix + ".visibilitymap.height")(visibilityMapHeight));
+	props.Set(Property(prefix + ".visibilitymap.samples")(visibilityMapSamples));
 
 	return props;
 }
@@ -48,15 +48,33 @@ void LightSourceDefinitions::DefineLightSource(const string &name, LightSource *
 	if (IsLightSourceDefined(name)) {
 		const LightSource *oldLight = GetLightSource(name);
 
-		// Update name/LightSource definition
+		// Update name/LightSource definition, the handle doesn't change
 		lightsByName.erase(name);
 		lightsByName.insert(std::make_pair(name, newLight));
+		lightsBySlot[GetSceneHandleSlot(GetLightSourceHandle(name))] = newLight;
 
 		// Delete old LightSource
 		delete oldLight;
 	} else {
 		// Add the new LightSource
 		lightsByName.insert(std::make_pair(name, newLight));
+
+		// Reuse the slot of a deleted LightSource if available
+		u_int slot;
+		if (freeSlots.size() > 0) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+
+			lightsBySlot[slot] = newLight;
+			namesBySlot[slot] = name;
+		} else {
+			slot = lightsBySlot.size();
+
+			lightsBySlot.push_back(newLight);
+			namesBySlot.push_back(name);
+			generationsBySlot.push_back(0);
+		}
+		handlesByName.insert(std::make_pair(name, MakeSceneHandle(slot, generationsBySlot[slot])));
 	}
 }
 
@@ -84,6 +102,29 @@ LightSource *LightSourceDefinitions::GetLightSource(const string &name) {
 		return it->second;
 }
 
+SceneHandle LightSourceDefinitions::GetLightSourceHandle(const string &name) const {
+	boost::unordered_map<std::string, SceneHandle>::const_iterator it = handlesByName.find(name);
+
+	if (it == handlesByName.end())
+		throw runtime_error("Reference to an undefined LightSource in LightSourceDefinitions::GetLightSourceHandle(): " + name);
+	else
+		return it->second;
+}
+
+LightSource *LightSourceDefinitions::GetLightSourceByHandle(const SceneHandle handle) {
+	if (!IsLightSourceHandleValid(handle))
+		throw runtime_error("Reference to an undefined LightSource handle in LightSourceDefinitions::GetLightSourceByHandle(): " + ToString(handle));
+
+	return lightsBySlot[GetSceneHandleSlot(handle)];
+}
+
+const string &LightSourceDefinitions::GetLightSourceName(const SceneHandle handle) const {
+	if (!IsLightSourceHandleValid(handle))
+		throw runtime_error("Reference to an undefined LightSource handle in LightSourceDefinitions::GetLightSourceName(): " + ToString(handle));
+
+	return namesBySlot[GetSceneHandleSlot(handle)];
+}
+
 const TriangleLight *LightSourceDefinitions::GetLightSourceByMeshIndex(const u_int index) const {
 	return (const TriangleLight *)lights[lightIndexByMeshIndex[index]];
 }
@@ -97,14 +138,29 @@ vector<string> LightSourceDefinitions::GetLightSourceNames() const {
 	return names;
 }
 
-void LightSourceDefinitions::DeleteLightSource(const string &name) {
-	boost::unordered_map<std::string, LightSource *>::const_iterator it = lightsByName.find(name);
+void LightSourceDefinitions::DeleteLightSource(const string &lightName) {
+	// lightName can be a reference to a key of lightsByName or to an element
+	// of namesBySlot (i.e. the result of GetLightSourceName()) so a copy
+	// is required before starting to erase things
+	const string name = lightName;
+
+	boost::unordered_map<std::string, LightSource *>::iterator it = lightsByName.find(name);
 
 	if (it == lightsByName.end())
 		throw runtime_error("Reference to an undefined LightSource in LightSourceDefinitions::DeleteLightSource(): " + name);
 	else {
+		const u_int slot = GetSceneHandleSlot(GetLightSourceHandle(name));
+
 		delete it->second;
-		lightsByName.erase(name);
+		lightsByName.erase(it);
+		handlesByName.erase(name);
+
+		lightsBySlot[slot] = NULL;
+		// Release the memory of the name too
+		string().swap(namesBySlot[slot]);
+		// Invalidate the handles of the deleted light source
+		++generationsBySlot[slot];
+		freeSlots.push_back(slot);
 	}
 }
 
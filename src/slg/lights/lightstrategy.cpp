@@ -18,6 +18,8 @@
 
 #include "slg/lights/lightstrategy.h"
 #include "slg/lights/lightstrategyregistry.h"
+#include "slg/lights/trianglelight.h"
+#include "slg/lights/pointlight.h"
 #include "slg/scene/scene.h"
 
 using namespace std;
@@ -121,6 +123,7 @@ OBJECTSTATICREGISTRY_STATICFIELDS(LightStrategyRegistry);
 OBJECTSTATICREGISTRY_REGISTER(LightStrategyRegistry, LightStrategyUniform);
 OBJECTSTATICREGISTRY_REGISTER(LightStrategyRegistry, LightStrategyPower);
 OBJECTSTATICREGISTRY_REGISTER(LightStrategyRegistry, LightStrategyLogPower);
+OBJECTSTATICREGISTRY_REGISTER(LightStrategyRegistry, LightStrategyLightTree);
 // Just add here any new LightStrategy (don't forget in the .h too)
 
 //------------------------------------------------------------------------------
@@ -323,3 +326,165 @@ const Properties &LightStrategyLogPower::GetDefaultProps() {
 
 	return props;
 }
+
+//------------------------------------------------------------------------------
+// LightStrategyLightTree
+//------------------------------------------------------------------------------
+
+LightStrategyLightTree::~LightStrategyLightTree() {
+	delete lightTree;
+	delete otherLightsDistribution;
+}
+
+// Return false if the light source can not be included in the LightTree
+static bool GetLightTreeBounds(const LightSource *l, LightTreeBounds *bounds) {
+	switch (l->GetType()) {
+		case slg::TYPE_TRIANGLE: {
+			const TriangleLight *tl = (const TriangleLight *)l;
+			const ExtMesh *mesh = tl->mesh;
+			// The position of a moving light source is not constant
+			if (mesh->GetType() == TYPE_EXT_TRIANGLE_MOTION)
+				return false;
+
+			const Triangle &tri = mesh->GetTriangles()[tl->triangleIndex];
+			const Normal geometryN = mesh->GetGeometryNormal(0.f, tl->triangleIndex);
+
+			bounds->bbox = BBox();
+			bounds->thetaO = 0.f;
+			for (u_int i = 0; i < 3; ++i) {
+				bounds->bbox = Union(bounds->bbox, mesh->GetVertex(0.f, tri.v[i]));
+
+				// The light is emitted around the interpolated shading normal
+				if (mesh->HasNormals()) {
+					const float cosTheta = Dot(geometryN, mesh->GetShadeNormal(0.f, tl->triangleIndex, i));
+					bounds->thetaO = Max(bounds->thetaO, acosf(Clamp(cosTheta, -1.f, 1.f)));
+				}
+			}
+			bounds->axis = Vector(geometryN);
+			bounds->thetaE = acosf(Clamp(tl->lightMaterial->GetEmittedCosThetaMax(), -1.f, 1.f));
+			return true;
+		}
+		case TYPE_POINT:
+		case TYPE_MAPPOINT: {
+			float absolutePos[3];
+			((const PointLight *)l)->GetPreprocessedData(NULL, absolutePos, NULL);
+
+			bounds->bbox = BBox(Point(absolutePos));
+			// Point light sources emit in all directions
+			bounds->axis = Vector(0.f, 0.f, 1.f);
+			bounds->thetaO = M_PI;
+			bounds->thetaE = M_PI * .5f;
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+void LightStrategyLightTree::Preprocess(const Scene *scn, const LightStrategyTask taskType) {
+	// The power distribution is used when there is no point to illuminate
+	LightStrategyPower::Preprocess(scn, taskType);
+
+	delete lightTree;
+	lightTree = NULL;
+	delete otherLightsDistribution;
+	otherLightsDistribution = NULL;
+	lightTreePickProb = 0.f;
+
+	// The LightTree is useful only to illuminate a point
+	if (taskType != TASK_ILLUMINATE)
+		return;
+
+	const u_int lightCount = scene->lightDefs.GetSize();
+	vector<LightTreeEmitter> emitters;
+	vector<float> otherLightPower(lightCount, 0.f);
+	float treePower = 0.f;
+	float otherPower = 0.f;
+
+	const vector<LightSource *> &lights = scene->lightDefs.GetLightSources();
+	for (u_int i = 0; i < lightCount; ++i) {
+		const float power = lightsDistribution->Pdf(i);
+		if (power <= 0.f)
+			continue;
+
+		LightTreeEmitter emitter;
+		if (GetLightTreeBounds(lights[i], &emitter.bounds)) {
+			emitter.bounds.power = power;
+			emitter.lightIndex = i;
+			emitters.push_back(emitter);
+
+			treePower += power;
+		} else {
+			otherLightPower[i] = power;
+			otherPower += power;
+		}
+	}
+
+	if (emitters.size() == 0)
+		return;
+
+	lightTree = new LightTree(emitters, lightCount);
+	lightTreePickProb = treePower / (treePower + otherPower);
+	if (otherPower > 0.f)
+		otherLightsDistribution = new Distribution1D(&otherLightPower[0], lightCount);
+
+	SLG_LOG("Light tree built with " << emitters.size() << " light sources");
+}
+
+LightSource *LightStrategyLightTree::SampleLights(const float u, const Point &p,
+		const Normal &n, float *pdf) const {
+	if (!lightTree)
+		return LightStrategy::SampleLights(u, pdf);
+
+	u_int lightIndex;
+	if (u < lightTreePickProb) {
+		lightIndex = lightTree->SampleLight(u / lightTreePickProb, p, n, pdf);
+		if (lightIndex == LIGHTTREE_NULL_INDEX)
+			return NULL;
+
+		*pdf *= lightTreePickProb;
+	} else {
+		lightIndex = otherLightsDistribution->SampleDiscrete(
+				(u - lightTreePickProb) / (1.f - lightTreePickProb), pdf);
+
+		*pdf *= 1.f - lightTreePickProb;
+	}
+
+	if (*pdf > 0.f)
+		return scene->lightDefs.GetLightSources()[lightIndex];
+	else
+		return NULL;
+}
+
+float LightStrategyLightTree::SampleLightPdf(const LightSource *light, const Point &p,
+		const Normal &n) const {
+	if (!lightTree)
+		return LightStrategy::SampleLightPdf(light);
+
+	const u_int lightIndex = light->lightSceneIndex;
+	if (lightTree->HasLight(lightIndex))
+		return lightTreePickProb * lightTree->LightPdf(lightIndex, p, n);
+	else if (otherLightsDistribution)
+		return (1.f - lightTreePickProb) * otherLightsDistribution->Pdf(lightIndex);
+	else
+		return 0.f;
+}
+
+// Static methods used by LightStrategyRegistry
+
+Properties LightStrategyLightTree::ToProperties(const Properties &cfg) {
+	return Properties() <<
+			cfg.Get(GetDefaultProps().Get("lightstrategy.type"));
+}
+
+LightStrategy *LightStrategyLightTree::FromProperties(const Properties &cfg) {
+	return new LightStrategyLightTree();
+}
+
+const Properties &LightStrategyLightTree::GetDefaultProps() {
+	static Properties props = Properties() <<
+			LightStrategy::GetDefaultProps() <<
+			Property("lightstrategy.type")(GetObjectTag());
+
+	return props;
+}
@@ -0,0 +1,312 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "slg/lights/lighttree.h"
+
+using namespace std;
+using namespace luxrays;
+using namespace slg;
+
+//------------------------------------------------------------------------------
+// LightTreeBounds
+//------------------------------------------------------------------------------
+
+void LightTreeBounds::Union(const LightTreeBounds &b) {
+	bbox = luxrays::Union(bbox, b.bbox);
+	power += b.power;
+	thetaE = Max(thetaE, b.thetaE);
+
+	// Merge the orientation cones, a is the larger one
+	Vector axisA = axis;
+	float thetaA = thetaO;
+	Vector axisB = b.axis;
+	float thetaB = b.thetaO;
+	if (thetaB > thetaA) {
+		swap(axisA, axisB);
+		swap(thetaA, thetaB);
+	}
+
+	const float thetaD = acosf(Clamp(Dot(axisA, axisB), -1.f, 1.f));
+	if (Min(thetaD + thetaB, (float)M_PI) <= thetaA) {
+		// a includes b
+		axis = axisA;
+		thetaO = thetaA;
+		return;
+	}
+
+	const float newThetaO = (thetaA + thetaD + thetaB) * .5f;
+	const Vector w = Cross(axisA, axisB);
+	const float wLength = w.Length();
+	if ((newThetaO >= M_PI) || (wLength < DEFAULT_EPSILON_STATIC)) {
+		axis = axisA;
+		thetaO = M_PI;
+		return;
+	}
+
+	// Rotate the axis of a toward the one of b
+	const float thetaR = newThetaO - thetaA;
+	axis = Normalize(axisA * cosf(thetaR) + Cross(w / wLength, axisA) * sinf(thetaR));
+	thetaO = newThetaO;
+}
+
+float LightTreeBounds::GetOrientationMeasure() const {
+	const float thetaW = Min(thetaO + thetaE, (float)M_PI);
+	const float cosThetaO = cosf(thetaO);
+	const float sinThetaO = sinf(thetaO);
+
+	return 2.f * M_PI * (1.f - cosThetaO) +
+			.5f * M_PI * (2.f * thetaW * sinThetaO - cosf(thetaO - 2.f * thetaW) -
+			2.f * thetaO * sinThetaO + cosThetaO);
+}
+
+//------------------------------------------------------------------------------
+// LightTree
+//------------------------------------------------------------------------------
+
+#define LIGHTTREE_BUCKET_COUNT 12
+
+static u_int BucketIndex(const float centroid, const float minCentroid, const float maxCentroid) {
+	const u_int bucket = (u_int)(LIGHTTREE_BUCKET_COUNT * ((centroid - minCentroid) / (maxCentroid - minCentroid)));
+
+	return Min<u_int>(bucket, LIGHTTREE_BUCKET_COUNT - 1);
+}
+
+class LightTreeBucketPredicate {
+public:
+	LightTreeBucketPredicate(const int a, const float minC, const float maxC, const u_int b) :
+		axis(a), minCentroid(minC), maxCentroid(maxC), splitBucket(b) { }
+
+	bool operator()(const LightTreeEmitter &emitter) const {
+		return BucketIndex(emitter.bounds.bbox.Center()[axis], minCentroid, maxCentroid) <= splitBucket;
+	}
+
+	const int axis;
+	const float minCentroid, maxCentroid;
+	const u_int splitBucket;
+};
+
+// The surface area orientation heuristic cost of a node
+static float SAOHCost(const LightTreeBounds &bounds) {
+	// Point lights have no surface area
+	return bounds.power * bounds.GetOrientationMeasure() *
+			Max(bounds.bbox.SurfaceArea(), DEFAULT_EPSILON_STATIC);
+}
+
+LightTree::LightTree(vector<LightTreeEmitter> &emitters, const u_int lightCount) {
+	leafIndexByLightIndex.resize(lightCount, LIGHTTREE_NULL_INDEX);
+
+	nodes.reserve(2 * emitters.size() - 1);
+	BuildNode(emitters, 0, emitters.size(), LIGHTTREE_NULL_INDEX);
+}
+
+u_int LightTree::BuildNode(vector<LightTreeEmitter> &emitters,
+		const u_int begin, const u_int end, const u_int parentIndex) {
+	const u_int nodeIndex = nodes.size();
+	nodes.resize(nodeIndex + 1);
+	nodes[nodeIndex].parentIndex = parentIndex;
+
+	LightTreeBounds bounds = emitters[begin].bounds;
+	BBox centroidsBBox(bounds.bbox.Center());
+	for (u_int i = begin + 1; i < end; ++i) {
+		bounds.Union(emitters[i].bounds);
+		centroidsBBox = Union(centroidsBBox, emitters[i].bounds.bbox.Center());
+	}
+	nodes[nodeIndex].bounds = bounds;
+
+	if (end - begin == 1) {
+		// A leaf
+		const u_int lightIndex = emitters[begin].lightIndex;
+		nodes[nodeIndex].nodeData = lightIndex | 0x80000000u;
+		leafIndexByLightIndex[lightIndex] = nodeIndex;
+
+		return nodeIndex;
+	}
+
+	// Look for the best split with the surface area orientation heuristic
+	const Vector diagonal = bounds.bbox.pMax - bounds.bbox.pMin;
+	const float maxExtent = Max(Max(diagonal.x, diagonal.y), diagonal.z);
+	float bestCost = INFINITY;
+	int bestAxis = -1;
+	u_int bestBucket = 0;
+	for (int axis = 0; axis < 3; ++axis) {
+		const float minCentroid = centroidsBBox.pMin[axis];
+		const float maxCentroid = centroidsBBox.pMax[axis];
+		if (maxCentroid <= minCentroid)
+			continue;
+
+		LightTreeBounds buckets[LIGHTTREE_BUCKET_COUNT];
+		u_int bucketCounts[LIGHTTREE_BUCKET_COUNT] = { 0 };
+		for (u_int i = begin; i < end; ++i) {
+			const u_int b = BucketIndex(emitters[i].bounds.bbox.Center()[axis], minCentroid, maxCentroid);
+
+			if (bucketCounts[b] == 0)
+				buckets[b] = emitters[i].bounds;
+			else
+				buckets[b].Union(emitters[i].bounds);
+			++bucketCounts[b];
+		}
+
+		// Penalize the splits along thin axes
+		const float axisFactor = (diagonal[axis] > 0.f) ? (maxExtent / diagonal[axis]) : 1.f;
+
+		for (u_int split = 0; split < LIGHTTREE_BUCKET_COUNT - 1; ++split) {
+			LightTreeBounds left, right;
+			u_int leftCount = 0;
+			u_int rightCount = 0;
+			for (u_int b = 0; b < LIGHTTREE_BUCKET_COUNT; ++b) {
+				if (bucketCounts[b] == 0)
+					continue;
+
+				LightTreeBounds &side = (b <= split) ? left : right;
+				u_int &sideCount = (b <= split) ? leftCount : rightCount;
+				if (sideCount == 0)
+					side = buckets[b];
+				else
+					side.Union(buckets[b]);
+				sideCount += bucketCounts[b];
+			}
+
+			if ((leftCount == 0) || (rightCount == 0))
+				continue;
+
+			const float cost = axisFactor * (SAOHCost(left) + SAOHCost(right));
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBucket = split;
+			}
+		}
+	}
+
+	u_int mid;
+	if (bestAxis >= 0) {
+		mid = partition(emitters.begin() + begin, emitters.begin() + end,
+				LightTreeBucketPredicate(bestAxis,
+					centroidsBBox.pMin[bestAxis], centroidsBBox.pMax[bestAxis],
+					bestBucket)) - emitters.begin();
+	} else {
+		// All centroids are in the same position, just split in the middle
+		mid = (begin + end) / 2;
+	}
+
+	BuildNode(emitters, begin, mid, nodeIndex);
+	nodes[nodeIndex].nodeData = BuildNode(emitters, mid, end, nodeIndex);
+
+	return nodeIndex;
+}
+
+float LightTree::Importance(const LightTreeBounds &bounds, const Point &p, const Normal &n) const {
+	const Point center = bounds.bbox.Center();
+	const float radius2 = DistanceSquared(center, bounds.bbox.pMax);
+
+	Vector dir = center - p;
+	const float distance2 = dir.LengthSquared();
+
+	// Inside the bounding sphere any direction is possible
+	if (distance2 <= radius2)
+		return bounds.power / Max(radius2, DEFAULT_EPSILON_STATIC);
+
+	const float distance = sqrtf(distance2);
+	dir /= distance;
+
+	// The angle subtended by the bounding sphere
+	const float thetaU = asinf(Min(sqrtf(radius2 / distance2), 1.f));
+
+	// The min. angle between the emission directions and the point
+	const float theta = acosf(Clamp(Dot(bounds.axis, -dir), -1.f, 1.f));
+	const float thetaPrime = Max(theta - bounds.thetaO - thetaU, 0.f);
+	if (thetaPrime >= bounds.thetaE)
+		return 0.f;
+
+	float importance = bounds.power * Max(cosf(thetaPrime), 0.f) / distance2;
+
+	// The min. angle between the point normal and the light source
+	if (Dot(n, n) > 0.f) {
+		const float thetaI = acosf(Clamp(Dot(n, dir), -1.f, 1.f));
+		const float thetaIPrime = Max(thetaI - thetaU, 0.f);
+		if (thetaIPrime >= .5f * M_PI)
+			return 0.f;
+
+		importance *= cosf(thetaIPrime);
+	}
+
+	return importance;
+}
+
+u_int LightTree::SampleLight(const float u, const Point &p, const Normal &n,
+		float *pdf) const {
+	float u0 = u;
+	*pdf = 1.f;
+
+	u_int nodeIndex = 0;
+	while (!LightTreeNodeData_IsLeaf(nodes[nodeIndex].nodeData)) {
+		const u_int leftIndex = nodeIndex + 1;
+		const u_int rightIndex = nodes[nodeIndex].nodeData;
+
+		const float leftImportance = Importance(nodes[leftIndex].bounds, p, n);
+		const float rightImportance = Importance(nodes[rightIndex].bounds, p, n);
+		const float totalImportance = leftImportance + rightImportance;
+		if (totalImportance <= 0.f) {
+			*pdf = 0.f;
+			return LIGHTTREE_NULL_INDEX;
+		}
+
+		const float leftProb = leftImportance / totalImportance;
+		if (u0 < leftProb) {
+			u0 = u0 / leftProb;
+			*pdf *= leftProb;
+			nodeIndex = leftIndex;
+		} else {
+			u0 = (u0 - leftProb) / (1.f - leftProb);
+			*pdf *= 1.f - leftProb;
+			nodeIndex = rightIndex;
+		}
+		// Avoid to reach 1.0 because of numerical errors
+		u0 = Min(u0, 1.f - DEFAULT_EPSILON_STATIC);
+	}
+
+	return LightTreeNodeData_GetLightIndex(nodes[nodeIndex].nodeData);
+}
+
+float LightTree::LightPdf(const u_int lightIndex, const Point &p, const Normal &n) const {
+	u_int nodeIndex = leafIndexByLightIndex[lightIndex];
+	if (nodeIndex == LIGHTTREE_NULL_INDEX)
+		return 0.f;
+
+	// Walk up to the root, the pdf is the product of the probabilities of
+	// each choice done during the traversal
+	float pdf = 1.f;
+	while (nodeIndex != 0) {
+		const u_int parentIndex = nodes[nodeIndex].parentIndex;
+		const u_int leftIndex = parentIndex + 1;
+		const u_int rightIndex = nodes[parentIndex].nodeData;
+
+		const float leftImportance = Importance(nodes[leftIndex].bounds, p, n);
+		const float rightImportance = Importance(nodes[rightIndex].bounds, p, n);
+		const float totalImportance = leftImportance + rightImportance;
+		if (totalImportance <= 0.f)
+			return 0.f;
+
+		pdf *= ((nodeIndex == leftIndex) ? leftImportance : rightImportance) / totalImportance;
+		nodeIndex = parentIndex;
+	}
+
+	return pdf;
+}
@@ -143,10 +143,13 @@ static void ComputeModel(float turbidity, const Spectrum &albedo, float elevatio
 
 SkyLight2::SkyLight2() : localSunDir(0.f, 0.f, 1.f), turbidity(2.2f),
 	groundAlbedo(0.f, 0.f, 0.f), groundColor(0.f, 0.f, 0.f),
-	hasGround(false), hasGroundAutoScale(true) {
+	hasGround(false), hasGroundAutoScale(true), useSkyDistribution(false),
+	skyDistributionWidth(512), skyDistributionHeight(256), skyDistribution(NULL),
+	sunRegionCosAngle(1.f) {
 }
 
 SkyLight2::~SkyLight2() {
+	delete skyDistribution;
 }
 
 Spectrum SkyLight2::ComputeRadiance(const Vector &w) const {
@@ -166,6 +169,95 @@ Spectrum SkyLight2::ComputeRadiance(const Vector &w) const {
 		(cTerm + expTerm + rayleighTerm + mieTerm + zenithTerm) * radianceTerm;
 }
 
+void SkyLight2::PreprocessSkyTable() {
+	const u_int width = Max(1u, skyDistributionWidth);
+	const u_int height = Max(1u, skyDistributionHeight);
+
+	// The table is in light local space, like the directions returned by
+	// SampleSkyDome(). The distribution includes the ground.
+	skyTable.resize(width * height);
+	vector<float> data(width * height);
+	for (u_int y = 0; y < height; ++y) {
+		const float theta = (y + .5f) * M_PI / height;
+		const float sinTheta = sinf(theta);
+		const float cosTheta = cosf(theta);
+
+		for (u_int x = 0; x < width; ++x) {
+			const u_int index = x + y * width;
+			const float phi = (x + .5f) * 2.f * M_PI / width;
+
+			const Vector w = Normalize(lightToWorld * SphericalDirection(sinTheta, cosTheta, phi));
+			skyTable[index] = gain * ComputeRadiance(w);
+
+			// The sinTheta term accounts for the area of the pixel on the sphere
+			const bool isGround = hasGround && (Dot(w, absoluteUpDir) < 0.f);
+			data[index] = (isGround ? scaledGroundColor.Y() : skyTable[index].Y()) * sinTheta;
+		}
+	}
+
+	delete skyDistribution;
+	skyDistribution = new Distribution2D(&data[0], width, height);
+
+	// The sun peak is a few pixels wide: the directions inside 4 pixels from
+	// the sun are not looked up in the table
+	const float pixelAngle = Max(2.f * M_PI / width, M_PI / height);
+	sunRegionCosAngle = cosf(Min(4.f * pixelAngle, (float)M_PI));
+}
+
+Vector SkyLight2::SampleSkyTable(const float u0, const float u1, float *directPdf) const {
+	float uv[2];
+	float distPdf;
+	skyDistribution->SampleContinuous(u0, u1, uv, &distPdf);
+
+	const float phi = uv[0] * 2.f * M_PI;
+	const float theta = uv[1] * M_PI;
+	const float sinTheta = sinf(theta);
+
+	// Convert the pdf from the (u, v) domain to solid angle
+	*directPdf = (sinTheta > 0.f) ? (distPdf / (2.f * M_PI * M_PI * sinTheta)) : 0.f;
+
+	return SphericalDirection(sinTheta, cosf(theta), phi);
+}
+
+float SkyLight2::GetSkyTablePdf(const Vector &localDir) const {
+	const float u = SphericalPhi(localDir) * INV_TWOPI;
+	const float v = SphericalTheta(localDir) * INV_PI;
+
+	const float sinTheta = SinTheta(localDir);
+	return (sinTheta > 0.f) ?
+		(skyDistribution->Pdf(u, v) / (2.f * M_PI * M_PI * sinTheta)) : 0.f;
+}
+
+const Spectrum &SkyLight2::GetSkyTableTexel(const int x, const int y) const {
+	const int width = (int)skyDistribution->GetWidth();
+	const int height = (int)skyDistribution->GetHeight();
+
+	// Wrap around on phi and clamp on theta
+	const int ix = (x < 0) ? (x + width) : ((x >= width) ? (x - width) : x);
+	const int iy = Clamp(y, 0, height - 1);
+
+	return skyTable[ix + iy * width];
+}
+
+Spectrum SkyLight2::GetSkyTableRadiance(const Vector &localDir) const {
+	const float s = SphericalPhi(localDir) * INV_TWOPI * skyDistribution->GetWidth() - .5f;
+	const float t = SphericalTheta(localDir) * INV_PI * skyDistribution->GetHeight() - .5f;
+
+	const int s0 = Floor2Int(s);
+	const int t0 = Floor2Int(t);
+
+	const float ds = s - s0;
+	const float dt = t - t0;
+
+	const float ids = 1.f - ds;
+	const float idt = 1.f - dt;
+
+	return ids * idt * GetSkyTableTexel(s0, t0) +
+			ids * dt * GetSkyTableTexel(s0, t0 + 1) +
+			ds * idt * GetSkyTableTexel(s0 + 1, t0) +
+			ds * dt * GetSkyTableTexel(s0 + 1, t0 + 1);
+}
+
 void SkyLight2::Preprocess() {
 	absoluteSunDir = Normalize(lightToWorld * localSunDir);
 	absoluteUpDir = Normalize(lightToWorld * Vector(0.f, 0.f, 1.f));
@@ -189,6 +281,14 @@ void SkyLight2::Preprocess() {
 		scaledGroundColor = groundColor;
 	
 	isGroundBlack = (hasGround && groundColor.Black());
+
+	if (useSkyDistribution)
+		PreprocessSkyTable();
+	else {
+		delete skyDistribution;
+		skyDistribution = NULL;
+		skyTable.clear();
+	}
 }
 
 void SkyLight2::GetPreprocessedData(float *absoluteSunDirData, float *absoluteUpDirData,
@@ -329,15 +429,30 @@ Spectrum SkyLight2::Emit(const Scene &scene,
 	const Point worldCenter = scene.dataSet->GetBSphere().center;
 	const float envRadius = GetEnvRadius(scene);
 
-	Point p1 = worldCenter + envRadius * SampleSkyDome(u0, u1);
+	Point p1;
+	if (skyDistribution) {
+		// Choose p1 according importance sampling
+		float directPdf;
+		p1 = worldCenter + envRadius * SampleSkyTable(u0, u1, &directPdf);
+		if (directPdf == 0.f) {
+			*emissionPdfW = 0.f;
+			return Spectrum();
+		}
+
+		*emissionPdfW = directPdf / (M_PI * envRadius * envRadius);
+		if (directPdfA)
+			*directPdfA = directPdf;
+	} else {
+		p1 = worldCenter + envRadius * SampleSkyDome(u0, u1);
+
+		SampleSkyDomePdf(scene, directPdfA, emissionPdfW);
+	}
 	Point p2 = worldCenter + envRadius * SampleSkyDome(u2, u3);
 
 	// Construct ray between p1 and p2
 	*orig = p1;
 	*dir = Normalize(lightToWorld * (p2 - p1));
 
-	SampleSkyDomePdf(scene, directPdfA, emissionPdfW);
-
 	if (cosThetaAtLight)
 		*cosThetaAtLight = Dot(Normalize(worldCenter -  p1), *dir);
 
@@ -351,7 +466,13 @@ Spectrum SkyLight2::Illuminate(const Scene &scene, const Point &p,
 	const Point worldCenter = scene.dataSet->GetBSphere().center;
 	const float envRadius = GetEnvRadius(scene);
 
-	*dir = Normalize(lightToWorld * SampleSkyDome(u0, u1));
+	float directPdf;
+	if (skyDistribution) {
+		*dir = Normalize(lightToWorld * SampleSkyTable(u0, u1, &directPdf));
+		if (directPdf == 0.f)
+			return Spectrum();
+	} else
+		*dir = Normalize(lightToWorld * SampleSkyDome(u0, u1));
 
 	const Vector toCenter(worldCenter - p);
 	const float centerDistance = Dot(toCenter, toCenter);
@@ -368,7 +489,12 @@ Spectrum SkyLight2::Illuminate(const Scene &scene, const Point &p,
 	if (cosThetaAtLight)
 		*cosThetaAtLight = cosAtLight;
 
-	SampleSkyDomePdf(scene, directPdfW, emissionPdfW);
+	if (skyDistribution) {
+		*directPdfW = directPdf;
+		if (emissionPdfW)
+			*emissionPdfW = directPdf / (M_PI * envRadius * envRadius);
+	} else
+		SampleSkyDomePdf(scene, directPdfW, emissionPdfW);
 
 	return GetRadiance(scene, -(*dir));
 }
@@ -378,6 +504,30 @@ Spectrum SkyLight2::GetRadiance(const Scene &scene,
 		float *directPdfA,
 		float *emissionPdfW) const {
 	const Vector w = -dir;
+
+	if (skyDistribution) {
+		const Vector localDir = Normalize(Inverse(lightToWorld) * w);
+
+		if (directPdfA || emissionPdfW) {
+			const float directPdf = GetSkyTablePdf(localDir);
+
+			if (directPdfA)
+				*directPdfA = directPdf;
+			if (emissionPdfW) {
+				const float envRadius = GetEnvRadius(scene);
+				*emissionPdfW = directPdf / (M_PI * envRadius * envRadius);
+			}
+		}
+
+		if (hasGround && (Dot(w, absoluteUpDir) < 0.f))
+			return scaledGroundColor;
+		else if (Dot(w, absoluteSunDir) > sunRegionCosAngle) {
+			// Too close to the sun for the table resolution
+			return gain * ComputeRadiance(w);
+		} else
+			return GetSkyTableRadiance(localDir);
+	}
+
 	if (hasGround && (Dot(w, absoluteUpDir) < 0.f)) {
 		// Lower hemisphere
 
@@ -408,6 +558,9 @@ Properties SkyLight2::ToProperties(const ImageMapCache &imgMapCache) const {
 	props.Set(Property(prefix + ".ground.enable")(hasGround));
 	props.Set(Property(prefix + ".ground.color")(groundColor));
 	props.Set(Property(prefix + ".ground.autoscale")(hasGroundAutoScale));
+	props.Set(Property(prefix + ".distribution.enable")(useSkyDistribution));
+	props.Set(Property(prefix + ".distribution.width")(skyDistributionWidth));
+	props.Set(Property(prefix + ".distribution.height")(skyDistributionHeight));
 
 	return props;
 }
@@ -88,6 +88,7 @@ Spectrum TriangleLight::Emit(const Scene &scene,
 	hitPoint.interiorVolume = NULL;
 	hitPoint.exteriorVolume = NULL;
 	hitPoint.uv = mesh->InterpolateTriUV(triangleIndex, b1, b2);
+	hitPoint.footprint = 0.f;
 	mesh->GetDifferentials(0.f, triangleIndex, hitPoint.shadeN,
 		&hitPoint.dpdu, &hitPoint.dpdv,
 		&hitPoint.dndu, &hitPoint.dndv);
@@ -166,6 +167,7 @@ Spectrum TriangleLight::Illuminate(const Scene &scene, const Point &p,
 	tmpHitPoint.interiorVolume = NULL;
 	tmpHitPoint.exteriorVolume = NULL;
 	tmpHitPoint.uv = mesh->InterpolateTriUV(triangleIndex, b1, b2);
+	tmpHitPoint.footprint = 0.f;
 	mesh->GetDifferentials(0.f, triangleIndex, tmpHitPoint.shadeN,
 		&tmpHitPoint.dpdu, &tmpHitPoint.dpdv,
 		&tmpHitPoint.dndu, &tmpHitPoint.dndv);
@@ -36,14 +36,16 @@ MaterialDefinitions::~MaterialDefinitions() {
 }
 
 void MaterialDefinitions::DefineMaterial(const string &name, Material *newMat) {
-	if (IsMaterialDefined(name)) {
-		Material *oldMat = GetMaterial(name);
+	boost::unordered_map<string, SceneHandle>::const_iterator it = handlesByName.find(name);
+
+	if (it != handlesByName.end()) {
+		// Update name/material definition, the handle doesn't change
+		const u_int index = indicesBySlot[GetSceneHandleSlot(it->second)];
+		Material *oldMat = mats[index];
 
-		// Update name/material definition
-		const u_int index = GetMaterialIndex(name);
 		mats[index] = newMat;
-		matsByName.erase(name);
-		matsByName.insert(make_pair(name, newMat));
+		indicesByMat.erase(oldMat);
+		indicesByMat.insert(make_pair(newMat, index));
 
 		// Update all possible references to old material with the new one
 		BOOST_FOREACH(Material *mat, mats)
@@ -53,8 +55,27 @@ void MaterialDefinitions::DefineMaterial(const string &name, Material *newMat) {
 		delete oldMat;
 	} else {
 		// Add the new material
+		const u_int index = mats.size();
+
+		// Reuse the slot of a deleted material if available
+		u_int slot;
+		if (freeSlots.size() > 0) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+
+			indicesBySlot[slot] = index;
+		} else {
+			slot = indicesBySlot.size();
+
+			indicesBySlot.push_back(index);
+			generationsBySlot.push_back(0);
+		}
+		const SceneHandle handle = MakeSceneHandle(slot, generationsBySlot[slot]);
+
 		mats.push_back(newMat);
-		matsByName.insert(make_pair(name, newMat));
+		matHandles.push_back(handle);
+		handlesByName.insert(make_pair(name, handle));
+		indicesByMat.insert(make_pair(newMat, index));
 	}
 }
 
@@ -64,39 +85,64 @@ void MaterialDefinitions::UpdateTextureReferences(const Texture *oldTex, const T
 }
 
 Material *MaterialDefinitions::GetMaterial(const string &name) {
-	// Check if the material has been already defined
-	boost::unordered_map<string, Material *>::const_iterator it = matsByName.find(name);
+	return mats[GetMaterialIndex(name)];
+}
 
-	if (it == matsByName.end())
-		throw runtime_error("Reference to an undefined material: " + name);
+u_int MaterialDefinitions::GetMaterialIndex(const string &name) {
+	return indicesBySlot[GetSceneHandleSlot(GetMaterialHandle(name))];
+}
+
+u_int MaterialDefinitions::GetMaterialIndex(const Material *m) const {
+	boost::unordered_map<const Material *, u_int>::const_iterator it = indicesByMat.find(m);
+
+	if (it == indicesByMat.end())
+		throw runtime_error("Reference to an undefined material: " + boost::lexical_cast<string>(m));
 	else
 		return it->second;
 }
 
-u_int MaterialDefinitions::GetMaterialIndex(const string &name) {
-	return GetMaterialIndex(GetMaterial(name));
+SceneHandle MaterialDefinitions::GetMaterialHandle(const string &name) const {
+	// Check if the material has been already defined
+	boost::unordered_map<string, SceneHandle>::const_iterator it = handlesByName.find(name);
+
+	if (it == handlesByName.end())
+		throw runtime_error("Reference to an undefined material: " + name);
+	else
+		return it->second;
 }
 
-u_int MaterialDefinitions::GetMaterialIndex(const Material *m) const {
-	for (u_int i = 0; i < mats.size(); ++i) {
-		if (m == mats[i])
-			return i;
-	}
+Material *MaterialDefinitions::GetMaterialByHandle(const SceneHandle handle) {
+	if (!IsMaterialHandleValid(handle))
+		throw runtime_error("Reference to an undefined material handle: " + ToString(handle));
 
-	throw runtime_error("Reference to an undefined material: " + boost::lexical_cast<string>(m));
+	return mats[indicesBySlot[GetSceneHandleSlot(handle)]];
 }
 
 vector<string> MaterialDefinitions::GetMaterialNames() const {
 	vector<string> names;
 	names.reserve(mats.size());
-	for (boost::unordered_map<string, Material *>::const_iterator it = matsByName.begin(); it != matsByName.end(); ++it)
+	for (boost::unordered_map<string, SceneHandle>::const_iterator it = handlesByName.begin(); it != handlesByName.end(); ++it)
 		names.push_back(it->first);
 
 	return names;
 }
 
 void MaterialDefinitions::DeleteMaterial(const string &name) {
-	const u_int index = GetMaterialIndex(name);
+	const u_int slot = GetSceneHandleSlot(GetMaterialHandle(name));
+	const u_int index = indicesBySlot[slot];
+
+	indicesByMat.erase(mats[index]);
 	mats.erase(mats.begin() + index);
-	matsByName.erase(name);
+	matHandles.erase(matHandles.begin() + index);
+	indicesBySlot[slot] = NULL_INDEX;
+	handlesByName.erase(name);
+	// Invalidate the handles of the deleted material
+	++generationsBySlot[slot];
+	freeSlots.push_back(slot);
+
+	// Update the indices of the following materials
+	for (u_int i = index; i < mats.size(); ++i) {
+		indicesBySlot[GetSceneHandleSlot(matHandles[i])] = i;
+		indicesByMat[mats[i]] = i;
+	}
 }
@@ -52,6 +52,10 @@ bool MixMaterial::IsPassThroughImpl() const {
 	return (matA->IsPassThrough() || matB->IsPassThrough());
 }
 
+bool MixMaterial::IsShadowTransparentImpl() const {
+	return (transparencyTex != NULL) || matA->IsShadowTransparent() || matB->IsShadowTransparent();
+}
+
 void MixMaterial::Preprocess() {
 	// Cache values for performance with very large material node trees
 
@@ -60,6 +64,7 @@ void MixMaterial::Preprocess() {
 	hasBumpTex = HasBumpTexImpl();
 	isDelta = IsDeltaImpl();
 	isPassThrough = IsPassThroughImpl();
+	isShadowTransparent = IsShadowTransparentImpl();
 }
 
 const Volume *MixMaterial::GetInteriorVolume(const HitPoint &hitPoint,
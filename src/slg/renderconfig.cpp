@@ -96,8 +96,15 @@ RenderConfig::RenderConfig(const Properties &props, Scene *scn) : scene(scn) {
 		const string sceneFileName = props.Get(Property("scene.file")(defaultSceneName)).Get<string>();
 		const float defaultImageScale = GetDefaultProperties().Get("images.scale").Get<float>();
 		const float imageScale = Max(.01f, props.Get(Property("images.scale")(defaultImageScale)).Get<float>());
-
-		scene = new Scene(sceneFileName, imageScale);
+		// The size of the image map tile cache is in MBytes
+		const bool defaultImageCacheEnable = GetDefaultProperties().Get("images.cache.enable").Get<bool>();
+		const u_int defaultImageCacheMaxMemory = GetDefaultProperties().Get("images.cache.maxmemory").Get<u_int>();
+		const size_t imageCacheSize = props.Get(Property("images.cache.enable")(defaultImageCacheEnable)).Get<bool>() ?
+			(Max<size_t>(1, props.Get(Property("images.cache.maxmemory")(defaultImageCacheMaxMemory)).Get<u_int>()) * 1024 * 1024) : 0;
+		const string defaultImageCacheDir = GetDefaultProperties().Get("images.cache.dir").Get<string>();
+		const string imageCacheDir = props.Get(Property("images.cache.dir")(defaultImageCacheDir)).Get<string>();
+
+		scene = new Scene(sceneFileName, imageScale, imageCacheSize, imageCacheDir);
 		allocatedScene = true;
 	}
 
@@ -381,6 +388,7 @@ Properties RenderConfig::ToProperties(const Properties &cfg) {
 	props << cfg.Get(Property("accelerator.type")("AUTO"));
 	props << cfg.Get(Property("accelerator.instances.enable")(true));
 	props << cfg.Get(Property("accelerator.motionblur.enable")(true));
+	props << cfg.Get(Property("accelerator.curves.enable")(true));
 	// (M)BVH accelerator
 #if !defined(LUXCORE_DISABLE_EMBREE_BVH_BUILDER)
 	props << cfg.Get(Property("accelerator.bvh.builder.type")("EMBREE_BINNED_SAH"));
@@ -392,6 +400,9 @@ Properties RenderConfig::ToProperties(const Properties &cfg) {
 	props << cfg.Get(Property("accelerator.bvh.isectcost")(80));
 	props << cfg.Get(Property("accelerator.bvh.travcost")(10));
 	props << cfg.Get(Property("accelerator.bvh.emptybonus")(.5));
+	props << cfg.Get(Property("accelerator.bvh.widetree.enable")(true));
+	props << cfg.Get(Property("accelerator.bvh.refit.sahthreshold")(1.5f));
+	props << cfg.Get(Property("accelerator.bvh.cache.path")(""));
 
 	// Scene epsilon
 	props << cfg.Get(Property("scene.epsilon.min")(DEFAULT_EPSILON_MIN));
@@ -399,6 +410,9 @@ Properties RenderConfig::ToProperties(const Properties &cfg) {
 
 	props << cfg.Get(Property("scene.file")("scenes/luxball/luxball.scn"));
 	props << cfg.Get(Property("images.scale")(1.f));
+	props << cfg.Get(Property("images.cache.enable")(false));
+	props << cfg.Get(Property("images.cache.maxmemory")(1024u));
+	props << cfg.Get(Property("images.cache.dir")(""));
 
 	// LightStrategy
 	props << LightStrategy::ToProperties(cfg);
@@ -428,6 +442,9 @@ Properties RenderConfig::ToProperties(const Properties &cfg) {
 	props << cfg.Get(Property("batch.haltthreshold")(-1.f));
 	props << cfg.Get(Property("batch.haltthreshold.step")(64));
 	props << cfg.Get(Property("batch.haltdebug")(0u));
+	props << cfg.Get(Property("batch.periodicsave")(0.f));
+	// If defined, the film is saved in this file too at each periodic save
+	props << cfg.Get(Property("batch.periodicsave.film.filename")(""));
 
 	return props;
 }
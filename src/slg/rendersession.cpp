@@ -39,6 +39,8 @@ RenderSession::RenderSession(RenderConfig *rcfg, RenderState *startState, Film *
 	lastPeriodicSave = WallClockTime();
 	periodicSaveEnabled = (periodiceSaveTime > 0.f);
 
+	filmSaveThread = NULL;
+
 	//--------------------------------------------------------------------------
 	// Create the Film
 	//--------------------------------------------------------------------------
@@ -65,6 +67,8 @@ RenderSession::~RenderSession() {
 	if (renderEngine->IsStarted())
 		Stop();
 
+	WaitFilmSave();
+
 	delete renderEngine;
 	delete film;
 }
@@ -82,8 +86,19 @@ void RenderSession::BeginSceneEdit() {
 }
 
 void RenderSession::EndSceneEdit() {
+	Scene *scene = renderConfig->scene;
+
+	// The env. light source visibility maps depend on the camera and on the
+	// geometry: the light sources have to be updated too (i.e. the OpenCL
+	// render engines have to upload the new light sampling distribution)
+	if ((scene->editActions.Has(CAMERA_EDIT) ||
+			scene->editActions.Has(GEOMETRY_EDIT) ||
+			scene->editActions.Has(GEOMETRY_TRANS_EDIT)) &&
+			scene->HasEnvLightVisibilityMaps())
+		scene->editActions.AddAction(LIGHTS_EDIT);
+
 	// Make a copy of the edit actions
-	const EditActionList editActions = renderConfig->scene->editActions;
+	const EditActionList editActions = scene->editActions;
 	
 	if ((renderEngine->GetType() != RTPATHOCL) &&
 			(renderEngine->GetType() != RTPATHCPU)) {
@@ -117,17 +132,57 @@ bool RenderSession::NeedPeriodicFilmSave() {
 		return false;
 }
 
-void RenderSession::SaveFilm(const string &fileName) {
+void RenderSession::SaveFilm(const string &fileName, const bool async) {
 	SLG_LOG("Saving film: " << fileName);
 
+	// Only one film save at time. It is waited before taking the new snapshot
+	// so there is never more than one copy of the film in memory.
+	WaitFilmSave();
+
 	// Ask the RenderEngine to update the film
 	renderEngine->UpdateFilm();
 
-	// renderEngine->UpdateFilm() uses the film lock on its own
-	boost::unique_lock<boost::mutex> lock(filmMutex);
+	auto_ptr<ChunkFileWriter> filmSnapshot;
+	{
+		// renderEngine->UpdateFilm() uses the film lock on its own
+		boost::unique_lock<boost::mutex> lock(filmMutex);
+
+		// Copy the film, the rendering can continue while it is written
+		filmSnapshot.reset(Film::AllocSerializedSnapshot(film));
+	}
+
+	if (async)
+		filmSaveThread = new boost::thread(&RenderSession::FilmSaveThreadImpl,
+				filmSnapshot.release(), fileName);
+	else {
+		const double startTime = WallClockTime();
+		filmSnapshot->Write(fileName);
 
-	// Serialize the film
-	Film::SaveSerialized(fileName, film);
+		SLG_LOG("Film saved in " << (WallClockTime() - startTime) << " secs");
+	}
+}
+
+void RenderSession::WaitFilmSave() {
+	if (filmSaveThread) {
+		filmSaveThread->join();
+
+		delete filmSaveThread;
+		filmSaveThread = NULL;
+	}
+}
+
+void RenderSession::FilmSaveThreadImpl(ChunkFileWriter *filmSnapshot, const string fileName) {
+	auto_ptr<ChunkFileWriter> snapshot(filmSnapshot);
+
+	try {
+		const double startTime = WallClockTime();
+		snapshot->Write(fileName);
+
+		SLG_LOG("Film saved in " << (WallClockTime() - startTime) << " secs: " << fileName);
+	} catch (exception &e) {
+		// There is no one to report the error to
+		SLG_LOG("Error while saving film " << fileName << ": " << e.what());
+	}
 }
 
 void RenderSession::SaveFilmOutputs() {
@@ -16,11 +16,14 @@
  * limitations under the License.                                          *
  ***************************************************************************/
 
+#include <sstream>
+
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 
 #include "luxrays/luxrays.h"
 #include "slg/renderstate.h"
+#include "slg/utils/chunkfile.h"
 
 using namespace std;
 using namespace luxrays;
@@ -40,6 +43,29 @@ void RenderState::CheckEngineTag(const std::string &tag) {
 }
 
 RenderState *RenderState::LoadSerialized(const std::string &fileName) {
+	if (ChunkFileReader::IsChunkFile(fileName)) {
+		// The file is memory mapped
+		ChunkFileReader reader(fileName);
+
+		if (reader.GetBlockCount() != 1)
+			throw runtime_error("Error while loading serialized render state: " + fileName);
+		string archiveData(reader.GetBlockSize(0), '\0');
+		if (archiveData.size() > 0)
+			reader.ReadBlock(0, &archiveData[0]);
+
+		istringstream inStream(archiveData);
+		eos::polymorphic_portable_iarchive inArchive(inStream);
+
+		RenderState *renderState;
+		inArchive >> renderState;
+
+		if (!inStream.good())
+			throw runtime_error("Error while loading serialized render state: " + fileName);
+
+		return renderState;
+	}
+
+	// The old format: a gzip compressed portable archive
 	ifstream inFile;
 	inFile.exceptions(ofstream::failbit | ofstream::badbit | ofstream::eofbit);
 	inFile.open(fileName.c_str());
@@ -68,31 +94,26 @@ void RenderState::SaveSerialized(const std::string &fileName) {
 	SLG_LOG("Saving render state: " << fileName);
 
 	// Serialize the render state
-	ofstream outFile;
-	outFile.exceptions(ofstream::failbit | ofstream::badbit | ofstream::eofbit);
-	outFile.open(fileName.c_str());
-
-	const streampos startPosition = outFile.tellp();
-
-	// Enable compression
-	boost::iostreams::filtering_ostream outStream;
-	outStream.push(boost::iostreams::gzip_compressor(4));
-	outStream.push(outFile);
-
-	// Use portable archive
-	eos::polymorphic_portable_oarchive outArchive(outStream);
-	//boost::archive::binary_oarchive outArchive(outStream);
-
-	// The following line is a workaround to a clang bug
-	RenderState *state = this;
-	outArchive << state;
+	ostringstream outStream;
+	{
+		// Use portable archive
+		eos::polymorphic_portable_oarchive outArchive(outStream);
+
+		// The following line is a workaround to a clang bug
+		RenderState *state = this;
+		outArchive << state;
+	}
 
 	if (!outStream.good())
 		throw runtime_error("Error while saving serialized render state: " + fileName);
 
-	flush(outStream);
+	// Write the archive in a chunk file
+	const string archiveData = outStream.str();
+	ChunkFileWriter writer;
+	writer.AddBlock(archiveData.data(), archiveData.size());
+	writer.Write(fileName);
 
-	const streamoff size = outFile.tellp() - startPosition;
+	const size_t size = archiveData.size();
 	if (size < 1024) {
 		SLG_LOG("Render state saved: " << size << " bytes");
 	} else {
@@ -30,18 +30,71 @@ using namespace slg;
 // RandomSamplerSharedData
 //------------------------------------------------------------------------------
 
+RandomSamplerSharedData::RandomSamplerSharedData(Film *engineFilm, const float adaptiveStrength) :
+		SamplerSharedData() {
+	if (adaptiveStrength > 0.f)
+		adaptiveImageDistribution = new AdaptiveImageDistribution(engineFilm, adaptiveStrength);
+	else
+		adaptiveImageDistribution = NULL;
+}
+
+RandomSamplerSharedData::~RandomSamplerSharedData() {
+	delete adaptiveImageDistribution;
+}
+
 SamplerSharedData *RandomSamplerSharedData::FromProperties(const Properties &cfg,
 		RandomGenerator *rndGen, Film *film) {
-	return new RandomSamplerSharedData();
+	const float adaptiveStrength = Clamp(cfg.Get(RandomSampler::GetDefaultProps().Get("sampler.random.adaptive.strength")).Get<float>(), 0.f, .95f);
+
+	return new RandomSamplerSharedData(film, adaptiveStrength);
 }
 
 //------------------------------------------------------------------------------
 // Random sampler
 //------------------------------------------------------------------------------
 
+RandomSampler::RandomSampler(RandomGenerator *rnd, Film *flm,
+		const FilmSampleSplatter *flmSplatter,
+		RandomSamplerSharedData *samplerSharedData) : Sampler(rnd, flm, flmSplatter),
+		sharedData(samplerSharedData), imageSamplesReady(false) {
+	if (sharedData->adaptiveImageDistribution)
+		adaptiveImageSampling = new AdaptiveImageSampling(sharedData->adaptiveImageDistribution);
+	else
+		adaptiveImageSampling = NULL;
+}
+
+RandomSampler::~RandomSampler() {
+	delete adaptiveImageSampling;
+}
+
+float RandomSampler::GetSample(const u_int index) {
+	// Index 0 and 1 (image X and Y) have to be mapped together
+	if (adaptiveImageSampling && (index < 2)) {
+		if (!imageSamplesReady) {
+			imageSamples[0] = rndGen->floatValue();
+			imageSamples[1] = rndGen->floatValue();
+			adaptiveImageSampling->Sample(&imageSamples[0], &imageSamples[1]);
+
+			imageSamplesReady = true;
+		}
+
+		return imageSamples[index];
+	}
+
+	return rndGen->floatValue();
+}
+
 void RandomSampler::NextSample(const vector<SampleResult> &sampleResults) {
 	film->AddSampleCount(1.0);
 	AddSamplesToFilm(sampleResults);
+
+	imageSamplesReady = false;
+}
+
+Properties RandomSampler::ToProperties() const {
+	return Sampler::ToProperties() <<
+			Property("sampler.random.adaptive.strength")(sharedData->adaptiveImageDistribution ?
+				sharedData->adaptiveImageDistribution->GetStrength() : 0.f);
 }
 
 //------------------------------------------------------------------------------
@@ -50,12 +103,13 @@ void RandomSampler::NextSample(const vector<SampleResult> &sampleResults) {
 
 Properties RandomSampler::ToProperties(const Properties &cfg) {
 	return Properties() <<
-			cfg.Get(GetDefaultProps().Get("sampler.type"));
+			cfg.Get(GetDefaultProps().Get("sampler.type")) <<
+			cfg.Get(GetDefaultProps().Get("sampler.random.adaptive.strength"));
 }
 
 Sampler *RandomSampler::FromProperties(const Properties &cfg, RandomGenerator *rndGen,
 		Film *film, const FilmSampleSplatter *flmSplatter, SamplerSharedData *sharedData) {
-	return new RandomSampler(rndGen, film, flmSplatter);
+	return new RandomSampler(rndGen, film, flmSplatter, (RandomSamplerSharedData *)sharedData);
 }
 
 slg::ocl::Sampler *RandomSampler::FromPropertiesOCL(const Properties &cfg) {
@@ -69,7 +123,8 @@ slg::ocl::Sampler *RandomSampler::FromPropertiesOCL(const Properties &cfg) {
 const Properties &RandomSampler::GetDefaultProps() {
 	static Properties props = Properties() <<
 			Sampler::GetDefaultProps() <<
-			Property("sampler.type")(GetObjectTag());
+			Property("sampler.type")(GetObjectTag()) <<
+			Property("sampler.random.adaptive.strength")(0.f);
 
 	return props;
 }
@@ -40,6 +40,73 @@ SamplerSharedData *SamplerSharedData::FromProperties(const Properties &cfg, Rand
 		throw runtime_error("Unknown sampler type in SamplerSharedData::FromProperties(): " + type);
 }
 
+//------------------------------------------------------------------------------
+// AdaptiveImageDistribution
+//------------------------------------------------------------------------------
+
+AdaptiveImageDistribution::AdaptiveImageDistribution(Film *engineFilm, const float s) :
+		film(engineFilm), strength(s), noiseMapVersion(0) {
+	// Ask the render engine to keep the noise map updated
+	film->SetNoiseMapUpdate(true);
+}
+
+AdaptiveImageDistribution::~AdaptiveImageDistribution() {
+	film->SetNoiseMapUpdate(false);
+}
+
+boost::shared_ptr<const Distribution2D> AdaptiveImageDistribution::GetDistribution(u_int *version) {
+	boost::unique_lock<boost::mutex> lock(distributionMutex);
+
+	// The version is read before the map so a change happening in the
+	// meanwhile will trigger a new update
+	const u_int currentVersion = film->GetNoiseMapVersion();
+	if (currentVersion != noiseMapVersion) {
+		noiseMapVersion = currentVersion;
+
+		u_int mapWidth, mapHeight;
+		film->GetNoiseMap(ADAPTIVE_SAMPLING_BLOCK_SIZE, noiseMap, &mapWidth, &mapHeight);
+
+		float avgNoise = 0.f;
+		for (u_int i = 0; i < noiseMap.size(); ++i)
+			avgNoise += noiseMap[i];
+		avgNoise /= noiseMap.size();
+
+		// Use a uniform distribution until a noise map is available
+		if (avgNoise > 0.f) {
+			for (u_int i = 0; i < noiseMap.size(); ++i)
+				noiseMap[i] = (1.f - strength) + strength * noiseMap[i] / avgNoise;
+
+			distribution.reset(new Distribution2D(&noiseMap[0], mapWidth, mapHeight));
+		} else
+			distribution.reset();
+	}
+
+	*version = noiseMapVersion;
+	return distribution;
+}
+
+//------------------------------------------------------------------------------
+// AdaptiveImageSampling
+//------------------------------------------------------------------------------
+
+AdaptiveImageSampling::AdaptiveImageSampling(AdaptiveImageDistribution *imgDistribution) :
+		imageDistribution(imgDistribution), noiseMapVersion(0) {
+}
+
+void AdaptiveImageSampling::Sample(float *u0, float *u1) {
+	if (imageDistribution->GetNoiseMapVersion() != noiseMapVersion)
+		distribution = imageDistribution->GetDistribution(&noiseMapVersion);
+
+	if (distribution) {
+		float uv[2], pdf;
+		distribution->SampleContinuous(*u0, *u1, uv, &pdf);
+
+		// Film sample normalization is per pixel so the pdf is not required
+		*u0 = uv[0];
+		*u1 = uv[1];
+	}
+}
+
 //------------------------------------------------------------------------------
 // Sampler
 //------------------------------------------------------------------------------
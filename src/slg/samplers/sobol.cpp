@@ -30,15 +30,27 @@ using namespace slg;
 // SobolSamplerSharedData
 //------------------------------------------------------------------------------
 
-SobolSamplerSharedData::SobolSamplerSharedData(RandomGenerator *rndGen) : SamplerSharedData() {
+SobolSamplerSharedData::SobolSamplerSharedData(RandomGenerator *rndGen, Film *engineFilm,
+		const float adaptiveStrength) : SamplerSharedData() {
 	rng0 = rndGen->floatValue();
 	rng1 = rndGen->floatValue();
 	pass = SOBOL_STARTOFFSET;
+
+	if (adaptiveStrength > 0.f)
+		adaptiveImageDistribution = new AdaptiveImageDistribution(engineFilm, adaptiveStrength);
+	else
+		adaptiveImageDistribution = NULL;
+}
+
+SobolSamplerSharedData::~SobolSamplerSharedData() {
+	delete adaptiveImageDistribution;
 }
 
 SamplerSharedData *SobolSamplerSharedData::FromProperties(const Properties &cfg,
 		RandomGenerator *rndGen, Film *film) {
-	return new SobolSamplerSharedData(rndGen);
+	const float adaptiveStrength = Clamp(cfg.Get(SobolSampler::GetDefaultProps().Get("sampler.sobol.adaptive.strength")).Get<float>(), 0.f, .95f);
+
+	return new SobolSamplerSharedData(rndGen, film, adaptiveStrength);
 }
 
 //------------------------------------------------------------------------------
@@ -50,11 +62,16 @@ SamplerSharedData *SobolSamplerSharedData::FromProperties(const Properties &cfg,
 SobolSampler::SobolSampler(RandomGenerator *rnd, Film *flm,
 		const FilmSampleSplatter *flmSplatter,
 		SobolSamplerSharedData *samplerSharedData) : Sampler(rnd, flm, flmSplatter),
-		sharedData(samplerSharedData), directions(NULL) {
+		sharedData(samplerSharedData), directions(NULL), imageSamplesReady(false) {
+	if (sharedData->adaptiveImageDistribution)
+		adaptiveImageSampling = new AdaptiveImageSampling(sharedData->adaptiveImageDistribution);
+	else
+		adaptiveImageSampling = NULL;
 }
 
 SobolSampler::~SobolSampler() {
 	delete directions;
+	delete adaptiveImageSampling;
 }
 
 void SobolSampler::RequestSamples(const u_int size) {
@@ -78,7 +95,7 @@ u_int SobolSampler::SobolDimension(const u_int index, const u_int dimension) con
 	return result;
 }
 
-float SobolSampler::GetSample(const u_int index) {
+float SobolSampler::GetSobolSample(const u_int index) const {
 	const u_int iResult = SobolDimension(passBase + passOffset, index);
 	const float fResult = iResult * (1.f / 0xffffffffu);
 	
@@ -89,10 +106,29 @@ float SobolSampler::GetSample(const u_int index) {
 	return val - floorf(val);
 }
 
+float SobolSampler::GetSample(const u_int index) {
+	// Index 0 and 1 (image X and Y) have to be mapped together
+	if (adaptiveImageSampling && (index < 2)) {
+		if (!imageSamplesReady) {
+			imageSamples[0] = GetSobolSample(0);
+			imageSamples[1] = GetSobolSample(1);
+			adaptiveImageSampling->Sample(&imageSamples[0], &imageSamples[1]);
+
+			imageSamplesReady = true;
+		}
+
+		return imageSamples[index];
+	}
+
+	return GetSobolSample(index);
+}
+
 void SobolSampler::NextSample(const vector<SampleResult> &sampleResults) {
 	film->AddSampleCount(1.0);
 	AddSamplesToFilm(sampleResults);
 
+	imageSamplesReady = false;
+
 	++passOffset;
 	if (passOffset >= SOBOL_THREAD_WORK_SIZE) {
 		passBase = sharedData->pass.fetch_add(SOBOL_THREAD_WORK_SIZE);
@@ -100,13 +136,20 @@ void SobolSampler::NextSample(const vector<SampleResult> &sampleResults) {
 	}
 }
 
+Properties SobolSampler::ToProperties() const {
+	return Sampler::ToProperties() <<
+			Property("sampler.sobol.adaptive.strength")(sharedData->adaptiveImageDistribution ?
+				sharedData->adaptiveImageDistribution->GetStrength() : 0.f);
+}
+
 //------------------------------------------------------------------------------
 // Static methods used by SamplerRegistry
 //------------------------------------------------------------------------------
 
 Properties SobolSampler::ToProperties(const Properties &cfg) {
 	return Properties() <<
-			cfg.Get(GetDefaultProps().Get("sampler.type"));
+			cfg.Get(GetDefaultProps().Get("sampler.type")) <<
+			cfg.Get(GetDefaultProps().Get("sampler.sobol.adaptive.strength"));
 }
 
 Sampler *SobolSampler::FromProperties(const Properties &cfg, RandomGenerator *rndGen,
@@ -125,7 +168,8 @@ slg::ocl::Sampler *SobolSampler::FromPropertiesOCL(const Properties &cfg) {
 const Properties &SobolSampler::GetDefaultProps() {
 	static Properties props = Properties() <<
 			Sampler::GetDefaultProps() <<
-			Property("sampler.type")(GetObjectTag());
+			Property("sampler.type")(GetObjectTag()) <<
+			Property("sampler.sobol.adaptive.strength")(0.f);
 
 	return props;
 }
@@ -16,6 +16,8 @@
  * limitations under the License.                                          *
  ***************************************************************************/
 
+#include <typeinfo>
+
 #include "slg/scene/extmeshcache.h"
 
 using namespace std;
@@ -32,35 +34,101 @@ ExtMeshCache::~ExtMeshCache() {
 			meshes[i]->Delete();
 		delete meshes[i];
 	}
+
+	for (boost::unordered_map<string, ExtMeshDataOwner *>::const_iterator it = dataOwnersByName.begin();
+			it != dataOwnersByName.end(); ++it)
+		delete it->second;
+}
+
+void ExtMeshCache::AddExtMesh(ExtMesh *mesh) {
+	meshIndices.insert(make_pair(mesh, meshes.size()));
+	meshes.push_back(mesh);
+}
+
+void ExtMeshCache::SetExtMeshDataOwner(const string &meshName, ExtMeshDataOwner *owner) {
+	DeleteExtMeshDataOwner(meshName);
+
+	dataOwnersByName.insert(make_pair(meshName, owner));
+}
+
+void ExtMeshCache::DeleteExtMeshDataOwner(const string &meshName) {
+	boost::unordered_map<string, ExtMeshDataOwner *>::iterator it = dataOwnersByName.find(meshName);
+	if (it != dataOwnersByName.end()) {
+		delete it->second;
+		dataOwnersByName.erase(it);
+	}
 }
 
-void ExtMeshCache::DefineExtMesh(const string &meshName, ExtMesh *mesh) {
+bool ExtMeshCache::IsExtMeshUpdateInPlace(const string &meshName, const ExtMesh *mesh) const {
+	boost::unordered_map<string, ExtMesh *>::const_iterator it = meshByName.find(meshName);
+	if (it == meshByName.end())
+		return false;
+
+	const ExtMesh *oldMesh = it->second;
+	if (oldMesh == mesh)
+		return false;
+
+	// Only plain triangle meshes own their vertex data (i.e. the ones of
+	// memory mapped, instanced, motion and curve meshes can not be swapped)
+	if ((typeid(*oldMesh) != typeid(ExtTriangleMesh)) || (typeid(*mesh) != typeid(ExtTriangleMesh)))
+		return false;
+
+	return ((const ExtTriangleMesh *)oldMesh)->HasSameTopology(*((const ExtTriangleMesh *)mesh));
+}
+
+ExtMesh *ExtMeshCache::DefineExtMesh(const string &meshName, ExtMesh *mesh) {
+	if (IsExtMeshUpdateInPlace(meshName, mesh)) {
+		// Move the new data in the old mesh so all the references to the old
+		// mesh stay valid and the new mesh, with the old data, is deleted
+		ExtTriangleMesh *oldMesh = (ExtTriangleMesh *)GetExtMesh(meshName);
+		ExtTriangleMesh *newMesh = (ExtTriangleMesh *)mesh;
+
+		oldMesh->SwapData(*newMesh);
+
+		if (deleteMeshData)
+			newMesh->Delete();
+		delete newMesh;
+		// The old data is not used anymore
+		DeleteExtMeshDataOwner(meshName);
+
+		return oldMesh;
+	}
+
 	if (meshByName.count(meshName) == 0) {
 		// It is a new mesh
 		meshByName.insert(make_pair(meshName, mesh));
-		meshes.push_back(mesh);
+		AddExtMesh(mesh);
+
+		handlesByName.insert(make_pair(meshName, meshesByHandle.size()));
+		meshesByHandle.push_back(mesh);
 	} else {
 		// Replace an old mesh
 		const u_int index = GetExtMeshIndex(meshName);
 		ExtMesh *oldMesh = meshes[index];
 
 		meshes[index] = mesh;
+		meshIndices.erase(oldMesh);
+		meshIndices.insert(make_pair(mesh, index));
 		meshByName.erase(meshName);
 		meshByName.insert(make_pair(meshName, mesh));
+		meshesByHandle[GetExtMeshHandle(meshName)] = mesh;
 
 		if (deleteMeshData)
 			oldMesh->Delete();
 		delete oldMesh;
+		DeleteExtMeshDataOwner(meshName);
 	}
+
+	return mesh;
 }
 
-void ExtMeshCache::DefineExtMesh(const string &meshName,
+ExtMesh *ExtMeshCache::DefineExtMesh(const string &meshName,
 		const u_int plyNbVerts, const u_int plyNbTris,
 		Point *p, Triangle *vi, Normal *n, UV *uv, Spectrum *cols, float *alphas) {
 	ExtTriangleMesh *mesh = new ExtTriangleMesh(
 			plyNbVerts, plyNbTris, p, vi, n, uv, cols, alphas);
 
-	DefineExtMesh(meshName, mesh);
+	return DefineExtMesh(meshName, mesh);
 }
 
 void ExtMeshCache::DeleteExtMesh(const string &meshName) {
@@ -69,9 +137,18 @@ void ExtMeshCache::DeleteExtMesh(const string &meshName) {
 	if (deleteMeshData)
 		meshes[index]->Delete();
 	delete meshes[index];
+	DeleteExtMeshDataOwner(meshName);
 
+	meshIndices.erase(meshes[index]);
 	meshes.erase(meshes.begin() + index);
 	meshByName.erase(meshName);
+
+	meshesByHandle[GetExtMeshHandle(meshName)] = NULL;
+	handlesByName.erase(meshName);
+
+	// Update the indices of the following meshes
+	for (u_int i = index; i < meshes.size(); ++i)
+		meshIndices[meshes[i]] = i;
 }
 
 ExtMesh *ExtMeshCache::GetExtMesh(const string &meshName) {
@@ -96,7 +173,7 @@ ExtMesh *ExtMeshCache::GetExtMesh(const string &meshName, const Transform &trans
 		throw runtime_error("Wrong mesh type: " + meshName);
 
 	ExtInstanceTriangleMesh *imesh = new ExtInstanceTriangleMesh(tmesh, trans);
-	meshes.push_back(imesh);
+	AddExtMesh(imesh);
 
 	return imesh;
 }
@@ -111,7 +188,7 @@ ExtMesh *ExtMeshCache::GetExtMesh(const string &meshName, const MotionSystem &ms
 		throw runtime_error("Wrong mesh type: " + meshName);
 	
 	ExtMotionTriangleMesh *mmesh = new ExtMotionTriangleMesh(tmesh, ms);
-	meshes.push_back(mmesh);
+	AddExtMesh(mmesh);
 
 	return mmesh;
 }
@@ -119,18 +196,33 @@ ExtMesh *ExtMeshCache::GetExtMesh(const string &meshName, const MotionSystem &ms
 u_int ExtMeshCache::GetExtMeshIndex(const string &meshName) const {
 	boost::unordered_map<string, ExtMesh *>::const_iterator it = meshByName.find(meshName);
 
-	return GetExtMeshIndex(it->second);
+	if (it == meshByName.end())
+		throw runtime_error("Unknown mesh: " + meshName);
+	else
+		return GetExtMeshIndex(it->second);
 }
 
 u_int ExtMeshCache::GetExtMeshIndex(const ExtMesh *m) const {
-	// TODO: use a boost::unordered_map
-	u_int i = 0;
-	for (vector<ExtMesh *>::const_iterator it = meshes.begin(); it != meshes.end(); ++it) {
-		if (*it == m)
-			return i;
-		else
-			++i;
-	}
+	boost::unordered_map<const ExtMesh *, u_int>::const_iterator it = meshIndices.find(m);
+
+	if (it == meshIndices.end())
+		throw runtime_error("Unknown mesh: " + boost::lexical_cast<string>(m));
+	else
+		return it->second;
+}
+
+u_int ExtMeshCache::GetExtMeshHandle(const string &meshName) const {
+	boost::unordered_map<string, u_int>::const_iterator it = handlesByName.find(meshName);
+
+	if (it == handlesByName.end())
+		throw runtime_error("Unknown mesh: " + meshName);
+	else
+		return it->second;
+}
+
+ExtMesh *ExtMeshCache::GetExtMeshByHandle(const u_int handle) {
+	if ((handle >= meshesByHandle.size()) || !meshesByHandle[handle])
+		throw runtime_error("Unknown mesh handle: " + boost::lexical_cast<string>(handle));
 
-	throw runtime_error("Unknown mesh: " + boost::lexical_cast<string>(m));
+	return meshesByHandle[handle];
 }
@@ -212,6 +212,9 @@ LightSource *Scene::CreateLightSource(const string &lightName, const luxrays::Pr
 		sl->hasGroundAutoScale = props.Get(Property(propName + ".ground.autoscale")(true)).Get<bool>();
 		sl->groundColor = props.Get(Property(propName + ".ground.color")(Spectrum(.75f, .75f, .75f))).Get<Spectrum>().Clamp(0.f);
 		sl->localSunDir = Normalize(props.Get(Property(propName + ".dir")(0.f, 0.f, 1.f)).Get<Vector>());
+		sl->useSkyDistribution = props.Get(Property(propName + ".distribution.enable")(false)).Get<bool>();
+		sl->skyDistributionWidth = Max(1u, props.Get(Property(propName + ".distribution.width")(512u)).Get<u_int>());
+		sl->skyDistributionHeight = Max(1u, props.Get(Property(propName + ".distribution.height")(256u)).Get<u_int>());
 
 		sl->SetIndirectDiffuseVisibility(props.Get(Property(propName + ".visibility.indirect.diffuse.enable")(true)).Get<bool>());
 		sl->SetIndirectGlossyVisibility(props.Get(Property(propName + ".visibility.indirect.glossy.enable")(true)).Get<bool>());
@@ -234,6 +237,13 @@ LightSource *Scene::CreateLightSource(const string &lightName, const luxrays::Pr
 		il->lightToWorld = light2World;
 		il->imageMap = imgMap;
 		il->sampleUpperHemisphereOnly = props.Get(Property(propName + ".sampleupperhemisphereonly")(false)).Get<bool>();
+		// Only the surfaces transparent to shadow rays (i.e. null and archglass
+		// materials, alpha maps, etc.) let the visibility map rays pass. Use
+		// archglass for the windows of an interior lit by the infinite light.
+		il->useVisibilityMap = props.Get(Property(propName + ".visibilitymap.enable")(false)).Get<bool>();
+		il->visibilityMapWidth = Max(1u, props.Get(Property(propName + ".visibilitymap.width")(64u)).Get<u_int>());
+		il->visibilityMapHeight = Max(1u, props.Get(Property(propName + ".visibilitymap.height")(32u)).Get<u_int>());
+		il->visibilityMapSamples = Max(1u, props.Get(Property(propName + ".visibilitymap.samples")(64u)).Get<u_int>());
 
 		// An old parameter kept only for compatibility
 		const UV shift = props.Get(Property(propName + ".shift")(0.f, 0.f)).Get<UV>();
@@ -57,6 +57,8 @@ void Scene::ParseObjects(const Properties &props) {
 				(((u_int)(RadicalInverse(objDefs.GetSize() + 1, 5) * 255.f + .5f)) << 16);
 		SceneObject *obj = CreateObject(objID, objName, props);
 		objDefs.DefineSceneObject(objName, obj);
+		// Instances are new meshes too
+		editedMeshes.insert(obj->GetExtMesh());
 
 		// Check if it is a light source
 		const Material *mat = obj->GetMaterial();
@@ -102,6 +104,7 @@ SceneObject *Scene::CreateObject(const u_int defaultObjID, const string &objName
 			// It is a mesh to define
 			ExtTriangleMesh *mesh = ExtTriangleMesh::LoadExtTriangleMesh(meshName);
 			extMeshCache.DefineExtMesh(meshName, mesh);
+			editedMeshes.insert(mesh);
 		}
 	} else if (props.IsDefined(propName + ".vertices")) {
 		// For compatibility with the past SDL syntax
@@ -111,6 +114,7 @@ SceneObject *Scene::CreateObject(const u_int defaultObjID, const string &objName
 			// It is a mesh to define
 			ExtMesh *mesh = CreateInlinedMesh(meshName, propName, props);
 			extMeshCache.DefineExtMesh(meshName, mesh);
+			editedMeshes.insert(mesh);
 		}
 	} else if (props.IsDefined(propName + ".shape")) {
 		meshName = props.Get(Property(propName + ".shape")("")).Get<string>();
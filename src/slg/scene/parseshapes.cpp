@@ -50,7 +50,8 @@ void Scene::ParseShapes(const Properties &props) {
 			throw runtime_error("Syntax error in shape definition: " + shapeName);
 
 		ExtMesh *mesh = CreateShape(shapeName, props);
-		if (extMeshCache.IsExtMeshDefined(shapeName)) {
+		if (extMeshCache.IsExtMeshDefined(shapeName) &&
+				!extMeshCache.IsExtMeshUpdateInPlace(shapeName, mesh)) {
 			// A replacement for an existing mesh
 			const ExtMesh *oldMesh = extMeshCache.GetExtMesh(shapeName);
 
@@ -86,7 +87,8 @@ void Scene::ParseShapes(const Properties &props) {
 			}
 		}
 
-		extMeshCache.DefineExtMesh(shapeName, mesh);
+		// A mesh with the same topology of the old one is updated in place
+		DefineExtMesh(shapeName, mesh);
 
 		++shapeCount;
 
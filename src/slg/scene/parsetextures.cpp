@@ -122,7 +122,8 @@ Texture *Scene::CreateTexture(const string &texName, const Properties &props) {
 		const ImageMapStorage::StorageType storageType = ImageMapStorage::String2StorageType(
 			props.Get(Property(propName + ".storage")("auto")).Get<string>());
 
-		ImageMap *im = imgMapCache.GetImageMap(name, gamma, selectionType, storageType);
+		// Image textures can be read on demand from a tiled MIP-mapped file
+		ImageMap *im = imgMapCache.GetImageMap(name, gamma, selectionType, storageType, true);
 		return new ImageMapTexture(im, CreateTextureMapping2D(propName + ".mapping", props), gain);
 	} else if (texType == "constfloat1") {
 		const float v = props.Get(Property(propName + ".value")(1.f)).Get<float>();
@@ -130,8 +130,12 @@ Volume *Scene::CreateVolume(const u_int defaultVolID, const string &volName, con
 		const float stepSize =  props.Get(Property(propName + ".steps.size")(1.f)).Get<float>();
 		const u_int maxStepsCount =  props.Get(Property(propName + ".steps.maxcount")(32u)).Get<u_int>();
 		const bool multiScattering =  props.Get(Property(propName + ".multiscattering")(false)).Get<bool>();
+		const HeterogeneousVolume::TrackingType tracking = HeterogeneousVolume::String2TrackingType(
+				props.Get(Property(propName + ".tracking.type")("raymarching")).Get<string>());
+		const float majorant =  props.Get(Property(propName + ".tracking.majorant")(0.f)).Get<float>();
 
-		vol = new HeterogeneousVolume(iorTex, emissionTex, absorption, scattering, asymmetry, stepSize, maxStepsCount, multiScattering);
+		vol = new HeterogeneousVolume(iorTex, emissionTex, absorption, scattering, asymmetry, stepSize, maxStepsCount, multiScattering,
+				tracking, majorant);
 	} else
 		throw runtime_error("Unknown volume type: " + volType);
 
@@ -52,8 +52,12 @@ Scene::Scene(const float imageScale) {
 	Init(imageScale);
 }
 
-Scene::Scene(const string &fileName, const float imageScale) {
+Scene::Scene(const string &fileName, const float imageScale,
+		const size_t imageCacheSize, const string &imageCacheDir) {
 	Init(imageScale);
+	// The cache has to be enabled before to read the image maps
+	if (imageCacheSize > 0)
+		imgMapCache.EnableTileCache(imageCacheSize, imageCacheDir);
 
 	SDL_LOG("Reading scene: " << fileName);
 
@@ -72,6 +76,8 @@ void Scene::Init(const float imageScale) {
 	imgMapCache.SetImageResize(imageScale);
 
 	enableParsePrint = false;
+	hasShadowTransparentMaterials = true;
+	envLightVisibilityMapsDirty = false;
 }
 
 Scene::~Scene() {
@@ -111,23 +117,55 @@ void Scene::Preprocess(Context *ctx, const u_int filmWidth, const u_int filmHeig
 	if (editActions.Has(CAMERA_EDIT))
 		PreprocessCamera(filmWidth, filmHeight, filmSubRegion);
 
+	// Strands are intersected as native curves only by Embree
+	const Properties &ctxCfg = ctx->GetConfig();
+	const AcceleratorType accelType = Accelerator::String2AcceleratorType(
+			ctxCfg.Get(Property("accelerator.type")("AUTO")).Get<string>());
+	const bool enableCurves = ctxCfg.Get(Property("accelerator.curves.enable")(true)).Get<bool>() &&
+			((accelType == ACCEL_AUTO) || (accelType == ACCEL_EMBREE));
+	TessellateCurves(enableCurves);
+
 	// Check if I have to rebuild the dataset
 	if (editActions.Has(GEOMETRY_EDIT) || (editActions.Has(GEOMETRY_TRANS_EDIT) &&
 			!dataSet->DoesAllAcceleratorsSupportUpdate())) {
-		// Rebuild the data set
-		delete dataSet;
-		dataSet = new DataSet(ctx);
-
-		// Add all objects
+		deque<const Mesh *> meshes;
 		for (u_int i = 0; i < objDefs.GetSize(); ++i)
-			dataSet->Add(objDefs.GetSceneObject(i)->GetExtMesh());
+			meshes.push_back(objDefs.GetSceneObject(i)->GetExtMesh());
+
+		if (dataSet && (dataSet->GetContext() == ctx) &&
+				dataSet->DoesAllAcceleratorsSupportMeshesUpdate()) {
+			// Rebuild only the parts of the accelerators depending on
+			// new or edited meshes and refit the deformed ones
+			dataSet->UpdateMeshes(meshes, editedMeshes, deformedMeshes);
+		} else {
+			// Rebuild the data set
+			delete dataSet;
+			dataSet = new DataSet(ctx);
+
+			// Add all objects
+			BOOST_FOREACH(const Mesh *mesh, meshes)
+				dataSet->Add(mesh);
 
-		dataSet->Preprocess();
+			dataSet->Preprocess();
+		}
 	} else if(editActions.Has(GEOMETRY_TRANS_EDIT)) {
 		// I have only to update the DataSet bounding boxes
 		dataSet->UpdateBBoxes();
 	}
 
+	// Check if shadow rays can use the occlusion only query
+	if (editActions.Has(MATERIALS_EDIT) || editActions.Has(MATERIAL_TYPES_EDIT)) {
+		hasShadowTransparentMaterials = false;
+		for (u_int i = 0; i < matDefs.GetSize(); ++i) {
+			const Material *mat = matDefs.GetMaterial(i);
+			// Volumes are handled separately
+			if (!dynamic_cast<const Volume *>(mat) && mat->IsShadowTransparent()) {
+				hasShadowTransparentMaterials = true;
+				break;
+			}
+		}
+	}
+
 	// Check if something has changed in light sources
 	if (editActions.Has(GEOMETRY_EDIT) ||
 			editActions.Has(GEOMETRY_TRANS_EDIT) ||
@@ -139,7 +177,84 @@ void Scene::Preprocess(Context *ctx, const u_int filmWidth, const u_int filmHeig
 		lightDefs.Preprocess(this);
 	}
 
+	// The env. light sources depending on the geometry and camera are
+	// updated by UpdateEnvLightVisibilityMaps()
+	if (editActions.Has(CAMERA_EDIT) ||
+			editActions.Has(GEOMETRY_EDIT) ||
+			editActions.Has(GEOMETRY_TRANS_EDIT) ||
+			editActions.Has(LIGHTS_EDIT) ||
+			editActions.Has(LIGHT_TYPES_EDIT) ||
+			editActions.Has(IMAGEMAPS_EDIT))
+		envLightVisibilityMapsDirty = true;
+
 	editActions.Reset();
+	editedMeshes.clear();
+	deformedMeshes.clear();
+}
+
+void Scene::UpdateEnvLightVisibilityMaps(const u_int filmWidth, const u_int filmHeight) {
+	if (!envLightVisibilityMapsDirty)
+		return;
+
+	BOOST_FOREACH(EnvLightSource *envLight, lightDefs.GetEnvLightSources())
+		envLight->UpdateVisibilityMap(this, filmWidth, filmHeight);
+
+	envLightVisibilityMapsDirty = false;
+}
+
+bool Scene::HasEnvLightVisibilityMaps() const {
+	BOOST_FOREACH(const EnvLightSource *envLight, lightDefs.GetEnvLightSources()) {
+		if (envLight->HasVisibilityMap())
+			return true;
+	}
+
+	return false;
+}
+
+void Scene::TessellateCurves(const bool enableCurves) {
+	// The curves have to be tessellated if they are not supported by the
+	// accelerator, for motion blur and to be used as light sources
+	boost::unordered_set<ExtCurveMesh *> curveMeshes;
+	for (u_int i = 0; i < objDefs.GetSize(); ++i) {
+		const SceneObject *obj = objDefs.GetSceneObject(i);
+		const ExtMesh *mesh = obj->GetExtMesh();
+
+		ExtCurveMesh *curveMesh = mesh->GetCurveMesh();
+		if (curveMesh && (!enableCurves || (mesh->GetType() == TYPE_EXT_TRIANGLE_MOTION) ||
+				obj->GetMaterial()->IsLightSource()))
+			curveMeshes.insert(curveMesh);
+	}
+
+	if (curveMeshes.size() == 0)
+		return;
+
+	// The triangle lights of the objects using the tessellated curves (an
+	// instanced mesh can be shared by more objects) have to be defined
+	vector<const SceneObject *> lightObjs;
+	for (u_int i = 0; i < objDefs.GetSize(); ++i) {
+		const SceneObject *obj = objDefs.GetSceneObject(i);
+		const ExtMesh *mesh = obj->GetExtMesh();
+
+		if (curveMeshes.count(mesh->GetCurveMesh()) > 0) {
+			editedMeshes.insert(mesh);
+			if (obj->GetMaterial()->IsLightSource())
+				lightObjs.push_back(obj);
+		}
+	}
+
+	BOOST_FOREACH(ExtCurveMesh *curveMesh, curveMeshes) {
+		curveMesh->Tessellate();
+		editedMeshes.insert(curveMesh);
+	}
+	editActions.AddAction(GEOMETRY_EDIT);
+
+	if (lightObjs.size() > 0) {
+		BOOST_FOREACH(const SceneObject *obj, lightObjs)
+			objDefs.DefineIntersectableLights(lightDefs, obj);
+
+		editActions.AddAction(LIGHTS_EDIT);
+		editActions.AddAction(LIGHT_TYPES_EDIT);
+	}
 }
 
 Properties Scene::ToProperties() {
@@ -209,19 +324,53 @@ bool Scene::IsImageMapDefined(const string &imgMapName) const {
 	return imgMapCache.IsImageMapDefined(imgMapName);
 }
 
-void Scene::DefineMesh(const string &meshName, luxrays::ExtTriangleMesh *mesh) {
-	extMeshCache.DefineExtMesh(meshName, mesh);
+void Scene::DefineExtMesh(const string &meshName, ExtMesh *mesh) {
+	ExtMesh *definedMesh = extMeshCache.DefineExtMesh(meshName, mesh);
+
+	if (definedMesh != mesh) {
+		// The old mesh has been updated in place with the new vertices (and
+		// mesh has been deleted): the accelerators can be just refitted
+		deformedMeshes.insert(definedMesh);
+
+		UpdateMeshTriangleLights(definedMesh);
+	} else
+		editedMeshes.insert(mesh);
 
 	editActions.AddAction(GEOMETRY_EDIT);
 }
 
+void Scene::UpdateMeshTriangleLights(const ExtMesh *mesh) {
+	for (u_int i = 0; i < objDefs.GetSize(); ++i) {
+		const SceneObject *obj = objDefs.GetSceneObject(i);
+		if (!obj->GetMaterial()->IsLightSource())
+			continue;
+
+		// Check if the object uses the mesh directly or with an instance
+		boost::unordered_set<const ExtMesh *> referencedMeshes;
+		obj->AddReferencedMeshes(referencedMeshes);
+
+		if (referencedMeshes.count(mesh) > 0) {
+			const string objName = obj->GetName();
+			const ExtMesh *objMesh = obj->GetExtMesh();
+
+			// The triangle areas have changed
+			for (u_int j = 0; j < objMesh->GetTotalTriangleCount(); ++j)
+				lightDefs.GetLightSource(objName + TRIANGLE_LIGHT_POSTFIX + ToString(j))->Preprocess();
+
+			editActions.AddActions(LIGHTS_EDIT | LIGHT_TYPES_EDIT);
+		}
+	}
+}
+
+void Scene::DefineMesh(const string &meshName, luxrays::ExtTriangleMesh *mesh) {
+	DefineExtMesh(meshName, mesh);
+}
+
 void Scene::DefineMesh(const string &shapeName,
 	const long plyNbVerts, const long plyNbTris,
 	luxrays::Point *p, luxrays::Triangle *vi, luxrays::Normal *n, luxrays::UV *uv,
 	luxrays::Spectrum *cols, float *alphas) {
-	extMeshCache.DefineExtMesh(shapeName, plyNbVerts, plyNbTris, p, vi, n, uv, cols, alphas);
-
-	editActions.AddAction(GEOMETRY_EDIT);
+	DefineExtMesh(shapeName, new ExtTriangleMesh(plyNbVerts, plyNbTris, p, vi, n, uv, cols, alphas));
 }
 
 void Scene::DefineStrands(const string &shapeName, const cyHairFile &strandsFile,
@@ -236,9 +385,7 @@ void Scene::DefineStrands(const string &shapeName, const cyHairFile &strandsFile
 			useCameraPosition);
 
 	ExtMesh *mesh = shape.Refine(this);
-	extMeshCache.DefineExtMesh(shapeName, mesh);
-
-	editActions.AddAction(GEOMETRY_EDIT);
+	DefineExtMesh(shapeName, mesh);
 }
 
 bool Scene::IsTextureDefined(const string &texName) const {
@@ -408,24 +555,37 @@ void Scene::RemoveUnusedMeshes() {
 
 	// Get the list of all defined objects
 	const vector<string> definedObjects = objDefs.GetSceneObjectNames();
-	bool deleted = false;
+	vector<SceneHandle> deletedObjects;
 	BOOST_FOREACH(const string  &objName, definedObjects) {
 		SceneObject *obj = objDefs.GetSceneObject(objName);
 
 		if (referencedMesh.count(obj->GetExtMesh()) == 0) {
 			SDL_LOG("Deleting unreferenced mesh: " << objName);
-			objDefs.DeleteSceneObject(objName);
-			deleted = true;
+			deletedObjects.push_back(objDefs.GetSceneObjectHandle(objName));
 		}
 	}
 
-	if (deleted)
+	if (deletedObjects.size() > 0) {
+		objDefs.DeleteSceneObjects(deletedObjects);
 		editActions.AddAction(GEOMETRY_EDIT);
+	}
 }
 
 void Scene::DeleteObject(const string &objName) {
-	if (objDefs.IsSceneObjectDefined(objName)) {
-		const SceneObject *oldObj = objDefs.GetSceneObject(objName);
+	if (objDefs.IsSceneObjectDefined(objName))
+		DeleteObjects(vector<SceneHandle>(1, objDefs.GetSceneObjectHandle(objName)));
+}
+
+void Scene::DeleteObjects(const vector<SceneHandle> &objHandles) {
+	if (objHandles.size() == 0)
+		return;
+
+	// Check all the handles before to modify anything, a duplicated handle
+	// would delete the same triangle lights twice
+	const vector<SceneHandle> uniqueObjHandles = objDefs.GetUniqueSceneObjectHandles(objHandles);
+
+	BOOST_FOREACH(const SceneHandle objHandle, uniqueObjHandles) {
+		const SceneObject *oldObj = objDefs.GetSceneObjectByHandle(objHandle);
 		const bool wasLightSource = oldObj->GetMaterial()->IsLightSource();
 
 		// Check if the old object was a light source
@@ -437,19 +597,37 @@ void Scene::DeleteObject(const string &objName) {
 			for (u_int i = 0; i < mesh->GetTotalTriangleCount(); ++i)
 				lightDefs.DeleteLightSource(oldObj->GetName() + TRIANGLE_LIGHT_POSTFIX + ToString(i));
 		}
+	}
 
-		objDefs.DeleteSceneObject(objName);
+	objDefs.DeleteSceneObjects(uniqueObjHandles);
 
-		editActions.AddAction(GEOMETRY_EDIT);
-	}
+	editActions.AddAction(GEOMETRY_EDIT);
 }
 
 void Scene::DeleteLight(const string &lightName) {
-	if (lightDefs.IsLightSourceDefined(lightName)) {
-		lightDefs.DeleteLightSource(lightName);
+	if (lightDefs.IsLightSourceDefined(lightName))
+		DeleteLights(vector<SceneHandle>(1, lightDefs.GetLightSourceHandle(lightName)));
+}
+
+void Scene::DeleteLights(const vector<SceneHandle> &lightHandles) {
+	if (lightHandles.size() == 0)
+		return;
+
+	// Check all the handles before to modify anything
+	vector<string> lightNames;
+	lightNames.reserve(lightHandles.size());
+	boost::unordered_set<SceneHandle> handlesDone;
+	BOOST_FOREACH(const SceneHandle lightHandle, lightHandles) {
+		const string &lightName = lightDefs.GetLightSourceName(lightHandle);
 
-		editActions.AddActions(LIGHTS_EDIT | LIGHT_TYPES_EDIT);
+		if (handlesDone.insert(lightHandle).second)
+			lightNames.push_back(lightName);
 	}
+
+	BOOST_FOREACH(const string &lightName, lightNames)
+		lightDefs.DeleteLightSource(lightName);
+
+	editActions.AddActions(LIGHTS_EDIT | LIGHT_TYPES_EDIT);
 }
 
 //------------------------------------------------------------------------------
@@ -458,18 +636,29 @@ bool Scene::Intersect(IntersectionDevice *device,
 		const bool fromLight, PathVolumeInfo *volInfo,
 		const float initialPassThrough, Ray *ray, RayHit *rayHit, BSDF *bsdf,
 		Spectrum *connectionThroughput, const Spectrum *pathThroughput,
-		SampleResult *sampleResult) const {
+		SampleResult *sampleResult, const PathFootprint *pathFootprint) const {
+	return Intersect(device, fromLight, volInfo, initialPassThrough, ray, rayHit, bsdf,
+			connectionThroughput, pathThroughput, sampleResult, pathFootprint, false);
+}
+
+bool Scene::Intersect(IntersectionDevice *device,
+		const bool fromLight, PathVolumeInfo *volInfo,
+		const float initialPassThrough, Ray *ray, RayHit *rayHit, BSDF *bsdf,
+		Spectrum *connectionThroughput, const Spectrum *pathThroughput,
+		SampleResult *sampleResult, const PathFootprint *pathFootprint,
+		const bool firstHitTraced) const {
 	*connectionThroughput = Spectrum(1.f);
 
 	float passThrough = initialPassThrough;
 	const float originalMaxT = ray->maxt;
 
-	for (;;) {
-		const bool hit = device->TraceRay(ray, rayHit);
+	for (bool traceRay = !firstHitTraced;; traceRay = true) {
+		const bool hit = traceRay ? device->TraceRay(ray, rayHit) : !rayHit->Miss();
 
 		const Volume *rayVolume = volInfo->GetCurrentVolume();
 		if (hit) {
-			bsdf->Init(fromLight, *this, *ray, *rayHit, passThrough, volInfo);
+			bsdf->Init(fromLight, *this, *ray, *rayHit, passThrough, volInfo,
+					pathFootprint ? pathFootprint->GetFootprint(rayHit->t) : 0.f);
 			rayVolume = bsdf->hitPoint.intoObject ? bsdf->hitPoint.exteriorVolume : bsdf->hitPoint.interiorVolume;
 			ray->maxt = rayHit->t;
 		} else if (!rayVolume) {
@@ -548,3 +737,40 @@ bool Scene::Intersect(IntersectionDevice *device,
 		passThrough = fabsf(passThrough - .5f) * 2.f;
 	}
 }
+
+bool Scene::Occluded(IntersectionDevice *device,
+		const bool fromLight, PathVolumeInfo *volInfo,
+		const float passThrough, Ray *ray, Spectrum *connectionThroughput) const {
+	// The occlusion query can be used only if there are no volumes along the ray
+	if (!volInfo->GetCurrentVolume() && !defaultWorldVolume) {
+		if (!hasShadowTransparentMaterials) {
+			// Nothing can let the ray pass, any hit is good enough
+			*connectionThroughput = Spectrum(1.f);
+
+			return device->TraceOccludedRay(ray);
+		}
+
+		// Look only at the material of the closest hit before evaluating
+		// the BSDF
+		RayHit rayHit;
+		if (!device->TraceRay(ray, &rayHit)) {
+			*connectionThroughput = Spectrum(1.f);
+
+			return false;
+		}
+
+		const Material *mat = objDefs.GetSceneObject(rayHit.meshIndex)->GetMaterial();
+		if (!mat->IsShadowTransparent())
+			return true;
+
+		// Continue with the complete path from the hit already traced
+		BSDF bsdf;
+		return Intersect(device, fromLight, volInfo, passThrough, ray, &rayHit, &bsdf,
+				connectionThroughput, NULL, NULL, NULL, true);
+	}
+
+	// The complete path, with BSDF evaluation at each hit
+	RayHit rayHit;
+	BSDF bsdf;
+	return Intersect(device, fromLight, volInfo, passThrough, ray, &rayHit, &bsdf, connectionThroughput);
+}
@@ -79,7 +79,7 @@ Properties SceneObject::ToProperties(const ExtMeshCache &extMeshCache) const {
 // SceneObjectDefinitions
 //------------------------------------------------------------------------------
 
-SceneObjectDefinitions::SceneObjectDefinitions() { }
+SceneObjectDefinitions::SceneObjectDefinitions() : indicesByMeshValid(true) { }
 
 SceneObjectDefinitions::~SceneObjectDefinitions() {
 	BOOST_FOREACH(SceneObject *o, objs)
@@ -87,21 +87,48 @@ SceneObjectDefinitions::~SceneObjectDefinitions() {
 }
 
 void SceneObjectDefinitions::DefineSceneObject(const std::string &name, SceneObject *newObj) {
-	if (IsSceneObjectDefined(name)) {
-		const SceneObject *oldObj = GetSceneObject(name);
+	boost::unordered_map<std::string, SceneHandle>::const_iterator it = handlesByName.find(name);
+
+	if (it != handlesByName.end()) {
+		// Update name/SceneObject definition, the handle doesn't change
+		const u_int index = indicesBySlot[GetSceneHandleSlot(it->second)];
+		const SceneObject *oldObj = objs[index];
 
-		// Update name/SceneObject definition
-		const u_int index = GetSceneObjectIndex(name);
 		objs[index] = newObj;
-		objsByName.erase(name);
-		objsByName.insert(std::make_pair(name, newObj));
+		indicesByObj.erase(oldObj);
+		indicesByObj.insert(std::make_pair(newObj, index));
+		indicesByMeshValid = false;
 
 		// Delete old SceneObject
 		delete oldObj;
 	} else {
 		// Add the new SceneObject
+		const u_int index = objs.size();
+
+		// Reuse the slot of a deleted SceneObject if available
+		u_int slot;
+		if (freeSlots.size() > 0) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+
+			indicesBySlot[slot] = index;
+			namesBySlot[slot] = name;
+		} else {
+			slot = indicesBySlot.size();
+
+			indicesBySlot.push_back(index);
+			namesBySlot.push_back(name);
+			generationsBySlot.push_back(0);
+		}
+		const SceneHandle handle = MakeSceneHandle(slot, generationsBySlot[slot]);
+
 		objs.push_back(newObj);
-		objsByName.insert(std::make_pair(name, newObj));
+		objHandles.push_back(handle);
+		handlesByName.insert(std::make_pair(name, handle));
+		indicesByObj.insert(std::make_pair(newObj, index));
+		// The index of the first object using the mesh is retained
+		if (indicesByMeshValid)
+			indicesByMesh.insert(std::make_pair(newObj->GetExtMesh(), index));
 	}
 }
 
@@ -130,51 +157,84 @@ void SceneObjectDefinitions::DefineIntersectableLights(LightSourceDefinitions &l
 }
 
 const SceneObject *SceneObjectDefinitions::GetSceneObject(const std::string &name) const {
-	// Check if the SceneObject has been already defined
-	boost::unordered_map<std::string, SceneObject *>::const_iterator it = objsByName.find(name);
+	return objs[GetSceneObjectIndex(name)];
+}
 
-	if (it == objsByName.end())
-		throw std::runtime_error("Reference to an undefined SceneObject: " + name);
+SceneObject *SceneObjectDefinitions::GetSceneObject(const std::string &name) {
+	return objs[GetSceneObjectIndex(name)];
+}
+
+u_int SceneObjectDefinitions::GetSceneObjectIndex(const std::string &name) const {
+	return indicesBySlot[GetSceneHandleSlot(GetSceneObjectHandle(name))];
+}
+
+u_int SceneObjectDefinitions::GetSceneObjectIndex(const SceneObject *m) const {
+	boost::unordered_map<const SceneObject *, u_int>::const_iterator it = indicesByObj.find(m);
+
+	if (it == indicesByObj.end())
+		throw std::runtime_error("Reference to an undefined SceneObject: " + boost::lexical_cast<std::string>(m));
 	else
 		return it->second;
 }
 
-SceneObject *SceneObjectDefinitions::GetSceneObject(const std::string &name) {
+void SceneObjectDefinitions::UpdateIndicesByMesh() const {
+	indicesByMesh.clear();
+	// The index of the first object using the mesh is retained
+	for (u_int i = 0; i < objs.size(); ++i)
+		indicesByMesh.insert(std::make_pair(objs[i]->GetExtMesh(), i));
+
+	indicesByMeshValid = true;
+}
+
+u_int SceneObjectDefinitions::GetSceneObjectIndex(const ExtMesh *mesh) const {
+	if (!indicesByMeshValid)
+		UpdateIndicesByMesh();
+
+	boost::unordered_map<const ExtMesh *, u_int>::const_iterator it = indicesByMesh.find(mesh);
+
+	if (it == indicesByMesh.end())
+		throw std::runtime_error("Reference to an undefined ExtMesh in a SceneObject: " + boost::lexical_cast<std::string>(mesh));
+	else
+		return it->second;
+}
+
+SceneHandle SceneObjectDefinitions::GetSceneObjectHandle(const std::string &name) const {
 	// Check if the SceneObject has been already defined
-	boost::unordered_map<std::string, SceneObject *>::const_iterator it = objsByName.find(name);
+	boost::unordered_map<std::string, SceneHandle>::const_iterator it = handlesByName.find(name);
 
-	if (it == objsByName.end())
+	if (it == handlesByName.end())
 		throw std::runtime_error("Reference to an undefined SceneObject: " + name);
 	else
 		return it->second;
 }
 
-u_int SceneObjectDefinitions::GetSceneObjectIndex(const std::string &name) const {
-	return GetSceneObjectIndex(GetSceneObject(name));
+void SceneObjectDefinitions::CheckHandle(const SceneHandle handle) const {
+	if (!IsSceneObjectHandleValid(handle))
+		throw std::runtime_error("Reference to an undefined SceneObject handle: " + ToString(handle));
 }
 
-u_int SceneObjectDefinitions::GetSceneObjectIndex(const SceneObject *m) const {
-	for (u_int i = 0; i < objs.size(); ++i) {
-		if (m == objs[i])
-			return i;
-	}
+const SceneObject *SceneObjectDefinitions::GetSceneObjectByHandle(const SceneHandle handle) const {
+	CheckHandle(handle);
 
-	throw std::runtime_error("Reference to an undefined SceneObject: " + boost::lexical_cast<std::string>(m));
+	return objs[indicesBySlot[GetSceneHandleSlot(handle)]];
 }
 
-u_int SceneObjectDefinitions::GetSceneObjectIndex(const ExtMesh *mesh) const {
-	for (u_int i = 0; i < objs.size(); ++i) {
-		if (mesh == objs[i]->GetExtMesh())
-			return i;
-	}
+SceneObject *SceneObjectDefinitions::GetSceneObjectByHandle(const SceneHandle handle) {
+	CheckHandle(handle);
+
+	return objs[indicesBySlot[GetSceneHandleSlot(handle)]];
+}
 
-	throw std::runtime_error("Reference to an undefined ExtMesh in a SceneObject: " + boost::lexical_cast<std::string>(mesh));
+const std::string &SceneObjectDefinitions::GetSceneObjectName(const SceneHandle handle) const {
+	CheckHandle(handle);
+
+	return namesBySlot[GetSceneHandleSlot(handle)];
 }
 
 std::vector<std::string> SceneObjectDefinitions::GetSceneObjectNames() const {
 	std::vector<std::string> names;
 	names.reserve(objs.size());
-	for (boost::unordered_map<std::string, SceneObject *>::const_iterator it = objsByName.begin(); it != objsByName.end(); ++it)
+	for (boost::unordered_map<std::string, SceneHandle>::const_iterator it = handlesByName.begin(); it != handlesByName.end(); ++it)
 		names.push_back(it->first);
 
 	return names;
@@ -192,10 +252,68 @@ void SceneObjectDefinitions::UpdateMeshReferences(const ExtMesh *oldMesh, ExtMes
 		if (o->UpdateMeshReference(oldMesh, newMesh))
 			modifiedObjsList.insert(o);
 	}
+
+	indicesByMeshValid = false;
 }
 
 void SceneObjectDefinitions::DeleteSceneObject(const std::string &name) {
-	const u_int index = GetSceneObjectIndex(name);
-	objs.erase(objs.begin() + index);
-	objsByName.erase(name);
+	DeleteSceneObjects(std::vector<SceneHandle>(1, GetSceneObjectHandle(name)));
+}
+
+std::vector<SceneHandle> SceneObjectDefinitions::GetUniqueSceneObjectHandles(const std::vector<SceneHandle> &handles) const {
+	std::vector<SceneHandle> uniqueHandles;
+	uniqueHandles.reserve(handles.size());
+
+	boost::unordered_set<SceneHandle> handlesDone;
+	BOOST_FOREACH(const SceneHandle handle, handles) {
+		CheckHandle(handle);
+
+		if (handlesDone.insert(handle).second)
+			uniqueHandles.push_back(handle);
+	}
+
+	return uniqueHandles;
+}
+
+void SceneObjectDefinitions::DeleteSceneObjects(const std::vector<SceneHandle> &handles) {
+	if (handles.size() == 0)
+		return;
+
+	// Check all the handles before to modify anything
+	const std::vector<SceneHandle> uniqueHandles = GetUniqueSceneObjectHandles(handles);
+
+	// Mark the deleted objects
+	BOOST_FOREACH(const SceneHandle handle, uniqueHandles) {
+		const u_int slot = GetSceneHandleSlot(handle);
+		const u_int index = indicesBySlot[slot];
+		indicesByObj.erase(objs[index]);
+		objs[index] = NULL;
+
+		indicesBySlot[slot] = NULL_INDEX;
+		handlesByName.erase(namesBySlot[slot]);
+		// Release the memory of the name too
+		std::string().swap(namesBySlot[slot]);
+		// Invalidate the handles of the deleted object
+		++generationsBySlot[slot];
+		freeSlots.push_back(slot);
+	}
+
+	// Compact the object list in a single pass
+	u_int newIndex = 0;
+	for (u_int i = 0; i < objs.size(); ++i) {
+		if (!objs[i])
+			continue;
+
+		if (newIndex != i) {
+			objs[newIndex] = objs[i];
+			objHandles[newIndex] = objHandles[i];
+			indicesBySlot[GetSceneHandleSlot(objHandles[newIndex])] = newIndex;
+			indicesByObj[objs[newIndex]] = newIndex;
+		}
+		++newIndex;
+	}
+	objs.resize(newIndex);
+	objHandles.resize(newIndex);
+
+	indicesByMeshValid = false;
 }
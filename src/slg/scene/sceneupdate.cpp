@@ -28,7 +28,11 @@ void Scene::UpdateObjectTransformation(const string &objName, const Transform &t
 	if (!objDefs.IsSceneObjectDefined(objName))
 		throw runtime_error("Unknown object in Scene::UpdateObjectTransformation(): " + objName);
 
-	SceneObject *obj = objDefs.GetSceneObject(objName);
+	UpdateObjectTransformation(objDefs.GetSceneObjectHandle(objName), trans);
+}
+
+void Scene::UpdateObjectTransformation(const SceneHandle objHandle, const Transform &trans) {
+	SceneObject *obj = objDefs.GetSceneObjectByHandle(objHandle);
 	ExtMesh *mesh = obj->GetExtMesh();
 
 	ExtInstanceTriangleMesh *instanceMesh = dynamic_cast<ExtInstanceTriangleMesh *>(mesh);
@@ -36,7 +40,9 @@ void Scene::UpdateObjectTransformation(const string &objName, const Transform &t
 		instanceMesh->SetTransformation(trans);
 		editActions.AddAction(GEOMETRY_TRANS_EDIT);
 	} else {
+		// The vertices are moved in place so the accelerators can be refitted
 		mesh->ApplyTransform(trans);
+		deformedMeshes.insert(mesh);
 		editActions.AddAction(GEOMETRY_EDIT);
 	}
 
@@ -56,7 +62,13 @@ void Scene::UpdateObjectMaterial(const string &objName, const string &matName) {
 	if (!matDefs.IsMaterialDefined(matName))
 		throw runtime_error("Unknown material in Scene::UpdateObjectMaterial(): " + matName);
 
-	SceneObject *obj = objDefs.GetSceneObject(objName);
+	UpdateObjectMaterial(objDefs.GetSceneObjectHandle(objName), matDefs.GetMaterialHandle(matName));
+}
+
+void Scene::UpdateObjectMaterial(const SceneHandle objHandle, const SceneHandle matHandle) {
+	SceneObject *obj = objDefs.GetSceneObjectByHandle(objHandle);
+	// Get the material
+	const Material *mat = matDefs.GetMaterialByHandle(matHandle);
 
 	// Check if the object is a light source
 	if (obj->GetMaterial()->IsLightSource()) {
@@ -66,13 +78,11 @@ void Scene::UpdateObjectMaterial(const string &objName, const string &matName) {
 		editActions.AddActions(LIGHTS_EDIT | LIGHT_TYPES_EDIT);
 	}
 	
-	// Get the material
-	const Material *mat = matDefs.GetMaterial(matName);
 	obj->SetMaterial(mat);
 	
 	// Check if the object is now a light source
 	if (mat->IsLightSource()) {
-		SDL_LOG("The " << objName << " object is a light sources with " << obj->GetExtMesh()->GetTotalTriangleCount() << " triangles");
+		SDL_LOG("The " << objDefs.GetSceneObjectName(objHandle) << " object is a light sources with " << obj->GetExtMesh()->GetTotalTriangleCount() << " triangles");
 
 		objDefs.DefineIntersectableLights(lightDefs, obj);
 
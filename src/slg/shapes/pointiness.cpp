@@ -41,6 +41,11 @@ public:
 };
 
 PointinessShape::PointinessShape(ExtTriangleMesh *srcMesh) : Shape() {
+	// The pointiness of strands is computed on their triangles
+	ExtCurveMesh *curveMesh = srcMesh->GetCurveMesh();
+	if (curveMesh)
+		curveMesh->Tessellate();
+
 	const u_int vertCount = srcMesh->GetTotalVertexCount();
 	const u_int triCount = srcMesh->GetTotalTriangleCount();
 
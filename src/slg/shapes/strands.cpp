@@ -283,17 +283,18 @@ private:
 // StrendsShape methods
 //------------------------------------------------------------------------------
 
+static void AddCurveVertex(vector<float> &curveVerts, const Point &p, const float radius) {
+	curveVerts.push_back(p.x);
+	curveVerts.push_back(p.y);
+	curveVerts.push_back(p.z);
+	curveVerts.push_back(Max(radius, 0.f));
+}
+
 StrendsShape::StrendsShape(const Scene *scene, 
 		const cyHairFile *hairFile, const TessellationType tesselType,
-		const u_int aMaxDepth, const float aError, const u_int sSideCount,
-		const bool sCapBottom, const bool sCapTop, const bool useCamPos) : Shape(), mesh(NULL) {
-	adaptiveMaxDepth = aMaxDepth;
-	adaptiveError = aError;
-	solidSideCount = sSideCount;
-	solidCapBottom = sCapBottom;
-	solidCapTop = sCapTop;
-	useCameraPosition = useCamPos;
-
+		const u_int adaptiveMaxDepth, const float adaptiveError, const u_int solidSideCount,
+		const bool solidCapBottom, const bool solidCapTop, const bool useCameraPosition) :
+		Shape(), mesh(NULL) {
 	const cyHairFileHeader &header = hairFile->GetHeader();
 	if (header.hair_count == 0)
 		throw runtime_error("Empty strands shape are not supported");
@@ -315,16 +316,13 @@ StrendsShape::StrendsShape(const Scene *scene,
 
 		vector<Point> hairPoints;
 		vector<float> hairSizes;
-		vector<Spectrum> hairCols;
-		vector<float> hairTransps;
-		vector<UV> hairUVs;
-
-		vector<Point> meshVerts;
-		vector<Normal> meshNorms;
-		vector<Triangle> meshTris;
-		vector<UV> meshUVs;
-		vector<Spectrum> meshCols;
-		vector<float> meshTransps;
+
+		vector<float> curveVerts;
+		vector<u_int> curveSegs;
+		vector<u_int> segPoints;
+		vector<UV> pointUVs;
+		vector<Spectrum> pointCols;
+		vector<float> pointTransps;
 		for (u_int i = 0; i < header.hair_count; ++i) {
 			// segmentSize must be signed 
 			const int segmentSize = segments ? segments[i] : header.d_segments;
@@ -334,102 +332,102 @@ StrendsShape::StrendsShape(const Scene *scene,
 			// Collect the segment points and size
 			hairPoints.clear();
 			hairSizes.clear();
-			hairCols.clear();
-			hairTransps.clear();
-			hairUVs.clear();
+			const u_int pointBase = pointUVs.size();
 			for (int j = 0; j <= segmentSize; ++j) {
 				hairPoints.push_back(Point(points[pointIndex * 3], points[pointIndex * 3 + 1], points[pointIndex * 3 + 2]));
 				hairSizes.push_back(((thickness) ? thickness[pointIndex] : header.d_thickness) * .5f);
 				if (colors)
-					hairCols.push_back(Spectrum(colors[pointIndex * 3], colors[pointIndex * 3 + 1], colors[pointIndex * 3 + 2]));
+					pointCols.push_back(Spectrum(colors[pointIndex * 3], colors[pointIndex * 3 + 1], colors[pointIndex * 3 + 2]));
 				else
-					hairCols.push_back(Spectrum(header.d_color[0], header.d_color[1], header.d_color[2]));
+					pointCols.push_back(Spectrum(header.d_color[0], header.d_color[1], header.d_color[2]));
 				if (transparency)
-					hairTransps.push_back(1.f - transparency[pointIndex]);
+					pointTransps.push_back(1.f - transparency[pointIndex]);
 				else
-					hairTransps.push_back(1.f - header.d_transparency);
+					pointTransps.push_back(1.f - header.d_transparency);
 				if (uvs)
-					hairUVs.push_back(UV(uvs[pointIndex * 2], uvs[pointIndex * 2 + 1]));
+					pointUVs.push_back(UV(uvs[pointIndex * 2], uvs[pointIndex * 2 + 1]));
 				else 
-					hairUVs.push_back(UV(0.f, j / (float)segmentSize));
+					pointUVs.push_back(UV(0.f, j / (float)segmentSize));
 
 				++pointIndex;
 			}
 
-			switch (tesselType) {
-				case TESSEL_RIBBON:
-					TessellateRibbon(scene, hairPoints, hairSizes, hairCols, hairUVs,
-							hairTransps, meshVerts, meshNorms, meshTris, meshUVs,
-							meshCols, meshTransps);
-					break;
-				case TESSEL_RIBBON_ADAPTIVE:
-					TessellateAdaptive(scene, false, hairPoints, hairSizes, hairCols, hairUVs, 
-							hairTransps, meshVerts, meshNorms, meshTris, meshUVs,
-							meshCols, meshTransps);
-					break;
-				case TESSEL_SOLID:
-					TessellateSolid(scene, hairPoints, hairSizes, hairCols, hairUVs, 
-							hairTransps, meshVerts, meshNorms, meshTris, meshUVs,
-							meshCols, meshTransps);
-					break;					
-				case TESSEL_SOLID_ADAPTIVE:
-					TessellateAdaptive(scene, true, hairPoints, hairSizes, hairCols, hairUVs, 
-							hairTransps, meshVerts, meshNorms, meshTris, meshUVs,
-							meshCols, meshTransps);
-					break;
-				default:
-					SLG_LOG("Unknown tessellation  type in an Strands Shape: " + ToString(tesselType));
+			// Convert the Catmull-Rom spline passing through the points in
+			// cubic Bezier segments (the first and last points are repeated
+			// like in CatmullRomCurve)
+			for (int j = 0; j < segmentSize; ++j) {
+				const int j0 = Max(j - 1, 0);
+				const int j3 = Min(j + 2, segmentSize);
+
+				const Point &p0 = hairPoints[j0];
+				const Point &p1 = hairPoints[j];
+				const Point &p2 = hairPoints[j + 1];
+				const Point &p3 = hairPoints[j3];
+				const float r0 = hairSizes[j0];
+				const float r1 = hairSizes[j];
+				const float r2 = hairSizes[j + 1];
+				const float r3 = hairSizes[j3];
+
+				// Consecutive segments share the end/start control point
+				if (j == 0)
+					AddCurveVertex(curveVerts, p1, r1);
+				curveSegs.push_back(curveVerts.size() / 4 - 1);
+				segPoints.push_back(pointBase + j);
+
+				AddCurveVertex(curveVerts, p1 + (p2 - p0) * (1.f / 6.f), r1 + (r2 - r0) * (1.f / 6.f));
+				AddCurveVertex(curveVerts, p2 - (p3 - p1) * (1.f / 6.f), r2 - (r3 - r1) * (1.f / 6.f));
+				AddCurveVertex(curveVerts, p2, r2);
 			}
 		}
 
-		// Normalize normals
-		for (u_int i = 0; i < meshNorms.size(); ++i)
-			meshNorms[i] = Normalize(meshNorms[i]);
+		if (curveSegs.size() == 0)
+			throw runtime_error("Strands shape without segments are not supported");
 
-		SLG_LOG("Strands mesh: " << meshTris.size() / 3 << " triangles");
+		SLG_LOG("Strands mesh: " << curveSegs.size() << " curve segments");
 
 		// Create the mesh
-		Point *newMeshVerts = TriangleMesh::AllocVerticesBuffer(meshVerts.size());
-		copy(meshVerts.begin(), meshVerts.end(), newMeshVerts);
+		float *newCurveVerts = new float[curveVerts.size()];
+		copy(curveVerts.begin(), curveVerts.end(), newCurveVerts);
 
-		Triangle *newMeshTris = TriangleMesh::AllocTrianglesBuffer(meshTris.size());
-		copy(meshTris.begin(), meshTris.end(), newMeshTris);
+		u_int *newCurveSegs = new u_int[curveSegs.size()];
+		copy(curveSegs.begin(), curveSegs.end(), newCurveSegs);
 
-		Normal *newMeshNorms = new Normal[meshNorms.size()];
-		copy(meshNorms.begin(), meshNorms.end(), newMeshNorms);
-		
-		UV *newMeshUVs = new UV[meshUVs.size()];
-		copy(meshUVs.begin(), meshUVs.end(), newMeshUVs);
-		
-		// Check if I have to include vertex colors too
-		Spectrum *newMeshCols = NULL;
-		BOOST_FOREACH(const Spectrum &c, meshCols) {
+		u_int *newSegPoints = new u_int[segPoints.size()];
+		copy(segPoints.begin(), segPoints.end(), newSegPoints);
+
+		UV *newPointUVs = new UV[pointUVs.size()];
+		copy(pointUVs.begin(), pointUVs.end(), newPointUVs);
+
+		// Check if I have to include point colors too
+		Spectrum *newPointCols = NULL;
+		BOOST_FOREACH(const Spectrum &c, pointCols) {
 			if (c != Spectrum(1.f)) {
 				// The mesh uses vertex colors
 				SLG_LOG("Strands shape uses colors");
 
-				newMeshCols = new Spectrum[meshUVs.size()];
-				copy(meshCols.begin(), meshCols.end(), newMeshCols);
+				newPointCols = new Spectrum[pointCols.size()];
+				copy(pointCols.begin(), pointCols.end(), newPointCols);
 				break;
 			}
 		}
 
-		// Check if I have to include vertex alpha too
-		float *newMeshTransps = NULL;
-		BOOST_FOREACH(const float &a, meshTransps) {
+		// Check if I have to include point alpha too
+		float *newPointTransps = NULL;
+		BOOST_FOREACH(const float &a, pointTransps) {
 			if (a != 1.f) {
 				// The mesh uses vertex alphas
 				SLG_LOG("Strands shape uses alphas");
 
-				newMeshTransps = new float[meshTransps.size()];
-				copy(meshTransps.begin(), meshTransps.end(), newMeshTransps);
+				newPointTransps = new float[pointTransps.size()];
+				copy(pointTransps.begin(), pointTransps.end(), newPointTransps);
 				break;
 			}
 		}
 
-		mesh = new ExtTriangleMesh(meshVerts.size(), meshTris.size(),
-				newMeshVerts, newMeshTris, newMeshNorms, newMeshUVs,
-				newMeshCols, newMeshTransps);
+		mesh = new StrandsMesh(scene, tesselType, adaptiveMaxDepth, adaptiveError,
+				solidSideCount, solidCapBottom, solidCapTop, useCameraPosition,
+				curveVerts.size() / 4, curveSegs.size(), newCurveVerts, newCurveSegs,
+				newSegPoints, newPointUVs, newPointCols, newPointTransps);
 	} else
 		throw runtime_error("Strands shape without segments are not supported");
 
@@ -437,8 +435,149 @@ StrendsShape::StrendsShape(const Scene *scene,
 	SLG_LOG("Refining time: " << std::setprecision(3) << dt << " secs");
 }
 
-void StrendsShape::TessellateRibbon(const Scene *scene,
-		const vector<Point> &hairPoints,
+StrendsShape::~StrendsShape() {
+	if (!refined)
+		delete mesh;
+}
+
+ExtMesh *StrendsShape::RefineImpl(const Scene *scene) {
+	return mesh;
+}
+
+//------------------------------------------------------------------------------
+// StrandsMesh methods
+//------------------------------------------------------------------------------
+
+StrandsMesh::StrandsMesh(const Scene *scn, const StrendsShape::TessellationType tType,
+		const u_int aMaxDepth, const float aError, const u_int sSideCount,
+		const bool sCapBottom, const bool sCapTop, const bool useCamPos,
+		const u_int curveVertCount, const u_int curveSegmentCount,
+		float *curveVertices, u_int *curveSegments, u_int *segmentPoints,
+		UV *pointUVs, Spectrum *pointCols, float *pointAlphas) :
+		ExtCurveMesh(curveVertCount, curveSegmentCount, curveVertices, curveSegments,
+			segmentPoints, pointUVs, pointCols, pointAlphas) {
+	scene = scn;
+
+	tesselType = tType;
+	adaptiveMaxDepth = aMaxDepth;
+	adaptiveError = aError;
+	solidSideCount = sSideCount;
+	solidCapBottom = sCapBottom;
+	solidCapTop = sCapTop;
+	useCameraPosition = useCamPos;
+}
+
+void StrandsMesh::TessellateCurves(u_int *meshVertCount, u_int *meshTriCount,
+		Point **meshVertices, Triangle **meshTriangles, Normal **meshNormals, UV **meshUVArray,
+		Spectrum **meshColArray, float **meshAlphas) const {
+	SLG_LOG("Tessellating " << curveSegmentCount << " strands curve segments");
+	const double start = WallClockTime();
+
+	vector<Point> hairPoints;
+	vector<float> hairSizes;
+	vector<Spectrum> hairCols;
+	vector<float> hairTransps;
+	vector<UV> hairUVs;
+
+	vector<Point> meshVerts;
+	vector<Normal> meshNorms;
+	vector<Triangle> meshTris;
+	vector<UV> meshUVs;
+	vector<Spectrum> meshCols;
+	vector<float> meshTransps;
+	for (u_int i = 0; i < curveSegmentCount; ++i) {
+		// Collect the points of the strand: the first control point of each
+		// segment and the last control point of the last segment
+		const float *cp = &curveVertices[curveSegments[i] * 4];
+		const u_int pointIndex = segmentPoints[i];
+
+		hairPoints.push_back(Point(cp[0], cp[1], cp[2]));
+		hairSizes.push_back(cp[3]);
+		hairCols.push_back(pointCols ? pointCols[pointIndex] : Spectrum(1.f));
+		hairTransps.push_back(pointAlphas ? pointAlphas[pointIndex] : 1.f);
+		hairUVs.push_back(pointUVs ? pointUVs[pointIndex] : UV(0.f, 0.f));
+
+		// Check if it is the last segment of the strand
+		if ((i == curveSegmentCount - 1) || (segmentPoints[i + 1] != pointIndex + 1)) {
+			hairPoints.push_back(Point(cp[12], cp[13], cp[14]));
+			hairSizes.push_back(cp[15]);
+			hairCols.push_back(pointCols ? pointCols[pointIndex + 1] : Spectrum(1.f));
+			hairTransps.push_back(pointAlphas ? pointAlphas[pointIndex + 1] : 1.f);
+			hairUVs.push_back(pointUVs ? pointUVs[pointIndex + 1] : UV(0.f, 0.f));
+
+			switch (tesselType) {
+				case StrendsShape::TESSEL_RIBBON:
+					TessellateRibbon(hairPoints, hairSizes, hairCols, hairUVs,
+							hairTransps, meshVerts, meshNorms, meshTris, meshUVs,
+							meshCols, meshTransps);
+					break;
+				case StrendsShape::TESSEL_RIBBON_ADAPTIVE:
+					TessellateAdaptive(false, hairPoints, hairSizes, hairCols, hairUVs, 
+							hairTransps, meshVerts, meshNorms, meshTris, meshUVs,
+							meshCols, meshTransps);
+					break;
+				case StrendsShape::TESSEL_SOLID:
+					TessellateSolid(hairPoints, hairSizes, hairCols, hairUVs, 
+							hairTransps, meshVerts, meshNorms, meshTris, meshUVs,
+							meshCols, meshTransps);
+					break;					
+				case StrendsShape::TESSEL_SOLID_ADAPTIVE:
+					TessellateAdaptive(true, hairPoints, hairSizes, hairCols, hairUVs, 
+							hairTransps, meshVerts, meshNorms, meshTris, meshUVs,
+							meshCols, meshTransps);
+					break;
+				default:
+					SLG_LOG("Unknown tessellation  type in an Strands Shape: " + ToString(tesselType));
+			}
+
+			hairPoints.clear();
+			hairSizes.clear();
+			hairCols.clear();
+			hairTransps.clear();
+			hairUVs.clear();
+		}
+	}
+
+	// Normalize normals
+	for (u_int i = 0; i < meshNorms.size(); ++i)
+		meshNorms[i] = Normalize(meshNorms[i]);
+
+	SLG_LOG("Strands mesh: " << meshTris.size() << " triangles");
+
+	// Create the mesh buffers
+	*meshVertCount = meshVerts.size();
+	*meshTriCount = meshTris.size();
+
+	*meshVertices = TriangleMesh::AllocVerticesBuffer(meshVerts.size());
+	copy(meshVerts.begin(), meshVerts.end(), *meshVertices);
+
+	*meshTriangles = TriangleMesh::AllocTrianglesBuffer(meshTris.size());
+	copy(meshTris.begin(), meshTris.end(), *meshTriangles);
+
+	*meshNormals = new Normal[meshNorms.size()];
+	copy(meshNorms.begin(), meshNorms.end(), *meshNormals);
+
+	*meshUVArray = new UV[meshUVs.size()];
+	copy(meshUVs.begin(), meshUVs.end(), *meshUVArray);
+
+	// The colors and alphas are included only if the curves have them
+	if (pointCols) {
+		*meshColArray = new Spectrum[meshCols.size()];
+		copy(meshCols.begin(), meshCols.end(), *meshColArray);
+	} else
+		*meshColArray = NULL;
+
+	if (pointAlphas) {
+		*meshAlphas = new float[meshTransps.size()];
+		copy(meshTransps.begin(), meshTransps.end(), *meshAlphas);
+	} else
+		*meshAlphas = NULL;
+
+	const float dt = WallClockTime() - start;
+	SLG_LOG("Tessellation time: " << std::setprecision(3) << dt << " secs");
+}
+
+void StrandsMesh::TessellateRibbon(const vector<Point> &hairPoints,
 		const vector<float> &hairSizes, const vector<Spectrum> &hairCols,
 		const vector<UV> &hairUVs, const vector<float> &hairTransps,
 		vector<Point> &meshVerts, vector<Normal> &meshNorms,
@@ -540,8 +679,7 @@ void StrendsShape::TessellateRibbon(const Scene *scene,
 	}
 }
 
-void StrendsShape::TessellateAdaptive(const Scene *scene,
-		const bool solid, const vector<Point> &hairPoints,
+void StrandsMesh::TessellateAdaptive(const bool solid, const vector<Point> &hairPoints,
 		const vector<float> &hairSizes, const vector<Spectrum> &hairCols,
 		const vector<UV> &hairUVs, const vector<float> &hairTransps,
 		vector<Point> &meshVerts, vector<Normal> &meshNorms,
@@ -572,15 +710,14 @@ void StrendsShape::TessellateAdaptive(const Scene *scene,
 	}
 
 	if (solid)
-		TessellateSolid(scene, tesselPoints, tesselSizes, tesselCols, tesselUVs, tesselTransps,
+		TessellateSolid(tesselPoints, tesselSizes, tesselCols, tesselUVs, tesselTransps,
 			meshVerts, meshNorms, meshTris, meshUVs, meshCols, meshTransps);
 	else
-		TessellateRibbon(scene, tesselPoints, tesselSizes, tesselCols, tesselUVs, tesselTransps,
+		TessellateRibbon(tesselPoints, tesselSizes, tesselCols, tesselUVs, tesselTransps,
 			meshVerts, meshNorms, meshTris, meshUVs, meshCols, meshTransps);
 }
 
-void StrendsShape::TessellateSolid(const Scene *scene,
-		const vector<Point> &hairPoints,
+void StrandsMesh::TessellateSolid(const vector<Point> &hairPoints,
 		const vector<float> &hairSizes, const vector<Spectrum> &hairCols,
 		const vector<UV> &hairUVs, const vector<float> &hairTransps,
 		vector<Point> &meshVerts, vector<Normal> &meshNorms,
@@ -732,12 +869,3 @@ void StrendsShape::TessellateSolid(const Scene *scene,
 		}
 	}
 }
-
-StrendsShape::~StrendsShape() {
-	if (!refined)
-		delete mesh;
-}
-
-ExtMesh *StrendsShape::RefineImpl(const Scene *scene) {
-	return mesh;
-}
@@ -30,14 +30,43 @@ using namespace slg;
 
 ImageMapTexture::ImageMapTexture(const ImageMap *img, const TextureMapping2D *mp, const float g) :
 	imageMap(img), mapping(mp), gain(g) {
+	filtered = imageMap->IsTiled();
+}
+
+UV ImageMapTexture::GetUV(const HitPoint &hitPoint, float *footprint) const {
+	UV du, dv;
+	const UV uv = mapping->MapDuv(hitPoint, &du, &dv);
+
+	// Convert the footprint from world units to image UV units
+	const float dpduLength = hitPoint.dpdu.Length();
+	const float dpdvLength = hitPoint.dpdv.Length();
+	const float footprintU = (dpduLength > 0.f) ?
+		(sqrtf(du.u * du.u + du.v * du.v) * hitPoint.footprint / dpduLength) : 0.f;
+	const float footprintV = (dpdvLength > 0.f) ?
+		(sqrtf(dv.u * dv.u + dv.v * dv.v) * hitPoint.footprint / dpdvLength) : 0.f;
+	*footprint = Max(footprintU, footprintV);
+
+	return uv;
 }
 
 float ImageMapTexture::GetFloatValue(const HitPoint &hitPoint) const {
-	return gain * imageMap->GetFloat(mapping->Map(hitPoint));
+	if (filtered && (hitPoint.footprint > 0.f)) {
+		float footprint;
+		const UV uv = GetUV(hitPoint, &footprint);
+
+		return gain * imageMap->GetFloat(uv, footprint);
+	} else
+		return gain * imageMap->GetFloat(mapping->Map(hitPoint));
 }
 
 Spectrum ImageMapTexture::GetSpectrumValue(const HitPoint &hitPoint) const {
-	return gain * imageMap->GetSpectrum(mapping->Map(hitPoint));
+	if (filtered && (hitPoint.footprint > 0.f)) {
+		float footprint;
+		const UV uv = GetUV(hitPoint, &footprint);
+
+		return gain * imageMap->GetSpectrum(uv, footprint);
+	} else
+		return gain * imageMap->GetSpectrum(mapping->Map(hitPoint));
 }
 
 Normal ImageMapTexture::Bump(const HitPoint &hitPoint, const float sampleDistance) const {
@@ -0,0 +1,368 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#include <boost/crc.hpp>
+#include <boost/foreach.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+
+#include "luxrays/utils/utils.h"
+#include "slg/utils/chunkfile.h"
+
+using namespace std;
+using namespace luxrays;
+using namespace slg;
+
+static const char CHUNKFILE_MAGIC[8] = { 'S', 'L', 'G', 'C', 'H', 'U', 'N', 'K' };
+static const u_int CHUNKFILE_VERSION = 1;
+
+// The chunk compression types
+static const u_int CHUNK_RAW = 0;
+static const u_int CHUNK_ZLIB = 1;
+
+static void WriteUInt(ostream &os, const u_int v) {
+	char buf[4];
+	for (u_int i = 0; i < 4; ++i)
+		buf[i] = (char)((v >> (8 * i)) & 0xffu);
+	os.write(buf, 4);
+}
+
+static void WriteULongLong(ostream &os, const u_longlong v) {
+	char buf[8];
+	for (u_int i = 0; i < 8; ++i)
+		buf[i] = (char)((v >> (8 * i)) & 0xffu);
+	os.write(buf, 8);
+}
+
+static u_int ReadUInt(const char **p, const char *end) {
+	if (end - *p < 4)
+		throw runtime_error("Truncated chunk file");
+
+	const unsigned char *buf = (const unsigned char *)*p;
+	u_int v = 0;
+	for (u_int i = 0; i < 4; ++i)
+		v |= ((u_int)buf[i]) << (8 * i);
+	*p += 4;
+
+	return v;
+}
+
+static u_longlong ReadULongLong(const char **p, const char *end) {
+	if (end - *p < 8)
+		throw runtime_error("Truncated chunk file");
+
+	const unsigned char *buf = (const unsigned char *)*p;
+	u_longlong v = 0;
+	for (u_int i = 0; i < 8; ++i)
+		v |= ((u_longlong)buf[i]) << (8 * i);
+	*p += 8;
+
+	return v;
+}
+
+static u_int ComputeChecksum(const char *data, const size_t size) {
+	boost::crc_32_type crc;
+	crc.process_bytes(data, size);
+
+	return crc.checksum();
+}
+
+//------------------------------------------------------------------------------
+// ChunkFileWriter
+//------------------------------------------------------------------------------
+
+// Large enough to compress well and small enough to split a film channel
+// across all the threads
+const size_t ChunkFileWriter::CHUNK_SIZE = 4 * 1024 * 1024;
+
+ChunkFileWriter::ChunkFileWriter(const bool comp) : compress(comp) {
+}
+
+ChunkFileWriter::~ChunkFileWriter() {
+	BOOST_FOREACH(Chunk *chunk, chunks)
+		delete chunk;
+}
+
+void ChunkFileWriter::AddBlock(const void *data, const size_t size) {
+	const u_int blockIndex = blockSizes.size();
+	blockSizes.push_back(size);
+
+	const char *src = (const char *)data;
+	for (size_t offset = 0; offset < size; offset += CHUNK_SIZE) {
+		Chunk *chunk = new Chunk();
+		chunk->blockIndex = blockIndex;
+		chunk->compression = CHUNK_RAW;
+		chunk->checksum = 0;
+		chunk->offset = offset;
+		chunk->rawSize = Min(CHUNK_SIZE, size - offset);
+		chunk->data.assign(src + offset, src + offset + chunk->rawSize);
+
+		chunks.push_back(chunk);
+	}
+}
+
+void ChunkFileWriter::ProcessChunk(Chunk *chunk) const {
+	chunk->checksum = ComputeChecksum(&chunk->data[0], chunk->rawSize);
+
+	if (compress) {
+		vector<char> compressedData;
+		{
+			boost::iostreams::filtering_ostream outStream;
+			outStream.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib::best_speed));
+			outStream.push(boost::iostreams::back_inserter(compressedData));
+			outStream.write(&chunk->data[0], chunk->rawSize);
+
+			if (!outStream.good())
+				throw runtime_error("Error while compressing a chunk");
+
+			// Flush the compressor
+			outStream.reset();
+		}
+
+		// Keep the raw data if it doesn't compress
+		if (compressedData.size() < chunk->rawSize) {
+			chunk->data.swap(compressedData);
+			chunk->compression = CHUNK_ZLIB;
+		}
+	}
+}
+
+void ChunkFileWriter::Write(const string &fileName) {
+	// Compute the checksums and compress the chunks in parallel
+	string errorMsg;
+	#pragma omp parallel for schedule(dynamic)
+	for (
+			// Visual C++ 2013 supports only OpenMP 2.5
+#if _OPENMP >= 200805
+			unsigned
+#endif
+			int i = 0; i < chunks.size(); ++i) {
+		try {
+			ProcessChunk(chunks[i]);
+		} catch (exception &e) {
+			#pragma omp critical
+			{
+				errorMsg = e.what();
+			}
+		}
+	}
+
+	if (errorMsg.length() > 0)
+		throw runtime_error("Error while writing chunk file " + fileName + ": " + errorMsg);
+
+	// The file is written with a temporary name and renamed only at the end
+	// so a crash while saving doesn't destroy the previous file
+	const string tmpFileName = fileName + ".tmp";
+	try {
+		WriteFile(tmpFileName);
+
+		boost::filesystem::rename(tmpFileName, fileName);
+	} catch (...) {
+		boost::system::error_code ec;
+		boost::filesystem::remove(tmpFileName, ec);
+		throw;
+	}
+}
+
+void ChunkFileWriter::WriteFile(const string &fileName) const {
+	ofstream outFile;
+	outFile.exceptions(ofstream::failbit | ofstream::badbit | ofstream::eofbit);
+	outFile.open(fileName.c_str(), ofstream::binary | ofstream::trunc);
+
+	outFile.write(CHUNKFILE_MAGIC, sizeof(CHUNKFILE_MAGIC));
+	WriteUInt(outFile, CHUNKFILE_VERSION);
+	WriteUInt(outFile, blockSizes.size());
+	BOOST_FOREACH(const size_t size, blockSizes)
+		WriteULongLong(outFile, size);
+
+	BOOST_FOREACH(const Chunk *chunk, chunks) {
+		WriteUInt(outFile, chunk->blockIndex);
+		WriteUInt(outFile, chunk->compression);
+		WriteULongLong(outFile, chunk->offset);
+		WriteULongLong(outFile, chunk->rawSize);
+		WriteULongLong(outFile, chunk->data.size());
+		WriteUInt(outFile, chunk->checksum);
+		outFile.write(&chunk->data[0], chunk->data.size());
+	}
+
+	outFile.flush();
+	outFile.close();
+}
+
+//------------------------------------------------------------------------------
+// ChunkFileReader
+//------------------------------------------------------------------------------
+
+ChunkFileReader::ChunkFileReader(const string &name) : fileName(name) {
+	file.open(fileName);
+	if (!file.is_open())
+		throw runtime_error("Unable to open chunk file: " + fileName);
+
+	const char *p = file.data();
+	const char *end = p + file.size();
+
+	// Read the header
+	if ((end - p < (ptrdiff_t)sizeof(CHUNKFILE_MAGIC)) ||
+			memcmp(p, CHUNKFILE_MAGIC, sizeof(CHUNKFILE_MAGIC)))
+		throw runtime_error("Not a chunk file: " + fileName);
+	p += sizeof(CHUNKFILE_MAGIC);
+
+	const u_int version = ReadUInt(&p, end);
+	if (version > CHUNKFILE_VERSION)
+		throw runtime_error("Unsupported chunk file version " + ToString(version) + ": " + fileName);
+
+	const u_int blockCount = ReadUInt(&p, end);
+	// Each block size is 8 bytes long
+	if (blockCount > (size_t)(end - p) / 8)
+		throw runtime_error("Corrupted chunk file: " + fileName);
+	blockSizes.resize(blockCount);
+	for (u_int i = 0; i < blockCount; ++i)
+		blockSizes[i] = ReadULongLong(&p, end);
+
+	// Read the chunk headers
+	while (p < end) {
+		Chunk chunk;
+		chunk.blockIndex = ReadUInt(&p, end);
+		chunk.compression = ReadUInt(&p, end);
+		chunk.offset = ReadULongLong(&p, end);
+		chunk.rawSize = ReadULongLong(&p, end);
+		chunk.storedSize = ReadULongLong(&p, end);
+		chunk.checksum = ReadUInt(&p, end);
+		chunk.data = p;
+
+		// The values are read from a file that can be corrupted so the checks
+		// are written to avoid any overflow
+		if ((chunk.blockIndex >= blockCount) ||
+				(chunk.rawSize == 0) ||
+				(chunk.rawSize > blockSizes[chunk.blockIndex]) ||
+				(chunk.offset > blockSizes[chunk.blockIndex] - chunk.rawSize) ||
+				(chunk.storedSize > (size_t)(end - p)))
+			throw runtime_error("Corrupted chunk file: " + fileName);
+		p += chunk.storedSize;
+
+		chunks.push_back(chunk);
+	}
+
+	// The chunks of a block must cover it exactly once: overlapping chunks
+	// would leave a part of the block unwritten and they would be written by
+	// different threads at the same time
+	vector<const Chunk *> sortedChunks;
+	BOOST_FOREACH(const Chunk &chunk, chunks)
+		sortedChunks.push_back(&chunk);
+	sort(sortedChunks.begin(), sortedChunks.end(), ChunkLess);
+
+	vector<size_t> blockReadSizes(blockCount, 0);
+	BOOST_FOREACH(const Chunk *chunk, sortedChunks) {
+		if (chunk->offset != blockReadSizes[chunk->blockIndex])
+			throw runtime_error("Corrupted chunk file: " + fileName);
+
+		blockReadSizes[chunk->blockIndex] += chunk->rawSize;
+	}
+
+	for (u_int i = 0; i < blockCount; ++i) {
+		if (blockReadSizes[i] != blockSizes[i])
+			throw runtime_error("Truncated chunk file: " + fileName);
+	}
+}
+
+// Used to sort the chunks by block and by offset inside the block
+bool ChunkFileReader::ChunkLess(const Chunk *a, const Chunk *b) {
+	return (a->blockIndex < b->blockIndex) ||
+			((a->blockIndex == b->blockIndex) && (a->offset < b->offset));
+}
+
+ChunkFileReader::~ChunkFileReader() {
+	file.close();
+}
+
+void ChunkFileReader::ProcessChunk(const Chunk &chunk, char *blockData) const {
+	char *dst = blockData + chunk.offset;
+
+	switch (chunk.compression) {
+		case CHUNK_RAW:
+			if (chunk.storedSize != chunk.rawSize)
+				throw runtime_error("Wrong raw chunk size");
+			memcpy(dst, chunk.data, chunk.rawSize);
+			break;
+		case CHUNK_ZLIB: {
+			boost::iostreams::filtering_istream inStream;
+			inStream.push(boost::iostreams::zlib_decompressor());
+			inStream.push(boost::iostreams::array_source(chunk.data, chunk.storedSize));
+			inStream.read(dst, chunk.rawSize);
+
+			if ((size_t)inStream.gcount() != chunk.rawSize)
+				throw runtime_error("Error while decompressing a chunk");
+			break;
+		}
+		default:
+			throw runtime_error("Unknown chunk compression type: " + ToString(chunk.compression));
+	}
+
+	if (ComputeChecksum(dst, chunk.rawSize) != chunk.checksum)
+		throw runtime_error("Wrong chunk checksum");
+}
+
+void ChunkFileReader::ReadBlock(const u_int index, void *data) {
+	// Collect the chunks of the block
+	vector<const Chunk *> blockChunks;
+	BOOST_FOREACH(const Chunk &chunk, chunks) {
+		if (chunk.blockIndex == index)
+			blockChunks.push_back(&chunk);
+	}
+
+	// Decompress and check the chunks in parallel
+	string errorMsg;
+	#pragma omp parallel for schedule(dynamic)
+	for (
+			// Visual C++ 2013 supports only OpenMP 2.5
+#if _OPENMP >= 200805
+			unsigned
+#endif
+			int i = 0; i < blockChunks.size(); ++i) {
+		try {
+			ProcessChunk(*blockChunks[i], (char *)data);
+		} catch (exception &e) {
+			#pragma omp critical
+			{
+				errorMsg = e.what();
+			}
+		}
+	}
+
+	if (errorMsg.length() > 0)
+		throw runtime_error("Error while reading chunk file " + fileName + ": " + errorMsg);
+}
+
+bool ChunkFileReader::IsChunkFile(const string &fileName) {
+	ifstream inFile(fileName.c_str(), ifstream::binary);
+	if (!inFile.is_open())
+		return false;
+
+	char magic[sizeof(CHUNKFILE_MAGIC)];
+	inFile.read(magic, sizeof(magic));
+
+	return (inFile.gcount() == sizeof(magic)) &&
+			!memcmp(magic, CHUNKFILE_MAGIC, sizeof(CHUNKFILE_MAGIC));
+}
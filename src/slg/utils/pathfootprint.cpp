@@ -0,0 +1,41 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#include "slg/utils/pathfootprint.h"
+#include "slg/cameras/camera.h"
+
+using namespace std;
+using namespace luxrays;
+using namespace slg;
+
+//------------------------------------------------------------------------------
+// PathFootprint
+//------------------------------------------------------------------------------
+
+PathFootprint::PathFootprint(const Camera &camera) {
+	camera.GetPixelFootprint(&width, &spread);
+}
+
+void PathFootprint::Bounce(const float t, const BSDFEvent event) {
+	if (event & SPECULAR) {
+		// The footprint is unknown after a specular bounce
+		width = 0.f;
+		spread = 0.f;
+	} else
+		width += spread * t;
+}
@@ -77,6 +77,19 @@ void VarianceClamping::Clamp(const float expectedValue[4], float value[4]) const
 			maxExpectedValue + delta);
 }
 
+static void GetExpectedValue(const Film &film, const SampleResult &sampleResult,
+		const int x, const int y, float expectedValue[3]) {
+	if (sampleResult.HasChannel(Film::RADIANCE_PER_PIXEL_NORMALIZED)) {
+		for (u_int i = 0; i < film.channel_RADIANCE_PER_PIXEL_NORMALIZEDs.size(); ++i)
+			film.channel_RADIANCE_PER_PIXEL_NORMALIZEDs[i]->AccumulateWeightedPixel(
+					x, y, &expectedValue[0]);
+	} else {
+		for (u_int i = 0; i < film.channel_RADIANCE_PER_SCREEN_NORMALIZEDs.size(); ++i)
+			film.channel_RADIANCE_PER_PIXEL_NORMALIZEDs[i]->AccumulateWeightedPixel(
+					x, y, &expectedValue[0]);			
+	}
+}
+
 void VarianceClamping::Clamp(const Film &film, SampleResult &sampleResult) const {
 	// Recover the current pixel value
 	int x, y;
@@ -89,15 +102,13 @@ void VarianceClamping::Clamp(const Film &film, SampleResult &sampleResult) const
 	}
 
 	float expectedValue[3] = { 0.f, 0.f, 0.f };
-	if (sampleResult.HasChannel(Film::RADIANCE_PER_PIXEL_NORMALIZED)) {
-		for (u_int i = 0; i < film.channel_RADIANCE_PER_PIXEL_NORMALIZEDs.size(); ++i)
-			film.channel_RADIANCE_PER_PIXEL_NORMALIZEDs[i]->AccumulateWeightedPixel(
-					x, y, &expectedValue[0]);
-	} else {
-		for (u_int i = 0; i < film.channel_RADIANCE_PER_SCREEN_NORMALIZEDs.size(); ++i)
-			film.channel_RADIANCE_PER_PIXEL_NORMALIZEDs[i]->AccumulateWeightedPixel(
-					x, y, &expectedValue[0]);			
-	}
+	boost::mutex *rowLock = film.GetRowLock(y);
+	if (rowLock) {
+		// The film is shared with the other render threads
+		boost::unique_lock<boost::mutex> lock(*rowLock);
+		GetExpectedValue(film, sampleResult, x, y, expectedValue);
+	} else
+		GetExpectedValue(film, sampleResult, x, y, expectedValue);
 
 	// Use the current pixel value as expected value
 	const float minExpectedValue = Min(expectedValue[0], Min(expectedValue[1], expectedValue[2]));
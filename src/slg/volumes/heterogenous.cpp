@@ -17,9 +17,17 @@
  ***************************************************************************/
 
 #include <cstddef>
+#include <cstring>
 
+#include "luxrays/core/randomgen.h"
 #include "slg/volumes/heterogenous.h"
 #include "slg/bsdf/bsdf.h"
+#include "slg/textures/constfloat.h"
+#include "slg/textures/constfloat3.h"
+#include "slg/textures/densitygrid.h"
+#include "slg/textures/scale.h"
+#include "slg/textures/add.h"
+#include "slg/textures/subtract.h"
 
 using namespace std;
 using namespace luxrays;
@@ -32,11 +40,34 @@ using namespace slg;
 HeterogeneousVolume::HeterogeneousVolume(const Texture *iorTex, const Texture *emiTex,
 		const Texture *a, const Texture *s, const Texture *g,
 		const float ss, const u_int maxStepC,
-		const bool multiScat) : Volume(iorTex, emiTex),
+		const bool multiScat, const TrackingType trackingType,
+		const float maj) : Volume(iorTex, emiTex),
 		schlickScatter(this, g), stepSize(ss), maxStepsCount(maxStepC),
-		multiScattering(multiScat) {
+		multiScattering(multiScat), tracking(trackingType), userMajorant(maj) {
 	sigmaA = a;
 	sigmaS = s;
+
+	PreprocessMajorant();
+}
+
+HeterogeneousVolume::TrackingType HeterogeneousVolume::String2TrackingType(const string &type) {
+	if (type == "raymarching")
+		return RAY_MARCHING;
+	else if (type == "deltatracking")
+		return DELTA_TRACKING;
+	else
+		throw runtime_error("Unknown heterogeneous volume tracking type: " + type);
+}
+
+string HeterogeneousVolume::TrackingType2String(const TrackingType type) {
+	switch (type) {
+		case RAY_MARCHING:
+			return "raymarching";
+		case DELTA_TRACKING:
+			return "deltatracking";
+		default:
+			throw runtime_error("Unknown heterogeneous volume tracking type: " + ToString(type));
+	}
 }
 
 Spectrum HeterogeneousVolume::SigmaA(const HitPoint &hitPoint) const {
@@ -47,7 +78,16 @@ Spectrum HeterogeneousVolume::SigmaS(const HitPoint &hitPoint) const {
 	return sigmaS->GetSpectrumValue(hitPoint).Clamp();
 }
 
-float HeterogeneousVolume::Scatter(const Ray &ray, const float initialU,
+float HeterogeneousVolume::Scatter(const Ray &ray, const float u,
+		const bool scatteredStart, Spectrum *connectionThroughput,
+		Spectrum *connectionEmission) const {
+	if (deltaTrackingEnabled)
+		return ScatterDeltaTracking(ray, u, scatteredStart, connectionThroughput, connectionEmission);
+	else
+		return ScatterRayMarching(ray, u, scatteredStart, connectionThroughput, connectionEmission);
+}
+
+float HeterogeneousVolume::ScatterRayMarching(const Ray &ray, const float initialU,
 		const bool scatteredStart, Spectrum *connectionThroughput,
 		Spectrum *connectionEmission) const {
 	// Compute the number of steps to evaluate the volume
@@ -177,6 +217,478 @@ float HeterogeneousVolume::Scatter(const Ray &ray, const float initialU,
 	return t;
 }
 
+//------------------------------------------------------------------------------
+// Majorant
+//------------------------------------------------------------------------------
+
+static float MaxAbsComponent(const Spectrum &s) {
+	return Max(fabsf(s.c[0]), Max(fabsf(s.c[1]), fabsf(s.c[2])));
+}
+
+static float GetDensityGridMaxAbsValue(const DensityGridTexture *tex) {
+	const vector<float> &data = tex->GetData();
+
+	float maxValue = (tex->GetWrapMode() == DensityGridTexture::WRAP_WHITE) ? 1.f : 0.f;
+	for (u_int i = 0; i < data.size(); ++i)
+		maxValue = Max(maxValue, fabsf(data[i]));
+
+	return maxValue;
+}
+
+// Computes a conservative bound of the absolute value of all the components
+// of the texture in the form scale * |g| + offset, where g is the value of
+// densityGrid (NULL if there is none). Returns false if the texture can not
+// be bounded.
+static bool GetTextureBound(const Texture *tex, const DensityGridTexture *densityGrid,
+		const float densityGridMax, float *scale, float *offset) {
+	switch (tex->GetType()) {
+		case CONST_FLOAT:
+			*scale = 0.f;
+			*offset = fabsf(static_cast<const ConstFloatTexture *>(tex)->GetValue());
+			return true;
+		case CONST_FLOAT3:
+			*scale = 0.f;
+			*offset = MaxAbsComponent(static_cast<const ConstFloat3Texture *>(tex)->GetColor());
+			return true;
+		case DENSITYGRID_TEX:
+			if (tex == densityGrid) {
+				*scale = 1.f;
+				*offset = 0.f;
+			} else {
+				*scale = 0.f;
+				*offset = GetDensityGridMaxAbsValue(static_cast<const DensityGridTexture *>(tex));
+			}
+			return true;
+		case SCALE_TEX: {
+			const ScaleTexture *scaleTex = static_cast<const ScaleTexture *>(tex);
+
+			float scale1, offset1, scale2, offset2;
+			if (!GetTextureBound(scaleTex->GetTexture1(), densityGrid, densityGridMax, &scale1, &offset1) ||
+					!GetTextureBound(scaleTex->GetTexture2(), densityGrid, densityGridMax, &scale2, &offset2))
+				return false;
+
+			if (scale1 == 0.f) {
+				*scale = offset1 * scale2;
+				*offset = offset1 * offset2;
+			} else if (scale2 == 0.f) {
+				*scale = scale1 * offset2;
+				*offset = offset1 * offset2;
+			} else {
+				// The product of 2 density grid values is not linear, I can use
+				// only the global max. value
+				*scale = 0.f;
+				*offset = (scale1 * densityGridMax + offset1) * (scale2 * densityGridMax + offset2);
+			}
+			return true;
+		}
+		case ADD_TEX:
+		case SUBTRACT_TEX: {
+			const Texture *tex1, *tex2;
+			if (tex->GetType() == ADD_TEX) {
+				tex1 = static_cast<const AddTexture *>(tex)->GetTexture1();
+				tex2 = static_cast<const AddTexture *>(tex)->GetTexture2();
+			} else {
+				tex1 = static_cast<const SubtractTexture *>(tex)->GetTexture1();
+				tex2 = static_cast<const SubtractTexture *>(tex)->GetTexture2();
+			}
+
+			float scale1, offset1, scale2, offset2;
+			if (!GetTextureBound(tex1, densityGrid, densityGridMax, &scale1, &offset1) ||
+					!GetTextureBound(tex2, densityGrid, densityGridMax, &scale2, &offset2))
+				return false;
+
+			*scale = scale1 + scale2;
+			*offset = offset1 + offset2;
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+void HeterogeneousVolume::PreprocessMajorant() {
+	majorant = 0.f;
+	deltaTrackingEnabled = false;
+	majorantGridTex = NULL;
+	gridMajorantScale = 0.f;
+	gridMajorantOffset = 0.f;
+	outsideMajorant = 0.f;
+	majorantGridSize[0] = 0;
+	majorantGridSize[1] = 0;
+	majorantGridSize[2] = 0;
+	majorantGrid.clear();
+
+	if (tracking != DELTA_TRACKING)
+		return;
+
+	// Look for a density grid with a world space mapping
+	boost::unordered_set<const Texture *> referencedTexs;
+	sigmaA->AddReferencedTextures(referencedTexs);
+	sigmaS->AddReferencedTextures(referencedTexs);
+	const DensityGridTexture *densityGrid = NULL;
+	BOOST_FOREACH(const Texture *tex, referencedTexs) {
+		if (tex->GetType() == DENSITYGRID_TEX) {
+			const DensityGridTexture *dgt = static_cast<const DensityGridTexture *>(tex);
+
+			// The hit points used by Scatter() have an identity local to
+			// world transformation so local and global mapping are the same
+			const TextureMapping3DType mappingType = dgt->GetTextureMapping()->GetType();
+			if ((mappingType == GLOBALMAPPING3D) || (mappingType == LOCALMAPPING3D)) {
+				densityGrid = dgt;
+				break;
+			}
+		}
+	}
+	const float densityGridMax = densityGrid ? GetDensityGridMaxAbsValue(densityGrid) : 0.f;
+
+	float scaleA, offsetA, scaleS, offsetS;
+	if (GetTextureBound(sigmaA, densityGrid, densityGridMax, &scaleA, &offsetA) &&
+			GetTextureBound(sigmaS, densityGrid, densityGridMax, &scaleS, &offsetS)) {
+		gridMajorantScale = scaleA + scaleS;
+		gridMajorantOffset = offsetA + offsetS;
+		majorant = gridMajorantScale * densityGridMax + gridMajorantOffset;
+
+		// The user defined majorant can be only tighter
+		if (userMajorant > 0.f)
+			majorant = Min(majorant, userMajorant);
+	} else if (userMajorant > 0.f)
+		majorant = userMajorant;
+	else
+		throw runtime_error("Heterogeneous volume " + GetName() + " uses textures without a known max. value, "
+				"the tracking.majorant parameter is required by delta tracking");
+
+	deltaTrackingEnabled = true;
+
+	if (!densityGrid || (gridMajorantScale == 0.f))
+		return;
+
+	//--------------------------------------------------------------------------
+	// Build the majorant grid with the max. absolute value of the voxels used
+	// by the trilinear interpolation inside each cell
+	//--------------------------------------------------------------------------
+
+	majorantGridTex = densityGrid;
+
+	const int n[3] = { densityGrid->GetNx(), densityGrid->GetNy(), densityGrid->GetNz() };
+	for (u_int i = 0; i < 3; ++i)
+		majorantGridSize[i] = (n[i] + HETEROGENEOUS_VOL_MAJORANT_CELL_SIZE - 1) / HETEROGENEOUS_VOL_MAJORANT_CELL_SIZE;
+
+	majorantGrid.resize(majorantGridSize[0] * majorantGridSize[1] * majorantGridSize[2], 0.f);
+	const vector<float> &data = densityGrid->GetData();
+	for (int z = 0; z < n[2]; ++z) {
+		for (int y = 0; y < n[1]; ++y) {
+			for (int x = 0; x < n[0]; ++x) {
+				const float value = fabsf(data[(z * n[1] + y) * n[0] + x]);
+
+				// A voxel is used by the cell including it and, because of
+				// the interpolation, by the previous one
+				const int v[3] = { x, y, z };
+				int c0[3], c1[3];
+				for (u_int i = 0; i < 3; ++i) {
+					c1[i] = v[i] / HETEROGENEOUS_VOL_MAJORANT_CELL_SIZE;
+					c0[i] = (v[i] % HETEROGENEOUS_VOL_MAJORANT_CELL_SIZE == 0) ? Max(c1[i] - 1, 0) : c1[i];
+				}
+
+				for (int cz = c0[2]; cz <= c1[2]; ++cz) {
+					for (int cy = c0[1]; cy <= c1[1]; ++cy) {
+						for (int cx = c0[0]; cx <= c1[0]; ++cx) {
+							float &cellValue = majorantGrid[(cz * majorantGridSize[1] + cy) * majorantGridSize[0] + cx];
+							cellValue = Max(cellValue, value);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// The density outside the [0, 1]^3 box
+	switch (densityGrid->GetWrapMode()) {
+		case DensityGridTexture::WRAP_BLACK:
+			outsideMajorant = gridMajorantOffset;
+			break;
+		case DensityGridTexture::WRAP_WHITE:
+			outsideMajorant = gridMajorantScale + gridMajorantOffset;
+			break;
+		case DensityGridTexture::WRAP_REPEAT:
+		case DensityGridTexture::WRAP_CLAMP:
+		default:
+			outsideMajorant = majorant;
+			break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// HeterogeneousVolumeMajorantIterator
+//
+// Returns, in order, the segments of the ray with the same majorant: the
+// cells of the majorant grid are traversed with a 3D DDA.
+//------------------------------------------------------------------------------
+
+namespace slg {
+
+class HeterogeneousVolumeMajorantIterator {
+public:
+	HeterogeneousVolumeMajorantIterator(const HeterogeneousVolume &volume, const Ray &ray) :
+			vol(volume), tMin(ray.mint), tMax(ray.maxt) {
+		state = (vol.majorantGridTex) ? BEFORE_GRID : AFTER_GRID;
+		if (state == AFTER_GRID)
+			return;
+
+		// Work in the majorant grid space where each cell has size 1. It is
+		// an affine transformation so the ray parameter is the same.
+		const Transform &worldToLocal = vol.majorantGridTex->GetTextureMapping()->worldToLocal;
+		const Point o = worldToLocal * ray.o;
+		const Vector d = worldToLocal * ray.d;
+		const float scale[3] = {
+			vol.majorantGridTex->GetNx() / (float)HETEROGENEOUS_VOL_MAJORANT_CELL_SIZE,
+			vol.majorantGridTex->GetNy() / (float)HETEROGENEOUS_VOL_MAJORANT_CELL_SIZE,
+			vol.majorantGridTex->GetNz() / (float)HETEROGENEOUS_VOL_MAJORANT_CELL_SIZE
+		};
+
+		// Clip the ray with the grid box
+		gridT0 = tMin;
+		gridT1 = tMax;
+		for (u_int i = 0; i < 3; ++i) {
+			gridO[i] = o[i] * scale[i];
+			gridD[i] = d[i] * scale[i];
+
+			const float boxMax = (float)vol.majorantGridSize[i];
+			if (gridD[i] == 0.f) {
+				if ((gridO[i] < 0.f) || (gridO[i] > scale[i])) {
+					// The ray doesn't cross the grid box
+					gridT0 = tMax;
+					gridT1 = tMax;
+				}
+				continue;
+			}
+
+			const float invD = 1.f / gridD[i];
+			float tNear = -gridO[i] * invD;
+			float tFar = (Min(scale[i], boxMax) - gridO[i]) * invD;
+			if (tNear > tFar)
+				Swap(tNear, tFar);
+			gridT0 = Max(gridT0, tNear);
+			gridT1 = Min(gridT1, tFar);
+		}
+
+		if (gridT0 >= gridT1) {
+			// The ray doesn't cross the grid box
+			gridT0 = tMax;
+			gridT1 = tMax;
+		}
+
+		// Initialize the DDA
+		for (u_int i = 0; i < 3; ++i) {
+			const float p = gridO[i] + gridT0 * gridD[i];
+			cell[i] = Clamp(Floor2Int(p), 0, vol.majorantGridSize[i] - 1);
+
+			if (gridD[i] > 0.f) {
+				step[i] = 1;
+				tNext[i] = (cell[i] + 1 - gridO[i]) / gridD[i];
+				tDelta[i] = 1.f / gridD[i];
+			} else if (gridD[i] < 0.f) {
+				step[i] = -1;
+				tNext[i] = (cell[i] - gridO[i]) / gridD[i];
+				tDelta[i] = -1.f / gridD[i];
+			} else {
+				step[i] = 0;
+				tNext[i] = numeric_limits<float>::infinity();
+				tDelta[i] = numeric_limits<float>::infinity();
+			}
+		}
+		t = gridT0;
+	}
+
+	bool Next(float *t0, float *t1, float *segmentMajorant) {
+		for (;;) {
+			switch (state) {
+				case BEFORE_GRID:
+					state = IN_GRID;
+					if (gridT0 > tMin) {
+						*t0 = tMin;
+						*t1 = gridT0;
+						*segmentMajorant = vol.outsideMajorant;
+						return true;
+					}
+					break;
+				case IN_GRID: {
+					if (t >= gridT1) {
+						state = AFTER_GRID;
+						break;
+					}
+
+					// The axis of the next cell
+					u_int axis = (tNext[0] < tNext[1]) ? 0 : 1;
+					if (tNext[2] < tNext[axis])
+						axis = 2;
+
+					*t0 = t;
+					*t1 = Min(tNext[axis], gridT1);
+					*segmentMajorant = vol.gridMajorantScale *
+							vol.majorantGrid[(cell[2] * vol.majorantGridSize[1] + cell[1]) * vol.majorantGridSize[0] + cell[0]] +
+							vol.gridMajorantOffset;
+
+					t = *t1;
+					cell[axis] += step[axis];
+					tNext[axis] += tDelta[axis];
+					if ((cell[axis] < 0) || (cell[axis] >= vol.majorantGridSize[axis]))
+						t = gridT1;
+
+					return true;
+				}
+				case AFTER_GRID:
+					state = DONE;
+					if (vol.majorantGridTex) {
+						if (gridT1 < tMax) {
+							*t0 = Max(gridT1, tMin);
+							*t1 = tMax;
+							*segmentMajorant = vol.outsideMajorant;
+							return true;
+						}
+					} else {
+						// There is no grid
+						*t0 = tMin;
+						*t1 = tMax;
+						*segmentMajorant = vol.majorant;
+						return true;
+					}
+					break;
+				case DONE:
+				default:
+					return false;
+			}
+		}
+	}
+
+private:
+	typedef enum { BEFORE_GRID, IN_GRID, AFTER_GRID, DONE } State;
+
+	const HeterogeneousVolume &vol;
+	const float tMin, tMax;
+	State state;
+
+	float gridO[3], gridD[3];
+	float gridT0, gridT1, t;
+	int cell[3], step[3];
+	float tNext[3], tDelta[3];
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Delta tracking
+//------------------------------------------------------------------------------
+
+float HeterogeneousVolume::ScatterDeltaTracking(const Ray &ray, const float u,
+		const bool scatteredStart, Spectrum *connectionThroughput,
+		Spectrum *connectionEmission) const {
+	HitPoint hitPoint =  {
+		ray.d,
+		ray(ray.mint),
+		UV(),
+		Normal(-ray.d),
+		Normal(-ray.d),
+		Spectrum(1.f),
+		Vector(0.f, 0.f, 0.f), Vector(0.f, 0.f, 0.f),
+		Normal(0.f, 0.f, 0.f), Normal(0.f, 0.f, 0.f),
+		1.f,
+		0.f, // It doesn't matter here
+		Transform(),
+		this, this, // It doesn't matter here
+		true, true // It doesn't matter here
+	};
+
+	const bool scatterAllowed = (!scatteredStart || multiScattering);
+
+	// The first tentative collision uses the sampler random variable, the
+	// following ones a generator seeded with it and the ray
+	u_int seed;
+	memcpy(&seed, &u, sizeof(float));
+	u_int originBits[3];
+	memcpy(originBits, &ray.o.x, 3 * sizeof(float));
+	seed ^= originBits[0] * 73856093u ^ originBits[1] * 19349663u ^ originBits[2] * 83492791u;
+	TauswortheRandomGenerator rndGen(seed);
+
+	// With delta tracking (the scattering is allowed), it is the weight
+	// accounting for the spectral variation of SigmaT, otherwise (ratio
+	// tracking) it is the transmittance estimate
+	Spectrum weight(1.f);
+	Spectrum emission;
+	float scatterT = -1.f;
+
+	// The optical depth to the next tentative collision
+	float tau = -logf(1.f - u);
+	u_int steps = 0;
+
+	HeterogeneousVolumeMajorantIterator majorantIterator(*this, ray);
+	float t0, t1, segmentMajorant;
+	while ((scatterT < 0.f) && !weight.Black() && (steps < HETEROGENEOUS_VOL_MAX_TRACKING_STEPS) &&
+			majorantIterator.Next(&t0, &t1, &segmentMajorant)) {
+		// Skip the empty space
+		if (segmentMajorant <= 0.f)
+			continue;
+
+		float t = t0;
+		for (;;) {
+			const float dt = tau / segmentMajorant;
+			if (t + dt >= t1) {
+				// The next tentative collision is in one of the next segments
+				tau -= (t1 - t) * segmentMajorant;
+				break;
+			}
+
+			// A tentative collision
+			t += dt;
+			++steps;
+
+			hitPoint.p = ray(t);
+			const Spectrum sigmaT = SigmaT(hitPoint);
+
+			// The tentative collisions are a Poisson process with rate
+			// segmentMajorant, it is an unbiased estimate of the emission
+			// integral
+			if (volumeEmissionTex)
+				emission += weight * volumeEmissionTex->GetSpectrumValue(hitPoint).Clamp() / segmentMajorant;
+
+			const Spectrum nullSigma = (Spectrum(segmentMajorant) - sigmaT).Clamp();
+			if (scatterAllowed) {
+				// Delta tracking
+				const float sigmaTFilter = sigmaT.Filter();
+				if (rndGen.floatValue() * segmentMajorant < sigmaTFilter) {
+					// A real collision: it is a scattering event with
+					// probability SigmaS / SigmaT (the single scattering
+					// albedo), an absorption otherwise. The albedo is used
+					// as weight because the phase function has albedo 1.
+					weight *= SigmaS(hitPoint) / sigmaTFilter;
+					scatterT = t;
+					break;
+				}
+
+				// A null collision
+				weight *= nullSigma / (segmentMajorant - sigmaTFilter);
+			} else {
+				// Ratio tracking
+				weight *= nullSigma / segmentMajorant;
+			}
+
+			if (weight.Black() || (steps >= HETEROGENEOUS_VOL_MAX_TRACKING_STEPS))
+				break;
+
+			tau = -logf(1.f - rndGen.floatValue());
+		}
+	}
+
+	// Add volume emission
+	if (volumeEmissionTex)
+		*connectionEmission += *connectionThroughput * emission;
+
+	// The transmittance and the ratio between SigmaT and the sampling pdf
+	// are 1 (with delta tracking) or they are included in weight
+	*connectionThroughput *= weight;
+
+	return scatterT;
+}
+
 Spectrum HeterogeneousVolume::Evaluate(const HitPoint &hitPoint,
 		const Vector &localLightDir, const Vector &localEyeDir, BSDFEvent *event,
 		float *directPdfW, float *reversePdfW) const {
@@ -215,6 +727,16 @@ void HeterogeneousVolume::UpdateTextureReferences(const Texture *oldTex, const T
 		sigmaS = newTex;
 	if (schlickScatter.g == oldTex)
 		schlickScatter.g = newTex;
+
+	// The textures referenced by sigmaA and sigmaS can be changed too. The
+	// scene is already partially updated here so the error can not be
+	// thrown: the volume falls back to ray marching.
+	try {
+		PreprocessMajorant();
+	} catch (runtime_error &e) {
+		// PreprocessMajorant() has already disabled delta tracking
+		SLG_LOG("WARNING: " << e.what() << ", using ray marching");
+	}
 }
 
 Properties HeterogeneousVolume::ToProperties() const {
@@ -228,6 +750,8 @@ Properties HeterogeneousVolume::ToProperties() const {
 	props.Set(Property("scene.volumes." + name + ".multiscattering")(multiScattering));
 	props.Set(Property("scene.volumes." + name + ".steps.size")(stepSize));
 	props.Set(Property("scene.volumes." + name + ".steps.maxcount")(maxStepsCount));
+	props.Set(Property("scene.volumes." + name + ".tracking.type")(TrackingType2String(tracking)));
+	props.Set(Property("scene.volumes." + name + ".tracking.majorant")(userMajorant));
 	props.Set(Volume::ToProperties());
 
 	return props;
@@ -0,0 +1,124 @@
+/***************************************************************************
+ * Copyright 1998-2017 by authors (see AUTHORS.txt)                        *
+ *                                                                         *
+ *   This file is part of LuxRender.                                       *
+ *                                                                         *
+ * Licensed under the Apache License, Version 2.0 (the "License");         *
+ * you may not use this file except in compliance with the License.        *
+ * You may obtain a copy of the License at                                 *
+ *                                                                         *
+ *     http://www.apache.org/licenses/LICENSE-2.0                          *
+ *                                                                         *
+ * Unless required by applicable law or agreed to in writing, software     *
+ * distributed under the License is distributed on an "AS IS" BASIS,       *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*
+ * See the License for the specific language governing permissions and     *
+ * limitations under the License.                                          *
+ ***************************************************************************/
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <boost/foreach.hpp>
+
+#include "luxrays/luxrays.h"
+#include "luxrays/utils/utils.h"
+#include "luxrays/utils/properties.h"
+
+// Each object has 5 properties, the default is a 1M properties scene
+#define OBJECT_COUNT 200000
+#define EDITED_OBJECT_COUNT 1000
+
+using namespace std;
+using namespace luxrays;
+
+static void PrintTime(const string &name, const double startTime) {
+	cerr << "  " << name << ": " << (WallClockTime() - startTime) << " secs" << endl;
+}
+
+int main(int argc, char** argv) {
+	try {
+		cerr << "LuxRays Properties Benchmark v" << LUXRAYS_VERSION_MAJOR << "." << LUXRAYS_VERSION_MINOR << endl;
+		cerr << "Usage: " << argv[0] << " [object count]" << endl;
+
+		const u_int objCount = (argc > 1) ? (u_int)atoi(argv[1]) : OBJECT_COUNT;
+
+		//----------------------------------------------------------------------
+		// Build a synthetic scene
+		//----------------------------------------------------------------------
+
+		stringstream ss;
+		ss << "scene.camera.lookat.orig = 0 0 10\n";
+		ss << "scene.camera.lookat.target = 0 0 0\n";
+		ss << "scene.materials.mat.type = matte\n";
+		ss << "scene.materials.mat.kd = 0.75 0.75 0.75\n";
+		for (u_int i = 0; i < objCount; ++i) {
+			const string prefix = "scene.objects.obj" + ToString(i);
+			ss << prefix << ".shape = shape" << i << "\n";
+			ss << prefix << ".material = mat\n";
+			ss << prefix << ".transformation = 1 0 0 0 0 1 0 0 0 0 1 0 " << i << " 0 0 1\n";
+			ss << prefix << ".id = " << i << "\n";
+			ss << prefix << ".camerainvisible = 0\n";
+		}
+		const string sceneText = ss.str();
+
+		cerr << "Parsing a scene with " << objCount << " objects" << endl;
+
+		//----------------------------------------------------------------------
+		// Parse the scene
+		//----------------------------------------------------------------------
+
+		double startTime = WallClockTime();
+		Properties props;
+		props.SetFromString(sceneText);
+		PrintTime("SetFromString() of " + ToString(props.GetSize()) + " properties", startTime);
+
+		// The same queries used by Scene::Parse()
+		startTime = WallClockTime();
+		const vector<string> objKeys = props.GetAllUniqueSubNames("scene.objects");
+		PrintTime("GetAllUniqueSubNames() of " + ToString(objKeys.size()) + " objects", startTime);
+
+		startTime = WallClockTime();
+		u_int count = 0;
+		BOOST_FOREACH(const string &key, objKeys) {
+			if (props.HaveNames(key + ".ply") || props.HaveNames(key + ".shape"))
+				++count;
+			if (props.IsDefined(key + ".material"))
+				++count;
+			count += props.Get(Property(key + ".id")(0u)).Get<u_int>();
+		}
+		PrintTime("HaveNames()/IsDefined()/Get() of all objects", startTime);
+
+		startTime = WallClockTime();
+		count = 0;
+		for (u_int i = 0; i < EDITED_OBJECT_COUNT; ++i)
+			count += props.GetAllProperties(objKeys[(i * 7919) % objKeys.size()]).GetSize();
+		PrintTime("GetAllProperties() of " + ToString(EDITED_OBJECT_COUNT) + " objects", startTime);
+
+		//----------------------------------------------------------------------
+		// Edit the scene
+		//----------------------------------------------------------------------
+
+		startTime = WallClockTime();
+		for (u_int i = 0; i < EDITED_OBJECT_COUNT; ++i)
+			props.DeleteAll(props.GetAllNames(objKeys[(i * 7919) % objKeys.size()]));
+		PrintTime("DeleteAll() of " + ToString(EDITED_OBJECT_COUNT) + " objects", startTime);
+
+		startTime = WallClockTime();
+		for (u_int i = 0; i < EDITED_OBJECT_COUNT; ++i)
+			props.Delete(objKeys[(i * 104729) % objKeys.size()] + ".camerainvisible");
+		PrintTime("Delete() of " + ToString(EDITED_OBJECT_COUNT) + " properties", startTime);
+
+		cerr << "Properties left: " << props.GetSize() << endl;
+	} catch (runtime_error &err) {
+		cerr << "RUNTIME ERROR: " << err.what() << endl;
+		return EXIT_FAILURE;
+	} catch (exception &err) {
+		cerr << "ERROR: " << err.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}